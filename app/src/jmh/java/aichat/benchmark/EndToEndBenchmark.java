@@ -0,0 +1,189 @@
+package aichat.benchmark;
+
+import aichat.core.ImageHarmonyEngine;
+import aichat.core.ImageHarmonyEngine.ColorModel;
+import aichat.model.ColorPalette;
+import aichat.native_.NativeAccelerator;
+import org.openjdk.jmh.annotations.*;
+import org.openjdk.jmh.infra.BenchmarkParams;
+
+import javax.imageio.ImageIO;
+import java.awt.image.BufferedImage;
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.StandardOpenOption;
+import java.util.List;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * JMH Benchmark: load, analyze, resynthesize and save on the synthetic
+ * corpus, each stage on its own and as one pipeline. SampleTime mode gives
+ * the p50/p95/p99 latencies; the peak RSS of every stage is appended to
+ * {@code e2e-rss.csv} next to the JMH results (Linux only).
+ * Run with {@code ./gradlew jmhEndToEnd}.
+ */
+@BenchmarkMode(Mode.SampleTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@State(Scope.Benchmark)
+@Fork(value = 1, warmups = 0)
+@Warmup(iterations = 1, time = 2)
+@Measurement(iterations = 3, time = 5)
+public class EndToEndBenchmark {
+
+    private static final int PALETTE_SIZE = 16;
+    private static final int JPEG_QUALITY = 90;
+    private static final long TARGET_SEED = 1L;
+    private static final long SOURCE_SEED = 2L;
+
+    @Param({"GRADIENT", "NATURAL", "FLAT", "NOISE"})
+    private SyntheticCorpus.Kind kind;
+
+    @Param({"1", "12"})
+    private int megapixels;
+
+    @Param({"jpg", "png"})
+    private String format;
+
+    private ImageHarmonyEngine engine;
+    private NativeAccelerator accel;
+    private Path targetFile;
+    private Path outputFile;
+
+    private BufferedImage targetImage;
+    private ColorPalette sourcePalette;
+    private ColorPalette targetPalette;
+    private BufferedImage resultImage;
+
+    @Setup(Level.Trial)
+    public void setup() throws IOException {
+        engine = new ImageHarmonyEngine(ColorModel.CIELAB, 42L);
+        accel = NativeAccelerator.getInstance();
+
+        Path corpus = Path.of(System.getProperty("aichat.corpus.dir", "build/corpus"));
+        targetFile = SyntheticCorpus.file(corpus, kind, megapixels, format, TARGET_SEED);
+        Path sourceFile = SyntheticCorpus.file(corpus, SyntheticCorpus.Kind.NATURAL, 1, "png", SOURCE_SEED);
+        outputFile = Files.createTempFile("aichat-e2e", "." + format);
+
+        // Inputs for the single-stage benchmarks
+        sourcePalette = engine.analyze(load(sourceFile), PALETTE_SIZE);
+        targetImage = load(targetFile);
+        targetPalette = engine.analyze(targetImage, PALETTE_SIZE);
+        resultImage = engine.resynthesize(targetImage, sourcePalette, targetPalette);
+    }
+
+    @TearDown(Level.Trial)
+    public void tearDown() throws IOException {
+        Files.deleteIfExists(outputFile);
+    }
+
+    @Setup(Level.Iteration)
+    public void resetPeakRss() {
+        PeakRss.reset();
+    }
+
+    @TearDown(Level.Iteration)
+    public void recordPeakRss(BenchmarkParams params) throws IOException {
+        long peakKb = PeakRss.readKb();
+        if (peakKb < 0) return;
+
+        Path csv = Path.of(System.getProperty("aichat.jmh.dir", "test-results/jmh"), "e2e-rss.csv");
+        Files.createDirectories(csv.getParent());
+        if (!Files.exists(csv)) {
+            Files.writeString(csv, "stage,kind,megapixels,format,peak_rss_mb\n");
+        }
+        String stage = params.getBenchmark().substring(params.getBenchmark().lastIndexOf('.') + 1);
+        Files.writeString(csv, String.format("%s,%s,%d,%s,%.1f%n", stage, kind, megapixels, format, peakKb / 1024.0),
+            StandardOpenOption.APPEND);
+    }
+
+    @Benchmark
+    public BufferedImage load() throws IOException {
+        return load(targetFile);
+    }
+
+    @Benchmark
+    public ColorPalette analyze() {
+        return engine.analyze(targetImage, PALETTE_SIZE);
+    }
+
+    @Benchmark
+    public BufferedImage resynthesize() {
+        return engine.resynthesize(targetImage, sourcePalette, targetPalette);
+    }
+
+    @Benchmark
+    public void save() throws IOException {
+        save(resultImage);
+    }
+
+    @Benchmark
+    public void pipeline() throws IOException {
+        BufferedImage image = load(targetFile);
+        ColorPalette palette = engine.analyze(image, PALETTE_SIZE);
+        save(engine.resynthesize(image, sourcePalette, palette));
+    }
+
+    /** Same decode order as the UI: TurboJPEG for JPEGs when present, else ImageIO. */
+    private BufferedImage load(Path file) throws IOException {
+        if (file.toString().endsWith(".jpg") && accel.hasTurboJpeg()) {
+            NativeAccelerator.DecodedImage decoded = accel.decodeJpeg(file.toString());
+            if (decoded != null) {
+                BufferedImage image = new BufferedImage(decoded.width(), decoded.height(), BufferedImage.TYPE_INT_ARGB);
+                image.setRGB(0, 0, decoded.width(), decoded.height(), decoded.pixels(), 0, decoded.width());
+                return image;
+            }
+        }
+        return ImageIO.read(file.toFile());
+    }
+
+    private void save(BufferedImage image) throws IOException {
+        if ("jpg".equals(format)) {
+            if (accel.hasTurboJpeg() && accel.saveJpeg(image, JPEG_QUALITY, outputFile.toString())) {
+                return;
+            }
+            ImageIO.write(withoutAlpha(image), "JPEG", outputFile.toFile());
+        } else {
+            ImageIO.write(image, "PNG", outputFile.toFile());
+        }
+    }
+
+    // ImageIO's JPEG writer rejects images with an alpha channel
+    private static BufferedImage withoutAlpha(BufferedImage image) {
+        if (!image.getColorModel().hasAlpha()) return image;
+        BufferedImage rgb = new BufferedImage(image.getWidth(), image.getHeight(), BufferedImage.TYPE_INT_RGB);
+        rgb.createGraphics().drawImage(image, 0, 0, null);
+        return rgb;
+    }
+
+    /**
+     * Process peak resident set size from /proc: writing 5 to clear_refs
+     * resets VmHWM, so each iteration sees only its own peak.
+     */
+    static final class PeakRss {
+        private static final Path STATUS = Path.of("/proc/self/status");
+        private static final Path CLEAR_REFS = Path.of("/proc/self/clear_refs");
+
+        static void reset() {
+            try {
+                Files.writeString(CLEAR_REFS, "5");
+            } catch (IOException | UnsupportedOperationException e) {
+                // Not Linux or not permitted: peaks then cover the whole fork
+            }
+        }
+
+        static long readKb() {
+            try {
+                List<String> lines = Files.readAllLines(STATUS);
+                for (String line : lines) {
+                    if (line.startsWith("VmHWM:")) {
+                        return Long.parseLong(line.replaceAll("[^0-9]", ""));
+                    }
+                }
+            } catch (IOException | NumberFormatException e) {
+                // Fall through
+            }
+            return -1;
+        }
+    }
+}
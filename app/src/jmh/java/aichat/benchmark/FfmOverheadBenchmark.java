@@ -0,0 +1,411 @@
+package aichat.benchmark;
+
+import aichat.model.ColorPalette;
+import aichat.model.ColorPoint;
+import aichat.native_.NativeAccelerator;
+import aichat.native_.NativeLibrary;
+import org.openjdk.jmh.annotations.*;
+import org.openjdk.jmh.infra.Blackhole;
+
+import java.lang.foreign.Arena;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.ValueLayout;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Random;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * JMH Benchmark: FFM marshalling overhead. Each native call is split into
+ * marshal-in (flatten + Arena allocation + copy), the bare downcall on
+ * preallocated segments, and marshal-out (copy back + boxing), next to the
+ * full NativeAccelerator call and an empty downcall baseline, for every
+ * NativeAccelerator entry point: color conversion both ways, assignment,
+ * k-means, hybrid clustering, resynthesis, posterization and image sampling.
+ * Run with {@code ./gradlew jmhFfmOverhead} for GC and allocation profiling.
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@State(Scope.Benchmark)
+@Fork(value = 1, warmups = 0)
+@Warmup(iterations = 2, time = 1)
+@Measurement(iterations = 3, time = 1)
+public class FfmOverheadBenchmark {
+
+    private static final int CENTROIDS = 64;
+    private static final int IMAGE_WIDTH = 1000;
+    private static final int KMEANS_ITERATIONS = 20;
+    private static final float KMEANS_THRESHOLD = 0.5f;
+    private static final int HYBRID_BLOCK_SIZE = 1000;
+    private static final int HYBRID_MIN_PTS = 3;
+    private static final int SAMPLES = 10000;
+    private static final long SEED = 42L;
+
+    @Param({"1000", "100000", "1000000"})
+    private int size;
+
+    private NativeLibrary nativeLib;
+    private NativeAccelerator accel;
+
+    private List<ColorPoint> points;
+    private List<ColorPoint> labPoints;
+    private List<ColorPoint> centroids;
+    private ColorPalette targetPalette;
+    private ColorPalette sourcePalette;
+    private int[] pixels;
+    private int width;
+    private int height;
+
+    // Preallocated native buffers so the downcall benchmarks time only the call
+    private Arena arena;
+    private MemorySegment pointsNative;
+    private MemorySegment labNative;
+    private MemorySegment centroidsNative;
+    private MemorySegment assignmentsNative;
+    private MemorySegment pixelsNative;
+    private MemorySegment targetPaletteNative;
+    private MemorySegment sourcePaletteNative;
+    private MemorySegment outputNative;
+    private MemorySegment rgbNative;
+    private MemorySegment clusterCentroidsNative;
+    private MemorySegment kmeansAssignmentsNative;
+    private MemorySegment samplesNative;
+    private float hybridEps;
+
+    @Setup(Level.Trial)
+    public void setup() {
+        accel = NativeAccelerator.getInstance();
+        if (!accel.isAvailable()) {
+            throw new IllegalStateException("FfmOverheadBenchmark needs the native library");
+        }
+        nativeLib = NativeLibrary.getInstance();
+        nativeLib.setLutCacheEnabled(false);
+
+        Random random = new Random(42L);
+        points = randomPoints(size, random);
+        centroids = randomPoints(CENTROIDS, random);
+        targetPalette = new ColorPalette(randomPoints(CENTROIDS, random));
+        sourcePalette = new ColorPalette(randomPoints(CENTROIDS, random));
+
+        width = Math.min(size, IMAGE_WIDTH);
+        height = size / width;
+        pixels = new int[width * height];
+        for (int i = 0; i < pixels.length; i++) {
+            pixels[i] = 0xFF000000 | random.nextInt(0x1000000);
+        }
+
+        // Shared: JMH may run setup and the benchmark on different threads
+        arena = Arena.ofShared();
+        pointsNative = toNative(arena, NativeAccelerator.colorPointsToFloatArray(points));
+        labNative = arena.allocate(ValueLayout.JAVA_FLOAT, size * 3L);
+        centroidsNative = toNative(arena, NativeAccelerator.colorPointsToFloatArray(centroids));
+        assignmentsNative = arena.allocate(ValueLayout.JAVA_INT, size);
+        pixelsNative = arena.allocate(ValueLayout.JAVA_INT, pixels.length);
+        pixelsNative.copyFrom(MemorySegment.ofArray(pixels));
+        targetPaletteNative = toNative(arena, NativeAccelerator.colorPointsToFloatArray(targetPalette.getColors()));
+        sourcePaletteNative = toNative(arena, NativeAccelerator.colorPointsToFloatArray(sourcePalette.getColors()));
+        outputNative = arena.allocate(ValueLayout.JAVA_INT, pixels.length);
+        rgbNative = arena.allocate(ValueLayout.JAVA_FLOAT, size * 3L);
+        clusterCentroidsNative = arena.allocate(NativeLibrary.COLOR_POINT_LAYOUT, CENTROIDS);
+        kmeansAssignmentsNative = arena.allocate(ValueLayout.JAVA_INT, size);
+        samplesNative = arena.allocate(NativeLibrary.COLOR_POINT_LAYOUT, Math.min(SAMPLES, pixels.length));
+        // The hybrid downcall is timed alone; its eps estimate is a separate native call
+        hybridEps = nativeLib.hybridCalculateEps(arena, NativeAccelerator.colorPointsToFloatArray(points),
+            HYBRID_BLOCK_SIZE, HYBRID_MIN_PTS, SEED);
+
+        nativeLib.rgbToLabBatch(pointsNative, labNative, size);
+        nativeLib.assignPointsBatch(pointsNative, size, centroidsNative, CENTROIDS, assignmentsNative);
+        nativeLib.resynthesizeImage(pixelsNative, width, height,
+            targetPaletteNative, sourcePaletteNative, CENTROIDS, outputNative);
+        labPoints = accel.rgbToLabBatch(points);
+        nativeLib.labToRgbBatch(labNative, rgbNative, size);
+        nativeLib.posterizeImage(pixelsNative, width, height,
+            targetPaletteNative, sourcePaletteNative, CENTROIDS, outputNative);
+        nativeLib.samplePixelsFromImage(pixelsNative, pixels.length, samplesNative, SAMPLES, SEED);
+    }
+
+    @TearDown(Level.Trial)
+    public void tearDown() {
+        arena.close();
+    }
+
+    // --- Baselines ---
+
+    @Benchmark
+    public int noop_downcall() {
+        return nativeLib.noop(pointsNative, size);
+    }
+
+    @Benchmark
+    public void arena_allocate(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            bh.consume(a.allocate(ValueLayout.JAVA_FLOAT, size * 3L));
+        }
+    }
+
+    // --- rgb_to_lab_batch ---
+
+    @Benchmark
+    public void rgbToLab_marshalIn(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            float[] flat = NativeAccelerator.colorPointsToFloatArray(points);
+            MemorySegment rgb = toNative(a, flat);
+            MemorySegment lab = a.allocate(ValueLayout.JAVA_FLOAT, flat.length);
+            bh.consume(rgb);
+            bh.consume(lab);
+        }
+    }
+
+    @Benchmark
+    public void rgbToLab_downcall() {
+        nativeLib.rgbToLabBatch(pointsNative, labNative, size);
+    }
+
+    @Benchmark
+    public List<ColorPoint> rgbToLab_marshalOut() {
+        float[] result = new float[size * 3];
+        MemorySegment.ofArray(result).copyFrom(labNative);
+        return NativeAccelerator.floatArrayToColorPoints(result);
+    }
+
+    @Benchmark
+    public List<ColorPoint> rgbToLab_endToEnd() {
+        return accel.rgbToLabBatch(points);
+    }
+
+    // --- assign_points_batch ---
+
+    @Benchmark
+    public void assign_marshalIn(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            MemorySegment p = toNative(a, NativeAccelerator.colorPointsToFloatArray(points));
+            MemorySegment c = toNative(a, NativeAccelerator.colorPointsToFloatArray(centroids));
+            MemorySegment assignments = a.allocate(ValueLayout.JAVA_INT, size);
+            for (int i = 0; i < size; i++) {
+                assignments.setAtIndex(ValueLayout.JAVA_INT, i, -1);
+            }
+            bh.consume(p);
+            bh.consume(c);
+            bh.consume(assignments);
+        }
+    }
+
+    @Benchmark
+    public int assign_downcall() {
+        return nativeLib.assignPointsBatch(pointsNative, size, centroidsNative, CENTROIDS, assignmentsNative);
+    }
+
+    @Benchmark
+    public int[] assign_marshalOut() {
+        int[] result = new int[size];
+        MemorySegment.ofArray(result).copyFrom(assignmentsNative);
+        return result;
+    }
+
+    @Benchmark
+    public int[] assign_endToEnd() {
+        return accel.assignPointsBatch(points, centroids);
+    }
+
+    // --- resynthesize_image ---
+
+    @Benchmark
+    public void resynthesize_marshalIn(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            MemorySegment image = a.allocate(ValueLayout.JAVA_INT, pixels.length);
+            image.copyFrom(MemorySegment.ofArray(pixels));
+            MemorySegment target = toNative(a, NativeAccelerator.colorPointsToFloatArray(targetPalette.getColors()));
+            MemorySegment source = toNative(a, NativeAccelerator.colorPointsToFloatArray(sourcePalette.getColors()));
+            MemorySegment output = a.allocate(ValueLayout.JAVA_INT, pixels.length);
+            bh.consume(image);
+            bh.consume(target);
+            bh.consume(source);
+            bh.consume(output);
+        }
+    }
+
+    @Benchmark
+    public void resynthesize_downcall() {
+        nativeLib.resynthesizeImage(pixelsNative, width, height,
+            targetPaletteNative, sourcePaletteNative, CENTROIDS, outputNative);
+    }
+
+    @Benchmark
+    public int[] resynthesize_marshalOut() {
+        int[] result = new int[pixels.length];
+        MemorySegment.ofArray(result).copyFrom(outputNative);
+        return result;
+    }
+
+    @Benchmark
+    public int[] resynthesize_endToEnd() {
+        return accel.resynthesizeImage(pixels, width, height, targetPalette, sourcePalette);
+    }
+
+    // --- lab_to_rgb_batch ---
+
+    @Benchmark
+    public void labToRgb_marshalIn(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            float[] flat = NativeAccelerator.colorPointsToFloatArray(labPoints);
+            MemorySegment lab = toNative(a, flat);
+            MemorySegment rgb = a.allocate(ValueLayout.JAVA_FLOAT, flat.length);
+            bh.consume(lab);
+            bh.consume(rgb);
+        }
+    }
+
+    @Benchmark
+    public void labToRgb_downcall() {
+        nativeLib.labToRgbBatch(labNative, rgbNative, size);
+    }
+
+    @Benchmark
+    public List<ColorPoint> labToRgb_marshalOut() {
+        float[] result = new float[size * 3];
+        MemorySegment.ofArray(result).copyFrom(rgbNative);
+        return NativeAccelerator.floatArrayToColorPoints(result);
+    }
+
+    @Benchmark
+    public List<ColorPoint> labToRgb_endToEnd() {
+        return accel.labToRgbBatch(labPoints);
+    }
+
+    // --- kmeans_cluster ---
+
+    @Benchmark
+    public void kmeans_marshalIn(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            MemorySegment p = toNative(a, NativeAccelerator.colorPointsToFloatArray(points));
+            MemorySegment c = a.allocate(NativeLibrary.COLOR_POINT_LAYOUT, CENTROIDS);
+            MemorySegment assignments = a.allocate(ValueLayout.JAVA_INT, size);
+            bh.consume(p);
+            bh.consume(c);
+            bh.consume(assignments);
+        }
+    }
+
+    @Benchmark
+    public int kmeans_downcall() {
+        return nativeLib.kmeansCluster(pointsNative, size, CENTROIDS, KMEANS_ITERATIONS, KMEANS_THRESHOLD,
+            clusterCentroidsNative, kmeansAssignmentsNative, SEED);
+    }
+
+    @Benchmark
+    public List<ColorPoint> kmeans_marshalOut() {
+        return centroidsOut();
+    }
+
+    @Benchmark
+    public List<ColorPoint> kmeans_endToEnd() {
+        return accel.kmeansCluster(points, CENTROIDS, KMEANS_ITERATIONS, KMEANS_THRESHOLD, SEED);
+    }
+
+    // --- hybrid_cluster_bounded ---
+
+    @Benchmark
+    public void hybrid_marshalIn(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            MemorySegment p = toNative(a, NativeAccelerator.colorPointsToFloatArray(points));
+            MemorySegment c = a.allocate(NativeLibrary.COLOR_POINT_LAYOUT, CENTROIDS);
+            bh.consume(p);
+            bh.consume(c);
+        }
+    }
+
+    @Benchmark
+    public int hybrid_downcall() {
+        return nativeLib.hybridCluster(pointsNative, size, CENTROIDS, HYBRID_BLOCK_SIZE, hybridEps,
+            HYBRID_MIN_PTS, 100, KMEANS_THRESHOLD, 0, clusterCentroidsNative, SEED);
+    }
+
+    @Benchmark
+    public List<ColorPoint> hybrid_marshalOut() {
+        return centroidsOut();
+    }
+
+    /** Includes the eps estimate, which the downcall phase leaves out. */
+    @Benchmark
+    public List<ColorPoint> hybrid_endToEnd() {
+        return accel.hybridCluster(points, CENTROIDS, HYBRID_BLOCK_SIZE, HYBRID_MIN_PTS, SEED);
+    }
+
+    // --- posterize_image ---
+
+    @Benchmark
+    public void posterize_marshalIn(Blackhole bh) {
+        resynthesize_marshalIn(bh);
+    }
+
+    @Benchmark
+    public void posterize_downcall() {
+        nativeLib.posterizeImage(pixelsNative, width, height,
+            targetPaletteNative, sourcePaletteNative, CENTROIDS, outputNative);
+    }
+
+    @Benchmark
+    public int[] posterize_marshalOut() {
+        return resynthesize_marshalOut();
+    }
+
+    @Benchmark
+    public int[] posterize_endToEnd() {
+        return accel.posterizeImage(pixels, width, height, targetPalette, sourcePalette);
+    }
+
+    // --- sample_pixels_from_image ---
+
+    @Benchmark
+    public void sample_marshalIn(Blackhole bh) {
+        try (Arena a = Arena.ofConfined()) {
+            MemorySegment image = a.allocate(ValueLayout.JAVA_INT, pixels.length);
+            image.copyFrom(MemorySegment.ofArray(pixels));
+            MemorySegment output = a.allocate(NativeLibrary.COLOR_POINT_LAYOUT, Math.min(SAMPLES, pixels.length));
+            bh.consume(image);
+            bh.consume(output);
+        }
+    }
+
+    @Benchmark
+    public int sample_downcall() {
+        return nativeLib.samplePixelsFromImage(pixelsNative, pixels.length, samplesNative, SAMPLES, SEED);
+    }
+
+    @Benchmark
+    public List<ColorPoint> sample_marshalOut() {
+        // ColorPoint3f has no padding, so the struct array reads as flat floats
+        float[] result = new float[(int) (samplesNative.byteSize() / 4)];
+        MemorySegment.ofArray(result).copyFrom(samplesNative);
+        return NativeAccelerator.floatArrayToColorPoints(result);
+    }
+
+    @Benchmark
+    public List<ColorPoint> sample_endToEnd() {
+        return accel.samplePixelsFromImage(pixels, SAMPLES, SEED);
+    }
+
+    private List<ColorPoint> centroidsOut() {
+        float[] result = new float[CENTROIDS * 3];
+        MemorySegment.ofArray(result).copyFrom(clusterCentroidsNative);
+        return NativeAccelerator.floatArrayToColorPoints(result);
+    }
+
+    private static MemorySegment toNative(Arena arena, float[] values) {
+        MemorySegment segment = arena.allocate(ValueLayout.JAVA_FLOAT, values.length);
+        segment.copyFrom(MemorySegment.ofArray(values));
+        return segment;
+    }
+
+    private static List<ColorPoint> randomPoints(int count, Random random) {
+        List<ColorPoint> result = new ArrayList<>(count);
+        for (int i = 0; i < count; i++) {
+            result.add(new ColorPoint(
+                random.nextDouble() * 255,
+                random.nextDouble() * 255,
+                random.nextDouble() * 255
+            ));
+        }
+        return result;
+    }
+}
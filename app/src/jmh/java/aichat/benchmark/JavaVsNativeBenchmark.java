@@ -55,6 +55,12 @@ public class JavaVsNativeBenchmark {
         bh.consume(ColorSpaceConverter.rgbToLabBatch(testPoints));
     }
 
+    @Benchmark
+    @Fork(value = 1, jvmArgsAppend = {"-Dforce.java=true", "-Daichat.java.vector=false"})
+    public void colorConversion_JavaScalar(Blackhole bh) {
+        bh.consume(ColorSpaceConverter.rgbToLabBatch(testPoints));
+    }
+
     @Benchmark
     @Fork(value = 1, jvmArgsAppend = {"-Dforce.java=true"})
     public void clustering_Java(Blackhole bh) {
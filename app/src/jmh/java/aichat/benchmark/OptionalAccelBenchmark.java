@@ -4,6 +4,7 @@ import aichat.core.ImageHarmonyEngine;
 import aichat.core.ImageHarmonyEngine.ColorModel;
 import aichat.model.ColorPalette;
 import aichat.native_.NativeAccelerator;
+import aichat.native_.NativeLibrary;
 import org.openjdk.jmh.annotations.*;
 import org.openjdk.jmh.infra.Blackhole;
 
@@ -48,6 +49,8 @@ public class OptionalAccelBenchmark {
     @Setup(Level.Trial)
     public void setup() throws IOException {
         accel = NativeAccelerator.getInstance();
+        // CPU resynthesis builds its LUT every call, as the GPU path does
+        NativeLibrary.getInstance().setLutCacheEnabled(false);
         engine = new ImageHarmonyEngine(ColorModel.CIELAB, 42L);
         
         openclAvailable = accel.hasOpenCL();
@@ -0,0 +1,290 @@
+package aichat.benchmark;
+
+import aichat.color.ColorSpaceConverter;
+import aichat.native_.NativeLibrary;
+
+import javax.imageio.ImageIO;
+import java.awt.image.BufferedImage;
+import java.io.IOException;
+import java.lang.foreign.Arena;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * Quality-versus-speed sweep over the analysis and resynthesis knobs: sample
+ * budget, DBSCAN eps, block size, k-means iterations and palette LUT
+ * resolution (plus the GPU path when OpenCL is present). Every configuration
+ * is scored by wall time, palette inertia and mean CIEDE2000 against the
+ * maximum-quality result, and the non-dominated ones form the Pareto frontier.
+ * Writes {@code pareto.json} to the JMH results directory. Run with
+ * {@code ./gradlew paretoSweep}.
+ */
+public final class ParetoSweep {
+
+    private static final int PALETTE_SIZE = 16;
+    private static final int MIN_PTS = 3;
+    private static final float KMEANS_THRESHOLD = 0.5f;
+    private static final long SEED = 42L;
+    private static final int REPS = 3;
+    private static final int EVAL_SAMPLES = 50_000;
+    private static final int DELTA_E_SAMPLES = 65_536;
+
+    private static final int[] SAMPLE_BUDGETS = {2_000, 10_000, 50_000, 200_000};
+    private static final double[] EPS_SCALES = {0.5, 1.0, 2.0};
+    private static final int[] BLOCK_SIZES = {500, 1_000, 4_000};
+    private static final int[] MAX_ITERATIONS = {5, 20, 100};
+    private static final int[] LUT_BITS = {5, 6, 7, 8};
+    // opencl_resynthesize_image always builds a 7-bit LUT
+    private static final int GPU_LUT_BITS = 7;
+
+    record Analysis(int samples, double epsScale, int blockSize, int maxIter) {}
+
+    record Point(String image, Analysis analysis, String backend, int lutBits,
+                 double analyzeMs, double resynthMs, double inertia, double deltaE) {
+        double totalMs() {
+            return analyzeMs + resynthMs;
+        }
+
+        boolean dominates(Point o) {
+            boolean noWorse = totalMs() <= o.totalMs() && deltaE <= o.deltaE && inertia <= o.inertia;
+            boolean better = totalMs() < o.totalMs() || deltaE < o.deltaE || inertia < o.inertia;
+            return noWorse && better;
+        }
+    }
+
+    private final NativeLibrary lib = NativeLibrary.getInstance();
+    private final boolean gpu;
+
+    private ParetoSweep() {
+        if (!lib.isLoaded()) {
+            throw new IllegalStateException("ParetoSweep needs the native library");
+        }
+        gpu = lib.hasOpenCL() && lib.initOpenCL();
+        // Repetitions would otherwise reuse the first run's LUT
+        lib.setLutCacheEnabled(false);
+    }
+
+    public static void main(String[] args) throws IOException {
+        Path corpus = Path.of(System.getProperty("aichat.corpus.dir", "build/corpus"));
+        Path out = Path.of(System.getProperty("aichat.jmh.dir", "test-results/jmh"), "pareto.json");
+
+        ParetoSweep sweep = new ParetoSweep();
+        float[] sourcePalette = sweep.sourcePalette(corpus);
+
+        List<Point> points = new ArrayList<>();
+        for (SyntheticCorpus.Kind kind : List.of(SyntheticCorpus.Kind.NATURAL, SyntheticCorpus.Kind.FLAT)) {
+            Path file = SyntheticCorpus.file(corpus, kind, 1, "png", 1L);
+            points.addAll(sweep.sweepImage(kind.name(), ImageIO.read(file.toFile()), sourcePalette));
+        }
+
+        boolean[] frontier = frontier(points);
+        Files.createDirectories(out.getParent());
+        Files.writeString(out, toJson(points, frontier, sweep.gpu));
+        printFrontier(points, frontier);
+        System.out.println("Wrote " + points.size() + " configurations to " + out);
+    }
+
+    private List<Point> sweepImage(String name, BufferedImage image, float[] sourcePalette) {
+        int width = image.getWidth();
+        int height = image.getHeight();
+        int[] pixels = image.getRGB(0, 0, width, height, null, 0, width);
+
+        float[] evalSample;
+        try (Arena arena = Arena.ofConfined()) {
+            evalSample = lib.samplePixelsFromImage(arena, pixels, EVAL_SAMPLES, SEED + 1);
+        }
+
+        // Reference: the most expensive analysis, resynthesized with the exact 8-bit LUT
+        Analysis best = new Analysis(SAMPLE_BUDGETS[SAMPLE_BUDGETS.length - 1], 1.0,
+            BLOCK_SIZES[BLOCK_SIZES.length - 1], MAX_ITERATIONS[MAX_ITERATIONS.length - 1]);
+        float[] referenceLab = toLab(strided(resynthesize(pixels, width, height, analyze(pixels, best),
+            sourcePalette, 8), DELTA_E_SAMPLES));
+
+        List<Point> points = new ArrayList<>();
+        for (int samples : SAMPLE_BUDGETS) {
+            for (double epsScale : EPS_SCALES) {
+                for (int blockSize : BLOCK_SIZES) {
+                    for (int maxIter : MAX_ITERATIONS) {
+                        Analysis analysis = new Analysis(samples, epsScale, blockSize, maxIter);
+                        float[][] palette = new float[1][];
+                        double analyzeMs = medianMs(() -> palette[0] = analyze(pixels, analysis));
+                        double inertia = inertia(evalSample, palette[0]);
+
+                        for (int bits : LUT_BITS) {
+                            int[][] result = new int[1][];
+                            double resynthMs = medianMs(() ->
+                                result[0] = resynthesize(pixels, width, height, palette[0], sourcePalette, bits));
+                            points.add(new Point(name, analysis, "cpu", bits, analyzeMs, resynthMs, inertia,
+                                meanDeltaE(referenceLab, strided(result[0], DELTA_E_SAMPLES))));
+                        }
+
+                        if (gpu) {
+                            int[][] result = new int[1][];
+                            double resynthMs = medianMs(() ->
+                                result[0] = resynthesizeGpu(pixels, width, height, palette[0], sourcePalette));
+                            if (result[0] != null) {
+                                points.add(new Point(name, analysis, "gpu", GPU_LUT_BITS, analyzeMs, resynthMs,
+                                    inertia, meanDeltaE(referenceLab, strided(result[0], DELTA_E_SAMPLES))));
+                            }
+                        }
+                    }
+                }
+            }
+            System.out.printf("[%s] samples=%d done%n", name, samples);
+        }
+        return points;
+    }
+
+    /** Target palette of the given analysis, sorted by luminance to line up with the source palette. */
+    private float[] analyze(int[] pixels, Analysis a) {
+        try (Arena arena = Arena.ofConfined()) {
+            float[] samples = lib.samplePixelsFromImage(arena, pixels, a.samples(), SEED);
+            float eps = (float) (lib.hybridCalculateEps(arena, samples, a.blockSize(), MIN_PTS, SEED) * a.epsScale());
+            return sortByLuminance(lib.hybridCluster(arena, samples, PALETTE_SIZE, a.blockSize(), eps, MIN_PTS,
+                a.maxIter(), KMEANS_THRESHOLD, SEED));
+        }
+    }
+
+    private int[] resynthesize(int[] pixels, int width, int height, float[] target, float[] source, int bits) {
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.resynthesizeImage(arena, pixels, width, height, target, source, bits);
+        }
+    }
+
+    private int[] resynthesizeGpu(int[] pixels, int width, int height, float[] target, float[] source) {
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.resynthesizeImageGPU(arena, pixels, width, height, target, source);
+        }
+    }
+
+    private float[] sourcePalette(Path corpus) throws IOException {
+        Path file = SyntheticCorpus.file(corpus, SyntheticCorpus.Kind.NATURAL, 1, "png", 2L);
+        BufferedImage image = ImageIO.read(file.toFile());
+        int[] pixels = image.getRGB(0, 0, image.getWidth(), image.getHeight(), null, 0, image.getWidth());
+        return analyze(pixels, new Analysis(SAMPLE_BUDGETS[SAMPLE_BUDGETS.length - 1], 1.0,
+            BLOCK_SIZES[BLOCK_SIZES.length - 1], MAX_ITERATIONS[MAX_ITERATIONS.length - 1]));
+    }
+
+    /** Mean squared RGB distance from each evaluation point to its nearest palette color. */
+    private double inertia(float[] points, float[] palette) {
+        int[] assignments;
+        try (Arena arena = Arena.ofConfined()) {
+            assignments = lib.assignPointsBatch(arena, points, palette);
+        }
+        double sum = 0;
+        for (int i = 0; i < assignments.length; i++) {
+            int c = assignments[i] * 3;
+            double dr = points[i * 3] - palette[c];
+            double dg = points[i * 3 + 1] - palette[c + 1];
+            double db = points[i * 3 + 2] - palette[c + 2];
+            sum += dr * dr + dg * dg + db * db;
+        }
+        return sum / assignments.length;
+    }
+
+    private double meanDeltaE(float[] referenceLab, int[] pixels) {
+        float[] deltaE = ColorSpaceConverter.deltaE2000Batch(referenceLab, toLab(pixels));
+        double sum = 0;
+        for (float d : deltaE) {
+            sum += d;
+        }
+        return sum / deltaE.length;
+    }
+
+    private float[] toLab(int[] pixels) {
+        float[] rgb = new float[pixels.length * 3];
+        for (int i = 0; i < pixels.length; i++) {
+            rgb[i * 3] = (pixels[i] >> 16) & 0xFF;
+            rgb[i * 3 + 1] = (pixels[i] >> 8) & 0xFF;
+            rgb[i * 3 + 2] = pixels[i] & 0xFF;
+        }
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.rgbToLabBatch(arena, rgb);
+        }
+    }
+
+    /** Every n-th pixel, so about {@code count} pixels spread over the whole image. */
+    private static int[] strided(int[] pixels, int count) {
+        int stride = Math.max(1, pixels.length / count);
+        int[] result = new int[(pixels.length + stride - 1) / stride];
+        for (int i = 0; i < result.length; i++) {
+            result[i] = pixels[i * stride];
+        }
+        return result;
+    }
+
+    private static float[] sortByLuminance(float[] palette) {
+        Integer[] order = new Integer[palette.length / 3];
+        for (int i = 0; i < order.length; i++) order[i] = i;
+        Arrays.sort(order, Comparator.comparingDouble(i ->
+            0.299 * palette[i * 3] + 0.587 * palette[i * 3 + 1] + 0.114 * palette[i * 3 + 2]));
+
+        float[] sorted = new float[palette.length];
+        for (int i = 0; i < order.length; i++) {
+            System.arraycopy(palette, order[i] * 3, sorted, i * 3, 3);
+        }
+        return sorted;
+    }
+
+    private static double medianMs(Runnable task) {
+        task.run(); // warmup
+        double[] times = new double[REPS];
+        for (int r = 0; r < REPS; r++) {
+            long start = System.nanoTime();
+            task.run();
+            times[r] = (System.nanoTime() - start) / 1e6;
+        }
+        Arrays.sort(times);
+        return times[REPS / 2];
+    }
+
+    /** Non-dominated points, per image: lower time, deltaE and inertia are all better. */
+    static boolean[] frontier(List<Point> points) {
+        boolean[] result = new boolean[points.size()];
+        for (int i = 0; i < points.size(); i++) {
+            Point p = points.get(i);
+            result[i] = points.stream().noneMatch(o -> o.image().equals(p.image()) && o.dominates(p));
+        }
+        return result;
+    }
+
+    private static void printFrontier(List<Point> points, boolean[] frontier) {
+        System.out.printf("%n%-8s %8s %6s %6s %5s %-4s %4s %10s %10s %8s%n",
+            "image", "samples", "eps×", "block", "iter", "path", "lut", "total_ms", "inertia", "dE00");
+        for (int i = 0; i < points.size(); i++) {
+            if (!frontier[i]) continue;
+            Point p = points.get(i);
+            Analysis a = p.analysis();
+            System.out.printf(Locale.ROOT, "%-8s %8d %6.1f %6d %5d %-4s %4d %10.2f %10.2f %8.3f%n",
+                p.image(), a.samples(), a.epsScale(), a.blockSize(), a.maxIter(), p.backend(), p.lutBits(),
+                p.totalMs(), p.inertia(), p.deltaE());
+        }
+    }
+
+    private static String toJson(List<Point> points, boolean[] frontier, boolean gpu) {
+        StringBuilder sb = new StringBuilder();
+        sb.append("{\n  \"paletteSize\": ").append(PALETTE_SIZE)
+          .append(",\n  \"colorModel\": \"RGB\"")
+          .append(",\n  \"gpu\": ").append(gpu)
+          .append(",\n  \"points\": [\n");
+        for (int i = 0; i < points.size(); i++) {
+            Point p = points.get(i);
+            Analysis a = p.analysis();
+            sb.append(String.format(Locale.ROOT,
+                "    {\"image\": \"%s\", \"samples\": %d, \"epsScale\": %.1f, \"blockSize\": %d, "
+                    + "\"maxIter\": %d, \"backend\": \"%s\", \"lutBits\": %d, \"analyzeMs\": %.3f, "
+                    + "\"resynthesizeMs\": %.3f, \"totalMs\": %.3f, \"inertia\": %.4f, \"deltaE2000\": %.5f, "
+                    + "\"frontier\": %b}%s%n",
+                p.image(), a.samples(), a.epsScale(), a.blockSize(), a.maxIter(), p.backend(), p.lutBits(),
+                p.analyzeMs(), p.resynthMs(), p.totalMs(), p.inertia(), p.deltaE(), frontier[i],
+                i + 1 < points.size() ? "," : ""));
+        }
+        sb.append("  ]\n}\n");
+        return sb.toString();
+    }
+}
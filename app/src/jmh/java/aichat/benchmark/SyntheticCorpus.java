@@ -0,0 +1,197 @@
+package aichat.benchmark;
+
+import javax.imageio.ImageIO;
+import java.awt.image.BufferedImage;
+import java.awt.image.DataBufferInt;
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.Random;
+
+/**
+ * Deterministic benchmark images with the color statistics of real inputs
+ * rather than uniform noise. The same kind, size and seed always give the
+ * same pixels, and encoded files are cached so each one is written once.
+ */
+public final class SyntheticCorpus {
+
+    public enum Kind {
+        /** Smooth multi-corner gradients with a vignette: few, slowly varying colors. */
+        GRADIENT,
+        /** Fractal value noise with a roughly 1/f^2 power spectrum, like photographs. */
+        NATURAL,
+        /** Flat shapes from a small palette, like UI screenshots and graphics. */
+        FLAT,
+        /** Uniform 24-bit noise: worst case for palettes and caches. */
+        NOISE
+    }
+
+    private static final int NATURAL_OCTAVES = 7;
+    private static final int FLAT_COLORS = 12;
+    private static final int FLAT_SHAPES = 60;
+
+    private SyntheticCorpus() {}
+
+    /**
+     * Encoded corpus image in {@code dir}, generated on first use.
+     *
+     * @param format "jpg" or "png"
+     */
+    public static Path file(Path dir, Kind kind, int megapixels, String format, long seed) throws IOException {
+        Path path = dir.resolve(String.format("%s-%dmp-%d.%s", kind.name().toLowerCase(), megapixels, seed, format));
+        if (Files.exists(path)) {
+            return path;
+        }
+
+        Files.createDirectories(dir);
+        BufferedImage image = generate(kind, widthFor(megapixels), heightFor(megapixels), seed);
+        Path tmp = Files.createTempFile(dir, "corpus", "." + format);
+        if (!ImageIO.write(image, "jpg".equals(format) ? "JPEG" : "PNG", tmp.toFile())) {
+            Files.deleteIfExists(tmp);
+            throw new IOException("No ImageIO writer for " + format);
+        }
+        return Files.move(tmp, path);
+    }
+
+    /** 4:3 width for the given megapixel count. */
+    public static int widthFor(int megapixels) {
+        return (int) Math.round(Math.sqrt(megapixels * 1_000_000.0 * 4 / 3));
+    }
+
+    public static int heightFor(int megapixels) {
+        return (int) (megapixels * 1_000_000L / widthFor(megapixels));
+    }
+
+    public static BufferedImage generate(Kind kind, int width, int height, long seed) {
+        BufferedImage image = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
+        int[] pixels = ((DataBufferInt) image.getRaster().getDataBuffer()).getData();
+        Random random = new Random(seed);
+
+        switch (kind) {
+            case GRADIENT -> fillGradient(pixels, width, height, random);
+            case NATURAL -> fillNatural(pixels, width, height, random);
+            case FLAT -> fillFlat(pixels, width, height, random);
+            case NOISE -> {
+                for (int i = 0; i < pixels.length; i++) {
+                    pixels[i] = random.nextInt(0x1000000);
+                }
+            }
+        }
+        return image;
+    }
+
+    private static void fillGradient(int[] pixels, int width, int height, Random random) {
+        int[][] corners = new int[4][3];
+        for (int[] corner : corners) {
+            for (int c = 0; c < 3; c++) corner[c] = random.nextInt(256);
+        }
+
+        for (int y = 0; y < height; y++) {
+            float fy = (float) y / Math.max(1, height - 1);
+            for (int x = 0; x < width; x++) {
+                float fx = (float) x / Math.max(1, width - 1);
+                float dx = fx - 0.5f, dy = fy - 0.5f;
+                float vignette = 1.0f - 0.6f * (dx * dx + dy * dy);
+
+                int rgb = 0;
+                for (int c = 0; c < 3; c++) {
+                    float top = corners[0][c] + (corners[1][c] - corners[0][c]) * fx;
+                    float bottom = corners[2][c] + (corners[3][c] - corners[2][c]) * fx;
+                    int v = clamp(Math.round((top + (bottom - top) * fy) * vignette));
+                    rgb = (rgb << 8) | v;
+                }
+                pixels[y * width + x] = rgb;
+            }
+        }
+    }
+
+    /**
+     * Sum of value-noise octaves, each at half the cell size and half the
+     * amplitude of the previous one. Luminance gets most of the energy and the
+     * two chroma fields less, as in photographs.
+     */
+    private static void fillNatural(int[] pixels, int width, int height, Random random) {
+        float[] luma = new float[pixels.length];
+        float[] chromaA = new float[pixels.length];
+        float[] chromaB = new float[pixels.length];
+        int baseCell = Math.max(8, Math.max(width, height) / 4);
+
+        addOctaves(luma, width, height, baseCell, 90f, random);
+        addOctaves(chromaA, width, height, baseCell, 45f, random);
+        addOctaves(chromaB, width, height, baseCell, 45f, random);
+
+        float baseR = 80 + random.nextInt(96), baseG = 80 + random.nextInt(96), baseB = 80 + random.nextInt(96);
+        for (int i = 0; i < pixels.length; i++) {
+            float l = luma[i], a = chromaA[i], b = chromaB[i];
+            int r = clamp(Math.round(baseR + l + a));
+            int g = clamp(Math.round(baseG + l - 0.5f * a + 0.5f * b));
+            int bl = clamp(Math.round(baseB + l - b));
+            pixels[i] = (r << 16) | (g << 8) | bl;
+        }
+    }
+
+    private static void addOctaves(float[] field, int width, int height, int baseCell, float amplitude, Random random) {
+        int cell = baseCell;
+        for (int octave = 0; octave < NATURAL_OCTAVES && cell >= 1; octave++) {
+            int gridW = width / cell + 2;
+            int gridH = height / cell + 2;
+            float[] lattice = new float[gridW * gridH];
+            for (int i = 0; i < lattice.length; i++) {
+                lattice[i] = (random.nextFloat() * 2 - 1) * amplitude;
+            }
+
+            float inv = 1.0f / cell;
+            for (int y = 0; y < height; y++) {
+                int gy = y / cell;
+                float ty = smooth((y - gy * cell) * inv);
+                int row0 = gy * gridW, row1 = row0 + gridW;
+                int offset = y * width;
+                for (int x = 0; x < width; x++) {
+                    int gx = x / cell;
+                    float tx = smooth((x - gx * cell) * inv);
+                    float top = lattice[row0 + gx] + (lattice[row0 + gx + 1] - lattice[row0 + gx]) * tx;
+                    float bottom = lattice[row1 + gx] + (lattice[row1 + gx + 1] - lattice[row1 + gx]) * tx;
+                    field[offset + x] += top + (bottom - top) * ty;
+                }
+            }
+
+            cell /= 2;
+            amplitude *= 0.5f;
+        }
+    }
+
+    private static void fillFlat(int[] pixels, int width, int height, Random random) {
+        int[] palette = new int[FLAT_COLORS];
+        for (int i = 0; i < palette.length; i++) {
+            palette[i] = random.nextInt(0x1000000);
+        }
+        java.util.Arrays.fill(pixels, palette[0]);
+
+        for (int s = 0; s < FLAT_SHAPES; s++) {
+            int color = palette[1 + random.nextInt(FLAT_COLORS - 1)];
+            int w = 1 + random.nextInt(Math.max(1, width / 3));
+            int h = 1 + random.nextInt(Math.max(1, height / 3));
+            int x0 = random.nextInt(width), y0 = random.nextInt(height);
+            boolean ellipse = random.nextBoolean();
+            float rx = w / 2f, ry = h / 2f;
+
+            for (int y = y0; y < Math.min(height, y0 + h); y++) {
+                for (int x = x0; x < Math.min(width, x0 + w); x++) {
+                    if (ellipse) {
+                        float dx = (x - x0 - rx) / rx, dy = (y - y0 - ry) / ry;
+                        if (dx * dx + dy * dy > 1) continue;
+                    }
+                    pixels[y * width + x] = color;
+                }
+            }
+        }
+    }
+
+    private static float smooth(float t) {
+        return t * t * (3 - 2 * t);
+    }
+
+    private static int clamp(int v) {
+        return v < 0 ? 0 : (v > 255 ? 255 : v);
+    }
+}
@@ -0,0 +1,147 @@
+package aichat.benchmark;
+
+import aichat.algorithm.HybridClusterer;
+import aichat.model.ColorPalette;
+import aichat.model.ColorPoint;
+import aichat.native_.NativeAccelerator;
+import aichat.native_.NativeLibrary;
+import org.openjdk.jmh.annotations.*;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Random;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * JMH Benchmark: thread scaling of the parallel kernels. {@code threads} sets
+ * the OpenMP thread count for the native calls and the ForkJoin parallelism
+ * for the Java ones. Run with {@code ./gradlew jmhThreadScaling}, which sweeps
+ * 1..all cores and writes speedup and efficiency next to the raw results.
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@State(Scope.Thread)
+@Fork(value = 1, warmups = 0)
+@Warmup(iterations = 2, time = 1)
+@Measurement(iterations = 3, time = 1)
+public class ThreadScalingBenchmark {
+
+    private static final int CLUSTERS = 16;
+    private static final int PALETTE_SIZE = 64;
+    // Clustering runs on every SAMPLE_STRIDE-th pixel
+    private static final int SAMPLE_STRIDE = 10;
+
+    @Param({"1", "2", "4", "8"})
+    private int threads;
+
+    @Param({"1000", "2000"})
+    private int imageSize;
+
+    private NativeAccelerator accel;
+    private ForkJoinPool pool;
+
+    private int[] pixels;
+    private List<ColorPoint> pixelPoints;
+    private List<ColorPoint> samples;
+    private ColorPalette targetPalette;
+    private ColorPalette sourcePalette;
+    private HybridClusterer clusterer;
+
+    @Setup(Level.Trial)
+    public void setup() {
+        accel = NativeAccelerator.getInstance();
+        if (!accel.isAvailable()) {
+            throw new IllegalStateException("ThreadScalingBenchmark needs the native library");
+        }
+
+        // Time a LUT build per resynthesis, not a cache hit
+        NativeLibrary.getInstance().setLutCacheEnabled(false);
+        pool = new ForkJoinPool(threads);
+        System.out.printf("[Setup] threads=%d, image=%dx%d%n", threads, imageSize, imageSize);
+
+        Random random = new Random(42L);
+        pixels = new int[imageSize * imageSize];
+        pixelPoints = new ArrayList<>(pixels.length);
+        samples = new ArrayList<>(pixels.length / SAMPLE_STRIDE + 1);
+        for (int y = 0; y < imageSize; y++) {
+            for (int x = 0; x < imageSize; x++) {
+                int r = x * 255 / imageSize;
+                int g = y * 255 / imageSize;
+                int b = Math.min(255, (x + y) * 255 / (2 * imageSize) + random.nextInt(16));
+                int i = y * imageSize + x;
+                pixels[i] = 0xFF000000 | (r << 16) | (g << 8) | b;
+
+                ColorPoint p = new ColorPoint(r, g, b);
+                pixelPoints.add(p);
+                if (i % SAMPLE_STRIDE == 0) {
+                    samples.add(p);
+                }
+            }
+        }
+
+        targetPalette = new ColorPalette(randomPoints(PALETTE_SIZE, random));
+        sourcePalette = new ColorPalette(randomPoints(PALETTE_SIZE, random));
+        clusterer = new HybridClusterer(42L);
+    }
+
+    /**
+     * omp_set_num_threads only applies to the calling thread, and JMH does not
+     * promise trial setup runs on the measuring one; iteration setup of a
+     * thread-scoped state does. The count is read back so a setting that did
+     * not take (no OpenMP, a capped runtime) fails the run.
+     */
+    @Setup(Level.Iteration)
+    public void applyThreads() {
+        NativeLibrary lib = NativeLibrary.getInstance();
+        lib.setNumThreads(threads);
+        int effective = lib.setNumThreads(0);
+        if (effective != threads) {
+            throw new IllegalStateException(
+                "OpenMP runs " + effective + " threads on the benchmark thread, expected " + threads);
+        }
+    }
+
+    @TearDown(Level.Trial)
+    public void tearDown() {
+        pool.shutdown();
+    }
+
+    @Benchmark
+    public List<ColorPoint> rgbToLab_Native() {
+        return accel.rgbToLabBatch(pixelPoints);
+    }
+
+    @Benchmark
+    public int[] resynthesize_Native() {
+        return accel.resynthesizeImage(pixels, imageSize, imageSize, targetPalette, sourcePalette);
+    }
+
+    @Benchmark
+    public List<ColorPoint> kmeans_Native() {
+        return accel.kmeansCluster(samples, CLUSTERS, 20, 0.5, 42L);
+    }
+
+    @Benchmark
+    public List<ColorPoint> hybridCluster_Native() {
+        return clusterer.clusterNative(samples, CLUSTERS);
+    }
+
+    @Benchmark
+    public List<ColorPoint> hybridCluster_Java() {
+        // Parallel streams started inside a pool task run on that pool
+        return pool.submit(() -> clusterer.clusterJava(samples, CLUSTERS)).join();
+    }
+
+    private static List<ColorPoint> randomPoints(int count, Random random) {
+        List<ColorPoint> result = new ArrayList<>(count);
+        for (int i = 0; i < count; i++) {
+            result.add(new ColorPoint(
+                random.nextDouble() * 255,
+                random.nextDouble() * 255,
+                random.nextDouble() * 255
+            ));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,118 @@
+package aichat.benchmark;
+
+import aichat.native_.NativeLibrary;
+import org.openjdk.jmh.annotations.*;
+
+import java.lang.foreign.Arena;
+import java.util.Random;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * JMH Benchmark: the scalar, SIMD and OpenMP builds of the native library on
+ * identical workloads. Each variant is loaded through its own SymbolLookup,
+ * so one run compares all of them. Run with {@code ./gradlew jmhVariants}
+ * for the comparison table.
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@State(Scope.Benchmark)
+@Fork(value = 1, warmups = 0)
+@Warmup(iterations = 2, time = 1)
+@Measurement(iterations = 3, time = 1)
+public class VariantComparisonBenchmark {
+
+    private static final int CLUSTERS = 16;
+    private static final int CENTROIDS = 64;
+    private static final int IMAGE_SIZE = 1000;
+
+    @Param({"scalar", "simd", "openmp"})
+    private String variant;
+
+    @Param({"100000"})
+    private int pointCount;
+
+    private NativeLibrary lib;
+    private float[] points;
+    private float[] centroids;
+    private int[] pixels;
+    private float[] targetPalette;
+    private float[] sourcePalette;
+
+    @Setup(Level.Trial)
+    public void setup() {
+        lib = NativeLibrary.forVariant(variant);
+        if (!lib.isLoaded()) {
+            throw new IllegalStateException("Variant library not found: " + variant
+                + " (build it with 'make variants')");
+        }
+        lib.setLutCacheEnabled(false);
+
+        // Same seed for every variant: identical inputs
+        Random random = new Random(42L);
+        points = randomFloats(pointCount * 3, random);
+        centroids = randomFloats(CENTROIDS * 3, random);
+        targetPalette = randomFloats(CENTROIDS * 3, random);
+        sourcePalette = randomFloats(CENTROIDS * 3, random);
+
+        pixels = new int[IMAGE_SIZE * IMAGE_SIZE];
+        for (int y = 0; y < IMAGE_SIZE; y++) {
+            for (int x = 0; x < IMAGE_SIZE; x++) {
+                int r = x * 255 / IMAGE_SIZE;
+                int g = y * 255 / IMAGE_SIZE;
+                int b = random.nextInt(256);
+                pixels[y * IMAGE_SIZE + x] = 0xFF000000 | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+
+    @Benchmark
+    public float[] rgbToLab() {
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.rgbToLabBatch(arena, points);
+        }
+    }
+
+    @Benchmark
+    public int[] assignPoints() {
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.assignPointsBatch(arena, points, centroids);
+        }
+    }
+
+    @Benchmark
+    public float[] kmeans() {
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.kmeansCluster(arena, points, CLUSTERS, 20, 0.5f, 42L);
+        }
+    }
+
+    @Benchmark
+    public float[] hybridCluster() {
+        try (Arena arena = Arena.ofConfined()) {
+            float eps = lib.hybridCalculateEps(arena, points, 1000, 3, 42L);
+            return lib.hybridCluster(arena, points, CLUSTERS, 1000, eps, 3, 100, 0.5f, 42L);
+        }
+    }
+
+    @Benchmark
+    public int[] resynthesize() {
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.resynthesizeImage(arena, pixels, IMAGE_SIZE, IMAGE_SIZE, targetPalette, sourcePalette);
+        }
+    }
+
+    @Benchmark
+    public int[] posterize() {
+        try (Arena arena = Arena.ofConfined()) {
+            return lib.posterizeImage(arena, pixels, IMAGE_SIZE, IMAGE_SIZE, targetPalette, sourcePalette);
+        }
+    }
+
+    private static float[] randomFloats(int count, Random random) {
+        float[] result = new float[count];
+        for (int i = 0; i < count; i++) {
+            result[i] = random.nextFloat() * 255;
+        }
+        return result;
+    }
+}
@@ -0,0 +1,97 @@
+package aichat.algorithm;
+
+/**
+ * Squared-distance scans over {@link PointArrays} for the Java clustering
+ * fallback. Each kernel runs on the Vector API ({@link VectorDistanceKernels})
+ * when the JVM was started with --add-modules jdk.incubator.vector, and as a
+ * plain loop otherwise; both compute the same float sums in the same order,
+ * so the choice never changes a result. Set -Daichat.java.vector=false to
+ * force the loops.
+ */
+final class DistanceKernels {
+
+    static final boolean VECTOR_API =
+        ModuleLayer.boot().findModule("jdk.incubator.vector").isPresent()
+            && !"false".equals(System.getProperty("aichat.java.vector"));
+
+    private DistanceKernels() {}
+
+    /** Points in [from, to) within the radius of (x, y, z); stops counting once {@code limit} is reached. */
+    static int countWithin(PointArrays points, int from, int to,
+                           float x, float y, float z, float radiusSq, int limit) {
+        return VECTOR_API
+            ? VectorDistanceKernels.countWithin(points, from, to, x, y, z, radiusSq, limit)
+            : countWithinScalar(points, from, to, x, y, z, radiusSq, limit, 0);
+    }
+
+    /** Whether any point in [from, to) flagged in {@code only} lies within the radius of (x, y, z). */
+    static boolean anyWithin(PointArrays points, int from, int to,
+                             float x, float y, float z, float radiusSq, boolean[] only) {
+        return VECTOR_API
+            ? VectorDistanceKernels.anyWithin(points, from, to, x, y, z, radiusSq, only)
+            : anyWithinScalar(points, from, to, x, y, z, radiusSq, only);
+    }
+
+    /**
+     * Writes the nearest centroid of each point in [from, to) to
+     * {@code assignments}, the lowest index winning ties, and returns how
+     * many assignments changed.
+     */
+    static int assignNearest(PointArrays points, PointArrays centroids, int from, int to, int[] assignments) {
+        return VECTOR_API
+            ? VectorDistanceKernels.assignNearest(points, centroids, from, to, assignments)
+            : assignNearestScalar(points, centroids, from, to, assignments);
+    }
+
+    /** Lowers {@code distances[i]} to the squared distance from point i to (x, y, z) for i in [from, to). */
+    static void lowerDistances(PointArrays points, int from, int to, float x, float y, float z, float[] distances) {
+        if (VECTOR_API) {
+            VectorDistanceKernels.lowerDistances(points, from, to, x, y, z, distances);
+        } else {
+            lowerDistancesScalar(points, from, to, x, y, z, distances);
+        }
+    }
+
+    static int countWithinScalar(PointArrays points, int from, int to,
+                                 float x, float y, float z, float radiusSq, int limit, int count) {
+        for (int j = from; j < to && count < limit; j++) {
+            if (points.distanceSq(j, x, y, z) <= radiusSq) count++;
+        }
+        return count;
+    }
+
+    static boolean anyWithinScalar(PointArrays points, int from, int to,
+                                   float x, float y, float z, float radiusSq, boolean[] only) {
+        for (int j = from; j < to; j++) {
+            if (only[j] && points.distanceSq(j, x, y, z) <= radiusSq) return true;
+        }
+        return false;
+    }
+
+    static int assignNearestScalar(PointArrays points, PointArrays centroids, int from, int to, int[] assignments) {
+        int changed = 0;
+        for (int i = from; i < to; i++) {
+            int closest = 0;
+            float minDist = centroids.distanceSq(0, points, i);
+            for (int c = 1; c < centroids.size; c++) {
+                float d = centroids.distanceSq(c, points, i);
+                if (d < minDist) {
+                    minDist = d;
+                    closest = c;
+                }
+            }
+            if (assignments[i] != closest) {
+                assignments[i] = closest;
+                changed++;
+            }
+        }
+        return changed;
+    }
+
+    static void lowerDistancesScalar(PointArrays points, int from, int to, float x, float y, float z, float[] distances) {
+        for (int i = from; i < to; i++) {
+            float d = points.distanceSq(i, x, y, z);
+            if (d < distances[i]) distances[i] = d;
+        }
+    }
+}
@@ -0,0 +1,279 @@
+package aichat.algorithm;
+
+import java.util.Arrays;
+import java.util.function.IntConsumer;
+import java.util.stream.IntStream;
+
+/**
+ * DBSCAN over a uniform grid, the Java counterpart of the global DBSCAN in
+ * native/src/hybrid.c. Points are bucketed into cells of side eps/sqrt(3),
+ * so two points sharing a cell are always neighbours and every neighbour of
+ * a point lies within two cells of it. Core detection, cell linking and
+ * border assignment each run per cell on the common ForkJoin pool; clusters
+ * are then joined by a union-find over core cells in cell order, so labels
+ * do not depend on scheduling.
+ */
+final class GridDbscan {
+
+    static final int NOISE = -1;
+
+    private static final int REACH = 2;
+    private static final int SPAN = 2 * REACH + 1;
+    private static final int DENSE_GRID_MIN = 1 << 20;
+    private static final int PARALLEL_CELLS = 64;
+
+    private final int numCells;
+    private final long[] cellKeys;
+    private final int[] cellStart;
+    private final int[] neighborStart;
+    private final int[] neighbors;
+    private final PointArrays sorted;
+    private final int[] sortedIndex;
+
+    private GridDbscan(PointArrays points, float cellSize) {
+        int n = points.size;
+        float[][] channels = { points.c1, points.c2, points.c3 };
+        float[] lo = new float[3];
+        float[] hi = new float[3];
+        for (int d = 0; d < 3; d++) {
+            float[] c = channels[d];
+            float min = c[0];
+            float max = c[0];
+            for (int i = 1; i < n; i++) {
+                if (c[i] < min) min = c[i];
+                if (c[i] > max) max = c[i];
+            }
+            lo[d] = min;
+            hi[d] = max;
+        }
+
+        float invCell = 1.0f / cellSize;
+        long[] dims = new long[3];
+        for (int d = 0; d < 3; d++) {
+            dims[d] = (long) ((hi[d] - lo[d]) * invCell) + 1;
+        }
+
+        long[] keys = new long[n];
+        for (int i = 0; i < n; i++) {
+            long x = Math.min((long) ((points.c1[i] - lo[0]) * invCell), dims[0] - 1);
+            long y = Math.min((long) ((points.c2[i] - lo[1]) * invCell), dims[1] - 1);
+            long z = Math.min((long) ((points.c3[i] - lo[2]) * invCell), dims[2] - 1);
+            keys[i] = (x * dims[1] + y) * dims[2] + z;
+        }
+
+        sortedIndex = sortByKey(keys);
+        sorted = new PointArrays(n);
+        long[] uniqueKeys = new long[n];
+        int[] starts = new int[n + 1];
+        int cells = 0;
+        for (int i = 0; i < n; i++) {
+            int index = sortedIndex[i];
+            if (i == 0 || keys[index] != keys[sortedIndex[i - 1]]) {
+                uniqueKeys[cells] = keys[index];
+                starts[cells] = i;
+                cells++;
+            }
+            sorted.set(i, points, index);
+        }
+        starts[cells] = n;
+        numCells = cells;
+        cellKeys = Arrays.copyOf(uniqueKeys, cells);
+        cellStart = Arrays.copyOf(starts, cells + 1);
+
+        // Small grids get a dense key -> cell table; otherwise binary search
+        long totalCells = dims[0] * dims[1] * dims[2];
+        int[] dense = null;
+        if (totalCells <= Math.max((long) n * 8, DENSE_GRID_MIN)) {
+            dense = new int[(int) totalCells];
+            Arrays.fill(dense, -1);
+            for (int c = 0; c < cells; c++) dense[(int) cellKeys[c]] = c;
+        }
+
+        // Neighbouring cells, in fixed offset order so later scans are deterministic
+        int[] denseTable = dense;
+        int[][] perCell = new int[cells][];
+        forEachCell(c -> perCell[c] = neighborCells(c, dims, denseTable));
+
+        neighborStart = new int[cells + 1];
+        for (int c = 0; c < cells; c++) {
+            neighborStart[c + 1] = neighborStart[c] + perCell[c].length;
+        }
+        neighbors = new int[neighborStart[cells]];
+        for (int c = 0; c < cells; c++) {
+            System.arraycopy(perCell[c], 0, neighbors, neighborStart[c], perCell[c].length);
+        }
+    }
+
+    /**
+     * Labels every point with a cluster id (0..clusters-1, numbered in grid
+     * cell order) or {@link #NOISE} and returns the number of clusters.
+     */
+    static int cluster(PointArrays points, float eps, int minPts, int[] labels) {
+        if (eps <= 0.0f) eps = 1e-3f;
+        return new GridDbscan(points, eps / (float) Math.sqrt(3.0)).label(eps * eps, minPts, labels);
+    }
+
+    private int label(float epsSq, int minPts, int[] labels) {
+        boolean[] core = new boolean[sorted.size];
+        boolean[] cellCore = new boolean[numCells];
+
+        // A cell holding minPts points is core as a whole; otherwise count
+        // neighbours until minPts is reached
+        forEachCell(c -> {
+            int start = cellStart[c];
+            int end = cellStart[c + 1];
+            if (end - start >= minPts) {
+                Arrays.fill(core, start, end, true);
+                cellCore[c] = true;
+                return;
+            }
+            for (int i = start; i < end; i++) {
+                int count = 0;
+                for (int e = neighborStart[c]; e < neighborStart[c + 1] && count < minPts; e++) {
+                    int nc = neighbors[e];
+                    count = DistanceKernels.countWithin(sorted, cellStart[nc], cellStart[nc + 1],
+                        sorted.c1[i], sorted.c2[i], sorted.c3[i], epsSq, minPts - count) + count;
+                }
+                if (count >= minPts) {
+                    core[i] = true;
+                    cellCore[c] = true;
+                }
+            }
+        });
+
+        // Core points within a cell are always mutually reachable, so
+        // clusters join at cell granularity: two core cells link when any
+        // pair of their core points lies within eps
+        int[][] links = new int[numCells][];
+        forEachCell(c -> links[c] = linkedCells(c, core, cellCore, epsSq));
+
+        int[] parent = new int[numCells];
+        for (int c = 0; c < numCells; c++) parent[c] = c;
+        for (int c = 0; c < numCells; c++) {
+            for (int nc : links[c]) union(parent, c, nc);
+        }
+
+        // Roots are the lowest cell of each component; number them in cell order
+        int[] cellCluster = new int[numCells];
+        int clusters = 0;
+        for (int c = 0; c < numCells; c++) {
+            if (!cellCore[c]) {
+                cellCluster[c] = NOISE;
+            } else if (find(parent, c) == c) {
+                cellCluster[c] = clusters++;
+            } else {
+                cellCluster[c] = cellCluster[find(parent, c)];
+            }
+        }
+
+        // Border points join the cluster of the first core neighbour found
+        forEachCell(c -> {
+            for (int i = cellStart[c]; i < cellStart[c + 1]; i++) {
+                int label = core[i] ? cellCluster[c] : NOISE;
+                for (int e = neighborStart[c]; e < neighborStart[c + 1] && label == NOISE; e++) {
+                    int nc = neighbors[e];
+                    if (cellCore[nc] && DistanceKernels.anyWithin(sorted, cellStart[nc], cellStart[nc + 1],
+                            sorted.c1[i], sorted.c2[i], sorted.c3[i], epsSq, core)) {
+                        label = cellCluster[nc];
+                    }
+                }
+                labels[sortedIndex[i]] = label;
+            }
+        });
+
+        return clusters;
+    }
+
+    private int[] linkedCells(int c, boolean[] core, boolean[] cellCore, float epsSq) {
+        if (!cellCore[c]) return new int[0];
+
+        int[] linked = new int[neighborStart[c + 1] - neighborStart[c]];
+        int count = 0;
+        for (int e = neighborStart[c]; e < neighborStart[c + 1]; e++) {
+            int nc = neighbors[e];
+            if (nc <= c || !cellCore[nc]) continue;
+            for (int i = cellStart[c]; i < cellStart[c + 1]; i++) {
+                if (core[i] && DistanceKernels.anyWithin(sorted, cellStart[nc], cellStart[nc + 1],
+                        sorted.c1[i], sorted.c2[i], sorted.c3[i], epsSq, core)) {
+                    linked[count++] = nc;
+                    break;
+                }
+            }
+        }
+        return Arrays.copyOf(linked, count);
+    }
+
+    private int[] neighborCells(int c, long[] dims, int[] dense) {
+        long key = cellKeys[c];
+        long z = key % dims[2];
+        long y = (key / dims[2]) % dims[1];
+        long x = key / (dims[1] * dims[2]);
+        int[] out = new int[SPAN * SPAN * SPAN];
+        int count = 0;
+
+        for (int dx = -REACH; dx <= REACH; dx++) {
+            long nx = x + dx;
+            if (nx < 0 || nx >= dims[0]) continue;
+            for (int dy = -REACH; dy <= REACH; dy++) {
+                long ny = y + dy;
+                if (ny < 0 || ny >= dims[1]) continue;
+                for (int dz = -REACH; dz <= REACH; dz++) {
+                    long nz = z + dz;
+                    if (nz < 0 || nz >= dims[2]) continue;
+                    long nkey = (nx * dims[1] + ny) * dims[2] + nz;
+                    int cell = dense != null ? dense[(int) nkey] : Arrays.binarySearch(cellKeys, nkey);
+                    if (cell >= 0) out[count++] = cell;
+                }
+            }
+        }
+        return Arrays.copyOf(out, count);
+    }
+
+    private void forEachCell(IntConsumer body) {
+        if (numCells > PARALLEL_CELLS) {
+            IntStream.range(0, numCells).parallel().forEach(body);
+        } else {
+            IntStream.range(0, numCells).forEach(body);
+        }
+    }
+
+    /** Point indices ordered by cell key, ties by index. */
+    private static int[] sortByKey(long[] keys) {
+        int n = keys.length;
+        int[] order = new int[n];
+        long maxKey = 0;
+        for (long key : keys) maxKey = Math.max(maxKey, key);
+
+        if (maxKey <= Integer.MAX_VALUE) {
+            // Key and index packed into one long sort as a pair
+            long[] packed = new long[n];
+            for (int i = 0; i < n; i++) packed[i] = (keys[i] << 32) | i;
+            Arrays.parallelSort(packed);
+            for (int i = 0; i < n; i++) order[i] = (int) packed[i];
+            return order;
+        }
+
+        Integer[] boxed = new Integer[n];
+        for (int i = 0; i < n; i++) boxed[i] = i;
+        Arrays.sort(boxed, (a, b) -> keys[a] != keys[b] ? Long.compare(keys[a], keys[b]) : Integer.compare(a, b));
+        for (int i = 0; i < n; i++) order[i] = boxed[i];
+        return order;
+    }
+
+    private static int find(int[] parent, int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    // Roots always link to the smaller cell, so each component is rooted at its lowest cell
+    private static void union(int[] parent, int a, int b) {
+        a = find(parent, a);
+        b = find(parent, b);
+        if (a == b) return;
+        if (a < b) parent[b] = a;
+        else parent[a] = b;
+    }
+}
@@ -1,22 +1,27 @@
 package aichat.algorithm;
 
+import aichat.diagnostics.ClusteringEvent;
 import aichat.model.ColorPoint;
 import aichat.native_.NativeAccelerator;
 
 import java.util.*;
-import java.util.concurrent.atomic.AtomicInteger;
-import java.util.stream.IntStream;
 
 public class HybridClusterer implements ClusteringStrategy {
     
     private static final int DEFAULT_BLOCK_SIZE = 1000;
     private static final int DEFAULT_MIN_PTS = 3;
+    private static final int DEFAULT_MAX_REPRESENTATIVES = 2048;
     private static final int KMEANS_MAX_ITERATIONS = 50;
-    private static final double KMEANS_THRESHOLD = 1.0;
-    private static final int PARALLEL_THRESHOLD = 500;
+    private static final float KMEANS_THRESHOLD = 1.0f;
+    // Representative cells stop growing here: cells this wide already cover
+    // the whole RGB / CIELAB range with a handful of cells
+    private static final float REPRESENTATIVE_CELL_LIMIT = 512.0f;
+    // Cell growth per compaction step (about 3x fewer cells each time)
+    private static final float REPRESENTATIVE_CELL_GROWTH = 1.5f;
     
     private final int blockSize;
     private final int minPts;
+    private final int maxRepresentatives;
     private final long seed;
     private final NativeAccelerator nativeAccelerator;
     
@@ -29,8 +34,17 @@ public class HybridClusterer implements ClusteringStrategy {
     }
     
     public HybridClusterer(int blockSize, int minPts, long seed) {
+        this(blockSize, minPts, DEFAULT_MAX_REPRESENTATIVES, seed);
+    }
+    
+    /**
+     * @param maxRepresentatives cap on the weighted representatives that reach
+     *        the final k-means; noise is grid-merged to stay under it
+     */
+    public HybridClusterer(int blockSize, int minPts, int maxRepresentatives, long seed) {
         this.blockSize = blockSize;
         this.minPts = minPts;
+        this.maxRepresentatives = maxRepresentatives;
         this.seed = seed;
         this.nativeAccelerator = NativeAccelerator.getInstance();
     }
@@ -59,208 +73,188 @@ public class HybridClusterer implements ClusteringStrategy {
     }
 
     public List<ColorPoint> clusterNative(List<ColorPoint> points, int k) {
-        return nativeAccelerator.hybridCluster(points, k, blockSize, minPts, seed);
+        return nativeAccelerator.hybridCluster(points, k, blockSize, minPts, maxRepresentatives, seed);
     }
 
     public List<ColorPoint> clusterJava(List<ColorPoint> points, int k) {
+        ClusteringEvent event = new ClusteringEvent();
+        event.begin();
+        List<ColorPoint> result = clusterJava(points, k, event);
+        event.end();
+        if (event.shouldCommit()) {
+            event.algorithm = "hybrid";
+            event.backend = DistanceKernels.VECTOR_API ? "java-vector" : "java";
+            event.k = k;
+            event.points = points.size();
+            event.commit();
+        }
+        return result;
+    }
+
+    private List<ColorPoint> clusterJava(List<ColorPoint> points, int k, ClusteringEvent event) {
         int n = points.size();
+        PointArrays flat = PointArrays.of(points);
+        
+        // Fewer iterations for large k (diminishing returns)
+        int maxIter = k > 100 ? 20 : (k > 32 ? 30 : KMEANS_MAX_ITERATIONS);
+        event.maxIterations = maxIter;
         
         // For very small datasets, use K-Means directly
         if (n <= blockSize * 2) {
-            return kmeansCluster(points, k);
+            return kmeansCluster(flat, null, k, maxIter, event);
         }
         
         // Calculate adaptive eps
-        float eps = calculateAdaptiveEps(points);
+        float eps = calculateAdaptiveEps(flat);
         
-        // Phase 1: Extract representatives from each block using DBSCAN
-        List<ColorPoint> representatives = extractRepresentatives(points, eps);
+        // Phase 1: DBSCAN over the whole sample, reduced to weighted representatives
+        int[] labels = new int[n];
+        int clusters = GridDbscan.cluster(flat, eps, minPts, labels);
+        Representatives representatives = boundedRepresentatives(flat, labels, clusters, eps, k);
         
         // Ensure we have enough representatives
-        if (representatives.size() < k) {
+        PointArrays repPoints = representatives.points();
+        float[] repWeights = representatives.weights();
+        if (repPoints.size < k) {
+            PointArrays padded = new PointArrays(k);
+            float[] paddedWeights = Arrays.copyOf(repWeights, k);
+            for (int i = 0; i < repPoints.size; i++) padded.set(i, repPoints, i);
             Random random = new Random(seed);
-            while (representatives.size() < k) {
-                representatives.add(points.get(random.nextInt(n)));
+            for (int i = repPoints.size; i < k; i++) {
+                padded.set(i, flat, random.nextInt(n));
+                paddedWeights[i] = 1.0f;
             }
+            repPoints = padded;
+            repWeights = paddedWeights;
         }
         
-        // Phase 2: Apply K-Means on representatives
-        return kmeansCluster(representatives, k);
+        // Phase 2: Apply weighted K-Means on representatives
+        return kmeansCluster(repPoints, repWeights, k, maxIter, event);
     }
     
-    private List<ColorPoint> extractRepresentatives(List<ColorPoint> points, float eps) {
-        int n = points.size();
-        int numBlocks = (n + blockSize - 1) / blockSize;
-        
-        // Convert to array for efficient access
-        double[][] pointArray = new double[n][3];
-        for (int i = 0; i < n; i++) {
-            ColorPoint p = points.get(i);
-            pointArray[i][0] = p.c1();
-            pointArray[i][1] = p.c2();
-            pointArray[i][2] = p.c3();
-        }
-        
-        // Process blocks (parallel for large datasets)
-        // Use an array of lists to preserve deterministic ordering
-        @SuppressWarnings("unchecked")
-        List<ColorPoint>[] blockResults = new List[numBlocks];
-        
-        if (n > PARALLEL_THRESHOLD && numBlocks > 4) {
-            IntStream.range(0, numBlocks).parallel().forEach(b -> {
-                blockResults[b] = processBlock(pointArray, b, n, eps);
-            });
-        } else {
-            for (int b = 0; b < numBlocks; b++) {
-                blockResults[b] = processBlock(pointArray, b, n, eps);
-            }
+    private List<ColorPoint> kmeansCluster(PointArrays points, float[] weights, int k, int maxIter,
+                                           ClusteringEvent event) {
+        if (points.size <= k) {
+            return points.toList();
         }
-        
-        // Collect results in deterministic order
-        List<ColorPoint> allRepresentatives = new ArrayList<>();
-        for (int b = 0; b < numBlocks; b++) {
-            if (blockResults[b] != null) {
-                allRepresentatives.addAll(blockResults[b]);
+        PointArrays centroids = new PointArrays(k);
+        event.iterations = WeightedKMeans.cluster(points, weights, centroids, maxIter, KMEANS_THRESHOLD, seed);
+        return centroids.toList();
+    }
+    
+    /** Weighted representatives of a labelled sample; weights count the points merged. */
+    record Representatives(PointArrays points, float[] weights, int noise) {}
+    
+    // Keep noise points as they are while the set fits the cap; otherwise
+    // grid-merge noise with growing cells, and as a last resort merge
+    // clusters sharing a cell too (as hybrid_cluster_bounded does natively)
+    private Representatives boundedRepresentatives(PointArrays points, int[] labels, int clusters,
+                                                   float eps, int k) {
+        int cap = Math.max(maxRepresentatives > 0 ? maxRepresentatives : DEFAULT_MAX_REPRESENTATIVES, k);
+        float baseCell = eps > 0.0f ? eps : 1e-3f;
+        float noiseCell = 0.0f;
+        float clusterCell = baseCell;
+        boolean mergeLabels = false;
+        
+        Representatives result = extractRepresentatives(points, labels, clusters, clusterCell, noiseCell, mergeLabels);
+        while (result.points().size > cap) {
+            if (!mergeLabels && result.noise() > 1 && noiseCell < REPRESENTATIVE_CELL_LIMIT) {
+                noiseCell = noiseCell > 0.0f ? noiseCell * REPRESENTATIVE_CELL_GROWTH : baseCell;
+            } else if (!mergeLabels) {
+                mergeLabels = true;
+            } else if (clusterCell < REPRESENTATIVE_CELL_LIMIT) {
+                clusterCell *= REPRESENTATIVE_CELL_GROWTH;
+            } else {
+                break;
             }
+            result = extractRepresentatives(points, labels, clusters, clusterCell, noiseCell, mergeLabels);
         }
-        
-        return allRepresentatives;
+        return result;
     }
     
-    private List<ColorPoint> processBlock(double[][] allPoints, int blockIndex, int totalPoints, float eps) {
-        int start = blockIndex * blockSize;
-        int end = Math.min(start + blockSize, totalPoints);
-        int blockN = end - start;
-        
-        if (blockN == 0) return Collections.emptyList();
-        
-        double epsSq = eps * eps;
-        
-        // Labels: -2 = unclassified, -1 = noise, 0+ = cluster
-        int[] labels = new int[blockN];
-        Arrays.fill(labels, -2);
-        
-        // Queue for BFS expansion
-        int[] queue = new int[blockN];
-        
-        int clusterId = 0;
-        
-        for (int i = 0; i < blockN; i++) {
-            if (labels[i] != -2) continue;
-            
-            // Count neighbors (simple O(n) scan)
-            int neighbors = 0;
-            double[] pi = allPoints[start + i];
-            for (int j = 0; j < blockN; j++) {
-                double[] pj = allPoints[start + j];
-                double d0 = pi[0] - pj[0];
-                double d1 = pi[1] - pj[1];
-                double d2 = pi[2] - pj[2];
-                if (d0*d0 + d1*d1 + d2*d2 <= epsSq) neighbors++;
-            }
-            
-            if (neighbors < minPts) {
-                labels[i] = -1;  // Noise
-                continue;
-            }
-            
-            // Start new cluster with BFS
-            labels[i] = clusterId;
-            int queueStart = 0, queueEnd = 0;
+    /**
+     * Each cluster contributes one centroid per clusterCell-sized cell it
+     * occupies. Noise points are kept individually when noiseCell is 0,
+     * otherwise merged per noiseCell cell; with mergeLabels set, cluster ids
+     * are ignored and all points are merged per clusterCell cell. Output is
+     * ordered by cluster, then cell, with noise last.
+     */
+    static Representatives extractRepresentatives(PointArrays points, int[] labels, int clusters,
+                                                  float clusterCell, float noiseCell, boolean mergeLabels) {
+        int n = points.size;
+        int groups = mergeLabels ? 1 : clusters + 1;
+        
+        // Counting sort of point indices by group (noise last), index order within
+        int[] groupStart = new int[groups + 1];
+        for (int i = 0; i < n; i++) groupStart[group(labels[i], clusters, mergeLabels) + 1]++;
+        for (int g = 0; g < groups; g++) groupStart[g + 1] += groupStart[g];
+        int[] order = new int[n];
+        int[] fill = groupStart.clone();
+        for (int i = 0; i < n; i++) order[fill[group(labels[i], clusters, mergeLabels)]++] = i;
+        
+        PointArrays out = new PointArrays(n);
+        float[] weights = new float[n];
+        int count = 0;
+        int noise = 0;
+        
+        for (int g = 0; g < groups; g++) {
+            boolean noiseGroup = !mergeLabels && g == clusters;
+            int from = groupStart[g];
+            int to = groupStart[g + 1];
             
-            // Add all neighbors to queue
-            for (int j = 0; j < blockN; j++) {
-                if (j != i && labels[j] == -2) {
-                    double[] pj = allPoints[start + j];
-                    double d0 = pi[0] - pj[0];
-                    double d1 = pi[1] - pj[1];
-                    double d2 = pi[2] - pj[2];
-                    if (d0*d0 + d1*d1 + d2*d2 <= epsSq) {
-                        queue[queueEnd++] = j;
-                        labels[j] = -3;  // In queue
-                    }
+            if (noiseGroup && noiseCell <= 0.0f) {
+                for (int o = from; o < to; o++) {
+                    out.set(count, points, order[o]);
+                    weights[count++] = 1.0f;
                 }
+                noise += to - from;
+                continue;
             }
             
-            while (queueStart < queueEnd) {
-                int q = queue[queueStart++];
-                
-                if (labels[q] == -1) {
-                    labels[q] = clusterId;  // Border point
-                    continue;
-                }
-                
-                labels[q] = clusterId;
-                
-                // Count q's neighbors
-                double[] pq = allPoints[start + q];
-                int qNeighbors = 0;
-                for (int j = 0; j < blockN; j++) {
-                    double[] pj = allPoints[start + j];
-                    double d0 = pq[0] - pj[0];
-                    double d1 = pq[1] - pj[1];
-                    double d2 = pq[2] - pj[2];
-                    if (d0*d0 + d1*d1 + d2*d2 <= epsSq) qNeighbors++;
-                }
-                
-                if (qNeighbors >= minPts) {
-                    // Add q's unvisited neighbors to queue
-                    for (int j = 0; j < blockN; j++) {
-                        if (labels[j] == -2) {
-                            double[] pj = allPoints[start + j];
-                            double d0 = pq[0] - pj[0];
-                            double d1 = pq[1] - pj[1];
-                            double d2 = pq[2] - pj[2];
-                            if (d0*d0 + d1*d1 + d2*d2 <= epsSq) {
-                                queue[queueEnd++] = j;
-                                labels[j] = -3;
-                            }
-                        }
-                    }
-                }
+            float invCell = 1.0f / (noiseGroup ? noiseCell : clusterCell);
+            Map<Long, double[]> cells = new HashMap<>();
+            for (int o = from; o < to; o++) {
+                int i = order[o];
+                double[] sum = cells.computeIfAbsent(representativeCell(points, i, invCell), key -> new double[4]);
+                sum[0] += points.c1[i];
+                sum[1] += points.c2[i];
+                sum[2] += points.c3[i];
+                sum[3]++;
             }
             
-            clusterId++;
-        }
-        
-        // Calculate representatives: cluster centroids + noise points
-        List<ColorPoint> representatives = new ArrayList<>();
-        
-        // Cluster centroids
-        for (int c = 0; c < clusterId; c++) {
-            double sum1 = 0, sum2 = 0, sum3 = 0;
-            int count = 0;
-            
-            for (int i = 0; i < blockN; i++) {
-                if (labels[i] == c) {
-                    sum1 += allPoints[start + i][0];
-                    sum2 += allPoints[start + i][1];
-                    sum3 += allPoints[start + i][2];
-                    count++;
-                }
-            }
-            
-            if (count > 0) {
-                representatives.add(new ColorPoint(sum1 / count, sum2 / count, sum3 / count));
-            }
-        }
-        
-        // Add noise points (they represent unique/rare colors)
-        for (int i = 0; i < blockN; i++) {
-            if (labels[i] == -1) {
-                representatives.add(new ColorPoint(
-                    allPoints[start + i][0],
-                    allPoints[start + i][1],
-                    allPoints[start + i][2]
-                ));
+            long[] keys = new long[cells.size()];
+            int j = 0;
+            for (long key : cells.keySet()) keys[j++] = key;
+            Arrays.sort(keys);
+            for (long key : keys) {
+                double[] sum = cells.get(key);
+                out.c1[count] = (float) (sum[0] / sum[3]);
+                out.c2[count] = (float) (sum[1] / sum[3]);
+                out.c3[count] = (float) (sum[2] / sum[3]);
+                weights[count++] = (float) sum[3];
             }
+            if (noiseGroup) noise += keys.length;
         }
         
-        return representatives;
+        PointArrays trimmed = new PointArrays(
+            Arrays.copyOf(out.c1, count), Arrays.copyOf(out.c2, count), Arrays.copyOf(out.c3, count));
+        return new Representatives(trimmed, Arrays.copyOf(weights, count), noise);
     }
     
-    private float calculateAdaptiveEps(List<ColorPoint> points) {
-        int n = points.size();
+    private static int group(int label, int clusters, boolean mergeLabels) {
+        if (mergeLabels) return 0;
+        return label == GridDbscan.NOISE ? clusters : label;
+    }
+    
+    private static long representativeCell(PointArrays points, int i, float invCell) {
+        long x = (long) Math.floor(points.c1[i] * invCell);
+        long y = (long) Math.floor(points.c2[i] * invCell);
+        long z = (long) Math.floor(points.c3[i] * invCell);
+        return ((x & 0x1FFFFF) << 42) | ((y & 0x1FFFFF) << 21) | (z & 0x1FFFFF);
+    }
+    
+    private float calculateAdaptiveEps(PointArrays points) {
+        int n = points.size;
         if (n <= minPts) {
             return 15.0f;
         }
@@ -290,18 +284,16 @@ public class HybridClusterer implements ClusteringStrategy {
             // Sample points from this block and find k-distances
             int sampleSize = Math.min(20, blockN);
             double[] kDistances = new double[sampleSize];
+            float[] distances = new float[blockN];
             
             for (int i = 0; i < sampleSize; i++) {
                 int idx = start + random.nextInt(blockN);
-                ColorPoint p = points.get(idx);
-                
-                double[] distances = new double[blockN];
                 for (int j = 0; j < blockN; j++) {
-                    distances[j] = p.distanceTo(points.get(start + j));
+                    distances[j] = points.distanceSq(start + j, points, idx);
                 }
                 
                 Arrays.sort(distances);
-                kDistances[i] = distances[k];
+                kDistances[i] = Math.sqrt(distances[k]);
             }
             
             // Use MEDIAN (50th percentile) for conservative clustering
@@ -318,200 +310,6 @@ public class HybridClusterer implements ClusteringStrategy {
         return avgEps;
     }
     
-    private List<ColorPoint> kmeansCluster(List<ColorPoint> points, int k) {
-        int n = points.size();
-        if (n <= k) {
-            return new ArrayList<>(points);
-        }
-        
-        // Convert to array for efficiency
-        double[][] pointArray = new double[n][3];
-        for (int i = 0; i < n; i++) {
-            ColorPoint p = points.get(i);
-            pointArray[i][0] = p.c1();
-            pointArray[i][1] = p.c2();
-            pointArray[i][2] = p.c3();
-        }
-        
-        // K-Means++ initialization
-        double[][] centroids = initPlusPlus(pointArray, k);
-        int[] assignments = new int[n];
-        
-        // Fewer iterations for large k (diminishing returns)
-        int maxIter = k > 100 ? 20 : (k > 32 ? 30 : KMEANS_MAX_ITERATIONS);
-        
-        // Main K-Means loop
-        for (int iter = 0; iter < maxIter; iter++) {
-            // Assign points to nearest centroids
-            int changed = assignPoints(pointArray, centroids, assignments);
-            
-            // Update centroids
-            double maxMovement = updateCentroids(pointArray, centroids, assignments, k);
-            
-            // Check convergence
-            if (maxMovement < KMEANS_THRESHOLD || changed == 0) {
-                break;
-            }
-        }
-        
-        // Convert centroids to ColorPoints
-        List<ColorPoint> result = new ArrayList<>(k);
-        for (int c = 0; c < k; c++) {
-            result.add(new ColorPoint(centroids[c][0], centroids[c][1], centroids[c][2]));
-        }
-        
-        return result;
-    }
-    
-    private double[][] initPlusPlus(double[][] points, int k) {
-        int n = points.length;
-        double[][] centroids = new double[k][3];
-        Random random = new Random(seed);
-        
-        if (k > 64) {
-            int step = Math.max(1, n / k);
-            for (int c = 0; c < k; c++) {
-                int idx = (c * step + random.nextInt(step)) % n;
-                centroids[c] = points[idx].clone();
-            }
-            return centroids;
-        }
-        
-        // Standard K-Means++ for small k
-        double[] distances = new double[n];
-        
-        // First centroid: random point
-        int first = random.nextInt(n);
-        centroids[0] = points[first].clone();
-        
-        // Remaining centroids: D² weighting
-        for (int c = 1; c < k; c++) {
-            double totalDist = 0;
-            
-            for (int i = 0; i < n; i++) {
-                double minDist = Double.MAX_VALUE;
-                for (int j = 0; j < c; j++) {
-                    double d = distanceSq(points[i], centroids[j]);
-                    if (d < minDist) minDist = d;
-                }
-                distances[i] = minDist;
-                totalDist += minDist;
-            }
-            
-            // Weighted random selection
-            double threshold = random.nextDouble() * totalDist;
-            double cumulative = 0;
-            int selected = n - 1;
-            
-            for (int i = 0; i < n; i++) {
-                cumulative += distances[i];
-                if (cumulative >= threshold) {
-                    selected = i;
-                    break;
-                }
-            }
-            
-            centroids[c] = points[selected].clone();
-        }
-        
-        return centroids;
-    }
-    
-    int assignPoints(double[][] points, double[][] centroids, int[] assignments) {
-        int n = points.length;
-        int k = centroids.length;
-        AtomicInteger changed = new AtomicInteger(0);
-        
-        if (n > PARALLEL_THRESHOLD) {
-            IntStream.range(0, n).parallel().forEach(i -> {
-                int closest = 0;
-                double minDist = distanceSq(points[i], centroids[0]);
-                
-                for (int c = 1; c < k; c++) {
-                    double d = distanceSq(points[i], centroids[c]);
-                    if (d < minDist) {
-                        minDist = d;
-                        closest = c;
-                    }
-                }
-                
-                if (assignments[i] != closest) {
-                    assignments[i] = closest;
-                    changed.incrementAndGet();
-                }
-            });
-        } else {
-            for (int i = 0; i < n; i++) {
-                int closest = 0;
-                double minDist = distanceSq(points[i], centroids[0]);
-                
-                for (int c = 1; c < k; c++) {
-                    double d = distanceSq(points[i], centroids[c]);
-                    if (d < minDist) {
-                        minDist = d;
-                        closest = c;
-                    }
-                }
-                
-                if (assignments[i] != closest) {
-                    assignments[i] = closest;
-                    changed.incrementAndGet();
-                }
-            }
-        }
-        
-        return changed.get();
-    }
-    
-    private double updateCentroids(double[][] points, double[][] centroids, int[] assignments, int k) {
-        int n = points.length;
-        
-        double[] sums = new double[k * 3];
-        int[] counts = new int[k];
-        
-        for (int i = 0; i < n; i++) {
-            int c = assignments[i];
-            sums[c * 3] += points[i][0];
-            sums[c * 3 + 1] += points[i][1];
-            sums[c * 3 + 2] += points[i][2];
-            counts[c]++;
-        }
-        
-        double maxMovement = 0;
-        Random random = new Random(seed);
-        
-        for (int c = 0; c < k; c++) {
-            double[] newCentroid = new double[3];
-            
-            if (counts[c] > 0) {
-                double inv = 1.0 / counts[c];
-                newCentroid[0] = sums[c * 3] * inv;
-                newCentroid[1] = sums[c * 3 + 1] * inv;
-                newCentroid[2] = sums[c * 3 + 2] * inv;
-            } else {
-                // Empty cluster: reinitialize
-                int idx = random.nextInt(n);
-                newCentroid = points[idx].clone();
-            }
-            
-            double movement = distanceSq(centroids[c], newCentroid);
-            if (movement > maxMovement) {
-                maxMovement = movement;
-            }
-            
-            centroids[c] = newCentroid;
-        }
-        
-        return Math.sqrt(maxMovement);
-    }
-    
-    private static double distanceSq(double[] a, double[] b) {
-        double d0 = a[0] - b[0];
-        double d1 = a[1] - b[1];
-        double d2 = a[2] - b[2];
-        return d0*d0 + d1*d1 + d2*d2;
-    }
-    
     @Override
     public String getName() {
         return "Hybrid DBSCAN+K-Means" + (nativeAccelerator.isAvailable() ? " (Native)" : "");
@@ -0,0 +1,69 @@
+package aichat.algorithm;
+
+import aichat.model.ColorPoint;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Colors as three flat float channel arrays, the layout the Java clustering
+ * kernels scan lane by lane instead of chasing one object per point.
+ */
+final class PointArrays {
+
+    final float[] c1;
+    final float[] c2;
+    final float[] c3;
+    final int size;
+
+    PointArrays(int size) {
+        this(new float[size], new float[size], new float[size]);
+    }
+
+    PointArrays(float[] c1, float[] c2, float[] c3) {
+        this.c1 = c1;
+        this.c2 = c2;
+        this.c3 = c3;
+        this.size = c1.length;
+    }
+
+    static PointArrays of(List<ColorPoint> points) {
+        PointArrays flat = new PointArrays(points.size());
+        for (int i = 0; i < flat.size; i++) {
+            ColorPoint p = points.get(i);
+            flat.c1[i] = (float) p.c1();
+            flat.c2[i] = (float) p.c2();
+            flat.c3[i] = (float) p.c3();
+        }
+        return flat;
+    }
+
+    ColorPoint get(int i) {
+        return new ColorPoint(c1[i], c2[i], c3[i]);
+    }
+
+    void set(int i, PointArrays from, int j) {
+        c1[i] = from.c1[j];
+        c2[i] = from.c2[j];
+        c3[i] = from.c3[j];
+    }
+
+    float distanceSq(int i, float x, float y, float z) {
+        float d1 = c1[i] - x;
+        float d2 = c2[i] - y;
+        float d3 = c3[i] - z;
+        return d1 * d1 + d2 * d2 + d3 * d3;
+    }
+
+    float distanceSq(int i, PointArrays other, int j) {
+        return distanceSq(i, other.c1[j], other.c2[j], other.c3[j]);
+    }
+
+    List<ColorPoint> toList() {
+        List<ColorPoint> result = new ArrayList<>(size);
+        for (int i = 0; i < size; i++) {
+            result.add(get(i));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,229 @@
+package aichat.algorithm;
+
+import aichat.diagnostics.ClusteringEvent;
+import aichat.model.ColorPoint;
+import aichat.native_.NativeAccelerator;
+
+import java.util.*;
+
+/**
+ * Tree-structured vector quantization for very large palettes.
+ * The leaf with the largest squared error is split in two by a 2-means
+ * until k leaves exist, so the cost grows with log k instead of k.
+ */
+public class TreeVectorQuantizer implements ClusteringStrategy {
+
+    private static final int SPLIT_ITERATIONS = 8;
+
+    private final NativeAccelerator nativeAccelerator;
+
+    public TreeVectorQuantizer() {
+        this.nativeAccelerator = NativeAccelerator.getInstance();
+    }
+
+    @Override
+    public List<ColorPoint> cluster(List<ColorPoint> points, int k) {
+        if (points == null || points.isEmpty()) {
+            return Collections.emptyList();
+        }
+
+        if (k <= 0) return Collections.emptyList();
+        if (k >= points.size()) {
+            return new ArrayList<>(points.subList(0, Math.min(k, points.size())));
+        }
+
+        if (nativeAccelerator.isAvailable()) {
+            List<ColorPoint> result = nativeAccelerator.tsvqBuildPalette(points, k);
+            if (result != null && !result.isEmpty()) {
+                return result;
+            }
+        }
+
+        return clusterJava(points, k);
+    }
+
+    /**
+     * Greedy splits without the native Lloyd refinement passes.
+     */
+    public List<ColorPoint> clusterJava(List<ColorPoint> points, int k) {
+        ClusteringEvent event = new ClusteringEvent();
+        event.begin();
+        int n = points.size();
+        double[][] pointArray = new double[n][3];
+        for (int i = 0; i < n; i++) {
+            ColorPoint p = points.get(i);
+            pointArray[i][0] = p.c1();
+            pointArray[i][1] = p.c2();
+            pointArray[i][2] = p.c3();
+        }
+
+        int[] idx = new int[n];
+        for (int i = 0; i < n; i++) idx[i] = i;
+
+        // Largest error first; ties go to the older leaf
+        PriorityQueue<Leaf> queue = new PriorityQueue<>((a, b) ->
+            a.error != b.error ? Double.compare(b.error, a.error) : Integer.compare(a.id, b.id));
+        List<Leaf> leaves = new ArrayList<>(k);
+
+        Leaf root = new Leaf(0, 0, n, squaredError(pointArray, idx, 0, n));
+        leaves.add(root);
+        if (root.error > 0) queue.add(root);
+
+        while (leaves.size() < k && !queue.isEmpty()) {
+            Leaf leaf = queue.poll();
+            int mid = split(pointArray, idx, leaf.start, leaf.end);
+            if (mid < 0) continue;
+
+            Leaf left = new Leaf(leaf.id, leaf.start, mid, squaredError(pointArray, idx, leaf.start, mid));
+            Leaf right = new Leaf(leaves.size(), mid, leaf.end, squaredError(pointArray, idx, mid, leaf.end));
+            leaves.set(leaf.id, left);
+            leaves.add(right);
+
+            if (left.error > 0) queue.add(left);
+            if (right.error > 0) queue.add(right);
+        }
+
+        List<ColorPoint> result = new ArrayList<>(leaves.size());
+        for (Leaf leaf : leaves) {
+            double[] mean = mean(pointArray, idx, leaf.start, leaf.end);
+            result.add(new ColorPoint(mean[0], mean[1], mean[2]));
+        }
+
+        event.end();
+        if (event.shouldCommit()) {
+            event.algorithm = "tsvq";
+            event.backend = "java";
+            event.k = k;
+            event.points = n;
+            event.commit();
+        }
+        return result;
+    }
+
+    private record Leaf(int id, int start, int end, double error) {}
+
+    private static double[] mean(double[][] points, int[] idx, int start, int end) {
+        double[] mean = new double[3];
+        for (int i = start; i < end; i++) {
+            double[] p = points[idx[i]];
+            mean[0] += p[0];
+            mean[1] += p[1];
+            mean[2] += p[2];
+        }
+        int count = end - start;
+        mean[0] /= count;
+        mean[1] /= count;
+        mean[2] /= count;
+        return mean;
+    }
+
+    private static double squaredError(double[][] points, int[] idx, int start, int end) {
+        double[] mean = mean(points, idx, start, end);
+        double error = 0;
+        for (int i = start; i < end; i++) {
+            error += distanceSq(points[idx[i]], mean);
+        }
+        return error;
+    }
+
+    /**
+     * 2-means over idx[start, end) seeded one standard deviation either side
+     * of the mean on the widest axis; partitions idx in place and returns the
+     * start of the second half, or -1 if the range holds a single color.
+     */
+    private static int split(double[][] points, int[] idx, int start, int end) {
+        if (end - start < 2) return -1;
+
+        double[] mean = mean(points, idx, start, end);
+        double[] var = new double[3];
+        for (int i = start; i < end; i++) {
+            double[] p = points[idx[i]];
+            for (int d = 0; d < 3; d++) {
+                var[d] += (p[d] - mean[d]) * (p[d] - mean[d]);
+            }
+        }
+
+        int axis = 0;
+        if (var[1] > var[axis]) axis = 1;
+        if (var[2] > var[axis]) axis = 2;
+        if (var[axis] <= 1e-9) return -1;
+
+        double sd = Math.sqrt(var[axis] / (end - start));
+        double[] c0 = mean.clone();
+        double[] c1 = mean.clone();
+        c0[axis] -= sd;
+        c1[axis] += sd;
+
+        for (int iter = 0; iter < SPLIT_ITERATIONS; iter++) {
+            double[] sum0 = new double[3];
+            double[] sum1 = new double[3];
+            int count0 = 0, count1 = 0;
+
+            for (int i = start; i < end; i++) {
+                double[] p = points[idx[i]];
+                if (distanceSq(p, c0) <= distanceSq(p, c1)) {
+                    for (int d = 0; d < 3; d++) sum0[d] += p[d];
+                    count0++;
+                } else {
+                    for (int d = 0; d < 3; d++) sum1[d] += p[d];
+                    count1++;
+                }
+            }
+            if (count0 == 0 || count1 == 0) break;
+
+            for (int d = 0; d < 3; d++) {
+                sum0[d] /= count0;
+                sum1[d] /= count1;
+            }
+            double movement = Math.max(distanceSq(sum0, c0), distanceSq(sum1, c1));
+            c0 = sum0;
+            c1 = sum1;
+            if (movement < 1e-4) break;
+        }
+
+        int mid = partition(points, idx, start, end, c0, c1);
+        if (mid > start && mid < end) return mid;
+
+        // 2-means collapsed onto one side: cut at the mean of the widest axis
+        int i = start, j = end - 1;
+        while (i <= j) {
+            if (points[idx[i]][axis] <= mean[axis]) {
+                i++;
+            } else {
+                swap(idx, i, j--);
+            }
+        }
+        return (i > start && i < end) ? i : -1;
+    }
+
+    private static int partition(double[][] points, int[] idx, int start, int end, double[] c0, double[] c1) {
+        int i = start, j = end - 1;
+        while (i <= j) {
+            double[] p = points[idx[i]];
+            if (distanceSq(p, c0) <= distanceSq(p, c1)) {
+                i++;
+            } else {
+                swap(idx, i, j--);
+            }
+        }
+        return i;
+    }
+
+    private static void swap(int[] a, int i, int j) {
+        int t = a[i];
+        a[i] = a[j];
+        a[j] = t;
+    }
+
+    private static double distanceSq(double[] a, double[] b) {
+        double d0 = a[0] - b[0];
+        double d1 = a[1] - b[1];
+        double d2 = a[2] - b[2];
+        return d0*d0 + d1*d1 + d2*d2;
+    }
+
+    @Override
+    public String getName() {
+        return "Tree-Structured VQ" + (nativeAccelerator.isAvailable() ? " (Native)" : "");
+    }
+}
@@ -0,0 +1,90 @@
+package aichat.algorithm;
+
+import jdk.incubator.vector.FloatVector;
+import jdk.incubator.vector.IntVector;
+import jdk.incubator.vector.VectorMask;
+import jdk.incubator.vector.VectorOperators;
+import jdk.incubator.vector.VectorSpecies;
+
+/**
+ * Vector API bodies of the {@link DistanceKernels}: whole vectors of points
+ * per step, with the scalar loops finishing each range. Only loaded when
+ * {@link DistanceKernels#VECTOR_API} is set.
+ */
+final class VectorDistanceKernels {
+
+    private static final VectorSpecies<Float> SPECIES = FloatVector.SPECIES_PREFERRED;
+    private static final VectorSpecies<Integer> INT_SPECIES = SPECIES.withLanes(int.class);
+
+    private VectorDistanceKernels() {}
+
+    private static FloatVector distanceSq(PointArrays points, int i, float x, float y, float z) {
+        FloatVector d1 = FloatVector.fromArray(SPECIES, points.c1, i).sub(x);
+        FloatVector d2 = FloatVector.fromArray(SPECIES, points.c2, i).sub(y);
+        FloatVector d3 = FloatVector.fromArray(SPECIES, points.c3, i).sub(z);
+        return d1.mul(d1).add(d2.mul(d2)).add(d3.mul(d3));
+    }
+
+    static int countWithin(PointArrays points, int from, int to,
+                           float x, float y, float z, float radiusSq, int limit) {
+        int count = 0;
+        int j = from;
+        int bound = from + SPECIES.loopBound(to - from);
+        for (; j < bound && count < limit; j += SPECIES.length()) {
+            count += distanceSq(points, j, x, y, z).compare(VectorOperators.LE, radiusSq).trueCount();
+        }
+        return DistanceKernels.countWithinScalar(points, j, to, x, y, z, radiusSq, limit, count);
+    }
+
+    static boolean anyWithin(PointArrays points, int from, int to,
+                             float x, float y, float z, float radiusSq, boolean[] only) {
+        int j = from;
+        int bound = from + SPECIES.loopBound(to - from);
+        for (; j < bound; j += SPECIES.length()) {
+            VectorMask<Float> within = distanceSq(points, j, x, y, z).compare(VectorOperators.LE, radiusSq);
+            if (within.and(VectorMask.fromArray(SPECIES, only, j)).anyTrue()) return true;
+        }
+        return DistanceKernels.anyWithinScalar(points, j, to, x, y, z, radiusSq, only);
+    }
+
+    static int assignNearest(PointArrays points, PointArrays centroids, int from, int to, int[] assignments) {
+        int changed = 0;
+        int i = from;
+        int bound = from + SPECIES.loopBound(to - from);
+        for (; i < bound; i += SPECIES.length()) {
+            FloatVector x = FloatVector.fromArray(SPECIES, points.c1, i);
+            FloatVector y = FloatVector.fromArray(SPECIES, points.c2, i);
+            FloatVector z = FloatVector.fromArray(SPECIES, points.c3, i);
+            FloatVector best = FloatVector.broadcast(SPECIES, Float.POSITIVE_INFINITY);
+            // Centroid indices ride along as floats, exact far beyond any palette size
+            FloatVector bestIndex = FloatVector.zero(SPECIES);
+
+            for (int c = 0; c < centroids.size; c++) {
+                FloatVector d1 = x.sub(centroids.c1[c]);
+                FloatVector d2 = y.sub(centroids.c2[c]);
+                FloatVector d3 = z.sub(centroids.c3[c]);
+                FloatVector d = d1.mul(d1).add(d2.mul(d2)).add(d3.mul(d3));
+                VectorMask<Float> closer = d.compare(VectorOperators.LT, best);
+                best = best.blend(d, closer);
+                bestIndex = bestIndex.blend((float) c, closer);
+            }
+
+            IntVector nearest = (IntVector) bestIndex.convert(VectorOperators.F2I, 0);
+            IntVector previous = IntVector.fromArray(INT_SPECIES, assignments, i);
+            changed += nearest.compare(VectorOperators.NE, previous).trueCount();
+            nearest.intoArray(assignments, i);
+        }
+        return changed + DistanceKernels.assignNearestScalar(points, centroids, i, to, assignments);
+    }
+
+    static void lowerDistances(PointArrays points, int from, int to, float x, float y, float z, float[] distances) {
+        int i = from;
+        int bound = from + SPECIES.loopBound(to - from);
+        for (; i < bound; i += SPECIES.length()) {
+            distanceSq(points, i, x, y, z)
+                .min(FloatVector.fromArray(SPECIES, distances, i))
+                .intoArray(distances, i);
+        }
+        DistanceKernels.lowerDistancesScalar(points, i, to, x, y, z, distances);
+    }
+}
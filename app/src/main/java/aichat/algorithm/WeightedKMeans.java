@@ -0,0 +1,182 @@
+package aichat.algorithm;
+
+import java.util.Arrays;
+import java.util.Random;
+import java.util.stream.IntStream;
+
+/**
+ * Lloyd k-means over {@link PointArrays} with optional per-point weights,
+ * the Java counterpart of kmeans_cluster_weighted in native/src/kmeans.c.
+ * Assignment and the centroid sums run over fixed chunks of points on the
+ * common ForkJoin pool once a set is large enough; partial sums are reduced
+ * in chunk order, so results do not depend on the number of threads.
+ */
+final class WeightedKMeans {
+
+    static final int PARALLEL_THRESHOLD = 500;
+
+    private static final int CHUNK = 1024;
+
+    private WeightedKMeans() {}
+
+    /**
+     * Clusters {@code points} into {@code centroids.size} centroids, written
+     * to {@code centroids}. {@code weights} may be null for unit weights.
+     * Returns the number of iterations run.
+     */
+    static int cluster(PointArrays points, float[] weights, PointArrays centroids,
+                       int maxIterations, float threshold, long seed) {
+        // No point starts in a cluster, so the first pass counts every point as changed
+        int[] assignments = new int[points.size];
+        Arrays.fill(assignments, -1);
+        initPlusPlus(points, weights, centroids, seed);
+
+        int iteration;
+        for (iteration = 0; iteration < maxIterations; iteration++) {
+            int changed = assign(points, centroids, assignments);
+            float movement = updateCentroids(points, weights, assignments, centroids, seed + iteration);
+            if (movement < threshold || changed == 0) {
+                iteration++;
+                break;
+            }
+        }
+        return iteration;
+    }
+
+    /** Nearest-centroid assignment; returns how many points changed cluster. */
+    static int assign(PointArrays points, PointArrays centroids, int[] assignments) {
+        int n = points.size;
+        if (n <= PARALLEL_THRESHOLD) {
+            return DistanceKernels.assignNearest(points, centroids, 0, n, assignments);
+        }
+        return IntStream.range(0, chunks(n)).parallel()
+            .map(chunk -> DistanceKernels.assignNearest(points, centroids,
+                chunk * CHUNK, Math.min(n, (chunk + 1) * CHUNK), assignments))
+            .sum();
+    }
+
+    // Weighted k-means++: D^2 sampling scaled by weight. Large k uses
+    // systematic sampling over the cumulative weight instead
+    private static void initPlusPlus(PointArrays points, float[] weights, PointArrays centroids, long seed) {
+        int n = points.size;
+        int k = centroids.size;
+        Random random = new Random(seed);
+
+        double totalWeight = 0;
+        for (int i = 0; i < n; i++) totalWeight += weight(weights, i);
+
+        if (k > 64) {
+            double step = totalWeight / k;
+            double target = random.nextDouble() * step;
+            double cumulative = 0;
+            int i = 0;
+            for (int c = 0; c < k; c++) {
+                while (i < n - 1 && cumulative + weight(weights, i) < target) {
+                    cumulative += weight(weights, i);
+                    i++;
+                }
+                centroids.set(c, points, i);
+                target += step;
+            }
+            return;
+        }
+
+        float[] distances = new float[n];
+        Arrays.fill(distances, Float.POSITIVE_INFINITY);
+        centroids.set(0, points, sample(weights, null, n, random.nextDouble() * totalWeight));
+
+        for (int c = 1; c < k; c++) {
+            lowerDistances(points, centroids, c - 1, distances);
+            double totalDist = 0;
+            for (int i = 0; i < n; i++) totalDist += (double) distances[i] * weight(weights, i);
+            centroids.set(c, points, sample(weights, distances, n, random.nextDouble() * totalDist));
+        }
+    }
+
+    /** First index where the running sum of weight (times distance, if given) reaches the threshold. */
+    private static int sample(float[] weights, float[] distances, int n, double threshold) {
+        double cumulative = 0;
+        for (int i = 0; i < n; i++) {
+            cumulative += (distances != null ? (double) distances[i] : 1.0) * weight(weights, i);
+            if (cumulative >= threshold) return i;
+        }
+        return n - 1;
+    }
+
+    private static void lowerDistances(PointArrays points, PointArrays centroids, int c, float[] distances) {
+        int n = points.size;
+        float x = centroids.c1[c], y = centroids.c2[c], z = centroids.c3[c];
+        if (n <= PARALLEL_THRESHOLD) {
+            DistanceKernels.lowerDistances(points, 0, n, x, y, z, distances);
+            return;
+        }
+        IntStream.range(0, chunks(n)).parallel().forEach(chunk ->
+            DistanceKernels.lowerDistances(points, chunk * CHUNK, Math.min(n, (chunk + 1) * CHUNK), x, y, z, distances));
+    }
+
+    private static float updateCentroids(PointArrays points, float[] weights, int[] assignments,
+                                         PointArrays centroids, long seed) {
+        int n = points.size;
+        int k = centroids.size;
+
+        // Per chunk: 3 weighted channel sums followed by the total weight
+        double[][] partials = n <= PARALLEL_THRESHOLD
+            ? new double[][] { accumulate(points, weights, assignments, k, 0, n) }
+            : IntStream.range(0, chunks(n)).parallel()
+                .mapToObj(chunk -> accumulate(points, weights, assignments, k,
+                    chunk * CHUNK, Math.min(n, (chunk + 1) * CHUNK)))
+                .toArray(double[][]::new);
+
+        double[] sums = partials[0];
+        for (int p = 1; p < partials.length; p++) {
+            for (int j = 0; j < sums.length; j++) sums[j] += partials[p][j];
+        }
+
+        Random random = new Random(seed);
+        float maxMovement = 0;
+        for (int c = 0; c < k; c++) {
+            float x, y, z;
+            double total = sums[c * 4 + 3];
+            if (total > 0) {
+                x = (float) (sums[c * 4] / total);
+                y = (float) (sums[c * 4 + 1] / total);
+                z = (float) (sums[c * 4 + 2] / total);
+            } else {
+                // Empty cluster: reinitialize
+                int idx = random.nextInt(n);
+                x = points.c1[idx];
+                y = points.c2[idx];
+                z = points.c3[idx];
+            }
+
+            float movement = centroids.distanceSq(c, x, y, z);
+            if (movement > maxMovement) maxMovement = movement;
+            centroids.c1[c] = x;
+            centroids.c2[c] = y;
+            centroids.c3[c] = z;
+        }
+        return (float) Math.sqrt(maxMovement);
+    }
+
+    private static double[] accumulate(PointArrays points, float[] weights, int[] assignments,
+                                       int k, int from, int to) {
+        double[] sums = new double[k * 4];
+        for (int i = from; i < to; i++) {
+            int c = assignments[i] * 4;
+            double w = weight(weights, i);
+            sums[c] += points.c1[i] * w;
+            sums[c + 1] += points.c2[i] * w;
+            sums[c + 2] += points.c3[i] * w;
+            sums[c + 3] += w;
+        }
+        return sums;
+    }
+
+    private static double weight(float[] weights, int i) {
+        return weights != null ? weights[i] : 1.0;
+    }
+
+    private static int chunks(int n) {
+        return (n + CHUNK - 1) / CHUNK;
+    }
+}
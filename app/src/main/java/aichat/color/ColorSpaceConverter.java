@@ -1,5 +1,6 @@
 package aichat.color;
 
+import aichat.diagnostics.ColorConversionEvent;
 import aichat.model.ColorPoint;
 import aichat.native_.NativeAccelerator;
 
@@ -18,6 +19,15 @@ public final class ColorSpaceConverter {
     
     private static final NativeAccelerator nativeAccelerator = NativeAccelerator.getInstance();
     
+    /**
+     * Java fallback batches run through {@link VectorColorMath} when the JVM was
+     * started with --add-modules jdk.incubator.vector. Set
+     * -Daichat.java.vector=false to keep the scalar loop.
+     */
+    private static final boolean VECTOR_API =
+        ModuleLayer.boot().findModule("jdk.incubator.vector").isPresent()
+            && !"false".equals(System.getProperty("aichat.java.vector"));
+    
     private ColorSpaceConverter() {}
     
     public static List<ColorPoint> rgbToLabBatch(List<ColorPoint> rgbColors) {
@@ -25,19 +35,35 @@ public final class ColorSpaceConverter {
             return new ArrayList<>();
         }
         
+        ColorConversionEvent event = new ColorConversionEvent();
+        event.begin();
+        event.direction = "rgb-to-lab";
+        event.points = rgbColors.size();
+        
         // Try native batch conversion
         if (nativeAccelerator.isAvailable()) {
             List<ColorPoint> nativeResult = nativeAccelerator.rgbToLabBatch(rgbColors);
             if (nativeResult != null) {
+                event.backend = "native";
+                event.commit();
                 return nativeResult;
             }
         }
         
         // Fallback to Java
+        if (VECTOR_API) {
+            List<ColorPoint> result = convertVectorized(rgbColors, true);
+            event.backend = "java-vector";
+            event.commit();
+            return result;
+        }
+        
         List<ColorPoint> result = new ArrayList<>(rgbColors.size());
         for (ColorPoint rgb : rgbColors) {
             result.add(rgbToLab(rgb));
         }
+        event.backend = "java";
+        event.commit();
         return result;
     }
     
@@ -46,19 +72,60 @@ public final class ColorSpaceConverter {
             return new ArrayList<>();
         }
         
+        ColorConversionEvent event = new ColorConversionEvent();
+        event.begin();
+        event.direction = "lab-to-rgb";
+        event.points = labColors.size();
+        
         // Try native batch conversion
         if (nativeAccelerator.isAvailable()) {
             List<ColorPoint> nativeResult = nativeAccelerator.labToRgbBatch(labColors);
             if (nativeResult != null) {
+                event.backend = "native";
+                event.commit();
                 return nativeResult;
             }
         }
         
         // Fallback to Java
+        if (VECTOR_API) {
+            List<ColorPoint> result = convertVectorized(labColors, false);
+            event.backend = "java-vector";
+            event.commit();
+            return result;
+        }
+        
         List<ColorPoint> result = new ArrayList<>(labColors.size());
         for (ColorPoint lab : labColors) {
             result.add(labToRgb(lab));
         }
+        event.backend = "java";
+        event.commit();
+        return result;
+    }
+
+    private static List<ColorPoint> convertVectorized(List<ColorPoint> colors, boolean toLab) {
+        int n = colors.size();
+        float[] c1 = new float[n];
+        float[] c2 = new float[n];
+        float[] c3 = new float[n];
+        for (int i = 0; i < n; i++) {
+            ColorPoint p = colors.get(i);
+            c1[i] = (float) p.c1();
+            c2[i] = (float) p.c2();
+            c3[i] = (float) p.c3();
+        }
+        
+        if (toLab) {
+            VectorColorMath.rgbToLab(c1, c2, c3, n);
+        } else {
+            VectorColorMath.labToRgb(c1, c2, c3, n);
+        }
+        
+        List<ColorPoint> result = new ArrayList<>(n);
+        for (int i = 0; i < n; i++) {
+            result.add(new ColorPoint(c1[i], c2[i], c3[i]));
+        }
         return result;
     }
 
@@ -160,6 +227,40 @@ public final class ColorSpaceConverter {
         return Math.max(min, Math.min(max, value));
     }
     
+    /**
+     * CIEDE2000 between each pair of packed L*a*b* triples ({@code lab1[3i..3i+2]}
+     * against {@code lab2[3i..3i+2]}), vectorized when the Vector API is available.
+     */
+    public static float[] deltaE2000Batch(float[] lab1, float[] lab2) {
+        if (lab1.length != lab2.length || lab1.length % 3 != 0) {
+            throw new IllegalArgumentException("Expected two equal-length arrays of L*a*b* triples");
+        }
+        int n = lab1.length / 3;
+        float[] out = new float[n];
+        
+        if (!VECTOR_API) {
+            for (int i = 0; i < n; i++) {
+                out[i] = (float) deltaE2000(
+                    new ColorPoint(lab1[i * 3], lab1[i * 3 + 1], lab1[i * 3 + 2]),
+                    new ColorPoint(lab2[i * 3], lab2[i * 3 + 1], lab2[i * 3 + 2]));
+            }
+            return out;
+        }
+        
+        float[] l1 = new float[n], a1 = new float[n], b1 = new float[n];
+        float[] l2 = new float[n], a2 = new float[n], b2 = new float[n];
+        for (int i = 0; i < n; i++) {
+            l1[i] = lab1[i * 3];
+            a1[i] = lab1[i * 3 + 1];
+            b1[i] = lab1[i * 3 + 2];
+            l2[i] = lab2[i * 3];
+            a2[i] = lab2[i * 3 + 1];
+            b2[i] = lab2[i * 3 + 2];
+        }
+        VectorColorMath.deltaE2000(l1, a1, b1, l2, a2, b2, out, n);
+        return out;
+    }
+    
     public static double deltaE2000(ColorPoint lab1, ColorPoint lab2) {
         double l1 = lab1.c1(), a1 = lab1.c2(), b1 = lab1.c3();
         double l2 = lab2.c1(), a2 = lab2.c2(), b2 = lab2.c3();
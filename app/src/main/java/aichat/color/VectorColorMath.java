@@ -0,0 +1,280 @@
+package aichat.color;
+
+import jdk.incubator.vector.FloatVector;
+import jdk.incubator.vector.IntVector;
+import jdk.incubator.vector.VectorMask;
+import jdk.incubator.vector.VectorOperators;
+import jdk.incubator.vector.VectorSpecies;
+
+/**
+ * Vector API versions of the {@link ColorSpaceConverter} batch paths for the
+ * Java fallback. Colors are structure-of-arrays float batches, one array per
+ * channel, and pow, cbrt, atan2 and sin are polynomial approximations built
+ * from lane-wise arithmetic so a whole batch stays in SIMD registers. Results
+ * track the scalar double-precision path to within about 1e-3 (L*a*b* units,
+ * RGB levels, ΔE).
+ *
+ * <p>Only load this class when {@code jdk.incubator.vector} is in the boot
+ * layer; {@link ColorSpaceConverter} checks before calling in.
+ */
+final class VectorColorMath {
+
+    private static final VectorSpecies<Float> SPECIES = FloatVector.SPECIES_PREFERRED;
+
+    private static final float REF_X = 95.047f;
+    private static final float REF_Y = 100.000f;
+    private static final float REF_Z = 108.883f;
+
+    private static final float EPSILON = 0.008856f;
+    private static final float KAPPA = 903.3f;
+    private static final float DELTA = 6f / 29f;
+
+    private static final float PI = (float) Math.PI;
+    private static final float TWO_PI = (float) (2 * Math.PI);
+    private static final float HALF_PI = (float) (Math.PI / 2);
+    private static final float SQRT2 = (float) Math.sqrt(2);
+    private static final float LN2 = (float) Math.log(2);
+    private static final float LOG2E = (float) (1 / Math.log(2));
+    private static final float POW25_7 = 6103515625f;
+
+    private static final float RAD_6 = (float) Math.toRadians(6);
+    private static final float RAD_25 = (float) Math.toRadians(25);
+    private static final float RAD_30 = (float) Math.toRadians(30);
+    private static final float RAD_63 = (float) Math.toRadians(63);
+    private static final float RAD_275 = (float) Math.toRadians(275);
+
+    private VectorColorMath() {}
+
+    /** Converts the first {@code n} sRGB colors (0-255) to CIELAB in place. */
+    static void rgbToLab(float[] c1, float[] c2, float[] c3, int n) {
+        for (int i = 0; i < n; i += SPECIES.length()) {
+            VectorMask<Float> m = SPECIES.indexInRange(i, n);
+            FloatVector r = linearize(FloatVector.fromArray(SPECIES, c1, i, m));
+            FloatVector g = linearize(FloatVector.fromArray(SPECIES, c2, i, m));
+            FloatVector b = linearize(FloatVector.fromArray(SPECIES, c3, i, m));
+
+            FloatVector x = r.mul(0.4124564f).add(g.mul(0.3575761f)).add(b.mul(0.1804375f));
+            FloatVector y = r.mul(0.2126729f).add(g.mul(0.7151522f)).add(b.mul(0.0721750f));
+            FloatVector z = r.mul(0.0193339f).add(g.mul(0.1191920f)).add(b.mul(0.9503041f));
+
+            FloatVector fx = labF(x.div(REF_X));
+            FloatVector fy = labF(y.div(REF_Y));
+            FloatVector fz = labF(z.div(REF_Z));
+
+            fy.mul(116f).sub(16f).intoArray(c1, i, m);
+            fx.sub(fy).mul(500f).intoArray(c2, i, m);
+            fy.sub(fz).mul(200f).intoArray(c3, i, m);
+        }
+    }
+
+    /** Converts the first {@code n} CIELAB colors to sRGB (0-255, clamped) in place. */
+    static void labToRgb(float[] c1, float[] c2, float[] c3, int n) {
+        for (int i = 0; i < n; i += SPECIES.length()) {
+            VectorMask<Float> m = SPECIES.indexInRange(i, n);
+            FloatVector l = FloatVector.fromArray(SPECIES, c1, i, m);
+            FloatVector a = FloatVector.fromArray(SPECIES, c2, i, m);
+            FloatVector b = FloatVector.fromArray(SPECIES, c3, i, m);
+
+            FloatVector fy = l.add(16f).div(116f);
+            FloatVector fx = a.div(500f).add(fy);
+            FloatVector fz = fy.sub(b.div(200f));
+
+            FloatVector x = labFInverse(fx).mul(REF_X / 100);
+            FloatVector y = labFInverse(fy).mul(REF_Y / 100);
+            FloatVector z = labFInverse(fz).mul(REF_Z / 100);
+
+            encode(x.mul(3.2404542f).add(y.mul(-1.5371385f)).add(z.mul(-0.4985314f))).intoArray(c1, i, m);
+            encode(x.mul(-0.9692660f).add(y.mul(1.8760108f)).add(z.mul(0.0415560f))).intoArray(c2, i, m);
+            encode(x.mul(0.0556434f).add(y.mul(-0.2040259f)).add(z.mul(1.0572252f))).intoArray(c3, i, m);
+        }
+    }
+
+    /** CIEDE2000 between the first {@code n} pairs of CIELAB colors, written to {@code out}. */
+    static void deltaE2000(float[] l1, float[] a1, float[] b1,
+                           float[] l2, float[] a2, float[] b2, float[] out, int n) {
+        for (int i = 0; i < n; i += SPECIES.length()) {
+            VectorMask<Float> m = SPECIES.indexInRange(i, n);
+            deltaE2000(
+                FloatVector.fromArray(SPECIES, l1, i, m),
+                FloatVector.fromArray(SPECIES, a1, i, m),
+                FloatVector.fromArray(SPECIES, b1, i, m),
+                FloatVector.fromArray(SPECIES, l2, i, m),
+                FloatVector.fromArray(SPECIES, a2, i, m),
+                FloatVector.fromArray(SPECIES, b2, i, m)
+            ).intoArray(out, i, m);
+        }
+    }
+
+    private static FloatVector deltaE2000(FloatVector l1, FloatVector a1, FloatVector b1,
+                                          FloatVector l2, FloatVector a2, FloatVector b2) {
+        FloatVector c1 = a1.mul(a1).add(b1.mul(b1)).sqrt();
+        FloatVector c2 = a2.mul(a2).add(b2.mul(b2)).sqrt();
+        FloatVector g = chromaWeight(c1.add(c2).mul(0.5f)).neg().add(1f).mul(0.5f);
+
+        FloatVector a1Prime = a1.mul(g.add(1f));
+        FloatVector a2Prime = a2.mul(g.add(1f));
+        FloatVector c1Prime = a1Prime.mul(a1Prime).add(b1.mul(b1)).sqrt();
+        FloatVector c2Prime = a2Prime.mul(a2Prime).add(b2.mul(b2)).sqrt();
+        FloatVector h1Prime = atan2(b1, a1Prime);
+        FloatVector h2Prime = atan2(b2, a2Prime);
+
+        FloatVector deltaL = l2.sub(l1);
+        FloatVector deltaC = c2Prime.sub(c1Prime);
+
+        // The scalar branches become masks: hue difference taken the short way
+        // round the circle, and zero whenever either color is achromatic
+        FloatVector chromaProduct = c1Prime.mul(c2Prime);
+        VectorMask<Float> achromatic = chromaProduct.compare(VectorOperators.EQ, 0f);
+        FloatVector dh = h2Prime.sub(h1Prime);
+        VectorMask<Float> wrapped = dh.abs().compare(VectorOperators.GT, PI);
+        FloatVector deltah = dh
+            .blend(dh.sub(TWO_PI), wrapped.and(dh.compare(VectorOperators.GT, 0f)))
+            .blend(dh.add(TWO_PI), wrapped.and(dh.compare(VectorOperators.LT, 0f)))
+            .blend(0f, achromatic);
+        FloatVector deltaH = chromaProduct.sqrt().mul(2f).mul(sin(deltah.mul(0.5f)));
+
+        FloatVector lAvg = l1.add(l2).mul(0.5f);
+        FloatVector cPrimeAvg = c1Prime.add(c2Prime).mul(0.5f);
+
+        FloatVector hSum = h1Prime.add(h2Prime);
+        FloatVector hPrimeAvg = hSum.mul(0.5f)
+            .blend(hSum.add(TWO_PI).mul(0.5f), wrapped.and(hSum.compare(VectorOperators.LT, TWO_PI)))
+            .blend(hSum.sub(TWO_PI).mul(0.5f), wrapped.and(hSum.compare(VectorOperators.GE, TWO_PI)))
+            .blend(hSum, achromatic);
+
+        FloatVector t = cos(hPrimeAvg.sub(RAD_30)).mul(-0.17f).add(1f)
+            .add(cos(hPrimeAvg.mul(2f)).mul(0.24f))
+            .add(cos(hPrimeAvg.mul(3f).add(RAD_6)).mul(0.32f))
+            .sub(cos(hPrimeAvg.mul(4f).sub(RAD_63)).mul(0.20f));
+
+        FloatVector lOffset = lAvg.sub(50f).mul(lAvg.sub(50f));
+        FloatVector sl = lOffset.mul(0.015f).div(lOffset.add(20f).sqrt()).add(1f);
+        FloatVector sc = cPrimeAvg.mul(0.045f).add(1f);
+        FloatVector sh = cPrimeAvg.mul(t).mul(0.015f).add(1f);
+
+        FloatVector rc = chromaWeight(cPrimeAvg).mul(2f);
+        FloatVector hueOffset = hPrimeAvg.sub(RAD_275).div(RAD_25);
+        FloatVector deltaTheta = exp2(hueOffset.mul(hueOffset).mul(-LOG2E)).mul(RAD_30);
+        FloatVector rt = sin(deltaTheta.mul(2f)).mul(rc).neg();
+
+        FloatVector termL = deltaL.div(sl);
+        FloatVector termC = deltaC.div(sc);
+        FloatVector termH = deltaH.div(sh);
+        return termL.mul(termL)
+            .add(termC.mul(termC))
+            .add(termH.mul(termH))
+            .add(rt.mul(termC).mul(termH))
+            .max(0f)
+            .sqrt();
+    }
+
+    /** sqrt(c^7 / (c^7 + 25^7)), with the seventh power by multiplication. */
+    private static FloatVector chromaWeight(FloatVector c) {
+        FloatVector c2 = c.mul(c);
+        FloatVector c7 = c2.mul(c2).mul(c2).mul(c);
+        return c7.div(c7.add(POW25_7)).sqrt();
+    }
+
+    /** sRGB 0-255 to linear light 0-100. */
+    private static FloatVector linearize(FloatVector c) {
+        c = c.div(255f);
+        FloatVector curve = pow(c.add(0.055f).div(1.055f), 2.4f);
+        return c.div(12.92f).blend(curve, c.compare(VectorOperators.GT, 0.04045f)).mul(100f);
+    }
+
+    /** Linear light 0-1 to sRGB 0-255. */
+    private static FloatVector encode(FloatVector c) {
+        FloatVector curve = pow(c, 1 / 2.4f).mul(1.055f).sub(0.055f);
+        return c.mul(12.92f).blend(curve, c.compare(VectorOperators.GT, 0.0031308f))
+            .mul(255f).max(0f).min(255f);
+    }
+
+    private static FloatVector labF(FloatVector t) {
+        return t.mul(KAPPA).add(16f).div(116f).blend(cbrt(t), t.compare(VectorOperators.GT, EPSILON));
+    }
+
+    private static FloatVector labFInverse(FloatVector t) {
+        return t.sub(4f / 29).mul(3 * DELTA * DELTA).blend(t.mul(t).mul(t), t.compare(VectorOperators.GT, DELTA));
+    }
+
+    /** x^p for positive x; other lanes are garbage for the caller to blend away. */
+    private static FloatVector pow(FloatVector x, float p) {
+        return exp2(log2(x).mul(p));
+    }
+
+    /** Cube root of positive t: exp2/log2 estimate polished by one Newton step. */
+    private static FloatVector cbrt(FloatVector t) {
+        FloatVector y = exp2(log2(t).mul(1f / 3));
+        return y.add(y).add(t.div(y.mul(y))).mul(1f / 3);
+    }
+
+    /**
+     * log2 of positive normal x: the exponent field plus ln(m)/ln(2) for the
+     * mantissa m in [sqrt(1/2), sqrt(2)), via the atanh series in (m-1)/(m+1).
+     */
+    private static FloatVector log2(FloatVector x) {
+        IntVector bits = x.reinterpretAsInts();
+        FloatVector e = (FloatVector) bits.lanewise(VectorOperators.LSHR, 23).sub(127)
+            .convert(VectorOperators.I2F, 0);
+        FloatVector m = bits.and(0x007FFFFF).or(0x3F800000).reinterpretAsFloats();
+        VectorMask<Float> high = m.compare(VectorOperators.GT, SQRT2);
+        m = m.blend(m.mul(0.5f), high);
+        e = e.blend(e.add(1f), high);
+
+        FloatVector s = m.sub(1f).div(m.add(1f));
+        FloatVector s2 = s.mul(s);
+        FloatVector series = s2.mul(1f / 9).add(1f / 7).mul(s2).add(1f / 5).mul(s2).add(1f / 3).mul(s2).add(1f).mul(s);
+        return series.mul(2 * LOG2E).add(e);
+    }
+
+    /** 2^y for y clamped to [-126, 126]: exponent bits of round(y) times a Taylor series for the rest. */
+    private static FloatVector exp2(FloatVector y) {
+        y = y.max(-126f).min(126f);
+        // y + 127.5 is positive, so truncation floors it to the biased exponent of round(y)
+        IntVector k = (IntVector) y.add(127.5f).convert(VectorOperators.F2I, 0);
+        FloatVector f = y.sub(((FloatVector) k.convert(VectorOperators.I2F, 0)).sub(127f));
+        FloatVector x = f.mul(LN2);
+        FloatVector p = x.mul(1f / 720).add(1f / 120).mul(x).add(1f / 24).mul(x)
+            .add(1f / 6).mul(x).add(0.5f).mul(x).add(1f).mul(x).add(1f);
+        return p.mul(k.lanewise(VectorOperators.LSHL, 23).reinterpretAsFloats());
+    }
+
+    private static FloatVector floor(FloatVector v) {
+        FloatVector t = (FloatVector) v.convert(VectorOperators.F2I, 0).convert(VectorOperators.I2F, 0);
+        return t.blend(t.sub(1f), t.compare(VectorOperators.GT, v));
+    }
+
+    /** sin x: reduce to [-pi/4, pi/4] by quarter turns, then pick the sin or cos series by quadrant. */
+    private static FloatVector sin(FloatVector x) {
+        FloatVector q = floor(x.mul(2 / PI).add(0.5f));
+        FloatVector r = x.sub(q.mul(HALF_PI));
+        FloatVector r2 = r.mul(r);
+        FloatVector s = r2.mul(-1f / 5040).add(1f / 120).mul(r2).add(-1f / 6).mul(r2).add(1f).mul(r);
+        FloatVector c = r2.mul(1f / 40320).add(-1f / 720).mul(r2).add(1f / 24).mul(r2).add(-0.5f).mul(r2).add(1f);
+
+        FloatVector quadrant = q.sub(floor(q.mul(0.25f)).mul(4f));
+        VectorMask<Float> odd = quadrant.compare(VectorOperators.EQ, 1f)
+            .or(quadrant.compare(VectorOperators.EQ, 3f));
+        FloatVector v = s.blend(c, odd);
+        return v.blend(v.neg(), quadrant.compare(VectorOperators.GE, 2f));
+    }
+
+    private static FloatVector cos(FloatVector x) {
+        return sin(x.add(HALF_PI));
+    }
+
+    /** atan2 shifted to [0, 2pi), as the scalar path uses it for hue angles. */
+    private static FloatVector atan2(FloatVector y, FloatVector x) {
+        FloatVector ax = x.abs();
+        FloatVector ay = y.abs();
+        FloatVector ratio = ax.min(ay).div(ax.max(ay).max(1e-30f));
+        FloatVector r2 = ratio.mul(ratio);
+        FloatVector angle = r2.mul(-0.01172120f).add(0.05265332f).mul(r2).add(-0.11643287f).mul(r2)
+            .add(0.19354346f).mul(r2).add(-0.33262347f).mul(r2).add(0.99997726f).mul(ratio);
+
+        angle = angle.blend(angle.neg().add(HALF_PI), ay.compare(VectorOperators.GT, ax));
+        angle = angle.blend(angle.neg().add(PI), x.compare(VectorOperators.LT, 0f));
+        angle = angle.blend(angle.neg(), y.compare(VectorOperators.LT, 0f));
+        return angle.blend(angle.add(TWO_PI), angle.compare(VectorOperators.LT, 0f));
+    }
+}
@@ -0,0 +1,71 @@
+package aichat.core;
+
+import java.util.stream.IntStream;
+
+/**
+ * Java box-filter (area-average) downscale, the fallback for
+ * downscale_box and downscale_lanczos3 in native/src/resample.c: same source
+ * spans and rounding as downscale_box, so the two agree exactly.
+ */
+public final class BoxResampler {
+
+    private BoxResampler() {}
+
+    /**
+     * Downscales {@code width x height} packed RGB pixels into {@code out} as
+     * {@code dstWidth x dstHeight} opaque ARGB pixels, rows in parallel. Each
+     * target size must be positive and no larger than the source.
+     */
+    public static void downscale(int[] pixels, int width, int height,
+                                 int[] out, int dstWidth, int dstHeight) {
+        if (dstWidth <= 0 || dstHeight <= 0 || dstWidth > width || dstHeight > height) {
+            throw new IllegalArgumentException(
+                "Invalid downscale " + width + "x" + height + " -> " + dstWidth + "x" + dstHeight);
+        }
+        IntStream.range(0, dstHeight).parallel().forEach(dy -> {
+            int y0 = span(dy, dstHeight, height);
+            int y1 = span(dy + 1, dstHeight, height);
+            for (int dx = 0; dx < dstWidth; dx++) {
+                int x0 = span(dx, dstWidth, width);
+                int x1 = span(dx + 1, dstWidth, width);
+                long r = 0, g = 0, b = 0;
+                for (int y = y0; y < y1; y++) {
+                    int row = y * width;
+                    for (int x = x0; x < x1; x++) {
+                        int p = pixels[row + x];
+                        r += (p >> 16) & 0xFF;
+                        g += (p >> 8) & 0xFF;
+                        b += p & 0xFF;
+                    }
+                }
+                long count = (long) (x1 - x0) * (y1 - y0);
+                long half = count / 2;
+                out[dy * dstWidth + dx] = 0xFF000000
+                    | (int) ((r + half) / count) << 16
+                    | (int) ((g + half) / count) << 8
+                    | (int) ((b + half) / count);
+            }
+        });
+    }
+
+    /**
+     * Target size fitting {@code width x height} within {@code maxPixels} at
+     * the same aspect ratio, as {width, height}; the size itself when it fits.
+     */
+    public static int[] fitWithin(int width, int height, long maxPixels) {
+        long pixels = (long) width * height;
+        if (pixels <= maxPixels) {
+            return new int[] { width, height };
+        }
+        double scale = Math.sqrt((double) maxPixels / pixels);
+        return new int[] {
+            Math.max(1, Math.min(width, (int) (width * scale))),
+            Math.max(1, Math.min(height, (int) (height * scale)))
+        };
+    }
+
+    // First source index of output index i of n over size pixels
+    private static int span(int i, int n, int size) {
+        return (int) ((long) i * size / n);
+    }
+}
@@ -2,12 +2,20 @@ package aichat.core;
 
 import aichat.algorithm.ClusteringStrategy;
 import aichat.algorithm.HybridClusterer;
+import aichat.algorithm.TreeVectorQuantizer;
 import aichat.color.ColorSpaceConverter;
+import aichat.diagnostics.PaletteMappingEvent;
+import aichat.diagnostics.ResynthesisEvent;
+import aichat.diagnostics.SamplingEvent;
 import aichat.model.ColorPalette;
 import aichat.model.ColorPoint;
+import aichat.model.ColorStatistics;
 import aichat.native_.NativeAccelerator;
 
+import java.awt.Rectangle;
 import java.awt.image.BufferedImage;
+import java.awt.image.DataBufferInt;
+import java.nio.IntBuffer;
 import java.util.ArrayList;
 import java.util.List;
 import java.util.Random;
@@ -19,13 +27,30 @@ public class ImageHarmonyEngine {
     }
     
     private static final int MAX_PIXELS = 10000;
+    // Above this k the palette is built by tree-structured VQ
+    private static final int LARGE_PALETTE_THRESHOLD = 512;
+    private static final int LARGE_PALETTE_SAMPLES_PER_COLOR = 8;
     private static final int MAX_TILE_PIXELS = 16 * 1024 * 1024;
     private static final long DEFAULT_SEED = 42L;
+    private static final int FULL_RESOLUTION_MAX_ITERATIONS = 50;
+    private static final double FULL_RESOLUTION_THRESHOLD = 0.5;
+    private static final int SUPERPIXEL_COUNT = 4096;
+    private static final double SUPERPIXEL_COMPACTNESS = 10.0;
+    private static final int SUPERPIXEL_ITERATIONS = 10;
+    // Sampled analysis of larger images runs on an area-averaged proxy
+    private static final long ANALYSIS_PROXY_THRESHOLD = 24L * 1024 * 1024;
+    private static final long ANALYSIS_PROXY_PIXELS = 8L * 1024 * 1024;
+    // Pixels sampled for color statistics, enough for means and deviations to settle
+    private static final int STATISTICS_SAMPLES = 1 << 18;
     
     private final ColorModel colorModel;
     private final ClusteringStrategy clusteringStrategy;
+    private final ClusteringStrategy largePaletteStrategy;
     private final NativeAccelerator nativeAccelerator;
     private final long seed;
+    private volatile PaletteMapping lastMapping;
+    
+    private record PaletteMapping(ColorPalette source, ColorPalette target, ColorPalette mappedSource) {}
     
     public ImageHarmonyEngine() {
         this(ColorModel.RGB, DEFAULT_SEED);
@@ -39,22 +64,40 @@ public class ImageHarmonyEngine {
         this.colorModel = colorModel;
         this.seed = seed;
         this.clusteringStrategy = new HybridClusterer(seed);
+        this.largePaletteStrategy = new TreeVectorQuantizer();
         this.nativeAccelerator = NativeAccelerator.getInstance();
     }
     
     public ColorPalette analyze(BufferedImage image, int k) {
+        if ((long) image.getWidth() * image.getHeight() > ANALYSIS_PROXY_THRESHOLD) {
+            image = proxy(image, ANALYSIS_PROXY_PIXELS, NativeAccelerator.ResampleFilter.BOX);
+        }
+        boolean largePalette = k > LARGE_PALETTE_THRESHOLD;
+        int maxSamples = largePalette ? Math.max(MAX_PIXELS, k * LARGE_PALETTE_SAMPLES_PER_COLOR) : MAX_PIXELS;
         List<ColorPoint> sampledPixels = null;
         
+        SamplingEvent sampling = new SamplingEvent();
+        sampling.begin();
+        sampling.backend = "native";
         if (nativeAccelerator.isAvailable()) {
             int width = image.getWidth();
             int height = image.getHeight();
             int[] rawPixels = new int[width * height];
             image.getRGB(0, 0, width, height, rawPixels, 0, width);
-            sampledPixels = nativeAccelerator.samplePixelsFromImage(rawPixels, MAX_PIXELS, seed);
+            sampledPixels = nativeAccelerator.samplePixelsFromImage(rawPixels, maxSamples, seed);
         }
         
         if (sampledPixels == null) {
-            sampledPixels = extractPixels(image, MAX_PIXELS);
+            sampling.backend = "java";
+            sampledPixels = extractPixels(image, maxSamples);
+        }
+        sampling.end();
+        if (sampling.shouldCommit()) {
+            sampling.width = image.getWidth();
+            sampling.height = image.getHeight();
+            sampling.requested = maxSamples;
+            sampling.samples = sampledPixels.size();
+            sampling.commit();
         }
 
         if (k > sampledPixels.size()) {
@@ -62,12 +105,94 @@ public class ImageHarmonyEngine {
         }
 
         List<ColorPoint> workingPixels = convertColorSpace(sampledPixels, true);
-        List<ColorPoint> centroids = clusteringStrategy.cluster(workingPixels, k);
+        ClusteringStrategy strategy = largePalette ? largePaletteStrategy : clusteringStrategy;
+        List<ColorPoint> centroids = strategy.cluster(workingPixels, k);
         List<ColorPoint> resultColors = convertColorSpace(centroids, false);
 
         return new ColorPalette(resultColors);
     }
     
+    /**
+     * The image scaled down to at most {@code maxPixels} pixels at the same
+     * aspect ratio, as TYPE_INT_RGB; the image itself when it already fits.
+     * Filtered natively with {@code filter}; the Java fallback is always a
+     * box filter.
+     */
+    public BufferedImage proxy(BufferedImage image, long maxPixels, NativeAccelerator.ResampleFilter filter) {
+        int width = image.getWidth();
+        int height = image.getHeight();
+        int[] size = BoxResampler.fitWithin(width, height, maxPixels);
+        if (size[0] == width && size[1] == height) {
+            return image;
+        }
+        
+        int[] pixels = PaletteLut.directPixels(image);
+        if (pixels == null) {
+            pixels = image.getRGB(0, 0, width, height, null, 0, width);
+        }
+        BufferedImage result = new BufferedImage(size[0], size[1], BufferedImage.TYPE_INT_RGB);
+        int[] output = ((DataBufferInt) result.getRaster().getDataBuffer()).getData();
+        IntBuffer scaled = nativeAccelerator.downscaleImage(pixels, width, height, size[0], size[1], filter);
+        if (scaled != null) {
+            scaled.get(output);
+        } else {
+            BoxResampler.downscale(pixels, width, height, output, size[0], size[1]);
+        }
+        return result;
+    }
+    
+    /**
+     * Fits the palette to every pixel of the image instead of a sample.
+     * Runs exact streaming k-means natively; CIELAB engines and the Java
+     * fallback use the sampled {@link #analyze(BufferedImage, int)} instead.
+     */
+    public ColorPalette analyzeFullResolution(BufferedImage image, int k) {
+        if (colorModel == ColorModel.RGB && nativeAccelerator.isAvailable()) {
+            int width = image.getWidth();
+            int height = image.getHeight();
+            int[] rawPixels = new int[width * height];
+            image.getRGB(0, 0, width, height, rawPixels, 0, width);
+            
+            List<ColorPoint> centroids = nativeAccelerator.kmeansClusterImage(
+                rawPixels, k, FULL_RESOLUTION_MAX_ITERATIONS, FULL_RESOLUTION_THRESHOLD, seed);
+            if (centroids != null) {
+                return new ColorPalette(centroids);
+            }
+        }
+        
+        return analyze(image, k);
+    }
+    
+    /**
+     * Clusters SLIC superpixels instead of sampled pixels: each superpixel's
+     * mean color is weighted by its area, so spatially coherent regions count
+     * in proportion to their size while near-duplicate pixels collapse into
+     * one point. Falls back to {@link #analyze(BufferedImage, int)} without
+     * the native library.
+     */
+    public ColorPalette analyzeSuperpixels(BufferedImage image, int k) {
+        if (nativeAccelerator.isAvailable()) {
+            int width = image.getWidth();
+            int height = image.getHeight();
+            int[] rawPixels = new int[width * height];
+            image.getRGB(0, 0, width, height, rawPixels, 0, width);
+            
+            NativeAccelerator.Superpixels superpixels = nativeAccelerator.slicSuperpixels(
+                rawPixels, width, height, SUPERPIXEL_COUNT, SUPERPIXEL_COMPACTNESS, SUPERPIXEL_ITERATIONS);
+            if (superpixels != null) {
+                List<ColorPoint> workingPoints = convertColorSpace(superpixels.means(), true);
+                List<ColorPoint> centroids = nativeAccelerator.kmeansClusterWeighted(
+                    workingPoints, superpixels.areas(), k,
+                    FULL_RESOLUTION_MAX_ITERATIONS, FULL_RESOLUTION_THRESHOLD, seed);
+                if (centroids != null) {
+                    return new ColorPalette(convertColorSpace(centroids, false));
+                }
+            }
+        }
+        
+        return analyze(image, k);
+    }
+    
     /**
      * Resynthesize with color transfer - preserves image details.
      * Each pixel's offset from the nearest target palette color is preserved
@@ -89,20 +214,177 @@ public class ImageHarmonyEngine {
         return resynthesizeInternal(targetImage, sourcePalette, targetPalette, true);
     }
     
+    /**
+     * Resynthesizes (or posterizes) only {@code region} of the image, scaled
+     * by {@code scale} (capped at 1), for interactive previews. The region is
+     * area-averaged down before mapping, so the cost follows the output size
+     * rather than the image size, and the palette mapping and the native or
+     * Java LUT are reused across calls with the same palettes. Averaging
+     * first can blend pixels a full-resolution pass would map to different
+     * palette colors, so edges may differ slightly from a downscaled
+     * {@link #resynthesize} result.
+     */
+    public BufferedImage resynthesizeViewport(BufferedImage targetImage,
+                                              ColorPalette sourcePalette,
+                                              ColorPalette targetPalette,
+                                              Rectangle region,
+                                              double scale,
+                                              boolean posterize) {
+        int imageWidth = targetImage.getWidth();
+        int imageHeight = targetImage.getHeight();
+        Rectangle clipped = region.intersection(new Rectangle(0, 0, imageWidth, imageHeight));
+        if (clipped.isEmpty() || !(scale > 0)) {
+            throw new IllegalArgumentException("Empty viewport " + region + " at scale " + scale);
+        }
+        int width = clipped.width;
+        int height = clipped.height;
+        int outWidth = Math.max(1, Math.min(width, (int) Math.round(width * scale)));
+        int outHeight = Math.max(1, Math.min(height, (int) Math.round(height * scale)));
+        
+        ResynthesisEvent event = new ResynthesisEvent();
+        event.begin();
+        ColorPalette mappedSource = mappedSourcePalette(sourcePalette, targetPalette);
+        
+        int[] pixels = width == imageWidth && height == imageHeight ? PaletteLut.directPixels(targetImage) : null;
+        if (pixels == null) {
+            pixels = targetImage.getRGB(clipped.x, clipped.y, width, height, null, 0, width);
+        }
+        if (outWidth < width || outHeight < height) {
+            int[] scaled = new int[outWidth * outHeight];
+            IntBuffer buffer = nativeAccelerator.downscaleImage(
+                pixels, width, height, outWidth, outHeight, NativeAccelerator.ResampleFilter.BOX);
+            if (buffer != null) {
+                buffer.get(scaled);
+            } else {
+                BoxResampler.downscale(pixels, width, height, scaled, outWidth, outHeight);
+            }
+            pixels = scaled;
+        }
+        
+        BufferedImage output = new BufferedImage(outWidth, outHeight, BufferedImage.TYPE_INT_RGB);
+        int[] outputPixels = ((DataBufferInt) output.getRaster().getDataBuffer()).getData();
+        int[] result = null;
+        if (nativeAccelerator.isAvailable()) {
+            result = posterize
+                ? nativeAccelerator.posterizeImage(pixels, outWidth, outHeight, targetPalette, mappedSource)
+                : nativeAccelerator.resynthesizeImage(pixels, outWidth, outHeight, targetPalette, mappedSource);
+            if (result == null) {
+                event.fallbacks++;
+            }
+        }
+        if (result != null) {
+            event.backend = "native";
+            System.arraycopy(result, 0, outputPixels, 0, outputPixels.length);
+        } else {
+            event.backend = "java";
+            PaletteLut.of(targetPalette).map(pixels, 0, outputPixels, 0, outWidth, outHeight,
+                PaletteLut.pack(mappedSource), posterize);
+        }
+        
+        event.end();
+        if (event.shouldCommit()) {
+            event.mode = (posterize ? "posterize" : "resynthesize") + "-viewport";
+            event.width = outWidth;
+            event.height = outHeight;
+            event.paletteSize = targetPalette.size();
+            event.commit();
+        }
+        return output;
+    }
+    
+    /**
+     * Per-channel Lab mean and standard deviation of the image, from a grid
+     * of about 2^18 pixels, for {@link #transfer}.
+     */
+    public ColorStatistics statistics(BufferedImage image) {
+        int width = image.getWidth();
+        int height = image.getHeight();
+        int[] pixels = PaletteLut.directPixels(image);
+        if (pixels == null) {
+            pixels = image.getRGB(0, 0, width, height, null, 0, width);
+        }
+        ColorStatistics stats = nativeAccelerator.labStatistics(pixels, width, height, STATISTICS_SAMPLES);
+        if (stats == null) {
+            stats = StatisticalTransfer.statistics(pixels, width, height, STATISTICS_SAMPLES);
+        }
+        return stats;
+    }
+    
+    /**
+     * Reinhard statistical color transfer: scales and shifts each Lab channel
+     * of the target image so its mean and standard deviation, given as
+     * {@code targetStatistics}, become {@code sourceStatistics}. No clustering
+     * or palette mapping is involved; the mapping is evaluated on a 33^3 RGB
+     * grid and applied with one trilinear lookup per pixel.
+     */
+    public BufferedImage transfer(BufferedImage targetImage,
+                                  ColorStatistics sourceStatistics,
+                                  ColorStatistics targetStatistics) {
+        int width = targetImage.getWidth();
+        int height = targetImage.getHeight();
+        
+        ResynthesisEvent event = new ResynthesisEvent();
+        event.begin();
+        int[] pixels = PaletteLut.directPixels(targetImage);
+        if (pixels == null) {
+            pixels = targetImage.getRGB(0, 0, width, height, null, 0, width);
+        }
+        
+        BufferedImage output = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
+        int[] outputPixels = ((DataBufferInt) output.getRaster().getDataBuffer()).getData();
+        boolean transferred = false;
+        if (nativeAccelerator.isAvailable()) {
+            transferred = nativeAccelerator.reinhardTransfer(pixels, width, height,
+                sourceStatistics, targetStatistics, outputPixels);
+            if (!transferred) {
+                event.fallbacks++;
+            }
+        }
+        if (transferred) {
+            event.backend = "native";
+        } else {
+            event.backend = "java";
+            StatisticalTransfer.apply(pixels, outputPixels, outputPixels.length, sourceStatistics, targetStatistics);
+        }
+        
+        event.end();
+        if (event.shouldCommit()) {
+            event.mode = "transfer";
+            event.width = width;
+            event.height = height;
+            event.commit();
+        }
+        return output;
+    }
+    
     private BufferedImage resynthesizeInternal(BufferedImage targetImage, 
                                                 ColorPalette sourcePalette, 
                                                 ColorPalette targetPalette,
                                                 boolean posterize) {
-        int[] mapping = targetPalette.computeMappingTo(sourcePalette);
-        
-        List<ColorPoint> targetColors = targetPalette.getColors();
-        List<ColorPoint> sourceColors = sourcePalette.getColors();
-        
-        ColorPalette mappedSource = new ColorPalette(
-            java.util.stream.IntStream.range(0, targetColors.size())
-                .mapToObj(i -> sourceColors.get(mapping[i]))
-                .toList()
-        );
+        ResynthesisEvent event = new ResynthesisEvent();
+        event.begin();
+        BufferedImage output = resynthesizeWithBackends(targetImage, sourcePalette, targetPalette, posterize, event);
+        event.end();
+        if (event.shouldCommit()) {
+            event.mode = posterize ? "posterize" : "resynthesize";
+            event.width = targetImage.getWidth();
+            event.height = targetImage.getHeight();
+            event.paletteSize = targetPalette.size();
+            event.commit();
+        }
+        return output;
+    }
+    
+    /**
+     * Runs the first backend that succeeds, recording it and the number of
+     * failed attempts on {@code event}.
+     */
+    private BufferedImage resynthesizeWithBackends(BufferedImage targetImage,
+                                                   ColorPalette sourcePalette,
+                                                   ColorPalette targetPalette,
+                                                   boolean posterize,
+                                                   ResynthesisEvent event) {
+        ColorPalette mappedSource = mappedSourcePalette(sourcePalette, targetPalette);
         
         int width = targetImage.getWidth();
         int height = targetImage.getHeight();
@@ -122,13 +404,16 @@ public class ImageHarmonyEngine {
                 );
                 
                 if (result != null) {
+                    event.backend = "native";
                     BufferedImage output = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
                     output.setRGB(0, 0, width, height, result, 0, width);
                     return output;
                 }
+                event.fallbacks++;
             }
             // Fallback to Java
-            return posterizeJava(targetImage, mappedSource, targetPalette);
+            event.backend = "java";
+            return mapJava(targetImage, pixels, mappedSource, targetPalette, true);
         }
         
         // Try GPU first for large images (>1MP) - much faster
@@ -140,16 +425,19 @@ public class ImageHarmonyEngine {
             );
             
             if (result != null) {
+                event.backend = "gpu";
                 BufferedImage output = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
                 output.setRGB(0, 0, width, height, result, 0, width);
                 return output;
             }
             // Fall through to CPU if GPU failed
+            event.fallbacks++;
         }
         
         if (nativeAccelerator.isAvailable()) {
             // Use tiled processing for very large images to limit memory
             if (totalPixels > MAX_TILE_PIXELS) {
+                event.backend = "native-tiled";
                 return resynthesizeTiled(targetImage, mappedSource, targetPalette);
             }
             
@@ -160,13 +448,50 @@ public class ImageHarmonyEngine {
             );
             
             if (result != null) {
+                event.backend = "native";
                 BufferedImage output = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
                 output.setRGB(0, 0, width, height, result, 0, width);
                 return output;
             }
+            event.fallbacks++;
+        }
+        
+        event.backend = "java";
+        return mapJava(targetImage, pixels, mappedSource, targetPalette, false);
+    }
+    
+    /**
+     * Source colors reordered so entry i is the one target color i maps to.
+     * The last mapping is kept, so a viewport preview followed by the full
+     * resynthesis with the same palettes solves the assignment once.
+     */
+    private ColorPalette mappedSourcePalette(ColorPalette sourcePalette, ColorPalette targetPalette) {
+        PaletteMapping last = lastMapping;
+        if (last != null && last.source() == sourcePalette && last.target() == targetPalette) {
+            return last.mappedSource();
+        }
+        
+        PaletteMappingEvent mappingEvent = new PaletteMappingEvent();
+        mappingEvent.begin();
+        int[] mapping = targetPalette.computeMappingTo(sourcePalette);
+        mappingEvent.end();
+        if (mappingEvent.shouldCommit()) {
+            mappingEvent.fromColors = targetPalette.size();
+            mappingEvent.toColors = sourcePalette.size();
+            mappingEvent.matrixSize = Math.max(targetPalette.size(), sourcePalette.size());
+            mappingEvent.commit();
         }
         
-        return resynthesizeJava(targetImage, mappedSource, targetPalette);
+        List<ColorPoint> targetColors = targetPalette.getColors();
+        List<ColorPoint> sourceColors = sourcePalette.getColors();
+        
+        ColorPalette mappedSource = new ColorPalette(
+            java.util.stream.IntStream.range(0, targetColors.size())
+                .mapToObj(i -> sourceColors.get(mapping[i]))
+                .toList()
+        );
+        lastMapping = new PaletteMapping(sourcePalette, targetPalette, mappedSource);
+        return mappedSource;
     }
     
     private BufferedImage resynthesizeTiled(BufferedImage targetImage,
@@ -180,45 +505,31 @@ public class ImageHarmonyEngine {
         if (tileHeight == 0) tileHeight = 64;
         
         BufferedImage output = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
+        int[] outputPixels = ((DataBufferInt) output.getRaster().getDataBuffer()).getData();
+        PaletteLut lut = null;
+        float[] source = null;
         
         int y = 0;
         while (y < height) {
             int currentTileHeight = Math.min(tileHeight, height - y);
             
-            int[] tilePixelsArray = new int[width * currentTileHeight];
-            targetImage.getRGB(0, y, width, currentTileHeight, tilePixelsArray, 0, width);
+            int[] tilePixels = new int[width * currentTileHeight];
+            targetImage.getRGB(0, y, width, currentTileHeight, tilePixels, 0, width);
             
             int[] resultTile = nativeAccelerator.resynthesizeImage(
-                tilePixelsArray, width, currentTileHeight,
+                tilePixels, width, currentTileHeight,
                 targetPalette, mappedSource
             );
             
             if (resultTile != null) {
-                output.setRGB(0, y, width, currentTileHeight, resultTile, 0, width);
+                System.arraycopy(resultTile, 0, outputPixels, y * width, width * currentTileHeight);
             } else {
-                for (int ty = 0; ty < currentTileHeight; ty++) {
-                    for (int x = 0; x < width; x++) {
-                        int idx = ty * width + x;
-                        int rgb = tilePixelsArray[idx];
-                        ColorPoint pixel = ColorPoint.fromRGB(rgb);
-                        
-                        int closest = targetPalette.findClosestIndex(pixel);
-                        ColorPoint targetCenter = targetPalette.getColor(closest);
-                        ColorPoint sourceCenter = mappedSource.getColor(closest);
-                        
-                        double dc1 = pixel.c1() - targetCenter.c1();
-                        double dc2 = pixel.c2() - targetCenter.c2();
-                        double dc3 = pixel.c3() - targetCenter.c3();
-                        
-                        ColorPoint newColor = new ColorPoint(
-                            clamp(sourceCenter.c1() + dc1, 0, 255),
-                            clamp(sourceCenter.c2() + dc2, 0, 255),
-                            clamp(sourceCenter.c3() + dc3, 0, 255)
-                        );
-                        
-                        output.setRGB(x, y + ty, newColor.toRGB());
-                    }
+                // Failed tiles share one Java LUT
+                if (lut == null) {
+                    lut = PaletteLut.of(targetPalette);
+                    source = PaletteLut.pack(mappedSource);
                 }
+                lut.map(tilePixels, 0, outputPixels, y * width, width, currentTileHeight, source, false);
             }
             
             y += currentTileHeight;
@@ -231,37 +542,7 @@ public class ImageHarmonyEngine {
     BufferedImage resynthesizeJava(BufferedImage targetImage,
                                    ColorPalette mappedSource,
                                    ColorPalette targetPalette) {
-        List<ColorPoint> sourceColors = mappedSource.getColors();
-        List<ColorPoint> targetColors = targetPalette.getColors();
-        
-        int width = targetImage.getWidth();
-        int height = targetImage.getHeight();
-        BufferedImage result = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
-        
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int rgb = targetImage.getRGB(x, y);
-                ColorPoint pixel = ColorPoint.fromRGB(rgb);
-                
-                int targetIndex = findClosestIndex(pixel, targetColors);
-                ColorPoint targetCenter = targetColors.get(targetIndex);
-                ColorPoint sourceCenter = sourceColors.get(targetIndex);
-                
-                double dc1 = pixel.c1() - targetCenter.c1();
-                double dc2 = pixel.c2() - targetCenter.c2();
-                double dc3 = pixel.c3() - targetCenter.c3();
-                
-                ColorPoint newColor = new ColorPoint(
-                    clamp(sourceCenter.c1() + dc1, 0, 255),
-                    clamp(sourceCenter.c2() + dc2, 0, 255),
-                    clamp(sourceCenter.c3() + dc3, 0, 255)
-                );
-                
-                result.setRGB(x, y, newColor.toRGB());
-            }
-        }
-        
-        return result;
+        return mapJava(targetImage, null, mappedSource, targetPalette, false);
     }
     
     /**
@@ -272,46 +553,32 @@ public class ImageHarmonyEngine {
     BufferedImage posterizeJava(BufferedImage targetImage,
                                 ColorPalette mappedSource,
                                 ColorPalette targetPalette) {
-        List<ColorPoint> sourceColors = mappedSource.getColors();
-        List<ColorPoint> targetColors = targetPalette.getColors();
-        
+        return mapJava(targetImage, null, mappedSource, targetPalette, true);
+    }
+    
+    /**
+     * Java resynthesis/posterization through the shared {@link PaletteLut},
+     * reading {@code pixels} when the caller already copied them out and the
+     * image's own int[] otherwise, and writing straight into the output's
+     * DataBufferInt.
+     */
+    private BufferedImage mapJava(BufferedImage targetImage, int[] pixels,
+                                  ColorPalette mappedSource, ColorPalette targetPalette,
+                                  boolean posterize) {
         int width = targetImage.getWidth();
         int height = targetImage.getHeight();
-        BufferedImage result = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
-        
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int rgb = targetImage.getRGB(x, y);
-                ColorPoint pixel = ColorPoint.fromRGB(rgb);
-                
-                int targetIndex = findClosestIndex(pixel, targetColors);
-                ColorPoint sourceCenter = sourceColors.get(targetIndex);
-                
-                // Direct replacement - no offset preservation
-                result.setRGB(x, y, sourceCenter.toRGB());
-            }
+        if (pixels == null) {
+            pixels = PaletteLut.directPixels(targetImage);
         }
-        
-        return result;
-    }
-    
-    private double clamp(double value, double min, double max) {
-        return Math.max(min, Math.min(max, value));
-    }
-    
-    private int findClosestIndex(ColorPoint pixel, List<ColorPoint> palette) {
-        int closestIndex = 0;
-        double minDist = Double.MAX_VALUE;
-        
-        for (int i = 0; i < palette.size(); i++) {
-            double dist = pixel.distanceTo(palette.get(i));
-            if (dist < minDist) {
-                minDist = dist;
-                closestIndex = i;
-            }
+        if (pixels == null) {
+            pixels = targetImage.getRGB(0, 0, width, height, null, 0, width);
         }
         
-        return closestIndex;
+        BufferedImage result = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
+        int[] output = ((DataBufferInt) result.getRaster().getDataBuffer()).getData();
+        PaletteLut.of(targetPalette).map(pixels, 0, output, 0, width, height,
+            PaletteLut.pack(mappedSource), posterize);
+        return result;
     }
     
     private List<ColorPoint> extractPixels(BufferedImage image, int maxSamples) {
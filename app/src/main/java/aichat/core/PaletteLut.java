@@ -0,0 +1,211 @@
+package aichat.core;
+
+import aichat.model.ColorPalette;
+import aichat.model.ColorPoint;
+
+import java.awt.image.BufferedImage;
+import java.awt.image.DataBufferInt;
+import java.awt.image.SinglePixelPackedSampleModel;
+import java.awt.image.WritableRaster;
+import java.util.Arrays;
+import java.util.List;
+import java.util.concurrent.atomic.AtomicReference;
+import java.util.stream.IntStream;
+
+/**
+ * Nearest target-palette index for every cell of the RGB cube at
+ * {@link #BITS} bits per channel, the Java counterpart of build_palette_lut
+ * in native/src/image.c: same cell centres, same perceptual weights (taken
+ * from the cell's red channel), lowest index on ties, so the Java fallback
+ * maps pixels exactly as the native LUT does.
+ * <p>
+ * Cells are filled on first use, and the whole cube is built in parallel
+ * once an image has at least as many pixels as cells. The last LUT built is
+ * kept and reused while the target palette stays the same, so resynthesis
+ * tiles and repeated calls share it.
+ */
+final class PaletteLut {
+
+    static final int BITS = 7;
+
+    private static final int DIM = 1 << BITS;
+    private static final int SHIFT = 8 - BITS;
+    private static final int SIZE = DIM * DIM * DIM;
+    private static final float SCALE = 255.0f / (DIM - 1);
+    private static final char UNSET = Character.MAX_VALUE;
+    // Pixels per parallel strip, as in the native schedule(static, 32768)
+    private static final int STRIP_PIXELS = 32768;
+
+    private static final AtomicReference<PaletteLut> LAST = new AtomicReference<>();
+
+    private final float[] palette;
+    private final int paletteSize;
+    // Null when the palette has too many colors for 16-bit indices
+    private final char[] cells;
+    private volatile boolean complete;
+
+    private PaletteLut(float[] palette) {
+        this.palette = palette;
+        this.paletteSize = palette.length / 3;
+        if (paletteSize < UNSET) {
+            cells = new char[SIZE];
+            Arrays.fill(cells, UNSET);
+        } else {
+            cells = null;
+        }
+    }
+
+    /** The LUT for {@code targetPalette}, reusing the last one built when the colors match. */
+    static PaletteLut of(ColorPalette targetPalette) {
+        float[] palette = pack(targetPalette);
+        PaletteLut last = LAST.get();
+        if (last != null && Arrays.equals(last.palette, palette)) {
+            return last;
+        }
+        PaletteLut lut = new PaletteLut(palette);
+        LAST.set(lut);
+        return lut;
+    }
+
+    /** Palette colors as packed float triples, the layout the native side receives. */
+    static float[] pack(ColorPalette palette) {
+        List<ColorPoint> colors = palette.getColors();
+        float[] packed = new float[colors.size() * 3];
+        for (int i = 0; i < colors.size(); i++) {
+            ColorPoint c = colors.get(i);
+            packed[i * 3] = (float) c.c1();
+            packed[i * 3 + 1] = (float) c.c2();
+            packed[i * 3 + 2] = (float) c.c3();
+        }
+        return packed;
+    }
+
+    /**
+     * The int[] behind a TYPE_INT_RGB or TYPE_INT_ARGB image laid out as
+     * width * height packed pixels, or null when pixels must be copied out
+     * with getRGB.
+     */
+    static int[] directPixels(BufferedImage image) {
+        int type = image.getType();
+        if (type != BufferedImage.TYPE_INT_RGB && type != BufferedImage.TYPE_INT_ARGB) {
+            return null;
+        }
+        WritableRaster raster = image.getRaster();
+        if (!(raster.getDataBuffer() instanceof DataBufferInt buffer)
+                || !(raster.getSampleModel() instanceof SinglePixelPackedSampleModel model)
+                || buffer.getNumBanks() != 1 || buffer.getOffset() != 0
+                || raster.getSampleModelTranslateX() != 0 || raster.getSampleModelTranslateY() != 0
+                || model.getScanlineStride() != image.getWidth()) {
+            return null;
+        }
+        int[] data = buffer.getData();
+        return data.length == image.getWidth() * image.getHeight() ? data : null;
+    }
+
+    /** Nearest palette index for a packed RGB pixel. */
+    int nearest(int rgb) {
+        int cell = (((rgb >> 16) & 0xFF) >> SHIFT) << (BITS * 2)
+            | (((rgb >> 8) & 0xFF) >> SHIFT) << BITS
+            | (rgb & 0xFF) >> SHIFT;
+        if (cells == null) {
+            return search(cell);
+        }
+        int index = cells[cell];
+        if (index == UNSET) {
+            // Racing threads store the same value, so the write needs no lock
+            index = search(cell);
+            cells[cell] = (char) index;
+        }
+        return index;
+    }
+
+    /**
+     * Maps {@code height} rows of {@code width} pixels from {@code in} to
+     * {@code out} in parallel row strips: resynthesis moves each pixel by
+     * the offset between its target and source palette colors, posterization
+     * replaces it with the source color.
+     */
+    void map(int[] in, int inOffset, int[] out, int outOffset, int width, int height,
+             float[] source, boolean posterize) {
+        long pixels = (long) width * height;
+        if (pixels >= SIZE) {
+            fill();
+        }
+
+        int rowsPerStrip = Math.max(1, STRIP_PIXELS / Math.max(1, width));
+        int strips = (height + rowsPerStrip - 1) / rowsPerStrip;
+        IntStream range = IntStream.range(0, strips);
+        (strips > 1 ? range.parallel() : range).forEach(strip -> {
+            int from = strip * rowsPerStrip * width;
+            int to = Math.min(height, (strip + 1) * rowsPerStrip) * width;
+            if (posterize) {
+                posterizeRange(in, inOffset, out, outOffset, from, to, source);
+            } else {
+                resynthesizeRange(in, inOffset, out, outOffset, from, to, source);
+            }
+        });
+    }
+
+    private void resynthesizeRange(int[] in, int inOffset, int[] out, int outOffset,
+                                   int from, int to, float[] source) {
+        for (int i = from; i < to; i++) {
+            int rgb = in[inOffset + i];
+            int index = nearest(rgb) * 3;
+            int r = channel(source[index] + (((rgb >> 16) & 0xFF) - palette[index]));
+            int g = channel(source[index + 1] + (((rgb >> 8) & 0xFF) - palette[index + 1]));
+            int b = channel(source[index + 2] + ((rgb & 0xFF) - palette[index + 2]));
+            out[outOffset + i] = (r << 16) | (g << 8) | b;
+        }
+    }
+
+    private void posterizeRange(int[] in, int inOffset, int[] out, int outOffset,
+                                int from, int to, float[] source) {
+        for (int i = from; i < to; i++) {
+            int index = nearest(in[inOffset + i]) * 3;
+            out[outOffset + i] = (channel(source[index]) << 16)
+                | (channel(source[index + 1]) << 8)
+                | channel(source[index + 2]);
+        }
+    }
+
+    // Round half up and clamp, matching the native (int)(v + 0.5f)
+    private static int channel(float value) {
+        int v = (int) (value + 0.5f);
+        return v < 0 ? 0 : Math.min(v, 255);
+    }
+
+    private void fill() {
+        if (complete || cells == null) return;
+        IntStream.range(0, DIM).parallel().forEach(ri -> {
+            int base = ri << (BITS * 2);
+            for (int cell = base; cell < base + DIM * DIM; cell++) {
+                if (cells[cell] == UNSET) {
+                    cells[cell] = (char) search(cell);
+                }
+            }
+        });
+        complete = true;
+    }
+
+    private int search(int cell) {
+        float r = (cell >> (BITS * 2)) * SCALE;
+        float g = ((cell >> BITS) & (DIM - 1)) * SCALE;
+        float b = (cell & (DIM - 1)) * SCALE;
+        float wr = r < 128.0f ? 2.0f : 3.0f;
+        float wb = r < 128.0f ? 3.0f : 2.0f;
+
+        int nearest = 0;
+        float minDist = Float.MAX_VALUE;
+        for (int i = 0; i < paletteSize; i++) {
+            float dr = r - palette[i * 3];
+            float dg = g - palette[i * 3 + 1];
+            float db = b - palette[i * 3 + 2];
+            float dist = wr * (dr * dr) + (4.0f * (dg * dg) + wb * (db * db));
+            if (dist < minDist) {
+                minDist = dist;
+                nearest = i;
+            }
+        }
+        return nearest;
+    }
+}
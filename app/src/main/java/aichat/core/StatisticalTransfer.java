@@ -0,0 +1,152 @@
+package aichat.core;
+
+import aichat.color.ColorSpaceConverter;
+import aichat.model.ColorPoint;
+import aichat.model.ColorStatistics;
+
+import java.util.stream.IntStream;
+
+/**
+ * Reinhard statistical color transfer in Java, the fallback for
+ * lab_statistics and reinhard_transfer in native/src/transfer.c: the same
+ * sample grid, and the same {@link #LUT_SIZE}^3 RGB grid mapped through
+ * {@link ColorSpaceConverter} and interpolated trilinearly, so the two
+ * backends differ by at most a level per channel.
+ */
+final class StatisticalTransfer {
+
+    static final int LUT_SIZE = 33;
+
+    // Below this deviation a channel is treated as flat and only shifted
+    private static final double MIN_STDDEV = 1e-3;
+    // Pixels per parallel strip, as in the native schedule(static, 32768)
+    private static final int STRIP_PIXELS = 32768;
+
+    private StatisticalTransfer() {}
+
+    /**
+     * Lab mean and standard deviation over a square grid of about
+     * {@code maxSamples} pixels, every pixel when it is not positive.
+     */
+    static ColorStatistics statistics(int[] pixels, int width, int height, int maxSamples) {
+        long total = (long) width * height;
+        int stride = 1;
+        if (maxSamples > 0 && total > maxSamples) {
+            stride = (int) Math.ceil(Math.sqrt((double) total / maxSamples));
+        }
+        int step = stride;
+        int rows = (height + step - 1) / step;
+        int cols = (width + step - 1) / step;
+
+        // {sumL, sumA, sumB, squares of each}
+        double[] sums = IntStream.range(0, rows).parallel().mapToObj(sy -> {
+            double[] acc = new double[6];
+            int row = sy * step * width;
+            for (int sx = 0; sx < cols; sx++) {
+                ColorPoint lab = ColorSpaceConverter.rgbToLab(ColorPoint.fromRGB(pixels[row + sx * step]));
+                acc[0] += lab.c1();
+                acc[1] += lab.c2();
+                acc[2] += lab.c3();
+                acc[3] += lab.c1() * lab.c1();
+                acc[4] += lab.c2() * lab.c2();
+                acc[5] += lab.c3() * lab.c3();
+            }
+            return acc;
+        }).reduce(new double[6], (a, b) -> {
+            double[] sum = new double[6];
+            for (int i = 0; i < 6; i++) {
+                sum[i] = a[i] + b[i];
+            }
+            return sum;
+        });
+
+        double n = (double) rows * cols;
+        double[] mean = new double[3];
+        double[] std = new double[3];
+        for (int c = 0; c < 3; c++) {
+            mean[c] = sums[c] / n;
+            std[c] = Math.sqrt(Math.max(0.0, sums[3 + c] / n - mean[c] * mean[c]));
+        }
+        return new ColorStatistics(
+            new ColorPoint(mean[0], mean[1], mean[2]),
+            new ColorPoint(std[0], std[1], std[2]));
+    }
+
+    /**
+     * Maps the first {@code count} pixels into {@code out} as packed RGB,
+     * moving each Lab channel from {@code target}'s statistics to
+     * {@code source}'s, strips in parallel.
+     */
+    static void apply(int[] pixels, int[] out, int count, ColorStatistics source, ColorStatistics target) {
+        float[] lut = buildLut(source, target);
+
+        int[] cell = new int[256];
+        float[] weight = new float[256];
+        for (int v = 0; v < 256; v++) {
+            float x = v * (float) (LUT_SIZE - 1) / 255.0f;
+            int i = Math.min((int) x, LUT_SIZE - 2);
+            cell[v] = i;
+            weight[v] = x - i;
+        }
+
+        int db = 3;
+        int dg = LUT_SIZE * 3;
+        int dr = LUT_SIZE * LUT_SIZE * 3;
+        int strips = (count + STRIP_PIXELS - 1) / STRIP_PIXELS;
+        IntStream.range(0, strips).parallel().forEach(strip -> {
+            int end = Math.min(count, (strip + 1) * STRIP_PIXELS);
+            for (int i = strip * STRIP_PIXELS; i < end; i++) {
+                int p = pixels[i];
+                int r = (p >> 16) & 0xFF;
+                int g = (p >> 8) & 0xFF;
+                int b = p & 0xFF;
+                int base = ((cell[r] * LUT_SIZE + cell[g]) * LUT_SIZE + cell[b]) * 3;
+                float fr = weight[r], fg = weight[g], fb = weight[b];
+                int packed = 0;
+                for (int c = 0; c < 3; c++) {
+                    int n = base + c;
+                    float v00 = lut[n] + (lut[n + db] - lut[n]) * fb;
+                    float v01 = lut[n + dg] + (lut[n + dg + db] - lut[n + dg]) * fb;
+                    float v10 = lut[n + dr] + (lut[n + dr + db] - lut[n + dr]) * fb;
+                    float v11 = lut[n + dr + dg] + (lut[n + dr + dg + db] - lut[n + dr + dg]) * fb;
+                    float v0 = v00 + (v01 - v00) * fg;
+                    float v1 = v10 + (v11 - v10) * fg;
+                    float v = v0 + (v1 - v0) * fr;
+                    packed = (packed << 8) | (int) Math.min(255.0f, Math.max(0.0f, v) + 0.5f);
+                }
+                out[i] = packed;
+            }
+        });
+    }
+
+    // Transferred {r, g, b} of every grid node, red slowest as in the native LUT
+    private static float[] buildLut(ColorStatistics source, ColorStatistics target) {
+        double[] scale = new double[3];
+        double[] offset = new double[3];
+        double[] sourceMean = { source.mean().c1(), source.mean().c2(), source.mean().c3() };
+        double[] sourceStd = { source.stdDev().c1(), source.stdDev().c2(), source.stdDev().c3() };
+        double[] targetMean = { target.mean().c1(), target.mean().c2(), target.mean().c3() };
+        double[] targetStd = { target.stdDev().c1(), target.stdDev().c2(), target.stdDev().c3() };
+        for (int c = 0; c < 3; c++) {
+            scale[c] = targetStd[c] > MIN_STDDEV ? sourceStd[c] / targetStd[c] : 1.0;
+            offset[c] = sourceMean[c] - targetMean[c] * scale[c];
+        }
+
+        double step = 255.0 / (LUT_SIZE - 1);
+        float[] lut = new float[LUT_SIZE * LUT_SIZE * LUT_SIZE * 3];
+        IntStream.range(0, LUT_SIZE * LUT_SIZE * LUT_SIZE).parallel().forEach(i -> {
+            int r = i / (LUT_SIZE * LUT_SIZE);
+            int g = (i / LUT_SIZE) % LUT_SIZE;
+            int b = i % LUT_SIZE;
+            ColorPoint lab = ColorSpaceConverter.rgbToLab(new ColorPoint(r * step, g * step, b * step));
+            ColorPoint rgb = ColorSpaceConverter.labToRgb(new ColorPoint(
+                lab.c1() * scale[0] + offset[0],
+                lab.c2() * scale[1] + offset[1],
+                lab.c3() * scale[2] + offset[2]));
+            lut[i * 3] = (float) rgb.c1();
+            lut[i * 3 + 1] = (float) rgb.c2();
+            lut[i * 3 + 2] = (float) rgb.c3();
+        });
+        return lut;
+    }
+}
@@ -0,0 +1,37 @@
+package aichat.diagnostics;
+
+import jdk.jfr.Category;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * One palette clustering run, on whichever backend actually produced it.
+ */
+@Name("aichat.Clustering")
+@Label("Clustering")
+@Category({"AIChat", "Engine"})
+@Description("Palette clustering with its size, backend and iteration count")
+public final class ClusteringEvent extends jdk.jfr.Event {
+
+    @Label("Algorithm")
+    @Description("hybrid, kmeans, kmeans-weighted, kmeans-image or tsvq")
+    public String algorithm;
+
+    @Label("Backend")
+    @Description("native, java-vector or java")
+    public String backend;
+
+    @Label("Clusters")
+    public int k;
+
+    @Label("Points")
+    public long points;
+
+    @Label("Iterations")
+    @Description("Lloyd iterations of the final k-means; 0 when not reported")
+    public int iterations;
+
+    @Label("Max Iterations")
+    public int maxIterations;
+}
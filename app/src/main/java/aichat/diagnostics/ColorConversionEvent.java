@@ -0,0 +1,27 @@
+package aichat.diagnostics;
+
+import jdk.jfr.Category;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * Batch conversion between RGB and CIELAB.
+ */
+@Name("aichat.ColorConversion")
+@Label("Color Conversion")
+@Category({"AIChat", "Engine"})
+@Description("Batch RGB/CIELAB conversion")
+public final class ColorConversionEvent extends jdk.jfr.Event {
+
+    @Label("Direction")
+    @Description("rgb-to-lab or lab-to-rgb")
+    public String direction;
+
+    @Label("Backend")
+    @Description("native, java-vector or java")
+    public String backend;
+
+    @Label("Points")
+    public int points;
+}
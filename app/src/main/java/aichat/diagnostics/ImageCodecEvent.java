@@ -0,0 +1,41 @@
+package aichat.diagnostics;
+
+import jdk.jfr.Category;
+import jdk.jfr.DataAmount;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * JPEG decode or encode through TurboJPEG.
+ */
+@Name("aichat.ImageCodec")
+@Label("Image Codec")
+@Category({"AIChat", "Native"})
+@Description("Native JPEG decode or encode")
+public final class ImageCodecEvent extends jdk.jfr.Event {
+
+    @Label("Operation")
+    @Description("decode or encode")
+    public String operation;
+
+    @Label("Path")
+    public String path;
+
+    @Label("Width")
+    public int width;
+
+    @Label("Height")
+    public int height;
+
+    @Label("Compressed Size")
+    @DataAmount
+    public long compressedBytes;
+
+    @Label("Quality")
+    @Description("Encode quality; 0 for decodes")
+    public int quality;
+
+    @Label("Success")
+    public boolean success;
+}
@@ -0,0 +1,60 @@
+package aichat.diagnostics;
+
+import jdk.jfr.Category;
+import jdk.jfr.DataAmount;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * One call through {@code NativeAccelerator}, covering marshalling of the
+ * Java arguments into native memory, the call itself and copying the result
+ * back.
+ */
+@Name("aichat.NativeCall")
+@Label("Native Call")
+@Category({"AIChat", "Native"})
+@Description("Native call with the bytes marshalled each way")
+public final class NativeCallEvent extends jdk.jfr.Event {
+
+    @Label("Function")
+    public String function;
+
+    @Label("Input Size")
+    @DataAmount
+    public long inputBytes;
+
+    @Label("Output Size")
+    @DataAmount
+    public long outputBytes;
+
+    @Label("Success")
+    public boolean success;
+
+    /** Creates and begins an event for {@code function}. */
+    public static NativeCallEvent start(String function, long inputBytes) {
+        NativeCallEvent event = new NativeCallEvent();
+        event.begin();
+        event.function = function;
+        event.inputBytes = inputBytes;
+        return event;
+    }
+
+    /** Commits a successful call that produced {@code outputBytes}. */
+    public void finish(long outputBytes) {
+        end();
+        if (shouldCommit()) {
+            this.outputBytes = outputBytes;
+            this.success = true;
+            commit();
+        }
+    }
+
+    /** Commits a call that threw or returned nothing usable. */
+    public void fail() {
+        end();
+        if (shouldCommit()) {
+            commit();
+        }
+    }
+}
@@ -0,0 +1,26 @@
+package aichat.diagnostics;
+
+import jdk.jfr.Category;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * Optimal assignment between two palettes (Hungarian algorithm).
+ */
+@Name("aichat.PaletteMapping")
+@Label("Palette Mapping")
+@Category({"AIChat", "Engine"})
+@Description("Matching of target palette colors to source palette colors")
+public final class PaletteMappingEvent extends jdk.jfr.Event {
+
+    @Label("From Colors")
+    public int fromColors;
+
+    @Label("To Colors")
+    public int toColors;
+
+    @Label("Matrix Size")
+    @Description("Side of the square cost matrix after padding")
+    public int matrixSize;
+}
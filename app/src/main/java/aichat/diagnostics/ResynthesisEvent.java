@@ -0,0 +1,39 @@
+package aichat.diagnostics;
+
+import jdk.jfr.Category;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * Recoloring of a whole image or a viewport preview, with the backend that
+ * ended up doing it.
+ */
+@Name("aichat.Resynthesis")
+@Label("Resynthesis")
+@Category({"AIChat", "Engine"})
+@Description("Image resynthesis, posterization or statistical transfer and the chosen backend")
+public final class ResynthesisEvent extends jdk.jfr.Event {
+
+    @Label("Mode")
+    @Description("resynthesize or posterize, suffixed -viewport for viewport previews, or transfer")
+    public String mode;
+
+    @Label("Backend")
+    @Description("gpu, native, native-tiled or java")
+    public String backend;
+
+    @Label("Width")
+    public int width;
+
+    @Label("Height")
+    public int height;
+
+    @Label("Palette Size")
+    @Description("Target palette colors, 0 for a statistical transfer")
+    public int paletteSize;
+
+    @Label("Fallbacks")
+    @Description("Backends tried and failed before the one that succeeded")
+    public int fallbacks;
+}
@@ -0,0 +1,32 @@
+package aichat.diagnostics;
+
+import jdk.jfr.Category;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+
+/**
+ * Pixel sampling ahead of palette extraction.
+ */
+@Name("aichat.Sampling")
+@Label("Pixel Sampling")
+@Category({"AIChat", "Engine"})
+@Description("Sampling of image pixels for clustering")
+public final class SamplingEvent extends jdk.jfr.Event {
+
+    @Label("Backend")
+    @Description("native or java")
+    public String backend;
+
+    @Label("Image Width")
+    public int width;
+
+    @Label("Image Height")
+    public int height;
+
+    @Label("Requested Samples")
+    public int requested;
+
+    @Label("Samples")
+    public int samples;
+}
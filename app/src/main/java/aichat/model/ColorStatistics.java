@@ -0,0 +1,22 @@
+package aichat.model;
+
+/**
+ * Per-channel mean and standard deviation of an image in CIELAB, the
+ * statistics a Reinhard color transfer matches.
+ */
+public record ColorStatistics(ColorPoint mean, ColorPoint stdDev) {
+
+    /** As {meanL, meanA, meanB, stdL, stdA, stdB}, the native layout. */
+    public float[] toArray() {
+        return new float[] {
+            (float) mean.c1(), (float) mean.c2(), (float) mean.c3(),
+            (float) stdDev.c1(), (float) stdDev.c2(), (float) stdDev.c3()
+        };
+    }
+
+    public static ColorStatistics fromArray(float[] stats) {
+        return new ColorStatistics(
+            new ColorPoint(stats[0], stats[1], stats[2]),
+            new ColorPoint(stats[3], stats[4], stats[5]));
+    }
+}
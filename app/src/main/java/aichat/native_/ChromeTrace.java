@@ -0,0 +1,96 @@
+package aichat.native_;
+
+import java.io.IOException;
+import java.io.Writer;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+
+/**
+ * Writes Java and native spans as one Chrome trace event file, readable by
+ * chrome://tracing and ui.perfetto.dev. Java threads appear under a "java"
+ * process and native ring-buffer threads under "native"; both share one
+ * time axis starting at the earliest span.
+ */
+final class ChromeTrace {
+
+    private static final int JAVA_PID = 1;
+    private static final int NATIVE_PID = 2;
+
+    /** A completed Java-side span, timestamps from {@link System#nanoTime()}. */
+    record JavaSpan(String name, long startNanos, long durationNanos, long threadId, String threadName) {}
+
+    private ChromeTrace() {}
+
+    /**
+     * @param nativeClockOffset native clock minus {@link System#nanoTime()},
+     *        subtracted from native timestamps to put them on the Java axis
+     */
+    static void write(Path file, List<JavaSpan> javaSpans, List<NativeLibrary.TraceSpan> nativeSpans,
+                      long nativeClockOffset) throws IOException {
+        long origin = Long.MAX_VALUE;
+        for (JavaSpan s : javaSpans) origin = Math.min(origin, s.startNanos());
+        for (NativeLibrary.TraceSpan s : nativeSpans) origin = Math.min(origin, s.startNanos() - nativeClockOffset);
+        if (origin == Long.MAX_VALUE) origin = 0;
+
+        Map<Long, String> javaThreads = new LinkedHashMap<>();
+        for (JavaSpan s : javaSpans) javaThreads.putIfAbsent(s.threadId(), s.threadName());
+
+        if (file.getParent() != null) {
+            Files.createDirectories(file.getParent());
+        }
+        try (Writer out = Files.newBufferedWriter(file)) {
+            out.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            out.write(metadata("process_name", JAVA_PID, 0, "java"));
+            out.write(",\n");
+            out.write(metadata("process_name", NATIVE_PID, 0, "native"));
+            for (Map.Entry<Long, String> t : javaThreads.entrySet()) {
+                out.write(",\n");
+                out.write(metadata("thread_name", JAVA_PID, t.getKey(), t.getValue()));
+            }
+
+            for (JavaSpan s : javaSpans) {
+                out.write(",\n");
+                out.write(complete(s.name(), "java", JAVA_PID, s.threadId(),
+                    s.startNanos() - origin, s.durationNanos()));
+            }
+            for (NativeLibrary.TraceSpan s : nativeSpans) {
+                out.write(",\n");
+                out.write(complete(s.name(), "native", NATIVE_PID, s.threadId(),
+                    s.startNanos() - nativeClockOffset - origin, s.durationNanos()));
+            }
+            out.write("\n]}\n");
+        }
+    }
+
+    private static String complete(String name, String category, int pid, long tid, long startNanos, long durationNanos) {
+        return String.format(Locale.ROOT,
+            "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            escape(name), category, pid, tid, startNanos / 1000.0, durationNanos / 1000.0);
+    }
+
+    private static String metadata(String kind, int pid, long tid, String name) {
+        return String.format(Locale.ROOT,
+            "{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            kind, pid, tid, escape(name));
+    }
+
+    private static String escape(String s) {
+        StringBuilder sb = new StringBuilder(s.length());
+        for (int i = 0; i < s.length(); i++) {
+            char c = s.charAt(i);
+            switch (c) {
+                case '"' -> sb.append("\\\"");
+                case '\\' -> sb.append("\\\\");
+                default -> {
+                    if (c < 0x20) sb.append(String.format("\\u%04x", (int) c));
+                    else sb.append(c);
+                }
+            }
+        }
+        return sb.toString();
+    }
+}
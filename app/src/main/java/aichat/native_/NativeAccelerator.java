@@ -1,11 +1,23 @@
 package aichat.native_;
 
+import aichat.diagnostics.ClusteringEvent;
+import aichat.diagnostics.ImageCodecEvent;
+import aichat.diagnostics.NativeCallEvent;
 import aichat.model.ColorPalette;
 import aichat.model.ColorPoint;
+import aichat.model.ColorStatistics;
 
+import java.io.IOException;
 import java.lang.foreign.Arena;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.ValueLayout;
+import java.nio.ByteOrder;
+import java.nio.IntBuffer;
+import java.nio.file.Path;
 import java.util.ArrayList;
 import java.util.List;
+import java.util.concurrent.ConcurrentLinkedQueue;
+import java.util.concurrent.atomic.AtomicInteger;
 
 public final class NativeAccelerator {
     
@@ -38,6 +50,22 @@ public final class NativeAccelerator {
         } else {
             System.out.println("Native acceleration unavailable, using Java fallback");
         }
+        
+        if (available && Boolean.getBoolean("aichat.native.memtrack")) {
+            nativeLib.setMemoryTracking(true);
+        }
+        
+        String traceFile = System.getProperty("aichat.trace");
+        if (traceFile != null && !traceFile.isBlank()) {
+            setTracing(true);
+            Runtime.getRuntime().addShutdownHook(new Thread(() -> {
+                try {
+                    writeChromeTrace(Path.of(traceFile));
+                } catch (IOException e) {
+                    System.err.println("Failed to write trace: " + e.getMessage());
+                }
+            }, "aichat-trace-writer"));
+        }
     }
     
     public static NativeAccelerator getInstance() {
@@ -80,27 +108,179 @@ public final class NativeAccelerator {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        ClusteringEvent clustering = new ClusteringEvent();
+        clustering.begin();
+        NativeCallEvent call = NativeCallEvent.start("kmeansCluster", points.size() * 12L);
+        try (TraceScope span = traceSpan("kmeansCluster"); Arena arena = Arena.ofConfined()) {
             float[] flatPoints = colorPointsToFloatArray(points);
             float[] result = nativeLib.kmeansCluster(arena, flatPoints, k, 
                 maxIterations, (float) threshold, seed);
+            call.finish(result.length * 4L);
+            commitClustering(clustering, "kmeans", points.size(), k, maxIterations);
             return floatArrayToColorPoints(result);
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native K-Means failed: " + e.getMessage());
             return null;
         }
     }
     
+    /**
+     * K-means where each point counts with the matching weight.
+     */
+    public List<ColorPoint> kmeansClusterWeighted(List<ColorPoint> points, float[] weights, int k,
+                                                   int maxIterations, double threshold, long seed) {
+        if (!available || points.isEmpty() || weights.length < points.size()) {
+            return null;
+        }
+        
+        ClusteringEvent clustering = new ClusteringEvent();
+        clustering.begin();
+        NativeCallEvent call = NativeCallEvent.start("kmeansClusterWeighted", points.size() * 16L);
+        try (Arena arena = Arena.ofConfined()) {
+            float[] flatPoints = colorPointsToFloatArray(points);
+            float[] result = nativeLib.kmeansClusterWeighted(arena, flatPoints, weights,
+                Math.min(k, points.size()), maxIterations, (float) threshold, seed);
+            call.finish(result.length * 4L);
+            commitClustering(clustering, "kmeans-weighted", points.size(), k, maxIterations);
+            return floatArrayToColorPoints(result);
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native weighted K-Means failed: " + e.getMessage());
+            return null;
+        }
+    }
+    
+    /**
+     * Exact k-means fitted to every pixel of an ARGB image (RGB space).
+     */
+    public List<ColorPoint> kmeansClusterImage(int[] pixels, int k,
+                                                int maxIterations, double threshold, long seed) {
+        if (!available || pixels.length == 0) {
+            return null;
+        }
+        
+        int clusters = Math.min(k, pixels.length);
+        
+        ClusteringEvent clustering = new ClusteringEvent();
+        clustering.begin();
+        NativeCallEvent call = NativeCallEvent.start("kmeansClusterImage", pixels.length * 4L);
+        try (TraceScope span = traceSpan("kmeansClusterImage"); Arena arena = Arena.ofConfined()) {
+            float[] result = nativeLib.kmeansClusterImage(arena, pixels, clusters,
+                maxIterations, (float) threshold, seed);
+            call.finish(result.length * 4L);
+            commitClustering(clustering, "kmeans-image", pixels.length, clusters, maxIterations);
+            return floatArrayToColorPoints(result);
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native streaming K-Means failed: " + e.getMessage());
+            return null;
+        }
+    }
+    
+    /**
+     * Exact k-means over ARGB pixels that already live in native memory
+     * (decoded native buffers or memory-mapped rasters), without copying them.
+     */
+    public List<ColorPoint> kmeansClusterImage(MemorySegment pixels, int pixelCount, int k,
+                                                int maxIterations, double threshold, long seed) {
+        if (!available || pixelCount <= 0) {
+            return null;
+        }
+        
+        int clusters = Math.min(k, pixelCount);
+        
+        ClusteringEvent clustering = new ClusteringEvent();
+        clustering.begin();
+        // Pixels are read in place, so nothing is marshalled in
+        NativeCallEvent call = NativeCallEvent.start("kmeansClusterImage", 0);
+        try (Arena arena = Arena.ofConfined()) {
+            float[] result = nativeLib.kmeansClusterImage(arena, pixels, pixelCount, clusters,
+                maxIterations, (float) threshold, seed);
+            call.finish(result.length * 4L);
+            commitClustering(clustering, "kmeans-image", pixelCount, clusters, maxIterations);
+            return floatArrayToColorPoints(result);
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native streaming K-Means failed: " + e.getMessage());
+            return null;
+        }
+    }
+    
+    /**
+     * Tree-structured VQ palette, built in O(n log k) for very large k.
+     */
+    public List<ColorPoint> tsvqBuildPalette(List<ColorPoint> points, int k) {
+        if (!available || points.isEmpty() || k <= 0) {
+            return null;
+        }
+        
+        ClusteringEvent clustering = new ClusteringEvent();
+        clustering.begin();
+        NativeCallEvent call = NativeCallEvent.start("tsvqBuildPalette", points.size() * 12L);
+        try (Arena arena = Arena.ofConfined()) {
+            float[] flatPoints = colorPointsToFloatArray(points);
+            float[] result = nativeLib.tsvqBuildPalette(arena, flatPoints, null, Math.min(k, points.size()));
+            call.finish(result.length * 4L);
+            clustering.end();
+            if (clustering.shouldCommit()) {
+                clustering.algorithm = "tsvq";
+                clustering.backend = "native";
+                clustering.k = k;
+                clustering.points = points.size();
+                clustering.commit();
+            }
+            return floatArrayToColorPoints(result);
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native TSVQ failed: " + e.getMessage());
+            return null;
+        }
+    }
+    
+    /** Superpixel mean colors (RGB) with the pixel count each one covers. */
+    public record Superpixels(List<ColorPoint> means, float[] areas) {}
+    
+    /**
+     * SLIC superpixels of an ARGB image, for clustering a few thousand
+     * weighted, spatially coherent colors instead of raw pixels.
+     */
+    public Superpixels slicSuperpixels(int[] pixels, int width, int height,
+                                        int maxSuperpixels, double compactness, int maxIterations) {
+        if (!available || pixels.length == 0 || pixels.length < width * height) {
+            return null;
+        }
+        
+        NativeCallEvent call = NativeCallEvent.start("slicSuperpixels", pixels.length * 4L);
+        try (Arena arena = Arena.ofConfined()) {
+            NativeLibrary.Superpixels result = nativeLib.slicSuperpixels(arena, pixels, width, height,
+                maxSuperpixels, (float) compactness, maxIterations);
+            if (result.count() == 0) {
+                call.fail();
+                return null;
+            }
+            call.finish((result.means().length + result.areas().length) * 4L);
+            return new Superpixels(floatArrayToColorPoints(result.means()), result.areas());
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native SLIC failed: " + e.getMessage());
+            return null;
+        }
+    }
+    
     public List<ColorPoint> rgbToLabBatch(List<ColorPoint> rgb) {
         if (!available || rgb.isEmpty()) {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        NativeCallEvent call = NativeCallEvent.start("rgbToLabBatch", rgb.size() * 12L);
+        try (TraceScope span = traceSpan("rgbToLabBatch"); Arena arena = Arena.ofConfined()) {
             float[] flatRgb = colorPointsToFloatArray(rgb);
             float[] result = nativeLib.rgbToLabBatch(arena, flatRgb);
+            call.finish(result.length * 4L);
             return floatArrayToColorPoints(result);
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native RGB to LAB failed: " + e.getMessage());
             return null;
         }
@@ -111,11 +291,14 @@ public final class NativeAccelerator {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        NativeCallEvent call = NativeCallEvent.start("labToRgbBatch", lab.size() * 12L);
+        try (TraceScope span = traceSpan("labToRgbBatch"); Arena arena = Arena.ofConfined()) {
             float[] flatLab = colorPointsToFloatArray(lab);
             float[] result = nativeLib.labToRgbBatch(arena, flatLab);
+            call.finish(result.length * 4L);
             return floatArrayToColorPoints(result);
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native LAB to RGB failed: " + e.getMessage());
             return null;
         }
@@ -127,11 +310,16 @@ public final class NativeAccelerator {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        NativeCallEvent call = NativeCallEvent.start("resynthesizeImage",
+            pixels.length * 4L + (targetPalette.size() + sourcePalette.size()) * 12L);
+        try (TraceScope span = traceSpan("resynthesizeImage"); Arena arena = Arena.ofConfined()) {
             float[] target = colorPaletteToFloatArray(targetPalette);
             float[] source = colorPaletteToFloatArray(sourcePalette);
-            return nativeLib.resynthesizeImage(arena, pixels, width, height, target, source);
+            int[] result = nativeLib.resynthesizeImage(arena, pixels, width, height, target, source);
+            call.finish(result.length * 4L);
+            return result;
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native resynthesis failed: " + e.getMessage());
             return null;
         }
@@ -143,26 +331,125 @@ public final class NativeAccelerator {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        NativeCallEvent call = NativeCallEvent.start("posterizeImage",
+            pixels.length * 4L + (targetPalette.size() + sourcePalette.size()) * 12L);
+        try (TraceScope span = traceSpan("posterizeImage"); Arena arena = Arena.ofConfined()) {
             float[] target = colorPaletteToFloatArray(targetPalette);
             float[] source = colorPaletteToFloatArray(sourcePalette);
-            return nativeLib.posterizeImage(arena, pixels, width, height, target, source);
+            int[] result = nativeLib.posterizeImage(arena, pixels, width, height, target, source);
+            call.finish(result.length * 4L);
+            return result;
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native posterize failed: " + e.getMessage());
             return null;
         }
     }
     
+    /**
+     * Lab mean and standard deviation over about {@code maxSamples} pixels,
+     * in one native parallel reduction; null on failure.
+     */
+    public ColorStatistics labStatistics(int[] pixels, int width, int height, int maxSamples) {
+        if (!available || pixels.length == 0) {
+            return null;
+        }
+        
+        NativeCallEvent call = NativeCallEvent.start("labStatistics", (long) width * height * 4);
+        try (TraceScope span = traceSpan("labStatistics"); Arena arena = Arena.ofConfined()) {
+            float[] stats = nativeLib.labStatistics(arena, pixels, width, height, maxSamples);
+            call.finish(stats.length * 4L);
+            return ColorStatistics.fromArray(stats);
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native Lab statistics failed: " + e.getMessage());
+            return null;
+        }
+    }
+    
+    /**
+     * Reinhard transfer of an image with statistics {@code target} toward
+     * {@code source}, through a native 3D LUT, written into {@code output};
+     * false on failure.
+     */
+    public boolean reinhardTransfer(int[] pixels, int width, int height,
+                                    ColorStatistics source, ColorStatistics target, int[] output) {
+        if (!available || pixels.length == 0) {
+            return false;
+        }
+        
+        NativeCallEvent call = NativeCallEvent.start("reinhardTransfer", (long) width * height * 4 + 48);
+        try (TraceScope span = traceSpan("reinhardTransfer"); Arena arena = Arena.ofConfined()) {
+            nativeLib.reinhardTransfer(arena, pixels, width, height,
+                source.toArray(), target.toArray(), output);
+            call.finish((long) width * height * 4);
+            return true;
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native Reinhard transfer failed: " + e.getMessage());
+            return false;
+        }
+    }
+    
+    /** Filters for {@link #downscaleImage}. */
+    public enum ResampleFilter {
+        /** Area average: the fastest, and exact for palette statistics. */
+        BOX,
+        /** Lanczos-3: sharper previews at several times the cost. */
+        LANCZOS3
+    }
+    
+    /** Box-filter {@link #downscaleImage(int[], int, int, int, int, ResampleFilter)}. */
+    public IntBuffer downscaleImage(int[] pixels, int width, int height, int dstWidth, int dstHeight) {
+        return downscaleImage(pixels, width, height, dstWidth, dstHeight, ResampleFilter.BOX);
+    }
+    
+    /**
+     * Downscale of packed RGB pixels to an opaque ARGB proxy of
+     * {@code dstWidth x dstHeight}. The result is a view of the native
+     * output buffer itself (freed once unreachable), ready to back a JavaFX
+     * PixelBuffer without another copy; null when native is unavailable or
+     * the call fails.
+     */
+    public IntBuffer downscaleImage(int[] pixels, int width, int height, int dstWidth, int dstHeight,
+                                    ResampleFilter filter) {
+        if (!available || pixels.length == 0) {
+            return null;
+        }
+        
+        String name = filter == ResampleFilter.LANCZOS3 ? "downscaleLanczos3" : "downscaleImage";
+        NativeCallEvent call = NativeCallEvent.start(name, (long) width * height * 4L);
+        try (TraceScope span = traceSpan(name); Arena arena = Arena.ofConfined()) {
+            MemorySegment image = arena.allocate(ValueLayout.JAVA_INT, (long) width * height);
+            image.copyFrom(MemorySegment.ofArray(pixels).asSlice(0, (long) width * height * 4));
+            MemorySegment output = Arena.ofAuto().allocate(ValueLayout.JAVA_INT, (long) dstWidth * dstHeight);
+            if (filter == ResampleFilter.LANCZOS3) {
+                nativeLib.downscaleLanczos3(image, width, height, output, dstWidth, dstHeight);
+            } else {
+                nativeLib.downscaleBox(image, width, height, output, dstWidth, dstHeight);
+            }
+            call.finish(output.byteSize());
+            return output.asByteBuffer().order(ByteOrder.nativeOrder()).asIntBuffer();
+        } catch (Exception e) {
+            call.fail();
+            System.err.println("Native downscale failed: " + e.getMessage());
+            return null;
+        }
+    }
+    
     public List<ColorPoint> samplePixels(List<ColorPoint> pixels, int sampleSize, long seed) {
         if (!available || pixels.isEmpty()) {
             return null;
         }
         
+        NativeCallEvent call = NativeCallEvent.start("samplePixels", pixels.size() * 12L);
         try (Arena arena = Arena.ofConfined()) {
             float[] input = colorPointsToFloatArray(pixels);
             float[] result = nativeLib.samplePixels(arena, input, sampleSize, seed);
+            call.finish(result.length * 4L);
             return floatArrayToColorPoints(result);
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native sampling failed: " + e.getMessage());
             return null;
         }
@@ -173,10 +460,13 @@ public final class NativeAccelerator {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        NativeCallEvent call = NativeCallEvent.start("samplePixelsFromImage", imagePixels.length * 4L);
+        try (TraceScope span = traceSpan("samplePixelsFromImage"); Arena arena = Arena.ofConfined()) {
             float[] result = nativeLib.samplePixelsFromImage(arena, imagePixels, sampleSize, seed);
+            call.finish(result.length * 4L);
             return floatArrayToColorPoints(result);
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native image sampling failed: " + e.getMessage());
             return null;
         }
@@ -187,11 +477,16 @@ public final class NativeAccelerator {
             return null;
         }
         
+        NativeCallEvent call = NativeCallEvent.start("assignPointsBatch",
+            (points.size() + centroids.size()) * 12L);
         try (Arena arena = Arena.ofConfined()) {
             float[] flatPoints = colorPointsToFloatArray(points);
             float[] flatCentroids = colorPointsToFloatArray(centroids);
-            return nativeLib.assignPointsBatch(arena, flatPoints, flatCentroids);
+            int[] result = nativeLib.assignPointsBatch(arena, flatPoints, flatCentroids);
+            call.finish(result.length * 4L);
+            return result;
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native assignment failed: " + e.getMessage());
             return null;
         }
@@ -199,30 +494,65 @@ public final class NativeAccelerator {
     
     public record DbscanResult(int numClusters, int[] labels, List<ColorPoint> centroids) {}
     
+    private static final int HYBRID_KMEANS_MAX_ITERATIONS = 100;
+    
     public List<ColorPoint> hybridCluster(List<ColorPoint> points, int k, 
                                            int blockSize, int minPts, long seed) {
+        return hybridCluster(points, k, blockSize, minPts, 0, seed);
+    }
+    
+    /**
+     * Hybrid clustering with the final k-means bounded to
+     * {@code maxRepresentatives} weighted representatives (0 = native default).
+     */
+    public List<ColorPoint> hybridCluster(List<ColorPoint> points, int k, 
+                                           int blockSize, int minPts, 
+                                           int maxRepresentatives, long seed) {
         if (!available || points.isEmpty()) {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        ClusteringEvent clustering = new ClusteringEvent();
+        clustering.begin();
+        NativeCallEvent call = NativeCallEvent.start("hybridCluster", points.size() * 12L);
+        try (TraceScope span = traceSpan("hybridCluster"); Arena arena = Arena.ofConfined()) {
             float[] flatPoints = colorPointsToFloatArray(points);
             
             float eps = nativeLib.hybridCalculateEps(arena, flatPoints, blockSize, minPts, seed);
             
             float[] result = nativeLib.hybridCluster(
                 arena, flatPoints, k, blockSize, eps, minPts,
-                100, 0.5f, seed
+                HYBRID_KMEANS_MAX_ITERATIONS, 0.5f, maxRepresentatives, seed
             );
             
+            call.finish(result.length * 4L);
+            commitClustering(clustering, "hybrid", points.size(), k, HYBRID_KMEANS_MAX_ITERATIONS);
             return floatArrayToColorPoints(result);
         } catch (Exception e) {
+            call.fail();
             System.err.println("Native Hybrid clustering failed: " + e.getMessage());
             return null;
         }
     }
     
-    private static float[] colorPointsToFloatArray(List<ColorPoint> points) {
+    private void commitClustering(ClusteringEvent event, String algorithm, long points,
+                                  int k, int maxIterations) {
+        event.end();
+        if (event.shouldCommit()) {
+            event.algorithm = algorithm;
+            event.backend = "native";
+            event.k = k;
+            event.points = points;
+            event.iterations = nativeLib.lastClusterIterations();
+            event.maxIterations = maxIterations;
+            event.commit();
+        }
+    }
+    
+    /**
+     * Flattens points to the interleaved c1,c2,c3 layout the native calls take.
+     */
+    public static float[] colorPointsToFloatArray(List<ColorPoint> points) {
         float[] result = new float[points.size() * 3];
         for (int i = 0; i < points.size(); i++) {
             ColorPoint p = points.get(i);
@@ -233,7 +563,7 @@ public final class NativeAccelerator {
         return result;
     }
     
-    private static List<ColorPoint> floatArrayToColorPoints(float[] flat) {
+    public static List<ColorPoint> floatArrayToColorPoints(float[] flat) {
         List<ColorPoint> result = new ArrayList<>(flat.length / 3);
         for (int i = 0; i < flat.length; i += 3) {
             result.add(new ColorPoint(flat[i], flat[i + 1], flat[i + 2]));
@@ -261,9 +591,14 @@ public final class NativeAccelerator {
             return null;
         }
         
-        try {
+        ImageCodecEvent codec = new ImageCodecEvent();
+        codec.begin();
+        codec.operation = "decode";
+        codec.path = filePath;
+        try (TraceScope span = traceSpan("decodeJpeg")) {
             // Read file in Java (supports Unicode paths on Windows)
             byte[] jpegData = java.nio.file.Files.readAllBytes(java.nio.file.Path.of(filePath));
+            codec.compressedBytes = jpegData.length;
             NativeLibrary.DecodedImage result = nativeLib.decodeJpegBuffer(jpegData);
             if (result == null) {
                 // Fallback to file-based decode (works on Linux/macOS)
@@ -272,13 +607,49 @@ public final class NativeAccelerator {
             if (result == null) {
                 return null;
             }
+            codec.width = result.width();
+            codec.height = result.height();
+            codec.success = true;
             return new DecodedImage(result.width(), result.height(), result.pixels());
         } catch (Exception e) {
             System.err.println("TurboJPEG decode failed: " + e.getMessage());
             return null;
+        } finally {
+            codec.commit();
         }
     }
     
+    /**
+     * Decode JPEG bytes already held in memory using TurboJPEG, so a caller
+     * that retains the compressed file can decode it again without touching
+     * the disk. Returns null on failure.
+     */
+    public DecodedImage decodeJpeg(byte[] jpegData) {
+        if (!available || !hasTurboJpeg()) {
+            return null;
+        }
+
+        ImageCodecEvent codec = new ImageCodecEvent();
+        codec.begin();
+        codec.operation = "decode";
+        codec.compressedBytes = jpegData.length;
+        try (TraceScope span = traceSpan("decodeJpeg")) {
+            NativeLibrary.DecodedImage result = nativeLib.decodeJpegBuffer(jpegData);
+            if (result == null) {
+                return null;
+            }
+            codec.width = result.width();
+            codec.height = result.height();
+            codec.success = true;
+            return new DecodedImage(result.width(), result.height(), result.pixels());
+        } catch (Exception e) {
+            System.err.println("TurboJPEG decode failed: " + e.getMessage());
+            return null;
+        } finally {
+            codec.commit();
+        }
+    }
+
     /**
      * Save image as JPEG using TurboJPEG (much faster than ImageIO).
      * @param pixels ARGB pixel array
@@ -293,11 +664,24 @@ public final class NativeAccelerator {
             return false;
         }
         
-        try {
-            return nativeLib.encodeJpegToFile(pixels, width, height, quality, filePath);
+        ImageCodecEvent codec = new ImageCodecEvent();
+        codec.begin();
+        codec.operation = "encode";
+        codec.path = filePath;
+        codec.width = width;
+        codec.height = height;
+        codec.quality = quality;
+        try (TraceScope span = traceSpan("saveJpeg")) {
+            codec.success = nativeLib.encodeJpegToFile(pixels, width, height, quality, filePath);
+            if (codec.success && codec.shouldCommit()) {
+                codec.compressedBytes = new java.io.File(filePath).length();
+            }
+            return codec.success;
         } catch (Exception e) {
             System.err.println("TurboJPEG encode failed: " + e.getMessage());
             return false;
+        } finally {
+            codec.commit();
         }
     }
     
@@ -366,23 +750,34 @@ public final class NativeAccelerator {
             return null;
         }
         
-        try (Arena arena = Arena.ofConfined()) {
+        NativeCallEvent call = NativeCallEvent.start("resynthesizeImageGPU",
+            pixels.length * 4L + (targetPalette.size() + sourcePalette.size()) * 12L);
+        try (TraceScope span = traceSpan("resynthesizeImageGPU"); Arena arena = Arena.ofConfined()) {
             float[] target = colorPaletteToFloatArray(targetPalette);
             float[] source = colorPaletteToFloatArray(sourcePalette);
             
             long imageSize = (long) width * height * 4;
             
             // Use streaming for large images (>64MB)
+            int[] result;
             if (imageSize > 64 * 1024 * 1024) {
-                return nativeLib.resynthesizeImageGPUStreaming(
+                call.function = "resynthesizeImageGPUStreaming";
+                result = nativeLib.resynthesizeImageGPUStreaming(
                     arena, pixels, width, height, target, source, 0
                 );
             } else {
-                return nativeLib.resynthesizeImageGPU(
+                result = nativeLib.resynthesizeImageGPU(
                     arena, pixels, width, height, target, source
                 );
             }
+            if (result == null) {
+                call.fail();
+            } else {
+                call.finish(result.length * 4L);
+            }
+            return result;
         } catch (Exception e) {
+            call.fail();
             System.err.println("GPU resynthesis failed: " + e.getMessage());
             return null;
         }
@@ -397,4 +792,130 @@ public final class NativeAccelerator {
             openclInitialized = false;
         }
     }
+    
+    // ==================== Metrics ====================
+
+    /**
+     * Native call counters, latency histograms and resource counters since
+     * load or the last {@link #resetMetrics()}; {@link NativeMetrics#toPrometheus()}
+     * renders them for scraping. Null when native is unavailable.
+     */
+    public NativeMetrics getMetrics() {
+        if (!available) return null;
+
+        try {
+            return nativeLib.metricsSnapshot();
+        } catch (Exception e) {
+            System.err.println("Native metrics snapshot failed: " + e.getMessage());
+            return null;
+        }
+    }
+
+    public void resetMetrics() {
+        if (available) {
+            nativeLib.resetMetrics();
+        }
+    }
+
+    /**
+     * Turns the native allocation tracker on or off (off by default, or on
+     * with {@code -Daichat.native.memtrack=true}). Turning it on restarts
+     * the peaks, so call it before the work to be measured.
+     */
+    public boolean setNativeMemoryTracking(boolean enabled) {
+        return available && nativeLib.setMemoryTracking(enabled);
+    }
+
+    /**
+     * Current and peak bytes of native working buffers, per subsystem and per
+     * call; memory the JVM cannot see. Null when native is unavailable.
+     */
+    public NativeMemoryStats getNativeMemoryStats() {
+        if (!available) return null;
+
+        try {
+            return nativeLib.memoryStats();
+        } catch (Exception e) {
+            System.err.println("Native memory snapshot failed: " + e.getMessage());
+            return null;
+        }
+    }
+
+    // ==================== Tracing ====================
+    
+    // Java spans kept while tracing; the oldest are dropped beyond this
+    private static final int JAVA_TRACE_CAPACITY = 65536;
+    
+    /** An open span; closing it records it. */
+    public interface TraceScope extends AutoCloseable {
+        @Override
+        void close();
+    }
+    
+    private static final TraceScope NO_SPAN = () -> {};
+    
+    private volatile boolean tracing = false;
+    private final ConcurrentLinkedQueue<ChromeTrace.JavaSpan> javaSpans = new ConcurrentLinkedQueue<>();
+    private final AtomicInteger javaSpanCount = new AtomicInteger();
+    
+    /**
+     * Starts or stops span recording, on the Java side and in the native
+     * per-thread ring buffers. Off by default; while off, spans cost a
+     * volatile read.
+     */
+    public void setTracing(boolean enabled) {
+        tracing = enabled;
+        if (available) {
+            nativeLib.setTraceEnabled(enabled);
+        }
+    }
+    
+    public boolean isTracing() {
+        return tracing;
+    }
+    
+    /**
+     * Opens a Java span on the current thread, for use in try-with-resources.
+     * Returns a no-op scope when tracing is off.
+     */
+    public TraceScope traceSpan(String name) {
+        if (!tracing) return NO_SPAN;
+        
+        long start = System.nanoTime();
+        Thread thread = Thread.currentThread();
+        return () -> {
+            javaSpans.add(new ChromeTrace.JavaSpan(name, start, System.nanoTime() - start,
+                thread.threadId(), thread.getName()));
+            if (javaSpanCount.incrementAndGet() > JAVA_TRACE_CAPACITY && javaSpans.poll() != null) {
+                javaSpanCount.decrementAndGet();
+            }
+        };
+    }
+    
+    /** Drops the recorded Java and native spans. */
+    public void clearTrace() {
+        javaSpans.clear();
+        javaSpanCount.set(0);
+        if (available) {
+            nativeLib.clearTrace();
+        }
+    }
+    
+    /**
+     * Writes the recorded Java spans and the native ring buffers as Chrome
+     * trace JSON (chrome://tracing, ui.perfetto.dev). Best called between
+     * operations: native spans still being written may be torn.
+     */
+    public void writeChromeTrace(Path file) throws IOException {
+        List<NativeLibrary.TraceSpan> nativeSpans = available ? nativeLib.collectTrace() : List.of();
+        long offset = 0;
+        if (!nativeSpans.isEmpty()) {
+            // Midpoint of two Java reads around one native read
+            long before = System.nanoTime();
+            long nativeNow = nativeLib.traceNowNanos();
+            long after = System.nanoTime();
+            offset = nativeNow - (before + (after - before) / 2);
+        }
+        ChromeTrace.write(file, new ArrayList<>(javaSpans), nativeSpans, offset);
+    }
 }
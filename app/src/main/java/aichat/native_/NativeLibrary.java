@@ -4,45 +4,82 @@ import java.io.InputStream;
 import java.io.IOException;
 import java.lang.foreign.*;
 import java.lang.invoke.MethodHandle;
+import java.nio.charset.StandardCharsets;
 import java.nio.file.Files;
 import java.nio.file.Path;
 import java.nio.file.StandardCopyOption;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.ArrayList;
+import java.util.HexFormat;
+import java.util.List;
+import java.util.Map;
 import java.util.Optional;
+import java.util.concurrent.ConcurrentHashMap;
 
 public final class NativeLibrary {
     
     private static final NativeLibrary INSTANCE = new NativeLibrary();
     private static final boolean AVAILABLE;
+    private static final Map<String, NativeLibrary> VARIANTS = new ConcurrentHashMap<>();
+    // Hex digits of the content hash used to name the extraction directory
+    private static final int EXTRACT_HASH_CHARS = 16;
     
+    private final String variant;
     private final SymbolLookup library;
     private final Linker linker;
     
-    private final MethodHandle kmeans_cluster;
-    private final MethodHandle assign_points_batch;
-    private final MethodHandle distance_squared;
-    private final MethodHandle rgb_to_lab_batch;
-    private final MethodHandle lab_to_rgb_batch;
-    private final MethodHandle resynthesize_image;
-    private final MethodHandle posterize_image;
-    private final MethodHandle sample_pixels;
-    private final MethodHandle aichat_native_version;
-    private final MethodHandle aichat_has_simd;
-    private final MethodHandle hybrid_cluster;
-    private final MethodHandle hybrid_calculate_dbscan_eps;
-    private final MethodHandle sample_pixels_from_image;
-    private final MethodHandle decode_jpeg_file_turbojpeg;
-    private final MethodHandle turbojpeg_decode_buffer;
-    private final MethodHandle turbojpeg_free;
-    private final MethodHandle turbojpeg_encode_to_file;
-    private final MethodHandle aichat_has_turbojpeg;
+    private final Downcall kmeans_cluster;
+    private final Downcall kmeans_cluster_image;
+    private final Downcall kmeans_cluster_weighted;
+    private final Downcall slic_superpixels;
+    private final Downcall tsvq_build_palette;
+    private final Downcall assign_points_batch;
+    private final Downcall distance_squared;
+    private final Downcall rgb_to_lab_batch;
+    private final Downcall lab_to_rgb_batch;
+    private final Downcall resynthesize_image;
+    private final Downcall resynthesize_image_lut_bits;
+    private final Downcall posterize_image;
+    private final Downcall downscale_box;
+    private final Downcall downscale_lanczos3;
+    private final Downcall lab_statistics;
+    private final Downcall reinhard_transfer;
+    private final Downcall sample_pixels;
+    private final Downcall aichat_native_version;
+    private final Downcall aichat_has_simd;
+    private final Downcall aichat_noop;
+    private final Downcall aichat_set_num_threads;
+    private final Downcall aichat_trace_enable;
+    private final Downcall aichat_trace_now_ns;
+    private final Downcall aichat_trace_collect;
+    private final Downcall aichat_trace_clear;
+    private final Downcall aichat_trace_dropped_threads;
+    private final Downcall aichat_metrics_snapshot;
+    private final Downcall aichat_metrics_reset;
+    private final Downcall aichat_metrics_op_name;
+    private final Downcall aichat_lut_cache_enable;
+    private final Downcall aichat_lut_cache_clear;
+    private final Downcall aichat_memtrack_enable;
+    private final Downcall aichat_memtrack_snapshot;
+    private final Downcall aichat_memtrack_subsystem_name;
+    private final Downcall hybrid_cluster;
+    private final Downcall hybrid_cluster_bounded;
+    private final Downcall hybrid_calculate_dbscan_eps;
+    private final Downcall sample_pixels_from_image;
+    private final Downcall decode_jpeg_file_turbojpeg;
+    private final Downcall turbojpeg_decode_buffer;
+    private final Downcall turbojpeg_free;
+    private final Downcall turbojpeg_encode_to_file;
+    private final Downcall aichat_has_turbojpeg;
     
     // OpenCL GPU acceleration
-    private final MethodHandle aichat_has_opencl;
-    private final MethodHandle opencl_init;
-    private final MethodHandle opencl_cleanup;
-    private final MethodHandle opencl_get_device_name;
-    private final MethodHandle opencl_resynthesize_image;
-    private final MethodHandle opencl_resynthesize_streaming;
+    private final Downcall aichat_has_opencl;
+    private final Downcall opencl_init;
+    private final Downcall opencl_cleanup;
+    private final Downcall opencl_get_device_name;
+    private final Downcall opencl_resynthesize_image;
+    private final Downcall opencl_resynthesize_streaming;
     
     public static final StructLayout COLOR_POINT_LAYOUT = MemoryLayout.structLayout(
         ValueLayout.JAVA_FLOAT.withName("c1"),
@@ -50,6 +87,17 @@ public final class NativeLibrary {
         ValueLayout.JAVA_FLOAT.withName("c3")
     ).withName("ColorPoint3f");
     
+    public static final StructLayout TRACE_EVENT_LAYOUT = MemoryLayout.structLayout(
+        ValueLayout.JAVA_LONG.withName("start_ns"),
+        ValueLayout.JAVA_LONG.withName("duration_ns"),
+        ValueLayout.ADDRESS.withName("name"),
+        ValueLayout.JAVA_INT.withName("thread_id"),
+        ValueLayout.JAVA_INT.withName("reserved")
+    ).withName("TraceEvent");
+    
+    // Iterations the last k-means or hybrid call on each thread ran
+    private final ThreadLocal<Integer> lastIterations = ThreadLocal.withInitial(() -> 0);
+    
     static {
         boolean available = false;
         
@@ -66,228 +114,375 @@ public final class NativeLibrary {
     }
     
     private NativeLibrary() {
+        this(System.getProperty("native.variant"));
+    }
+    
+    private NativeLibrary(String variant) {
+        this.variant = variant;
         this.linker = Linker.nativeLinker();
-        this.library = loadLibrary();
-        
-        if (this.library != null) {
-            this.kmeans_cluster = lookupFunction("kmeans_cluster",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_FLOAT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_LONG
-                ));
-            
-            this.assign_points_batch = lookupFunction("assign_points_batch",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS
-                ));
-            
-            this.distance_squared = lookupFunction("distance_squared",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_FLOAT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS
-                ));
-            
-            this.rgb_to_lab_batch = lookupFunction("rgb_to_lab_batch",
-                FunctionDescriptor.ofVoid(
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT
-                ));
-            
-            this.lab_to_rgb_batch = lookupFunction("lab_to_rgb_batch",
-                FunctionDescriptor.ofVoid(
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT
-                ));
-            
-            this.resynthesize_image = lookupFunction("resynthesize_image",
-                FunctionDescriptor.ofVoid(
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS
-                ));
-            
-            this.posterize_image = lookupFunction("posterize_image",
-                FunctionDescriptor.ofVoid(
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS
-                ));
-            
-            this.sample_pixels = lookupFunction("sample_pixels",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_LONG
-                ));
-            
-            this.aichat_native_version = lookupFunction("aichat_native_version",
-                FunctionDescriptor.of(ValueLayout.ADDRESS));
-            
-            this.aichat_has_simd = lookupFunction("aichat_has_simd",
-                FunctionDescriptor.of(ValueLayout.JAVA_INT));
-            
-            this.hybrid_cluster = lookupFunction("hybrid_cluster",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_FLOAT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_FLOAT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_LONG
-                ));
-            
-            this.hybrid_calculate_dbscan_eps = lookupFunction("hybrid_calculate_dbscan_eps",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_FLOAT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_LONG
-                ));
-            
-            this.sample_pixels_from_image = lookupFunction("sample_pixels_from_image",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_LONG
-                ));
-            
-            this.decode_jpeg_file_turbojpeg = lookupFunction("decode_jpeg_file_turbojpeg",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.ADDRESS
-                ));
-            
-            this.turbojpeg_decode_buffer = lookupFunction("turbojpeg_decode_buffer",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,  // jpeg_data
-                    ValueLayout.JAVA_LONG, // jpeg_size
-                    ValueLayout.ADDRESS,  // out_width
-                    ValueLayout.ADDRESS,  // out_height
-                    ValueLayout.ADDRESS   // out_pixels
-                ));
-            
-            this.turbojpeg_free = lookupFunction("turbojpeg_free",
-                FunctionDescriptor.ofVoid(ValueLayout.ADDRESS));
-            
-            this.turbojpeg_encode_to_file = lookupFunction("turbojpeg_encode_to_file",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS
-                ));
-            
-            this.aichat_has_turbojpeg = lookupFunction("aichat_has_turbojpeg",
-                FunctionDescriptor.of(ValueLayout.JAVA_INT));
-            
-            // OpenCL GPU acceleration functions
-            this.aichat_has_opencl = lookupFunction("aichat_has_opencl",
-                FunctionDescriptor.of(ValueLayout.JAVA_INT));
-            
-            this.opencl_init = lookupFunction("opencl_init",
-                FunctionDescriptor.of(ValueLayout.JAVA_INT));
-            
-            this.opencl_cleanup = lookupFunction("opencl_cleanup",
-                FunctionDescriptor.ofVoid());
-            
-            this.opencl_get_device_name = lookupFunction("opencl_get_device_name",
-                FunctionDescriptor.of(ValueLayout.ADDRESS));
-            
-            this.opencl_resynthesize_image = lookupFunction("opencl_resynthesize_image",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,  // image_pixels
-                    ValueLayout.JAVA_INT,  // width
-                    ValueLayout.JAVA_INT,  // height
-                    ValueLayout.ADDRESS,  // target_palette
-                    ValueLayout.ADDRESS,  // source_palette
-                    ValueLayout.JAVA_INT,  // palette_size
-                    ValueLayout.ADDRESS   // output_pixels
-                ));
-            
-            this.opencl_resynthesize_streaming = lookupFunction("opencl_resynthesize_streaming",
-                FunctionDescriptor.of(
-                    ValueLayout.JAVA_INT,
-                    ValueLayout.ADDRESS,  // image_pixels
-                    ValueLayout.JAVA_INT,  // width
-                    ValueLayout.JAVA_INT,  // height
-                    ValueLayout.ADDRESS,  // target_palette
-                    ValueLayout.ADDRESS,  // source_palette
-                    ValueLayout.JAVA_INT,  // palette_size
-                    ValueLayout.ADDRESS,  // output_pixels
-                    ValueLayout.JAVA_INT   // tile_height
-                ));
-        } else {
-            this.kmeans_cluster = null;
-            this.assign_points_batch = null;
-            this.distance_squared = null;
-            this.rgb_to_lab_batch = null;
-            this.lab_to_rgb_batch = null;
-            this.resynthesize_image = null;
-            this.posterize_image = null;
-            this.sample_pixels = null;
-            this.aichat_native_version = null;
-            this.aichat_has_simd = null;
-            this.hybrid_cluster = null;
-            this.hybrid_calculate_dbscan_eps = null;
-            this.sample_pixels_from_image = null;
-            this.decode_jpeg_file_turbojpeg = null;
-            this.turbojpeg_decode_buffer = null;
-            this.turbojpeg_free = null;
-            this.turbojpeg_encode_to_file = null;
-            this.aichat_has_turbojpeg = null;
-            this.aichat_has_opencl = null;
-            this.opencl_init = null;
-            this.opencl_cleanup = null;
-            this.opencl_get_device_name = null;
-            this.opencl_resynthesize_image = null;
-            this.opencl_resynthesize_streaming = null;
-        }
-    }
-    
-    private SymbolLookup loadLibrary() {
+        this.library = loadLibrary(variant);
+        
+        this.kmeans_cluster = downcall("kmeans_cluster",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.kmeans_cluster_image = downcall("kmeans_cluster_image",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // image_pixels
+                ValueLayout.JAVA_INT,  // n
+                ValueLayout.JAVA_INT,  // k
+                ValueLayout.JAVA_INT,  // max_iterations
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.ADDRESS,   // centroids
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.kmeans_cluster_weighted = downcall("kmeans_cluster_weighted",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // points
+                ValueLayout.ADDRESS,   // weights
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.slic_superpixels = downcall("slic_superpixels",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // image_pixels
+                ValueLayout.JAVA_INT,  // width
+                ValueLayout.JAVA_INT,  // height
+                ValueLayout.JAVA_INT,  // max_superpixels
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // means
+                ValueLayout.ADDRESS    // areas
+            ));
+        
+        this.tsvq_build_palette = downcall("tsvq_build_palette",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // points
+                ValueLayout.ADDRESS,   // weights (nullable)
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS    // palette
+            ));
+        
+        this.assign_points_batch = downcall("assign_points_batch",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS
+            ));
+        
+        this.distance_squared = downcall("distance_squared",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS
+            ));
+        
+        this.rgb_to_lab_batch = downcall("rgb_to_lab_batch",
+            FunctionDescriptor.ofVoid(
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT
+            ));
+        
+        this.lab_to_rgb_batch = downcall("lab_to_rgb_batch",
+            FunctionDescriptor.ofVoid(
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT
+            ));
+        
+        this.resynthesize_image = downcall("resynthesize_image",
+            FunctionDescriptor.ofVoid(
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS
+            ));
+        
+        this.resynthesize_image_lut_bits = downcall("resynthesize_image_lut_bits",
+            FunctionDescriptor.ofVoid(
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS
+            ));
+        
+        this.posterize_image = downcall("posterize_image",
+            FunctionDescriptor.ofVoid(
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS
+            ));
+        
+        this.downscale_box = downcall("downscale_box",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // src_pixels
+                ValueLayout.JAVA_INT,  // width
+                ValueLayout.JAVA_INT,  // height
+                ValueLayout.ADDRESS,   // dst_pixels
+                ValueLayout.JAVA_INT,  // dst_width
+                ValueLayout.JAVA_INT   // dst_height
+            ));
+        
+        this.downscale_lanczos3 = downcall("downscale_lanczos3",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // src_pixels
+                ValueLayout.JAVA_INT,  // width
+                ValueLayout.JAVA_INT,  // height
+                ValueLayout.ADDRESS,   // dst_pixels
+                ValueLayout.JAVA_INT,  // dst_width
+                ValueLayout.JAVA_INT   // dst_height
+            ));
+        
+        this.lab_statistics = downcall("lab_statistics",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // pixels
+                ValueLayout.JAVA_INT,  // width
+                ValueLayout.JAVA_INT,  // height
+                ValueLayout.JAVA_INT,  // max_samples
+                ValueLayout.ADDRESS    // stats
+            ));
+        
+        this.reinhard_transfer = downcall("reinhard_transfer",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,   // image_pixels
+                ValueLayout.JAVA_INT,  // width
+                ValueLayout.JAVA_INT,  // height
+                ValueLayout.ADDRESS,   // source_stats
+                ValueLayout.ADDRESS,   // target_stats
+                ValueLayout.ADDRESS    // output_pixels
+            ));
+        
+        this.sample_pixels = downcall("sample_pixels",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.aichat_native_version = downcall("aichat_native_version",
+            FunctionDescriptor.of(ValueLayout.ADDRESS));
+        
+        this.aichat_has_simd = downcall("aichat_has_simd",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT));
+        
+        this.aichat_noop = downcall("aichat_noop",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT
+            ));
+        
+        this.aichat_set_num_threads = downcall("aichat_set_num_threads",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.JAVA_INT));
+        
+        this.aichat_trace_enable = downcall("aichat_trace_enable",
+            FunctionDescriptor.ofVoid(ValueLayout.JAVA_INT));
+        
+        this.aichat_trace_now_ns = downcall("aichat_trace_now_ns",
+            FunctionDescriptor.of(ValueLayout.JAVA_LONG));
+        
+        this.aichat_trace_collect = downcall("aichat_trace_collect",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.JAVA_INT));
+        
+        this.aichat_trace_clear = downcall("aichat_trace_clear",
+            FunctionDescriptor.ofVoid());
+        
+        this.aichat_trace_dropped_threads = downcall("aichat_trace_dropped_threads",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT));
+        
+        this.aichat_metrics_snapshot = downcall("aichat_metrics_snapshot",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.JAVA_INT));
+        
+        this.aichat_metrics_reset = downcall("aichat_metrics_reset",
+            FunctionDescriptor.ofVoid());
+        
+        this.aichat_metrics_op_name = downcall("aichat_metrics_op_name",
+            FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.JAVA_INT));
+        
+        this.aichat_lut_cache_enable = downcall("aichat_lut_cache_enable",
+            FunctionDescriptor.ofVoid(ValueLayout.JAVA_INT));
+        
+        this.aichat_lut_cache_clear = downcall("aichat_lut_cache_clear",
+            FunctionDescriptor.ofVoid());
+        
+        this.aichat_memtrack_enable = downcall("aichat_memtrack_enable",
+            FunctionDescriptor.ofVoid(ValueLayout.JAVA_INT));
+        
+        this.aichat_memtrack_snapshot = downcall("aichat_memtrack_snapshot",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT, ValueLayout.ADDRESS, ValueLayout.JAVA_INT));
+        
+        this.aichat_memtrack_subsystem_name = downcall("aichat_memtrack_subsystem_name",
+            FunctionDescriptor.of(ValueLayout.ADDRESS, ValueLayout.JAVA_INT));
+        
+        this.hybrid_cluster = downcall("hybrid_cluster",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.hybrid_cluster_bounded = downcall("hybrid_cluster_bounded",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.JAVA_INT,  // max_representatives
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.hybrid_calculate_dbscan_eps = downcall("hybrid_calculate_dbscan_eps",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_FLOAT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.sample_pixels_from_image = downcall("sample_pixels_from_image",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_LONG
+            ));
+        
+        this.decode_jpeg_file_turbojpeg = downcall("decode_jpeg_file_turbojpeg",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS,
+                ValueLayout.ADDRESS
+            ));
+        
+        this.turbojpeg_decode_buffer = downcall("turbojpeg_decode_buffer",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,  // jpeg_data
+                ValueLayout.JAVA_LONG, // jpeg_size
+                ValueLayout.ADDRESS,  // out_width
+                ValueLayout.ADDRESS,  // out_height
+                ValueLayout.ADDRESS   // out_pixels
+            ));
+        
+        this.turbojpeg_free = downcall("turbojpeg_free",
+            FunctionDescriptor.ofVoid(ValueLayout.ADDRESS));
+        
+        this.turbojpeg_encode_to_file = downcall("turbojpeg_encode_to_file",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS
+            ));
+        
+        this.aichat_has_turbojpeg = downcall("aichat_has_turbojpeg",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT));
+        
+        // OpenCL GPU acceleration functions
+        this.aichat_has_opencl = downcall("aichat_has_opencl",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT));
+        
+        this.opencl_init = downcall("opencl_init",
+            FunctionDescriptor.of(ValueLayout.JAVA_INT));
+        
+        this.opencl_cleanup = downcall("opencl_cleanup",
+            FunctionDescriptor.ofVoid());
+        
+        this.opencl_get_device_name = downcall("opencl_get_device_name",
+            FunctionDescriptor.of(ValueLayout.ADDRESS));
+        
+        this.opencl_resynthesize_image = downcall("opencl_resynthesize_image",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,  // image_pixels
+                ValueLayout.JAVA_INT,  // width
+                ValueLayout.JAVA_INT,  // height
+                ValueLayout.ADDRESS,  // target_palette
+                ValueLayout.ADDRESS,  // source_palette
+                ValueLayout.JAVA_INT,  // palette_size
+                ValueLayout.ADDRESS   // output_pixels
+            ));
+        
+        this.opencl_resynthesize_streaming = downcall("opencl_resynthesize_streaming",
+            FunctionDescriptor.of(
+                ValueLayout.JAVA_INT,
+                ValueLayout.ADDRESS,  // image_pixels
+                ValueLayout.JAVA_INT,  // width
+                ValueLayout.JAVA_INT,  // height
+                ValueLayout.ADDRESS,  // target_palette
+                ValueLayout.ADDRESS,  // source_palette
+                ValueLayout.JAVA_INT,  // palette_size
+                ValueLayout.ADDRESS,  // output_pixels
+                ValueLayout.JAVA_INT   // tile_height
+            ));
+    }
+    
+    private SymbolLookup loadLibrary(String variant) {
         String osName = System.getProperty("os.name").toLowerCase();
         String platform;
         String libExtension;
@@ -306,9 +501,8 @@ public final class NativeLibrary {
             return null;
         }
         
-        // Check for variant (for testing different optimization levels)
+        // Variant library (for testing different optimization levels)
         // Valid variants: "scalar", "simd", "openmp"
-        String variant = System.getProperty("native.variant");
         String libName;
         if (variant != null && !variant.isEmpty()) {
             // Load variant library (e.g., libaichat_native_scalar.so)
@@ -385,38 +579,133 @@ public final class NativeLibrary {
         return null;
     }
     
+    /**
+     * Extracts a bundled library to {@code <tmpdir>/aichat-native/<hash>/},
+     * keyed by its SHA-256, so an upgraded jar never reuses a stale copy and
+     * one already extracted by an earlier run is loaded without writing.
+     * The hash comes from the {@code .sha256} file the build writes next to
+     * each library, or from the library bytes when that file is missing.
+     * Each JVM writes to its own temp file and renames it into place, so
+     * concurrent first runs never load a half-written library.
+     */
     private Path extractLibraryFromJar(String resourcePath, String libName) {
-        try (InputStream is = getClass().getResourceAsStream(resourcePath)) {
-            if (is == null) {
-                return null;
+        try {
+            byte[] bytes = null;
+            String hash = readBundledHash(resourcePath);
+            if (hash == null) {
+                bytes = readResource(resourcePath);
+                if (bytes == null) {
+                    return null;
+                }
+                hash = sha256(bytes);
             }
             
-            // Create temp directory for native libs (survives between runs)
-            Path tempDir = Path.of(System.getProperty("java.io.tmpdir"), "aichat-native");
-            Files.createDirectories(tempDir);
-            
-            Path tempLib = tempDir.resolve(libName);
-            
-            // Extract if not exists or if newer in JAR
-            if (!Files.exists(tempLib)) {
-                Files.copy(is, tempLib, StandardCopyOption.REPLACE_EXISTING);
-                tempLib.toFile().setExecutable(true);
+            Path dir = Path.of(System.getProperty("java.io.tmpdir"), "aichat-native",
+                hash.substring(0, EXTRACT_HASH_CHARS));
+            Path target = dir.resolve(libName);
+            if (Files.isRegularFile(target)) {
+                return target;
             }
             
-            return tempLib;
-        } catch (IOException e) {
+            if (bytes == null) {
+                bytes = readResource(resourcePath);
+                if (bytes == null) {
+                    return null;
+                }
+            }
+            Files.createDirectories(dir);
+            Path temp = Files.createTempFile(dir, libName, ".tmp");
+            try {
+                Files.write(temp, bytes);
+                temp.toFile().setExecutable(true);
+                Files.move(temp, target, StandardCopyOption.ATOMIC_MOVE);
+            } catch (IOException e) {
+                // Another JVM may have renamed the same content into place first
+                if (!Files.isRegularFile(target)) {
+                    throw e;
+                }
+            } finally {
+                Files.deleteIfExists(temp);
+            }
+            return target;
+        } catch (IOException | NoSuchAlgorithmException e) {
             System.err.println("Failed to extract library from JAR: " + e.getMessage());
             return null;
         }
     }
     
-    private MethodHandle lookupFunction(String name, FunctionDescriptor descriptor) {
-        Optional<MemorySegment> symbol = library.find(name);
-        if (symbol.isPresent()) {
-            return linker.downcallHandle(symbol.get(), descriptor);
-        } else {
-            System.err.println("Function not found: " + name);
-            return null;
+    private String readBundledHash(String resourcePath) throws IOException {
+        try (InputStream is = getClass().getResourceAsStream(resourcePath + ".sha256")) {
+            if (is == null) {
+                return null;
+            }
+            String hash = new String(is.readAllBytes(), StandardCharsets.US_ASCII).trim();
+            return hash.length() >= EXTRACT_HASH_CHARS && hash.chars().allMatch(c -> Character.digit(c, 16) >= 0)
+                ? hash.toLowerCase() : null;
+        }
+    }
+    
+    private byte[] readResource(String resourcePath) throws IOException {
+        try (InputStream is = getClass().getResourceAsStream(resourcePath)) {
+            return is == null ? null : is.readAllBytes();
+        }
+    }
+    
+    private static String sha256(byte[] bytes) throws NoSuchAlgorithmException {
+        return HexFormat.of().formatHex(MessageDigest.getInstance("SHA-256").digest(bytes));
+    }
+    
+    private Downcall downcall(String name, FunctionDescriptor descriptor) {
+        return library != null ? new Downcall(library, linker, name, descriptor) : Downcall.MISSING;
+    }
+    
+    /**
+     * A downcall handle looked up and linked on first use rather than when
+     * the library loads, so startup only pays for the functions a run calls.
+     */
+    private static final class Downcall {
+        
+        // Stands in for every function when no library was loaded
+        static final Downcall MISSING = new Downcall(null, null, null, null);
+        
+        private final SymbolLookup library;
+        private final Linker linker;
+        private final String name;
+        private final FunctionDescriptor descriptor;
+        // Written before resolved, read after it
+        private MethodHandle handle;
+        private volatile boolean resolved;
+        
+        Downcall(SymbolLookup library, Linker linker, String name, FunctionDescriptor descriptor) {
+            this.library = library;
+            this.linker = linker;
+            this.name = name;
+            this.descriptor = descriptor;
+        }
+        
+        boolean isPresent() {
+            return handle() != null;
+        }
+        
+        /** The linked handle, or null when the library lacks the symbol. */
+        MethodHandle handle() {
+            if (!resolved) {
+                resolve();
+            }
+            return handle;
+        }
+        
+        private synchronized void resolve() {
+            if (resolved) return;
+            if (library != null) {
+                Optional<MemorySegment> symbol = library.find(name);
+                if (symbol.isPresent()) {
+                    handle = linker.downcallHandle(symbol.get(), descriptor);
+                } else {
+                    System.err.println("Function not found: " + name);
+                }
+            }
+            resolved = true;
         }
     }
     
@@ -428,10 +717,30 @@ public final class NativeLibrary {
         return AVAILABLE;
     }
     
+    /**
+     * A separately loaded instance of one build variant ("scalar", "simd",
+     * "openmp"), independent of {@code native.variant}, so several variants can
+     * be called side by side in one JVM. Check {@link #isLoaded()} before use.
+     */
+    public static NativeLibrary forVariant(String variant) {
+        return VARIANTS.computeIfAbsent(variant, NativeLibrary::new);
+    }
+    
+    public boolean isLoaded() {
+        return library != null;
+    }
+    
+    /**
+     * The variant this instance loaded, or null for the default library.
+     */
+    public String getVariant() {
+        return variant;
+    }
+    
     public String getVersion() {
-        if (aichat_native_version == null) return "N/A (fallback)";
+        if (!aichat_native_version.isPresent()) return "N/A (fallback)";
         try {
-            MemorySegment ptr = (MemorySegment) aichat_native_version.invokeExact();
+            MemorySegment ptr = (MemorySegment) aichat_native_version.handle().invokeExact();
             return ptr.reinterpret(256).getString(0);
         } catch (Throwable t) {
             return "Error: " + t.getMessage();
@@ -439,14 +748,258 @@ public final class NativeLibrary {
     }
     
     public boolean hasSIMD() {
-        if (aichat_has_simd == null) return false;
+        if (!aichat_has_simd.isPresent()) return false;
         try {
-            return ((int) aichat_has_simd.invokeExact()) != 0;
+            return ((int) aichat_has_simd.handle().invokeExact()) != 0;
         } catch (Throwable t) {
             return false;
         }
     }
     
+    /**
+     * Calls the empty native function; the baseline cost of one downcall
+     * with a pointer argument. Returns {@code n}.
+     */
+    public int noop(MemorySegment data, int n) {
+        if (!aichat_noop.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        try {
+            return (int) aichat_noop.handle().invokeExact(data, n);
+        } catch (Throwable t) {
+            throw new RuntimeException("No-op native call failed", t);
+        }
+    }
+    
+    /**
+     * Sets the OpenMP thread count for native calls made from the current
+     * thread, like {@code OMP_NUM_THREADS} but at runtime; {@code threads <= 0}
+     * only queries. Returns the count now in effect (1 without OpenMP).
+     */
+    public int setNumThreads(int threads) {
+        if (!aichat_set_num_threads.isPresent()) return 1;
+        try {
+            return (int) aichat_set_num_threads.handle().invokeExact(threads);
+        } catch (Throwable t) {
+            return 1;
+        }
+    }
+    
+    /** One native span; {@code threadId} numbers native threads from 1 in order of first use. */
+    public record TraceSpan(String name, long startNanos, long durationNanos, int threadId) {}
+    
+    /**
+     * Turns native span recording on or off for all threads. Returns false
+     * when the loaded library has no tracing support.
+     */
+    public boolean setTraceEnabled(boolean enabled) {
+        if (!aichat_trace_enable.isPresent()) return false;
+        try {
+            aichat_trace_enable.handle().invokeExact(enabled ? 1 : 0);
+            return true;
+        } catch (Throwable t) {
+            return false;
+        }
+    }
+    
+    /** Native monotonic clock; on Linux and macOS the same clock as {@link System#nanoTime()}. */
+    public long traceNowNanos() {
+        if (!aichat_trace_now_ns.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        try {
+            return (long) aichat_trace_now_ns.handle().invokeExact();
+        } catch (Throwable t) {
+            throw new RuntimeException("Trace clock native call failed", t);
+        }
+    }
+    
+    /**
+     * Copies the spans buffered in the per-thread native rings. Call while no
+     * traced native work is running; spans recorded meanwhile may be torn.
+     */
+    public List<TraceSpan> collectTrace() {
+        if (!aichat_trace_collect.isPresent()) return List.of();
+        
+        try (Arena arena = Arena.ofConfined()) {
+            int available = (int) aichat_trace_collect.handle().invokeExact(MemorySegment.NULL, 0);
+            if (available == 0) return List.of();
+            
+            MemorySegment events = arena.allocate(TRACE_EVENT_LAYOUT, available);
+            int total = (int) aichat_trace_collect.handle().invokeExact(events, available);
+            int count = Math.min(total, available);
+            
+            List<TraceSpan> spans = new ArrayList<>(count);
+            long size = TRACE_EVENT_LAYOUT.byteSize();
+            for (int i = 0; i < count; i++) {
+                MemorySegment e = events.asSlice(i * size, size);
+                MemorySegment name = e.get(ValueLayout.ADDRESS, 16);
+                spans.add(new TraceSpan(
+                    name.equals(MemorySegment.NULL) ? "?" : name.reinterpret(Long.MAX_VALUE).getString(0),
+                    e.get(ValueLayout.JAVA_LONG, 0),
+                    e.get(ValueLayout.JAVA_LONG, 8),
+                    e.get(ValueLayout.JAVA_INT, 24)
+                ));
+            }
+            return spans;
+        } catch (Throwable t) {
+            throw new RuntimeException("Trace collect native call failed", t);
+        }
+    }
+    
+    public void clearTrace() {
+        if (!aichat_trace_clear.isPresent()) return;
+        try {
+            aichat_trace_clear.handle().invokeExact();
+        } catch (Throwable t) {
+            throw new RuntimeException("Trace clear native call failed", t);
+        }
+    }
+    
+    /**
+     * Native threads whose spans were never recorded because all 256 rings
+     * were held by live threads; rings of exited threads are reused.
+     */
+    public int traceDroppedThreads() {
+        if (!aichat_trace_dropped_threads.isPresent()) return 0;
+        try {
+            return (int) aichat_trace_dropped_threads.handle().invokeExact();
+        } catch (Throwable t) {
+            throw new RuntimeException("Trace dropped threads native call failed", t);
+        }
+    }
+    
+    /**
+     * Reads the native counters, or returns null when the loaded library has
+     * no metrics support. Counters bumped while the snapshot is copied may be
+     * off by those calls.
+     */
+    public NativeMetrics metricsSnapshot() {
+        if (!aichat_metrics_snapshot.isPresent()) return null;
+        
+        try (Arena arena = Arena.ofConfined()) {
+            int size = (int) aichat_metrics_snapshot.handle().invokeExact(MemorySegment.NULL, 0);
+            MemorySegment snapshot = arena.allocate(size, ValueLayout.JAVA_LONG.byteAlignment());
+            int written = (int) aichat_metrics_snapshot.handle().invokeExact(snapshot, size);
+            if (written != size) return null;
+            
+            // Header of two ints, then uint64 counters in struct order
+            int opCount = snapshot.get(ValueLayout.JAVA_INT, 0);
+            int bucketCount = snapshot.get(ValueLayout.JAVA_INT, 4);
+            long[] words = snapshot.asSlice(8).toArray(ValueLayout.JAVA_LONG);
+            
+            long[] calls = new long[opCount];
+            long[] callNanos = new long[opCount];
+            long[] items = new long[opCount];
+            System.arraycopy(words, 0, calls, 0, opCount);
+            System.arraycopy(words, opCount, callNanos, 0, opCount);
+            System.arraycopy(words, 2 * opCount, items, 0, opCount);
+            int latency = 3 * opCount;
+            int globals = latency + opCount * bucketCount;
+            
+            List<NativeMetrics.OpMetrics> ops = new ArrayList<>(opCount);
+            for (int op = 0; op < opCount; op++) {
+                long[] buckets = new long[bucketCount];
+                System.arraycopy(words, latency + op * bucketCount, buckets, 0, bucketCount);
+                ops.add(new NativeMetrics.OpMetrics(metricsOpName(op), calls[op], callNanos[op], items[op], buckets));
+            }
+            return new NativeMetrics(ops, words[globals], words[globals + 1], words[globals + 2],
+                words[globals + 3], words[globals + 4]);
+        } catch (Throwable t) {
+            throw new RuntimeException("Metrics snapshot native call failed", t);
+        }
+    }
+    
+    private String metricsOpName(int op) throws Throwable {
+        MemorySegment name = !aichat_metrics_op_name.isPresent()
+            ? MemorySegment.NULL : (MemorySegment) aichat_metrics_op_name.handle().invokeExact(op);
+        return name.equals(MemorySegment.NULL) ? "op" + op : name.reinterpret(Long.MAX_VALUE).getString(0);
+    }
+    
+    public void resetMetrics() {
+        if (!aichat_metrics_reset.isPresent()) return;
+        try {
+            aichat_metrics_reset.handle().invokeExact();
+        } catch (Throwable t) {
+            throw new RuntimeException("Metrics reset native call failed", t);
+        }
+    }
+    
+    /**
+     * Turns the native palette LUT cache on (the default) or off; off also
+     * frees the cached table. Benchmarks turn it off to time cold LUT builds.
+     */
+    public void setLutCacheEnabled(boolean enabled) {
+        if (!aichat_lut_cache_enable.isPresent()) return;
+        try {
+            aichat_lut_cache_enable.handle().invokeExact(enabled ? 1 : 0);
+        } catch (Throwable t) {
+            throw new RuntimeException("LUT cache native call failed", t);
+        }
+    }
+    
+    public void clearLutCache() {
+        if (!aichat_lut_cache_clear.isPresent()) return;
+        try {
+            aichat_lut_cache_clear.handle().invokeExact();
+        } catch (Throwable t) {
+            throw new RuntimeException("LUT cache native call failed", t);
+        }
+    }
+    
+    /**
+     * Turns the native allocation tracker on or off; turning it on restarts
+     * the peaks. Returns false when the loaded library has no tracker.
+     */
+    public boolean setMemoryTracking(boolean enabled) {
+        if (!aichat_memtrack_enable.isPresent()) return false;
+        try {
+            aichat_memtrack_enable.handle().invokeExact(enabled ? 1 : 0);
+            return true;
+        } catch (Throwable t) {
+            return false;
+        }
+    }
+    
+    /** Reads the native allocation tracker, or null when the library has none. */
+    public NativeMemoryStats memoryStats() {
+        if (!aichat_memtrack_snapshot.isPresent()) return null;
+        
+        try (Arena arena = Arena.ofConfined()) {
+            int size = (int) aichat_memtrack_snapshot.handle().invokeExact(MemorySegment.NULL, 0);
+            MemorySegment snapshot = arena.allocate(size, ValueLayout.JAVA_LONG.byteAlignment());
+            int written = (int) aichat_memtrack_snapshot.handle().invokeExact(snapshot, size);
+            if (written != size) return null;
+            
+            // Header of four ints, then int64 counters in struct order
+            int subsystemCount = snapshot.get(ValueLayout.JAVA_INT, 0);
+            int opCount = snapshot.get(ValueLayout.JAVA_INT, 4);
+            boolean enabled = snapshot.get(ValueLayout.JAVA_INT, 8) != 0;
+            long[] words = snapshot.asSlice(16).toArray(ValueLayout.JAVA_LONG);
+            
+            List<NativeMemoryStats.Subsystem> subsystems = new ArrayList<>(subsystemCount);
+            for (int s = 0; s < subsystemCount; s++) {
+                MemorySegment name = !aichat_memtrack_subsystem_name.isPresent()
+                    ? MemorySegment.NULL : (MemorySegment) aichat_memtrack_subsystem_name.handle().invokeExact(s);
+                subsystems.add(new NativeMemoryStats.Subsystem(
+                    name.equals(MemorySegment.NULL) ? "subsystem" + s : name.reinterpret(Long.MAX_VALUE).getString(0),
+                    words[s], words[subsystemCount + s]));
+            }
+            int totals = 2 * subsystemCount;
+            int callPeaks = totals + 2;
+            
+            List<NativeMemoryStats.CallPeak> calls = new ArrayList<>(opCount);
+            for (int op = 0; op < opCount; op++) {
+                calls.add(new NativeMemoryStats.CallPeak(metricsOpName(op),
+                    words[callPeaks + op], words[callPeaks + opCount + op]));
+            }
+            return new NativeMemoryStats(enabled, words[totals], words[totals + 1], subsystems, calls);
+        } catch (Throwable t) {
+            throw new RuntimeException("Memory tracker native call failed", t);
+        }
+    }
+    
     /**
      * Calculates squared Euclidean distance between two color points.
      * 
@@ -456,7 +1009,7 @@ public final class NativeLibrary {
      * @return squared distance: (c1a-c1b)² + (c2a-c2b)² + (c3a-c3b)²
      */
     public float distanceSquared(Arena arena, float[] point1, float[] point2) {
-        if (distance_squared == null) {
+        if (!distance_squared.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -472,7 +1025,7 @@ public final class NativeLibrary {
         p2.set(ValueLayout.JAVA_FLOAT, 8, point2[2]);
         
         try {
-            return (float) distance_squared.invokeExact(p1, p2);
+            return (float) distance_squared.handle().invokeExact(p1, p2);
         } catch (Throwable t) {
             throw new RuntimeException("distance_squared native call failed", t);
         }
@@ -482,12 +1035,20 @@ public final class NativeLibrary {
      * Checks if distance_squared function is available.
      */
     public boolean hasDistanceSquared() {
-        return distance_squared != null;
+        return distance_squared.isPresent();
+    }
+    
+    /**
+     * Lloyd iterations run by the most recent k-means or hybrid clustering
+     * call on this thread, for diagnostics.
+     */
+    public int lastClusterIterations() {
+        return lastIterations.get();
     }
     
     public float[] kmeansCluster(Arena arena, float[] points, int k, 
                                   int maxIterations, float threshold, long seed) {
-        if (kmeans_cluster == null) {
+        if (!kmeans_cluster.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -499,12 +1060,68 @@ public final class NativeLibrary {
         
         pointsNative.copyFrom(MemorySegment.ofArray(points));
         
+        kmeansCluster(pointsNative, n, k, maxIterations, threshold, centroidsNative, assignmentsNative, seed);
+        
+        float[] result = new float[k * 3];
+        for (int i = 0; i < k; i++) {
+            long offset = i * COLOR_POINT_LAYOUT.byteSize();
+            result[i * 3] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset);
+            result[i * 3 + 1] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
+            result[i * 3 + 2] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
+        }
+        
+        return result;
+    }
+    
+    /**
+     * K-means over points already in native memory, writing {@code k}
+     * ColorPoint3f centroids and {@code n} assignments; returns the
+     * iterations run.
+     */
+    public int kmeansCluster(MemorySegment points, int n, int k, int maxIterations, float threshold,
+                             MemorySegment centroids, MemorySegment assignments, long seed) {
+        if (!kmeans_cluster.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            @SuppressWarnings("unused")
-            int iterations = (int) kmeans_cluster.invokeExact(
-                pointsNative, n, k, maxIterations, threshold,
+            int iterations = (int) kmeans_cluster.handle().invokeExact(
+                points, n, k, maxIterations, threshold,
+                centroids, assignments, seed
+            );
+            lastIterations.set(iterations);
+            return iterations;
+        } catch (Throwable t) {
+            throw new RuntimeException("K-Means native call failed", t);
+        }
+    }
+    
+    /**
+     * K-means where each point counts with its weight (e.g. the number of
+     * samples a representative stands for).
+     */
+    public float[] kmeansClusterWeighted(Arena arena, float[] points, float[] weights, int k,
+                                          int maxIterations, float threshold, long seed) {
+        if (!kmeans_cluster_weighted.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        int n = points.length / 3;
+        
+        MemorySegment pointsNative = arena.allocate(ValueLayout.JAVA_FLOAT, points.length);
+        MemorySegment weightsNative = arena.allocate(ValueLayout.JAVA_FLOAT, n);
+        MemorySegment centroidsNative = arena.allocate(COLOR_POINT_LAYOUT, k);
+        MemorySegment assignmentsNative = arena.allocate(ValueLayout.JAVA_INT, n);
+        
+        pointsNative.copyFrom(MemorySegment.ofArray(points));
+        weightsNative.copyFrom(MemorySegment.ofArray(weights).asSlice(0, n * 4L));
+        
+        try {
+            int iterations = (int) kmeans_cluster_weighted.handle().invokeExact(
+                pointsNative, weightsNative, n, k, maxIterations, threshold,
                 centroidsNative, assignmentsNative, seed
             );
+            lastIterations.set(iterations);
             
             float[] result = new float[k * 3];
             for (int i = 0; i < k; i++) {
@@ -516,12 +1133,137 @@ public final class NativeLibrary {
             
             return result;
         } catch (Throwable t) {
-            throw new RuntimeException("K-Means native call failed", t);
+            throw new RuntimeException("Weighted K-Means native call failed", t);
+        }
+    }
+    
+    /**
+     * Exact k-means over every pixel of an ARGB image.
+     * Copies the pixels to native memory; use the {@link MemorySegment} overload
+     * for buffers that already live off-heap.
+     */
+    public float[] kmeansClusterImage(Arena arena, int[] imagePixels, int k,
+                                       int maxIterations, float threshold, long seed) {
+        MemorySegment imageNative = arena.allocate(ValueLayout.JAVA_INT, imagePixels.length);
+        imageNative.copyFrom(MemorySegment.ofArray(imagePixels));
+        return kmeansClusterImage(arena, imageNative, imagePixels.length, k, maxIterations, threshold, seed);
+    }
+    
+    /**
+     * Exact k-means over {@code n} ARGB pixels in native memory, e.g. a decoded
+     * native buffer or a raster mapped with {@code FileChannel.map}.
+     * The pixels are streamed in tiles and never copied.
+     */
+    public float[] kmeansClusterImage(Arena arena, MemorySegment imagePixels, int n, int k,
+                                       int maxIterations, float threshold, long seed) {
+        if (!kmeans_cluster_image.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        if (imagePixels.byteSize() < n * 4L) {
+            throw new IllegalArgumentException("Pixel segment smaller than " + n + " pixels");
+        }
+        
+        MemorySegment centroidsNative = arena.allocate(COLOR_POINT_LAYOUT, k);
+        
+        try {
+            int iterations = (int) kmeans_cluster_image.handle().invokeExact(
+                imagePixels, n, k, maxIterations, threshold, centroidsNative, seed
+            );
+            lastIterations.set(iterations);
+            
+            float[] result = new float[k * 3];
+            MemorySegment.ofArray(result).copyFrom(centroidsNative.asSlice(0, result.length * 4L));
+            return result;
+        } catch (Throwable t) {
+            throw new RuntimeException("Streaming K-Means native call failed", t);
+        }
+    }
+    
+    /**
+     * Tree-structured VQ palette of up to {@code k} colors; {@code weights}
+     * may be null. Fewer colors are returned when the input has fewer
+     * distinct ones.
+     */
+    public float[] tsvqBuildPalette(Arena arena, float[] points, float[] weights, int k) {
+        if (!tsvq_build_palette.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        int n = points.length / 3;
+        
+        MemorySegment pointsNative = arena.allocate(ValueLayout.JAVA_FLOAT, points.length);
+        MemorySegment weightsNative = MemorySegment.NULL;
+        MemorySegment paletteNative = arena.allocate(COLOR_POINT_LAYOUT, k);
+        
+        pointsNative.copyFrom(MemorySegment.ofArray(points));
+        if (weights != null) {
+            weightsNative = arena.allocate(ValueLayout.JAVA_FLOAT, n);
+            weightsNative.copyFrom(MemorySegment.ofArray(weights).asSlice(0, n * 4L));
+        }
+        
+        try {
+            int count = (int) tsvq_build_palette.handle().invokeExact(
+                pointsNative, weightsNative, n, k, paletteNative
+            );
+            
+            float[] result = new float[count * 3];
+            for (int i = 0; i < count; i++) {
+                long offset = i * COLOR_POINT_LAYOUT.byteSize();
+                result[i * 3] = paletteNative.get(ValueLayout.JAVA_FLOAT, offset);
+                result[i * 3 + 1] = paletteNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
+                result[i * 3 + 2] = paletteNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
+            }
+            
+            return result;
+        } catch (Throwable t) {
+            throw new RuntimeException("TSVQ native call failed", t);
+        }
+    }
+    
+    /** Mean RGB colors (3 floats each) and pixel counts of {@code count} superpixels. */
+    public record Superpixels(int count, float[] means, float[] areas) {}
+    
+    /**
+     * SLIC superpixels of an ARGB image; at most {@code maxSuperpixels}
+     * are returned, empty ones are dropped.
+     */
+    public Superpixels slicSuperpixels(Arena arena, int[] imagePixels, int width, int height,
+                                        int maxSuperpixels, float compactness, int maxIterations) {
+        if (!slic_superpixels.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        MemorySegment imageNative = arena.allocate(ValueLayout.JAVA_INT, imagePixels.length);
+        MemorySegment meansNative = arena.allocate(COLOR_POINT_LAYOUT, maxSuperpixels);
+        MemorySegment areasNative = arena.allocate(ValueLayout.JAVA_FLOAT, maxSuperpixels);
+        
+        imageNative.copyFrom(MemorySegment.ofArray(imagePixels));
+        
+        try {
+            int count = (int) slic_superpixels.handle().invokeExact(
+                imageNative, width, height, maxSuperpixels, compactness, maxIterations,
+                meansNative, areasNative
+            );
+            
+            float[] means = new float[count * 3];
+            for (int i = 0; i < count; i++) {
+                long offset = i * COLOR_POINT_LAYOUT.byteSize();
+                means[i * 3] = meansNative.get(ValueLayout.JAVA_FLOAT, offset);
+                means[i * 3 + 1] = meansNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
+                means[i * 3 + 2] = meansNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
+            }
+            
+            float[] areas = new float[count];
+            MemorySegment.copy(areasNative, ValueLayout.JAVA_FLOAT, 0, areas, 0, count);
+            
+            return new Superpixels(count, means, areas);
+        } catch (Throwable t) {
+            throw new RuntimeException("SLIC superpixels native call failed", t);
         }
     }
     
     public float[] rgbToLabBatch(Arena arena, float[] rgb) {
-        if (rgb_to_lab_batch == null) {
+        if (!rgb_to_lab_batch.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -532,19 +1274,30 @@ public final class NativeLibrary {
         
         rgbNative.copyFrom(MemorySegment.ofArray(rgb));
         
+        rgbToLabBatch(rgbNative, labNative, n);
+        
+        float[] result = new float[rgb.length];
+        MemorySegment.ofArray(result).copyFrom(labNative);
+        return result;
+    }
+    
+    /**
+     * Converts {@code n} RGB points in native memory to LAB without copying.
+     */
+    public void rgbToLabBatch(MemorySegment rgb, MemorySegment lab, int n) {
+        if (!rgb_to_lab_batch.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            rgb_to_lab_batch.invokeExact(rgbNative, labNative, n);
-            
-            float[] result = new float[rgb.length];
-            MemorySegment.ofArray(result).copyFrom(labNative);
-            return result;
+            rgb_to_lab_batch.handle().invokeExact(rgb, lab, n);
         } catch (Throwable t) {
             throw new RuntimeException("RGB to LAB native call failed", t);
         }
     }
     
     public float[] labToRgbBatch(Arena arena, float[] lab) {
-        if (lab_to_rgb_batch == null) {
+        if (!lab_to_rgb_batch.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -555,12 +1308,23 @@ public final class NativeLibrary {
         
         labNative.copyFrom(MemorySegment.ofArray(lab));
         
+        labToRgbBatch(labNative, rgbNative, n);
+        
+        float[] result = new float[lab.length];
+        MemorySegment.ofArray(result).copyFrom(rgbNative);
+        return result;
+    }
+    
+    /**
+     * Converts {@code n} LAB points in native memory to RGB without copying.
+     */
+    public void labToRgbBatch(MemorySegment lab, MemorySegment rgb, int n) {
+        if (!lab_to_rgb_batch.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            lab_to_rgb_batch.invokeExact(labNative, rgbNative, n);
-            
-            float[] result = new float[lab.length];
-            MemorySegment.ofArray(result).copyFrom(rgbNative);
-            return result;
+            lab_to_rgb_batch.handle().invokeExact(lab, rgb, n);
         } catch (Throwable t) {
             throw new RuntimeException("LAB to RGB native call failed", t);
         }
@@ -568,7 +1332,7 @@ public final class NativeLibrary {
     
     public int[] resynthesizeImage(Arena arena, int[] imagePixels, int width, int height,
                                     float[] targetPalette, float[] sourcePalette) {
-        if (resynthesize_image == null) {
+        if (!resynthesize_image.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -584,10 +1348,59 @@ public final class NativeLibrary {
         targetPaletteNative.copyFrom(MemorySegment.ofArray(targetPalette));
         sourcePaletteNative.copyFrom(MemorySegment.ofArray(sourcePalette));
         
+        resynthesizeImage(imageNative, width, height,
+                          targetPaletteNative, sourcePaletteNative, paletteSize, outputNative);
+        
+        MemorySegment.ofArray(output).copyFrom(outputNative);
+    }
+    
+    /**
+     * Resynthesis over an image and palettes already in native memory;
+     * writes {@code width * height} pixels to {@code output}.
+     */
+    public void resynthesizeImage(MemorySegment image, int width, int height,
+                                  MemorySegment targetPalette, MemorySegment sourcePalette,
+                                  int paletteSize, MemorySegment output) {
+        if (!resynthesize_image.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            resynthesize_image.invokeExact(
+            resynthesize_image.handle().invokeExact(
+                image, width, height,
+                targetPalette, sourcePalette, paletteSize, output
+            );
+        } catch (Throwable t) {
+            throw new RuntimeException("Resynthesize native call failed", t);
+        }
+    }
+    
+    /**
+     * Resynthesis with a palette LUT of {@code lutBits} per channel (4-8, the
+     * default is 7). 8 bits is exact; fewer bits trade accuracy for build time.
+     */
+    public int[] resynthesizeImage(Arena arena, int[] imagePixels, int width, int height,
+                                    float[] targetPalette, float[] sourcePalette, int lutBits) {
+        if (!resynthesize_image_lut_bits.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        int paletteSize = sourcePalette.length / 3;
+        int n = width * height;
+        
+        MemorySegment imageNative = arena.allocate(ValueLayout.JAVA_INT, n);
+        MemorySegment targetPaletteNative = arena.allocate(ValueLayout.JAVA_FLOAT, targetPalette.length);
+        MemorySegment sourcePaletteNative = arena.allocate(ValueLayout.JAVA_FLOAT, sourcePalette.length);
+        MemorySegment outputNative = arena.allocate(ValueLayout.JAVA_INT, n);
+        
+        imageNative.copyFrom(MemorySegment.ofArray(imagePixels));
+        targetPaletteNative.copyFrom(MemorySegment.ofArray(targetPalette));
+        sourcePaletteNative.copyFrom(MemorySegment.ofArray(sourcePalette));
+        
+        try {
+            resynthesize_image_lut_bits.handle().invokeExact(
                 imageNative, width, height,
-                targetPaletteNative, sourcePaletteNative, paletteSize, outputNative
+                targetPaletteNative, sourcePaletteNative, paletteSize, lutBits, outputNative
             );
             
             int[] result = new int[n];
@@ -600,7 +1413,7 @@ public final class NativeLibrary {
     
     public int[] posterizeImage(Arena arena, int[] imagePixels, int width, int height,
                                  float[] targetPalette, float[] sourcePalette) {
-        if (posterize_image == null) {
+        if (!posterize_image.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -616,22 +1429,164 @@ public final class NativeLibrary {
         targetPaletteNative.copyFrom(MemorySegment.ofArray(targetPalette));
         sourcePaletteNative.copyFrom(MemorySegment.ofArray(sourcePalette));
         
+        posterizeImage(imageNative, width, height,
+                       targetPaletteNative, sourcePaletteNative, paletteSize, outputNative);
+        
+        int[] result = new int[n];
+        MemorySegment.ofArray(result).copyFrom(outputNative);
+        return result;
+    }
+    
+    /**
+     * Posterization over an image and palettes already in native memory;
+     * writes {@code width * height} pixels to {@code output}.
+     */
+    public void posterizeImage(MemorySegment image, int width, int height,
+                               MemorySegment targetPalette, MemorySegment sourcePalette,
+                               int paletteSize, MemorySegment output) {
+        if (!posterize_image.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            posterize_image.invokeExact(
-                imageNative, width, height,
-                targetPaletteNative, sourcePaletteNative, paletteSize, outputNative
+            posterize_image.handle().invokeExact(
+                image, width, height,
+                targetPalette, sourcePalette, paletteSize, output
             );
-            
-            int[] result = new int[n];
-            MemorySegment.ofArray(result).copyFrom(outputNative);
-            return result;
         } catch (Throwable t) {
             throw new RuntimeException("Posterize native call failed", t);
         }
     }
     
+    public int[] downscaleBox(Arena arena, int[] imagePixels, int width, int height,
+                              int dstWidth, int dstHeight) {
+        return downscale(arena, imagePixels, width, height, dstWidth, dstHeight, false);
+    }
+    
+    public int[] downscaleLanczos3(Arena arena, int[] imagePixels, int width, int height,
+                                   int dstWidth, int dstHeight) {
+        return downscale(arena, imagePixels, width, height, dstWidth, dstHeight, true);
+    }
+    
+    private int[] downscale(Arena arena, int[] imagePixels, int width, int height,
+                            int dstWidth, int dstHeight, boolean lanczos) {
+        int n = dstWidth * dstHeight;
+        MemorySegment imageNative = arena.allocate(ValueLayout.JAVA_INT, (long) width * height);
+        MemorySegment outputNative = arena.allocate(ValueLayout.JAVA_INT, n);
+        imageNative.copyFrom(MemorySegment.ofArray(imagePixels).asSlice(0, (long) width * height * 4));
+        
+        if (lanczos) {
+            downscaleLanczos3(imageNative, width, height, outputNative, dstWidth, dstHeight);
+        } else {
+            downscaleBox(imageNative, width, height, outputNative, dstWidth, dstHeight);
+        }
+        
+        int[] result = new int[n];
+        MemorySegment.ofArray(result).copyFrom(outputNative);
+        return result;
+    }
+    
+    /**
+     * Box-filter downscale of an image in native memory to {@code dstWidth x
+     * dstHeight} opaque ARGB pixels in {@code output}; each target size must
+     * be positive and no larger than the source. Throws
+     * IllegalArgumentException when the sizes are rejected.
+     */
+    public void downscaleBox(MemorySegment image, int width, int height,
+                             MemorySegment output, int dstWidth, int dstHeight) {
+        downscale(downscale_box, image, width, height, output, dstWidth, dstHeight);
+    }
+    
+    /** Lanczos-3 counterpart of {@link #downscaleBox(MemorySegment, int, int, MemorySegment, int, int)}. */
+    public void downscaleLanczos3(MemorySegment image, int width, int height,
+                                  MemorySegment output, int dstWidth, int dstHeight) {
+        downscale(downscale_lanczos3, image, width, height, output, dstWidth, dstHeight);
+    }
+    
+    private static void downscale(Downcall function, MemorySegment image, int width, int height,
+                                  MemorySegment output, int dstWidth, int dstHeight) {
+        if (!function.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        int ok;
+        try {
+            ok = (int) function.handle().invokeExact(image, width, height, output, dstWidth, dstHeight);
+        } catch (Throwable t) {
+            throw new RuntimeException("Downscale native call failed", t);
+        }
+        if (ok == 0) {
+            throw new IllegalArgumentException(
+                "Invalid downscale " + width + "x" + height + " -> " + dstWidth + "x" + dstHeight);
+        }
+    }
+    
+    /**
+     * Mean and standard deviation of L*, a*, b* over a grid of about
+     * {@code maxSamples} pixels (all of them when not positive), as
+     * {meanL, meanA, meanB, stdL, stdA, stdB}.
+     */
+    public float[] labStatistics(Arena arena, int[] imagePixels, int width, int height, int maxSamples) {
+        if (!lab_statistics.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        MemorySegment imageNative = arena.allocate(ValueLayout.JAVA_INT, (long) width * height);
+        MemorySegment statsNative = arena.allocate(ValueLayout.JAVA_FLOAT, 6);
+        imageNative.copyFrom(MemorySegment.ofArray(imagePixels).asSlice(0, (long) width * height * 4));
+        
+        int sampled;
+        try {
+            sampled = (int) lab_statistics.handle().invokeExact(
+                imageNative, width, height, maxSamples, statsNative);
+        } catch (Throwable t) {
+            throw new RuntimeException("Lab statistics native call failed", t);
+        }
+        if (sampled == 0) {
+            throw new IllegalArgumentException("Invalid image size " + width + "x" + height);
+        }
+        return statsNative.toArray(ValueLayout.JAVA_FLOAT);
+    }
+    
+    /**
+     * Reinhard transfer of an image toward {@code sourceStats}, given its own
+     * {@code targetStats}, both laid out as returned by {@link #labStatistics}.
+     * The result is copied straight into {@code output}, e.g. the data array
+     * of the destination raster.
+     */
+    public void reinhardTransfer(Arena arena, int[] imagePixels, int width, int height,
+                                 float[] sourceStats, float[] targetStats, int[] output) {
+        if (!reinhard_transfer.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        int n = width * height;
+        MemorySegment imageNative = arena.allocate(ValueLayout.JAVA_INT, n);
+        MemorySegment sourceNative = arena.allocate(ValueLayout.JAVA_FLOAT, 6);
+        MemorySegment targetNative = arena.allocate(ValueLayout.JAVA_FLOAT, 6);
+        MemorySegment outputNative = arena.allocate(ValueLayout.JAVA_INT, n);
+        imageNative.copyFrom(MemorySegment.ofArray(imagePixels).asSlice(0, (long) n * 4));
+        sourceNative.copyFrom(MemorySegment.ofArray(sourceStats).asSlice(0, 6 * 4));
+        targetNative.copyFrom(MemorySegment.ofArray(targetStats).asSlice(0, 6 * 4));
+        
+        int ok;
+        try {
+            ok = (int) reinhard_transfer.handle().invokeExact(
+                imageNative, width, height, sourceNative, targetNative, outputNative);
+        } catch (Throwable t) {
+            throw new RuntimeException("Reinhard transfer native call failed", t);
+        }
+        if (ok == 0) {
+            throw new IllegalStateException("Reinhard transfer failed for " + width + "x" + height);
+        }
+        
+        int[] result = new int[n];
+        MemorySegment.ofArray(result).copyFrom(outputNative);
+        return result;
+    }
+    
     public float[] samplePixels(Arena arena, float[] input, int sampleSize, long seed) {
-        if (sample_pixels == null) {
+        if (!sample_pixels.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -644,7 +1599,7 @@ public final class NativeLibrary {
         inputNative.copyFrom(MemorySegment.ofArray(input));
         
         try {
-            int actualSize = (int) sample_pixels.invokeExact(
+            int actualSize = (int) sample_pixels.handle().invokeExact(
                 inputNative, inputSize, outputNative, sampleSize, seed
             );
             
@@ -657,7 +1612,7 @@ public final class NativeLibrary {
     }
     
     public int[] assignPointsBatch(Arena arena, float[] points, float[] centroids) {
-        if (assign_points_batch == null) {
+        if (!assign_points_batch.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -675,13 +1630,25 @@ public final class NativeLibrary {
             assignmentsNative.setAtIndex(ValueLayout.JAVA_INT, i, -1);
         }
         
+        assignPointsBatch(pointsNative, n, centroidsNative, k, assignmentsNative);
+        
+        int[] result = new int[n];
+        MemorySegment.ofArray(result).copyFrom(assignmentsNative);
+        return result;
+    }
+    
+    /**
+     * Nearest-centroid assignment over segments already in native memory;
+     * updates {@code assignments} in place and returns how many changed.
+     */
+    public int assignPointsBatch(MemorySegment points, int n, MemorySegment centroids, int k,
+                                 MemorySegment assignments) {
+        if (!assign_points_batch.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            @SuppressWarnings("unused")
-            int changed = (int) assign_points_batch.invokeExact(pointsNative, n, centroidsNative, k, assignmentsNative);
-            
-            int[] result = new int[n];
-            MemorySegment.ofArray(result).copyFrom(assignmentsNative);
-            return result;
+            return (int) assign_points_batch.handle().invokeExact(points, n, centroids, k, assignments);
         } catch (Throwable t) {
             throw new RuntimeException("Assign points native call failed", t);
         }
@@ -692,7 +1659,7 @@ public final class NativeLibrary {
     public float[] hybridCluster(Arena arena, float[] points, int k, int blockSize, 
                                   float dbscanEps, int dbscanMinPts, 
                                   int kmeansMaxIter, float kmeansThreshold, long seed) {
-        if (hybrid_cluster == null) {
+        if (!hybrid_cluster.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -703,29 +1670,100 @@ public final class NativeLibrary {
         
         pointsNative.copyFrom(MemorySegment.ofArray(points));
         
+        hybridCluster(pointsNative, n, k, blockSize, dbscanEps, dbscanMinPts,
+                      kmeansMaxIter, kmeansThreshold, centroidsNative, seed);
+        
+        float[] result = new float[k * 3];
+        for (int i = 0; i < k; i++) {
+            long offset = i * COLOR_POINT_LAYOUT.byteSize();
+            result[i * 3] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset);
+            result[i * 3 + 1] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
+            result[i * 3 + 2] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
+        }
+        
+        return result;
+    }
+    
+    /**
+     * Hybrid clustering of points already in native memory into {@code k}
+     * ColorPoint3f centroids; returns the final k-means iterations.
+     */
+    public int hybridCluster(MemorySegment points, int n, int k, int blockSize,
+                             float dbscanEps, int dbscanMinPts,
+                             int kmeansMaxIter, float kmeansThreshold,
+                             MemorySegment centroids, long seed) {
+        if (!hybrid_cluster.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            @SuppressWarnings("unused")
-            int iterations = (int) hybrid_cluster.invokeExact(
-                pointsNative, n, k, blockSize, dbscanEps, dbscanMinPts,
-                kmeansMaxIter, kmeansThreshold, centroidsNative, seed
+            int iterations = (int) hybrid_cluster.handle().invokeExact(
+                points, n, k, blockSize, dbscanEps, dbscanMinPts,
+                kmeansMaxIter, kmeansThreshold, centroids, seed
             );
-            
-            float[] result = new float[k * 3];
-            for (int i = 0; i < k; i++) {
-                long offset = i * COLOR_POINT_LAYOUT.byteSize();
-                result[i * 3] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset);
-                result[i * 3 + 1] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
-                result[i * 3 + 2] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
-            }
-            
-            return result;
+            lastIterations.set(iterations);
+            return iterations;
+        } catch (Throwable t) {
+            throw new RuntimeException("Hybrid cluster native call failed", t);
+        }
+    }
+    
+    /**
+     * Hybrid clustering with at most {@code maxRepresentatives} weighted
+     * representatives reaching the final k-means (0 = native default).
+     */
+    public float[] hybridCluster(Arena arena, float[] points, int k, int blockSize,
+                                  float dbscanEps, int dbscanMinPts,
+                                  int kmeansMaxIter, float kmeansThreshold,
+                                  int maxRepresentatives, long seed) {
+        if (!hybrid_cluster_bounded.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        int n = points.length / 3;
+        
+        MemorySegment pointsNative = arena.allocate(ValueLayout.JAVA_FLOAT, points.length);
+        MemorySegment centroidsNative = arena.allocate(COLOR_POINT_LAYOUT, k);
+        
+        pointsNative.copyFrom(MemorySegment.ofArray(points));
+        
+        hybridCluster(pointsNative, n, k, blockSize, dbscanEps, dbscanMinPts,
+                      kmeansMaxIter, kmeansThreshold, maxRepresentatives, centroidsNative, seed);
+        
+        float[] result = new float[k * 3];
+        for (int i = 0; i < k; i++) {
+            long offset = i * COLOR_POINT_LAYOUT.byteSize();
+            result[i * 3] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset);
+            result[i * 3 + 1] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
+            result[i * 3 + 2] = centroidsNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
+        }
+        
+        return result;
+    }
+    
+    /** Bounded hybrid clustering of points already in native memory; returns the final k-means iterations. */
+    public int hybridCluster(MemorySegment points, int n, int k, int blockSize,
+                             float dbscanEps, int dbscanMinPts,
+                             int kmeansMaxIter, float kmeansThreshold,
+                             int maxRepresentatives, MemorySegment centroids, long seed) {
+        if (!hybrid_cluster_bounded.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
+        try {
+            int iterations = (int) hybrid_cluster_bounded.handle().invokeExact(
+                points, n, k, blockSize, dbscanEps, dbscanMinPts,
+                kmeansMaxIter, kmeansThreshold, maxRepresentatives, centroids, seed
+            );
+            lastIterations.set(iterations);
+            return iterations;
         } catch (Throwable t) {
             throw new RuntimeException("Hybrid cluster native call failed", t);
         }
     }
     
     public float hybridCalculateEps(Arena arena, float[] points, int blockSize, int minPts, long seed) {
-        if (hybrid_calculate_dbscan_eps == null) {
+        if (!hybrid_calculate_dbscan_eps.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -735,7 +1773,7 @@ public final class NativeLibrary {
         pointsNative.copyFrom(MemorySegment.ofArray(points));
         
         try {
-            return (float) hybrid_calculate_dbscan_eps.invokeExact(
+            return (float) hybrid_calculate_dbscan_eps.handle().invokeExact(
                 pointsNative, n, blockSize, minPts, seed
             );
         } catch (Throwable t) {
@@ -744,7 +1782,7 @@ public final class NativeLibrary {
     }
     
     public float[] samplePixelsFromImage(Arena arena, int[] imagePixels, int sampleSize, long seed) {
-        if (sample_pixels_from_image == null) {
+        if (!sample_pixels_from_image.isPresent()) {
             throw new UnsupportedOperationException("Native library not loaded");
         }
         
@@ -756,20 +1794,33 @@ public final class NativeLibrary {
         
         imageNative.copyFrom(MemorySegment.ofArray(imagePixels));
         
+        int actualSize = samplePixelsFromImage(imageNative, totalPixels, outputNative, sampleSize, seed);
+        
+        float[] result = new float[actualSize * 3];
+        for (int i = 0; i < actualSize; i++) {
+            long offset = i * COLOR_POINT_LAYOUT.byteSize();
+            result[i * 3] = outputNative.get(ValueLayout.JAVA_FLOAT, offset);
+            result[i * 3 + 1] = outputNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
+            result[i * 3 + 2] = outputNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
+        }
+        
+        return result;
+    }
+    
+    /**
+     * Samples up to {@code sampleSize} pixels of an image already in native
+     * memory into ColorPoint3f {@code output}; returns the number written.
+     */
+    public int samplePixelsFromImage(MemorySegment image, int totalPixels, MemorySegment output,
+                                     int sampleSize, long seed) {
+        if (!sample_pixels_from_image.isPresent()) {
+            throw new UnsupportedOperationException("Native library not loaded");
+        }
+        
         try {
-            int actualSize = (int) sample_pixels_from_image.invokeExact(
-                imageNative, totalPixels, outputNative, sampleSize, seed
+            return (int) sample_pixels_from_image.handle().invokeExact(
+                image, totalPixels, output, sampleSize, seed
             );
-            
-            float[] result = new float[actualSize * 3];
-            for (int i = 0; i < actualSize; i++) {
-                long offset = i * COLOR_POINT_LAYOUT.byteSize();
-                result[i * 3] = outputNative.get(ValueLayout.JAVA_FLOAT, offset);
-                result[i * 3 + 1] = outputNative.get(ValueLayout.JAVA_FLOAT, offset + 4);
-                result[i * 3 + 2] = outputNative.get(ValueLayout.JAVA_FLOAT, offset + 8);
-            }
-            
-            return result;
         } catch (Throwable t) {
             throw new RuntimeException("Sample pixels from image native call failed", t);
         }
@@ -778,7 +1829,7 @@ public final class NativeLibrary {
     public record DecodedImage(int width, int height, int[] pixels) {}
     
     public DecodedImage decodeJpegFile(String filePath) {
-        if (decode_jpeg_file_turbojpeg == null || turbojpeg_free == null) {
+        if (!decode_jpeg_file_turbojpeg.isPresent() || !turbojpeg_free.isPresent()) {
             return null; // TurboJPEG not available
         }
         
@@ -793,7 +1844,7 @@ public final class NativeLibrary {
             MemorySegment heightPtr = arena.allocate(ValueLayout.JAVA_INT);
             MemorySegment pixelsPtr = arena.allocate(ValueLayout.ADDRESS);
             
-            int result = (int) decode_jpeg_file_turbojpeg.invokeExact(
+            int result = (int) decode_jpeg_file_turbojpeg.handle().invokeExact(
                 pathNative, widthPtr, heightPtr, pixelsPtr
             );
             
@@ -817,7 +1868,7 @@ public final class NativeLibrary {
             MemorySegment.ofArray(pixelArray).copyFrom(pixels);
             
             // Free native memory
-            turbojpeg_free.invokeExact(nativePixels);
+            turbojpeg_free.handle().invokeExact(nativePixels);
             nativePixels = null;
             
             return new DecodedImage(width, height, pixelArray);
@@ -825,7 +1876,7 @@ public final class NativeLibrary {
             // Try to free memory if allocated
             if (nativePixels != null && !nativePixels.equals(MemorySegment.NULL)) {
                 try {
-                    turbojpeg_free.invokeExact(nativePixels);
+                    turbojpeg_free.handle().invokeExact(nativePixels);
                 } catch (Throwable ignored) {}
             }
             System.err.println("TurboJPEG decode failed: " + t.getMessage());
@@ -837,7 +1888,7 @@ public final class NativeLibrary {
      * Decode JPEG from byte array (works with Unicode paths by reading in Java).
      */
     public DecodedImage decodeJpegBuffer(byte[] jpegData) {
-        if (turbojpeg_decode_buffer == null || turbojpeg_free == null) {
+        if (!turbojpeg_decode_buffer.isPresent() || !turbojpeg_free.isPresent()) {
             return null;
         }
         
@@ -853,7 +1904,7 @@ public final class NativeLibrary {
             MemorySegment heightPtr = arena.allocate(ValueLayout.JAVA_INT);
             MemorySegment pixelsPtr = arena.allocate(ValueLayout.ADDRESS);
             
-            int result = (int) turbojpeg_decode_buffer.invokeExact(
+            int result = (int) turbojpeg_decode_buffer.handle().invokeExact(
                 jpegNative, (long) jpegData.length, widthPtr, heightPtr, pixelsPtr
             );
             
@@ -875,14 +1926,14 @@ public final class NativeLibrary {
             int[] pixelArray = new int[numPixels];
             MemorySegment.ofArray(pixelArray).copyFrom(pixels);
             
-            turbojpeg_free.invokeExact(nativePixels);
+            turbojpeg_free.handle().invokeExact(nativePixels);
             nativePixels = null;
             
             return new DecodedImage(width, height, pixelArray);
         } catch (Throwable t) {
             if (nativePixels != null && !nativePixels.equals(MemorySegment.NULL)) {
                 try {
-                    turbojpeg_free.invokeExact(nativePixels);
+                    turbojpeg_free.handle().invokeExact(nativePixels);
                 } catch (Throwable ignored) {}
             }
             System.err.println("TurboJPEG buffer decode failed: " + t.getMessage());
@@ -891,11 +1942,11 @@ public final class NativeLibrary {
     }
     
     public boolean hasTurboJpeg() {
-        if (aichat_has_turbojpeg == null) {
+        if (!aichat_has_turbojpeg.isPresent()) {
             return false;
         }
         try {
-            int result = (int) aichat_has_turbojpeg.invokeExact();
+            int result = (int) aichat_has_turbojpeg.handle().invokeExact();
             return result != 0;
         } catch (Throwable t) {
             return false;
@@ -912,7 +1963,7 @@ public final class NativeLibrary {
      * @return true if successful
      */
     public boolean encodeJpegToFile(int[] pixels, int width, int height, int quality, String filePath) {
-        if (turbojpeg_encode_to_file == null) {
+        if (!turbojpeg_encode_to_file.isPresent()) {
             return false;
         }
         
@@ -922,7 +1973,7 @@ public final class NativeLibrary {
             
             MemorySegment pathNative = arena.allocateFrom(filePath);
             
-            int result = (int) turbojpeg_encode_to_file.invokeExact(
+            int result = (int) turbojpeg_encode_to_file.handle().invokeExact(
                 pixelsNative, width, height, quality, pathNative
             );
             
@@ -939,9 +1990,9 @@ public final class NativeLibrary {
      * Check if OpenCL is available on this system.
      */
     public boolean hasOpenCL() {
-        if (aichat_has_opencl == null) return false;
+        if (!aichat_has_opencl.isPresent()) return false;
         try {
-            return ((int) aichat_has_opencl.invokeExact()) != 0;
+            return ((int) aichat_has_opencl.handle().invokeExact()) != 0;
         } catch (Throwable t) {
             return false;
         }
@@ -951,9 +2002,9 @@ public final class NativeLibrary {
      * Initialize OpenCL context. Called automatically on first use.
      */
     public boolean initOpenCL() {
-        if (opencl_init == null) return false;
+        if (!opencl_init.isPresent()) return false;
         try {
-            return ((int) opencl_init.invokeExact()) == 0;
+            return ((int) opencl_init.handle().invokeExact()) == 0;
         } catch (Throwable t) {
             System.err.println("OpenCL init failed: " + t.getMessage());
             return false;
@@ -964,9 +2015,9 @@ public final class NativeLibrary {
      * Cleanup OpenCL resources.
      */
     public void cleanupOpenCL() {
-        if (opencl_cleanup == null) return;
+        if (!opencl_cleanup.isPresent()) return;
         try {
-            opencl_cleanup.invokeExact();
+            opencl_cleanup.handle().invokeExact();
         } catch (Throwable ignored) {}
     }
     
@@ -974,9 +2025,9 @@ public final class NativeLibrary {
      * Get OpenCL device name.
      */
     public String getOpenCLDeviceName() {
-        if (opencl_get_device_name == null) return "N/A";
+        if (!opencl_get_device_name.isPresent()) return "N/A";
         try {
-            MemorySegment ptr = (MemorySegment) opencl_get_device_name.invokeExact();
+            MemorySegment ptr = (MemorySegment) opencl_get_device_name.handle().invokeExact();
             return ptr.reinterpret(256).getString(0);
         } catch (Throwable t) {
             return "Error: " + t.getMessage();
@@ -989,7 +2040,7 @@ public final class NativeLibrary {
      */
     public int[] resynthesizeImageGPU(Arena arena, int[] imagePixels, int width, int height,
                                        float[] targetPalette, float[] sourcePalette) {
-        if (opencl_resynthesize_image == null) {
+        if (!opencl_resynthesize_image.isPresent()) {
             return null;
         }
         
@@ -1006,7 +2057,7 @@ public final class NativeLibrary {
         sourcePaletteNative.copyFrom(MemorySegment.ofArray(sourcePalette));
         
         try {
-            int result = (int) opencl_resynthesize_image.invokeExact(
+            int result = (int) opencl_resynthesize_image.handle().invokeExact(
                 imageNative, width, height,
                 targetPaletteNative, sourcePaletteNative, paletteSize, outputNative
             );
@@ -1032,7 +2083,7 @@ public final class NativeLibrary {
     public int[] resynthesizeImageGPUStreaming(Arena arena, int[] imagePixels, int width, int height,
                                                 float[] targetPalette, float[] sourcePalette, 
                                                 int tileHeight) {
-        if (opencl_resynthesize_streaming == null) {
+        if (!opencl_resynthesize_streaming.isPresent()) {
             return null;
         }
         
@@ -1049,7 +2100,7 @@ public final class NativeLibrary {
         sourcePaletteNative.copyFrom(MemorySegment.ofArray(sourcePalette));
         
         try {
-            int result = (int) opencl_resynthesize_streaming.invokeExact(
+            int result = (int) opencl_resynthesize_streaming.handle().invokeExact(
                 imageNative, width, height,
                 targetPaletteNative, sourcePaletteNative, paletteSize, outputNative,
                 tileHeight
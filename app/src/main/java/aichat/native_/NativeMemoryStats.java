@@ -0,0 +1,48 @@
+package aichat.native_;
+
+import java.util.List;
+
+/**
+ * Snapshot of the native allocation tracker: bytes of working buffers (LUTs,
+ * DBSCAN grids, JPEG scratch, ...) held now and at peak, in total and per
+ * subsystem, plus the most any single call of each native operation held.
+ * Only buffers allocated while tracking was on are counted; peaks restart
+ * whenever tracking is (re)enabled.
+ */
+public record NativeMemoryStats(
+    boolean enabled,
+    long currentBytes,
+    long peakBytes,
+    List<Subsystem> subsystems,
+    List<CallPeak> calls
+) {
+
+    public record Subsystem(String name, long currentBytes, long peakBytes) {}
+
+    /**
+     * Bytes held at once by one call of {@code op} on its calling thread:
+     * the largest call since tracking was enabled, and the latest.
+     */
+    public record CallPeak(String op, long peakBytes, long lastPeakBytes) {}
+
+    public NativeMemoryStats {
+        subsystems = List.copyOf(subsystems);
+        calls = List.copyOf(calls);
+    }
+
+    /** The named subsystem ("kmeans", "hybrid", "lut", "slic", "tsvq", "jpeg", "resample"), or null. */
+    public Subsystem subsystem(String name) {
+        for (Subsystem s : subsystems) {
+            if (s.name().equals(name)) return s;
+        }
+        return null;
+    }
+
+    /** Per-call peaks of the named operation ("resynthesize", "jpeg_decode", ...), or null. */
+    public CallPeak call(String op) {
+        for (CallPeak c : calls) {
+            if (c.op().equals(op)) return c;
+        }
+        return null;
+    }
+}
@@ -0,0 +1,103 @@
+package aichat.native_;
+
+import java.math.BigDecimal;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * Snapshot of the native library's always-on counters: calls, time and
+ * items (pixels or points) per operation with a latency histogram, plus
+ * LUT builds and cache hits, working-buffer bytes allocated, OpenMP regions
+ * entered and GPU fallbacks. Counters are cumulative since the library
+ * loaded or the last {@link NativeLibrary#resetMetrics()}.
+ */
+public record NativeMetrics(
+    List<OpMetrics> ops,
+    long lutBuilds,
+    long lutCacheHits,
+    long bytesAllocated,
+    long ompRegions,
+    long gpuFallbacks
+) {
+
+    /**
+     * Counters of one native operation. {@code latencyBuckets[i]} counts
+     * calls shorter than 2^i microseconds (and at least half that); the last
+     * bucket also takes everything longer.
+     */
+    public record OpMetrics(String name, long calls, long callNanos, long items, long[] latencyBuckets) {
+
+        /** Upper bound of latency bucket {@code i} in seconds, infinite for the last one. */
+        public double bucketUpperBoundSeconds(int i) {
+            return i == latencyBuckets.length - 1 ? Double.POSITIVE_INFINITY : (1L << i) / 1e6;
+        }
+    }
+
+    public NativeMetrics {
+        ops = List.copyOf(ops);
+    }
+
+    /** The counters of the named operation ("kmeans", "resynthesize", ...), or null. */
+    public OpMetrics op(String name) {
+        for (OpMetrics op : ops) {
+            if (op.name().equals(name)) return op;
+        }
+        return null;
+    }
+
+    /** Prometheus text exposition format (version 0.0.4). */
+    public String toPrometheus() {
+        StringBuilder out = new StringBuilder();
+
+        header(out, "aichat_native_calls_total", "counter", "Native calls by operation.");
+        for (OpMetrics op : ops) {
+            sample(out, "aichat_native_calls_total", op.name(), null, Long.toString(op.calls()));
+        }
+
+        header(out, "aichat_native_items_total", "counter", "Pixels or points processed by native calls.");
+        for (OpMetrics op : ops) {
+            sample(out, "aichat_native_items_total", op.name(), null, Long.toString(op.items()));
+        }
+
+        header(out, "aichat_native_call_duration_seconds", "histogram", "Native call latency.");
+        for (OpMetrics op : ops) {
+            long[] buckets = op.latencyBuckets();
+            long cumulative = 0;
+            for (int i = 0; i < buckets.length; i++) {
+                cumulative += buckets[i];
+                String le = i == buckets.length - 1
+                    ? "+Inf"
+                    : BigDecimal.valueOf(1L << i, 6).stripTrailingZeros().toPlainString();
+                sample(out, "aichat_native_call_duration_seconds_bucket", op.name(), le, Long.toString(cumulative));
+            }
+            sample(out, "aichat_native_call_duration_seconds_sum", op.name(), null,
+                String.format(Locale.ROOT, "%.9f", op.callNanos() / 1e9));
+            sample(out, "aichat_native_call_duration_seconds_count", op.name(), null, Long.toString(cumulative));
+        }
+
+        counter(out, "aichat_native_lut_builds_total", "Palette LUTs built.", lutBuilds);
+        counter(out, "aichat_native_lut_cache_hits_total", "Palette LUTs reused from the cache.", lutCacheHits);
+        counter(out, "aichat_native_allocated_bytes_total", "Bytes of native working buffers allocated.", bytesAllocated);
+        counter(out, "aichat_native_omp_regions_total", "OpenMP parallel regions entered.", ompRegions);
+        counter(out, "aichat_native_gpu_fallbacks_total", "GPU calls that failed over to the CPU.", gpuFallbacks);
+        return out.toString();
+    }
+
+    private static void header(StringBuilder out, String name, String type, String help) {
+        out.append("# HELP ").append(name).append(' ').append(help).append('\n');
+        out.append("# TYPE ").append(name).append(' ').append(type).append('\n');
+    }
+
+    private static void counter(StringBuilder out, String name, String help, long value) {
+        header(out, name, "counter", help);
+        out.append(name).append(' ').append(value).append('\n');
+    }
+
+    private static void sample(StringBuilder out, String name, String op, String le, String value) {
+        out.append(name).append("{op=\"").append(op).append('"');
+        if (le != null) {
+            out.append(",le=\"").append(le).append('"');
+        }
+        out.append("} ").append(value).append('\n');
+    }
+}
@@ -0,0 +1,97 @@
+package aichat.ui;
+
+import aichat.core.BoxResampler;
+import aichat.native_.NativeAccelerator;
+
+import javafx.scene.image.PixelBuffer;
+import javafx.scene.image.PixelFormat;
+import javafx.scene.image.WritableImage;
+
+import java.awt.image.BufferedImage;
+import java.awt.image.DataBufferInt;
+import java.awt.image.SinglePixelPackedSampleModel;
+import java.awt.image.WritableRaster;
+import java.nio.IntBuffer;
+import java.util.Arrays;
+
+/**
+ * JavaFX images backed by a {@link PixelBuffer} over engine output, in place
+ * of SwingFXUtils.toFXImage and its per-pixel conversion into a second copy.
+ * <p>
+ * A proxy at screen resolution is Lanczos-filtered natively (box-filtered in
+ * Java when native is unavailable) into a buffer JavaFX uploads as is. The
+ * full-resolution image wraps the result's own int[]: the engine writes
+ * opaque TYPE_INT_RGB pixels with a zero alpha byte, which is set in place so
+ * the array reads as premultiplied ARGB.
+ */
+final class DisplayImages {
+
+    private DisplayImages() {}
+
+    /**
+     * The image scaled down to fit {@code maxWidth x maxHeight} pixels, or
+     * {@link #fullResolution} when it already fits.
+     */
+    static WritableImage proxy(BufferedImage image, int maxWidth, int maxHeight) {
+        int width = image.getWidth();
+        int height = image.getHeight();
+        double scale = Math.min((double) maxWidth / width, (double) maxHeight / height);
+        if (scale >= 1.0) {
+            return fullResolution(image);
+        }
+        int dstWidth = Math.max(1, Math.min(width, (int) Math.round(width * scale)));
+        int dstHeight = Math.max(1, Math.min(height, (int) Math.round(height * scale)));
+
+        int[] pixels = directPixels(image);
+        if (pixels == null) {
+            pixels = image.getRGB(0, 0, width, height, null, 0, width);
+        }
+
+        IntBuffer scaled = NativeAccelerator.getInstance().downscaleImage(
+            pixels, width, height, dstWidth, dstHeight, NativeAccelerator.ResampleFilter.LANCZOS3);
+        if (scaled == null) {
+            int[] box = new int[dstWidth * dstHeight];
+            BoxResampler.downscale(pixels, width, height, box, dstWidth, dstHeight);
+            scaled = IntBuffer.wrap(box);
+        }
+        return wrap(scaled, dstWidth, dstHeight);
+    }
+
+    /** The image at full resolution, sharing its pixel array when it is packed TYPE_INT_RGB. */
+    static WritableImage fullResolution(BufferedImage image) {
+        int width = image.getWidth();
+        int height = image.getHeight();
+        int[] pixels = directPixels(image);
+        if (pixels == null) {
+            pixels = image.getRGB(0, 0, width, height, null, 0, width);
+        }
+        int[] argb = pixels;
+        // Alpha is ignored by TYPE_INT_RGB, so forcing it opaque leaves the image unchanged
+        Arrays.parallelSetAll(argb, i -> argb[i] | 0xFF000000);
+        return wrap(IntBuffer.wrap(argb), width, height);
+    }
+
+    /** Opaque ARGB pixels as an image, without copying them. */
+    static WritableImage wrap(IntBuffer argb, int width, int height) {
+        PixelBuffer<IntBuffer> buffer =
+            new PixelBuffer<>(width, height, argb, PixelFormat.getIntArgbPreInstance());
+        return new WritableImage(buffer);
+    }
+
+    // Only TYPE_INT_RGB: an ARGB image's alpha is real and must not be overwritten
+    static int[] directPixels(BufferedImage image) {
+        if (image.getType() != BufferedImage.TYPE_INT_RGB) {
+            return null;
+        }
+        WritableRaster raster = image.getRaster();
+        if (!(raster.getDataBuffer() instanceof DataBufferInt buffer)
+                || !(raster.getSampleModel() instanceof SinglePixelPackedSampleModel model)
+                || buffer.getNumBanks() != 1 || buffer.getOffset() != 0
+                || raster.getSampleModelTranslateX() != 0 || raster.getSampleModelTranslateY() != 0
+                || model.getScanlineStride() != image.getWidth()) {
+            return null;
+        }
+        int[] data = buffer.getData();
+        return data.length == image.getWidth() * image.getHeight() ? data : null;
+    }
+}
@@ -8,8 +8,8 @@ import aichat.model.ColorPalette;
 import aichat.model.ColorPoint;
 import aichat.native_.NativeAccelerator;
 
+import javafx.application.Platform;
 import javafx.concurrent.Task;
-import javafx.embed.swing.SwingFXUtils;
 import javafx.fxml.FXML;
 import javafx.geometry.Insets;
 import javafx.geometry.Pos;
@@ -25,13 +25,9 @@ import javafx.stage.FileChooser;
 import javafx.stage.Stage;
 
 import javax.imageio.ImageIO;
-import javax.imageio.ImageReader;
-import javax.imageio.ImageReadParam;
-import javax.imageio.stream.ImageInputStream;
 import java.awt.image.BufferedImage;
 import java.io.File;
 import java.io.IOException;
-import java.util.Iterator;
 
 public class MainController {
     
@@ -67,9 +63,10 @@ public class MainController {
     @FXML private ProgressBar progressBar;
     @FXML private Label statusLabel;
     
-    private BufferedImage sourceImage;
-    private BufferedImage targetImage;
-    private BufferedImage resultImage;
+    // Compressed bytes or native pixels; tasks decode them on demand
+    private RetainedImage sourceImage;
+    private RetainedImage targetImage;
+    private RetainedImage resultImage;
     
     // Loading state tracking
     private volatile boolean sourceLoading = false;
@@ -82,6 +79,13 @@ public class MainController {
     private ColorPalette targetPalette;
     
     private Stage resultStage;
+    private ImageView resultImageView;
+    private ToggleButton resultZoomButton;
+    private Button resultSaveButton;
+    private Image resultProxyImage;
+    private Image resultFullImage;
+    // Bumped per resynthesis, so a superseded run never updates the window
+    private long resultRunId;
     
     @FXML
     public void initialize() {
@@ -169,8 +173,8 @@ public class MainController {
             return;
         }
         
-        // Swap BufferedImages
-        BufferedImage tempImage = sourceImage;
+        // Swap retained images
+        RetainedImage tempImage = sourceImage;
         sourceImage = targetImage;
         targetImage = tempImage;
         
@@ -179,9 +183,10 @@ public class MainController {
         sourcePalette = targetPalette;
         targetPalette = tempPalette;
         
-        // Update displays from BufferedImages (ensures sync)
-        sourceImageView.setImage(SwingFXUtils.toFXImage(sourceImage, null));
-        targetImageView.setImage(SwingFXUtils.toFXImage(targetImage, null));
+        // Swap the displayed previews along with the images
+        Image tempView = sourceImageView.getImage();
+        sourceImageView.setImage(targetImageView.getImage());
+        targetImageView.setImage(tempView);
         
         displayPalette(sourcePalettePane, sourcePalette);
         displayPalette(targetPalettePane, targetPalette);
@@ -218,22 +223,23 @@ public class MainController {
         setProcessing(true, "Analyzing images...");
         
         // Capture image references at the start to avoid race conditions
-        final BufferedImage srcImg = sourceImage;
-        final BufferedImage tgtImg = targetImage;
+        final RetainedImage srcImg = sourceImage;
+        final RetainedImage tgtImg = targetImage;
         
         Task<Void> analyzeTask = new Task<>() {
             private ColorPalette srcPal;
             private ColorPalette tgtPal;
             
             @Override
-            protected Void call() {
+            protected Void call() throws IOException {
                 ImageHarmonyEngine engine = new ImageHarmonyEngine(colorModel);
                 
+                // Each decoded raster is garbage as soon as its palette is extracted
                 if (srcImg != null) {
-                    srcPal = engine.analyze(srcImg, k);
+                    srcPal = engine.analyze(srcImg.decode(), k);
                 }
                 if (tgtImg != null) {
-                    tgtPal = engine.analyze(tgtImg, k);
+                    tgtPal = engine.analyze(tgtImg.decode(), k);
                 }
                 return null;
             }
@@ -282,47 +288,91 @@ public class MainController {
         setProcessing(true, posterize ? "Posterizing image..." : "Resynthesizing image...");
         
         // Capture references to avoid race conditions
-        final BufferedImage tgtImg = targetImage;
+        final RetainedImage tgtImg = targetImage;
         final ColorPalette srcPal = sourcePalette;
         final ColorPalette tgtPal = targetPalette;
         final boolean doPosterize = posterize;
+        final long runId = ++resultRunId;
+        final String mode = doPosterize ? "Posterization" : "Resynthesis";
+        final int[] screen = screenProxySize();
+        // One engine for both passes, so the full pass reuses the preview's palette mapping
+        final ImageHarmonyEngine engine = new ImageHarmonyEngine(colorModel);
+        resultImage = null;
+        if (resultZoomButton != null) {
+            resultZoomButton.setSelected(false);
+            resultZoomButton.setDisable(true);
+            resultSaveButton.setDisable(true);
+        }
         
-        Task<BufferedImage> resynthTask = new Task<>() {
+        Task<RetainedImage> resynthesisTask = new Task<>() {
             @Override
-            protected BufferedImage call() {
-                ImageHarmonyEngine engine = new ImageHarmonyEngine(colorModel);
-                if (doPosterize) {
-                    return engine.posterize(tgtImg, srcPal, tgtPal);
-                } else {
-                    return engine.resynthesize(tgtImg, srcPal, tgtPal);
+            protected RetainedImage call() throws IOException {
+                // Decoded once for both passes and dropped with the task
+                BufferedImage target = tgtImg.decode();
+                
+                // The visible viewport first: the whole image at the window's scale
+                double previewScale = Math.min(1.0, Math.min(
+                    (double) screen[0] / target.getWidth(), (double) screen[1] / target.getHeight()));
+                try {
+                    Image preview = DisplayImages.proxy(engine.resynthesizeViewport(target, srcPal, tgtPal,
+                        new java.awt.Rectangle(0, 0, target.getWidth(), target.getHeight()),
+                        previewScale, doPosterize), screen[0], screen[1]);
+                    Platform.runLater(() -> {
+                        if (runId != resultRunId) return;
+                        showResultWindow(preview, tgtImg.width(), tgtImg.height());
+                        statusLabel.setText(mode + " preview shown. Rendering full resolution...");
+                    });
+                } catch (RuntimeException e) {
+                    // The window opens on the full result instead
+                    System.err.println("Preview failed: " + e.getMessage());
                 }
+                
+                BufferedImage result = doPosterize
+                    ? engine.posterize(target, srcPal, tgtPal)
+                    : engine.resynthesize(target, srcPal, tgtPal);
+                return RetainedImage.of(result, screen[0], screen[1]);
             }
             
             @Override
             protected void succeeded() {
+                if (runId != resultRunId) return;
                 resultImage = getValue();
-                showResultWindow(resultImage);
-                String mode = doPosterize ? "Posterization" : "Resynthesis";
+                showFullResult(resultImage);
                 setProcessing(false, mode + " complete. Result shown in new window.");
             }
             
             @Override
             protected void failed() {
+                if (runId != resultRunId) return;
                 setProcessing(false, "Resynthesis failed: " + getException().getMessage());
             }
         };
         
-        new Thread(resynthTask).start();
+        new Thread(resynthesisTask).start();
     }
     
-    private void showResultWindow(BufferedImage image) {
+    // Screen pixels available to the result window, the size of its proxy
+    private int[] screenProxySize() {
+        javafx.stage.Screen screen = javafx.stage.Screen.getPrimary();
+        javafx.geometry.Rectangle2D screenBounds = screen.getVisualBounds();
+        return new int[] {
+            (int) (screenBounds.getWidth() * 0.9 * screen.getOutputScaleX()),
+            (int) (screenBounds.getHeight() * 0.9 * screen.getOutputScaleY())
+        };
+    }
+    
+    /**
+     * Opens the result window on {@code preview}, a screen-sized rendering of
+     * a {@code fullWidth x fullHeight} result. Saving and the 100% view wait
+     * for {@link #showFullResult}.
+     */
+    private void showResultWindow(Image preview, int fullWidth, int fullHeight) {
         if (resultStage == null) {
             resultStage = new Stage();
             resultStage.setTitle("AICHAT - Result");
         }
         
-        Image fxImage = SwingFXUtils.toFXImage(image, null);
-        ImageView imageView = new ImageView(fxImage);
+        ImageView imageView = new ImageView(preview);
         imageView.setPreserveRatio(true);
         
         StackPane imageContainer = new StackPane(imageView);
@@ -333,17 +383,55 @@ public class MainController {
         scrollPane.setFitToHeight(true);
         scrollPane.setStyle("-fx-background-color: #1e1e1e; -fx-background: #1e1e1e;");
         
+        ToggleButton zoomButton = new ToggleButton("100%");
+        zoomButton.setStyle("-fx-background-color: #3c3c3c; -fx-text-fill: #e0e0e0; " +
+                          "-fx-font-size: 14px; -fx-padding: 10 24; -fx-background-radius: 6; -fx-cursor: hand;");
+        zoomButton.setTooltip(new Tooltip("View at full resolution (or double-click the image)"));
+        zoomButton.setDisable(true);
+        zoomButton.selectedProperty().addListener((obs, wasZoomed, zoomed) -> {
+            if (zoomed) {
+                if (resultFullImage == null) {
+                    try {
+                        resultFullImage = resultImage.fullResolution();
+                    } catch (IOException e) {
+                        zoomButton.setSelected(false);
+                        showAlert("View Error", "Failed to show full resolution: " + e.getMessage());
+                        return;
+                    }
+                }
+                imageView.fitWidthProperty().unbind();
+                imageView.fitHeightProperty().unbind();
+                imageView.setFitWidth(0);
+                imageView.setFitHeight(0);
+                imageView.setImage(resultFullImage);
+                scrollPane.setFitToWidth(false);
+                scrollPane.setFitToHeight(false);
+            } else {
+                imageView.setImage(resultProxyImage);
+                scrollPane.setFitToWidth(true);
+                scrollPane.setFitToHeight(true);
+                imageView.fitWidthProperty().bind(scrollPane.widthProperty().subtract(20));
+                imageView.fitHeightProperty().bind(scrollPane.heightProperty().subtract(20));
+            }
+        });
+        imageView.setOnMouseClicked(e -> {
+            if (e.getClickCount() == 2 && !zoomButton.isDisabled()) {
+                zoomButton.setSelected(!zoomButton.isSelected());
+            }
+        });
+        
         Button saveButton = new Button("Save Image");
         saveButton.setStyle("-fx-background-color: #2563eb; -fx-text-fill: white; " +
                           "-fx-font-size: 14px; -fx-padding: 10 24; -fx-background-radius: 6; -fx-cursor: hand;");
         saveButton.setOnAction(e -> handleSaveResult());
+        saveButton.setDisable(true);
         
         Button closeButton = new Button("Close");
         closeButton.setStyle("-fx-background-color: #3c3c3c; -fx-text-fill: #e0e0e0; " +
                            "-fx-font-size: 14px; -fx-padding: 10 24; -fx-background-radius: 6; -fx-cursor: hand;");
         closeButton.setOnAction(e -> resultStage.close());
         
-        HBox buttonBar = new HBox(12, saveButton, closeButton);
+        HBox buttonBar = new HBox(12, zoomButton, saveButton, closeButton);
         buttonBar.setAlignment(Pos.CENTER);
         buttonBar.setPadding(new Insets(16));
         buttonBar.setStyle("-fx-background-color: #252525;");
@@ -355,8 +443,8 @@ public class MainController {
         
         // Calculate window size within screen bounds
         javafx.geometry.Rectangle2D screenBounds = javafx.stage.Screen.getPrimary().getVisualBounds();
-        int windowWidth = Math.min(image.getWidth() + 40, (int)(screenBounds.getWidth() * 0.9));
-        int windowHeight = Math.min(image.getHeight() + 100, (int)(screenBounds.getHeight() * 0.9));
+        int windowWidth = Math.min(fullWidth + 40, (int)(screenBounds.getWidth() * 0.9));
+        int windowHeight = Math.min(fullHeight + 100, (int)(screenBounds.getHeight() * 0.9));
         
         Scene scene = new Scene(root, windowWidth, windowHeight);
         
@@ -373,6 +461,29 @@ public class MainController {
         
         imageView.fitWidthProperty().bind(scrollPane.widthProperty().subtract(20));
         imageView.fitHeightProperty().bind(scrollPane.heightProperty().subtract(20));
+        
+        resultImageView = imageView;
+        resultZoomButton = zoomButton;
+        resultSaveButton = saveButton;
+        resultProxyImage = imageView.getImage();
+        resultFullImage = null;
+    }
+    
+    // Replaces the preview with a proxy of the full result and enables saving and zoom
+    private void showFullResult(RetainedImage image) {
+        if (resultStage == null || resultImageView == null) {
+            showResultWindow(image.proxy(), image.width(), image.height());
+        }
+        resultProxyImage = image.proxy();
+        resultFullImage = null;
+        if (!resultZoomButton.isSelected()) {
+            resultImageView.setImage(resultProxyImage);
+        }
+        resultZoomButton.setDisable(false);
+        resultSaveButton.setDisable(false);
+        if (!resultStage.isShowing()) {
+            resultStage.show();
+        }
     }
     
     private void handleSaveResult() {
@@ -411,12 +522,13 @@ public class MainController {
             
             try {
                 long start = System.currentTimeMillis();
+                BufferedImage image = resultImage.decode();
                 
                 if (isJpeg) {
                     // Try fast TurboJPEG first
                     NativeAccelerator nativeAccel = NativeAccelerator.getInstance();
                     if (nativeAccel.hasTurboJpeg()) {
-                        if (nativeAccel.saveJpeg(resultImage, 90, file.getAbsolutePath())) {
+                        if (nativeAccel.saveJpeg(image, 90, file.getAbsolutePath())) {
                             long elapsed = System.currentTimeMillis() - start;
                             statusLabel.setText(String.format("Image saved: %s (%dms, TurboJPEG)", 
                                 file.getName(), elapsed));
@@ -424,9 +536,9 @@ public class MainController {
                         }
                     }
                     // Fallback to ImageIO for JPEG
-                    ImageIO.write(resultImage, "JPEG", file);
+                    ImageIO.write(image, "JPEG", file);
                 } else {
-                    ImageIO.write(resultImage, "PNG", file);
+                    ImageIO.write(image, "PNG", file);
                 }
                 
                 long elapsed = System.currentTimeMillis() - start;
@@ -492,6 +604,7 @@ public class MainController {
         
         // Capture load ID to detect if a newer load was started
         final long currentLoadId = isSource ? sourceLoadId : targetLoadId;
+        final int[] proxySize = screenProxySize();
         
         // Step 1: Show preview immediately using JavaFX async loading (fast, downscaled)
         String url = file.toURI().toString();
@@ -501,7 +614,8 @@ public class MainController {
             if (newVal.doubleValue() >= 1.0 && !preview.isError()) {
                 // Show preview while full image loads
                 long activeLoadId = isSource ? sourceLoadId : targetLoadId;
-                if (currentLoadId == activeLoadId) {
+                RetainedImage loaded = isSource ? sourceImage : targetImage;
+                if (currentLoadId == activeLoadId && loaded == null) {
                     if (isSource) {
                         sourceImageView.setImage(preview);
                     } else {
@@ -512,11 +626,11 @@ public class MainController {
             }
         });
         
-        // Step 2: Load full BufferedImage in background with optimizations
-        Task<BufferedImage> loadTask = new Task<>() {
+        // Step 2: Decode in background, keeping only the file bytes and a screen-sized proxy
+        Task<RetainedImage> loadTask = new Task<>() {
             @Override
-            protected BufferedImage call() throws IOException {
-                return readImageOptimized(file);
+            protected RetainedImage call() throws IOException {
+                return RetainedImage.read(file, proxySize[0], proxySize[1]);
             }
             
             @Override
@@ -527,7 +641,7 @@ public class MainController {
                     return;
                 }
                 
-                BufferedImage img = getValue();
+                RetainedImage img = getValue();
                 if (img == null) {
                     showAlert("Load Error", "Could not read image file.");
                     if (isSource) {
@@ -543,16 +657,18 @@ public class MainController {
                 
                 if (isSource) {
                     sourceImage = img;
+                    sourceImageView.setImage(img.proxy());
                     sourceLoading = false;
                 } else {
                     targetImage = img;
+                    targetImageView.setImage(img.proxy());
                     targetLoading = false;
                 }
                 
                 updateButtonStates();
                 progressBar.setProgress(0);
                 statusLabel.setText("Loaded: " + file.getName() + 
-                    " (" + img.getWidth() + "x" + img.getHeight() + ")");
+                    " (" + img.width() + "x" + img.height() + ")");
             }
             
             @Override
@@ -577,53 +693,6 @@ public class MainController {
         new Thread(loadTask).start();
     }
     
-    //Optimized image reading using TurboJPEG for JPEGs.
-    private BufferedImage readImageOptimized(File file) throws IOException {
-        String fileName = file.getName().toLowerCase();
-        
-        if (fileName.endsWith(".jpg") || fileName.endsWith(".jpeg")) {
-            NativeAccelerator accel = NativeAccelerator.getInstance();
-            if (accel.hasTurboJpeg()) {
-                NativeAccelerator.DecodedImage decoded = accel.decodeJpeg(file.getAbsolutePath());
-                if (decoded != null) {
-                    BufferedImage img = new BufferedImage(
-                        decoded.width(), decoded.height(), BufferedImage.TYPE_INT_ARGB
-                    );
-                    img.setRGB(0, 0, decoded.width(), decoded.height(), 
-                        decoded.pixels(), 0, decoded.width());
-                    return img;
-                }
-                // TurboJPEG failed, fall through to standard path
-            }
-        }
-        
-        // Get appropriate reader
-        Iterator<ImageReader> readers;
-        if (fileName.endsWith(".jpg") || fileName.endsWith(".jpeg")) {
-            readers = ImageIO.getImageReadersByFormatName("JPEG");
-        } else if (fileName.endsWith(".png")) {
-            readers = ImageIO.getImageReadersByFormatName("PNG");
-        } else {
-            // Fallback to standard ImageIO
-            return ImageIO.read(file);
-        }
-        
-        if (!readers.hasNext()) {
-            return ImageIO.read(file);
-        }
-        
-        ImageReader reader = readers.next();
-        try (ImageInputStream iis = ImageIO.createImageInputStream(file)) {
-            reader.setInput(iis, true, true); // seekForwardOnly=true, ignoreMetadata=true
-            
-            ImageReadParam param = reader.getDefaultReadParam();
-            
-            return reader.read(0, param);
-        } finally {
-            reader.dispose();
-        }
-    }
-    
     private void displayPalette(FlowPane pane, ColorPalette palette) {
         pane.getChildren().clear();
         if (palette == null) return;
@@ -0,0 +1,167 @@
+package aichat.ui;
+
+import aichat.native_.NativeAccelerator;
+
+import javafx.scene.image.Image;
+
+import javax.imageio.ImageIO;
+import javax.imageio.ImageReader;
+import javax.imageio.stream.ImageInputStream;
+import java.awt.image.BufferedImage;
+import java.awt.image.DataBufferInt;
+import java.awt.image.DirectColorModel;
+import java.awt.image.Raster;
+import java.awt.image.WritableRaster;
+import java.io.ByteArrayInputStream;
+import java.io.File;
+import java.io.IOException;
+import java.lang.foreign.Arena;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.ValueLayout;
+import java.nio.ByteOrder;
+import java.nio.file.Files;
+import java.util.Arrays;
+import java.util.Iterator;
+
+/**
+ * An image held by the UI without its full raster on the Java heap.
+ * <p>
+ * A loaded image keeps the compressed file bytes and is decoded again, with
+ * TurboJPEG for JPEG, whenever analysis or resynthesis needs its pixels; the
+ * decoded raster is dropped with the task. A result keeps its pixels in
+ * native memory, released once the image is unreachable, which the 100% view
+ * wraps without copying. Only the screen-sized proxy lives on the heap, and
+ * not even that when the native resampler produced it.
+ */
+final class RetainedImage {
+
+    private static final DirectColorModel RGB = new DirectColorModel(24, 0xFF0000, 0x00FF00, 0x0000FF);
+
+    private final byte[] encoded;
+    private final MemorySegment pixels;
+    private final int width;
+    private final int height;
+    private final Image proxy;
+
+    private RetainedImage(byte[] encoded, MemorySegment pixels, int width, int height, Image proxy) {
+        this.encoded = encoded;
+        this.pixels = pixels;
+        this.width = width;
+        this.height = height;
+        this.proxy = proxy;
+    }
+
+    /**
+     * Reads {@code file}, keeping its bytes and a proxy fitting
+     * {@code maxWidth x maxHeight}; null when no decoder accepts it.
+     */
+    static RetainedImage read(File file, int maxWidth, int maxHeight) throws IOException {
+        byte[] encoded = Files.readAllBytes(file.toPath());
+        BufferedImage image = decode(encoded);
+        if (image == null) {
+            return null;
+        }
+        return new RetainedImage(encoded, null, image.getWidth(), image.getHeight(),
+            DisplayImages.proxy(image, maxWidth, maxHeight));
+    }
+
+    /**
+     * Moves an engine result into native memory, keeping a proxy fitting
+     * {@code maxWidth x maxHeight}. The caller should drop {@code image}.
+     */
+    static RetainedImage of(BufferedImage image, int maxWidth, int maxHeight) {
+        int width = image.getWidth();
+        int height = image.getHeight();
+        Image proxy = DisplayImages.proxy(image, maxWidth, maxHeight);
+
+        MemorySegment pixels = Arena.ofAuto().allocate(ValueLayout.JAVA_INT, (long) width * height);
+        int[] data = DisplayImages.directPixels(image);
+        if (data != null) {
+            // Alpha is ignored by TYPE_INT_RGB, so forcing it opaque leaves the image unchanged
+            Arrays.parallelSetAll(data, i -> data[i] | 0xFF000000);
+            MemorySegment.copy(data, 0, pixels, ValueLayout.JAVA_INT, 0, data.length);
+        } else {
+            // Row by row, so no second full-size array is allocated
+            int[] row = new int[width];
+            for (int y = 0; y < height; y++) {
+                image.getRGB(0, y, width, 1, row, 0, width);
+                for (int x = 0; x < width; x++) {
+                    row[x] |= 0xFF000000;
+                }
+                MemorySegment.copy(row, 0, pixels, ValueLayout.JAVA_INT, (long) y * width * 4, width);
+            }
+        }
+        return new RetainedImage(null, pixels, width, height, proxy);
+    }
+
+    int width() {
+        return width;
+    }
+
+    int height() {
+        return height;
+    }
+
+    /** The screen-sized proxy to display. */
+    Image proxy() {
+        return proxy;
+    }
+
+    /** A fresh full-resolution TYPE_INT_RGB copy, or the decoded image for a loaded file. */
+    BufferedImage decode() throws IOException {
+        if (pixels != null) {
+            BufferedImage image = new BufferedImage(width, height, BufferedImage.TYPE_INT_RGB);
+            int[] data = ((DataBufferInt) image.getRaster().getDataBuffer()).getData();
+            MemorySegment.copy(pixels, ValueLayout.JAVA_INT, 0, data, 0, data.length);
+            return image;
+        }
+        BufferedImage image = decode(encoded);
+        if (image == null) {
+            throw new IOException("Retained image could not be decoded");
+        }
+        return image;
+    }
+
+    /** The image at 100%: a view of the native pixels for a result, decoded for a loaded file. */
+    Image fullResolution() throws IOException {
+        if (pixels != null) {
+            return DisplayImages.wrap(
+                pixels.asByteBuffer().order(ByteOrder.nativeOrder()).asIntBuffer(), width, height);
+        }
+        return DisplayImages.fullResolution(decode());
+    }
+
+    // TurboJPEG into a TYPE_INT_RGB image over the decoded array, else the first ImageIO reader
+    private static BufferedImage decode(byte[] encoded) throws IOException {
+        if (isJpeg(encoded)) {
+            NativeAccelerator.DecodedImage decoded = NativeAccelerator.getInstance().decodeJpeg(encoded);
+            if (decoded != null) {
+                int[] data = decoded.pixels();
+                WritableRaster raster = Raster.createPackedRaster(
+                    new DataBufferInt(data, data.length), decoded.width(), decoded.height(),
+                    decoded.width(), RGB.getMasks(), null);
+                return new BufferedImage(RGB, raster, false, null);
+            }
+            // TurboJPEG failed, fall through to ImageIO
+        }
+
+        try (ImageInputStream iis = ImageIO.createImageInputStream(new ByteArrayInputStream(encoded))) {
+            Iterator<ImageReader> readers = ImageIO.getImageReaders(iis);
+            if (!readers.hasNext()) {
+                return null;
+            }
+            ImageReader reader = readers.next();
+            try {
+                reader.setInput(iis, true, true); // seekForwardOnly=true, ignoreMetadata=true
+                return reader.read(0, reader.getDefaultReadParam());
+            } finally {
+                reader.dispose();
+            }
+        }
+    }
+
+    private static boolean isJpeg(byte[] data) {
+        return data.length > 3 && (data[0] & 0xFF) == 0xFF && (data[1] & 0xFF) == 0xD8
+            && (data[2] & 0xFF) == 0xFF;
+    }
+}
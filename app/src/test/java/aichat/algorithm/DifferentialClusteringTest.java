@@ -242,29 +242,10 @@ class DifferentialClusteringTest {
                 "All 10000 assignments should match between Java and Native");
         }
         
-        //Helper to call HybridClusterer.assignPoints with List<ColorPoint> input.
+        //Helper to call the Java k-means assignment with List<ColorPoint> input.
         private int[] assignPointsJava(List<ColorPoint> points, List<ColorPoint> centroids) {
-            int n = points.size();
-            int k = centroids.size();
-            
-            double[][] pointArray = new double[n][3];
-            for (int i = 0; i < n; i++) {
-                ColorPoint p = points.get(i);
-                pointArray[i][0] = p.c1();
-                pointArray[i][1] = p.c2();
-                pointArray[i][2] = p.c3();
-            }
-            
-            double[][] centroidArray = new double[k][3];
-            for (int i = 0; i < k; i++) {
-                ColorPoint c = centroids.get(i);
-                centroidArray[i][0] = c.c1();
-                centroidArray[i][1] = c.c2();
-                centroidArray[i][2] = c.c3();
-            }
-            
-            int[] assignments = new int[n];
-            clusterer.assignPoints(pointArray, centroidArray, assignments);
+            int[] assignments = new int[points.size()];
+            WeightedKMeans.assign(PointArrays.of(points), PointArrays.of(centroids), assignments);
             return assignments;
         }
     }
@@ -0,0 +1,142 @@
+package aichat.algorithm;
+
+import aichat.model.ColorPoint;
+import org.junit.jupiter.api.*;
+
+import java.util.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * Unit tests for the flat-array Java clustering pieces: grid DBSCAN against a
+ * brute-force reference, the distance kernels against their scalar loops and
+ * the weighted representatives.
+ */
+@DisplayName("Grid DBSCAN Tests")
+class GridDbscanTest {
+
+    private static final long SEED = 42L;
+
+    @Test
+    @DisplayName("Separated blobs become two clusters, strays stay noise")
+    void separatedBlobs() {
+        List<ColorPoint> points = new ArrayList<>();
+        Random rand = new Random(SEED);
+        for (int i = 0; i < 300; i++) {
+            points.add(new ColorPoint(40 + rand.nextGaussian() * 2, 40 + rand.nextGaussian() * 2, 40 + rand.nextGaussian() * 2));
+            points.add(new ColorPoint(200 + rand.nextGaussian() * 2, 60 + rand.nextGaussian() * 2, 90 + rand.nextGaussian() * 2));
+        }
+        points.add(new ColorPoint(120, 250, 5));
+        points.add(new ColorPoint(5, 250, 250));
+
+        int[] labels = new int[points.size()];
+        int clusters = GridDbscan.cluster(PointArrays.of(points), 8.0f, 3, labels);
+
+        assertEquals(2, clusters);
+        assertNotEquals(labels[0], labels[1]);
+        for (int i = 0; i < 600; i++) {
+            assertEquals(labels[i % 2], labels[i], "point " + i);
+        }
+        assertEquals(GridDbscan.NOISE, labels[600]);
+        assertEquals(GridDbscan.NOISE, labels[601]);
+    }
+
+    @Test
+    @DisplayName("Core points and their clusters match brute-force DBSCAN")
+    void matchesBruteForce() {
+        PointArrays points = randomPoints(3000, 60);
+        float eps = 6.0f;
+        int minPts = 4;
+
+        int[] labels = new int[points.size];
+        GridDbscan.cluster(points, eps, minPts, labels);
+
+        boolean[] core = new boolean[points.size];
+        for (int i = 0; i < points.size; i++) {
+            core[i] = DistanceKernels.countWithinScalar(points, 0, points.size,
+                points.c1[i], points.c2[i], points.c3[i], eps * eps, minPts, 0) >= minPts;
+        }
+
+        // Every core point is labelled, and two core points within eps share a label
+        for (int i = 0; i < points.size; i++) {
+            if (!core[i]) continue;
+            assertNotEquals(GridDbscan.NOISE, labels[i], "core point " + i);
+            for (int j = i + 1; j < points.size; j++) {
+                if (core[j] && points.distanceSq(i, points, j) <= eps * eps) {
+                    assertEquals(labels[i], labels[j], "core pair " + i + "," + j);
+                }
+            }
+        }
+
+        // Non-core points are noise exactly when no core point is within eps
+        for (int i = 0; i < points.size; i++) {
+            if (core[i]) continue;
+            boolean reachable = DistanceKernels.anyWithinScalar(points, 0, points.size,
+                points.c1[i], points.c2[i], points.c3[i], eps * eps, core);
+            assertEquals(reachable, labels[i] != GridDbscan.NOISE, "border point " + i);
+        }
+    }
+
+    @Test
+    @DisplayName("Distance kernels agree with the scalar loops")
+    void kernelParity() {
+        PointArrays points = randomPoints(1037, 255);
+        PointArrays centroids = randomPoints(19, 255);
+
+        int[] expected = new int[points.size];
+        int[] actual = new int[points.size];
+        int expectedChanged = DistanceKernels.assignNearestScalar(points, centroids, 0, points.size, expected);
+        int actualChanged = DistanceKernels.assignNearest(points, centroids, 0, points.size, actual);
+        assertArrayEquals(expected, actual);
+        assertEquals(expectedChanged, actualChanged);
+        assertEquals(0, DistanceKernels.assignNearest(points, centroids, 0, points.size, actual));
+
+        float[] lowered = new float[points.size];
+        float[] loweredScalar = new float[points.size];
+        Arrays.fill(lowered, 5000f);
+        Arrays.fill(loweredScalar, 5000f);
+        DistanceKernels.lowerDistances(points, 3, points.size, 100, 50, 200, lowered);
+        DistanceKernels.lowerDistancesScalar(points, 3, points.size, 100, 50, 200, loweredScalar);
+        assertArrayEquals(loweredScalar, lowered);
+
+        float radiusSq = 60 * 60;
+        assertEquals(
+            DistanceKernels.countWithinScalar(points, 5, 1000, 128, 128, 128, radiusSq, Integer.MAX_VALUE, 0),
+            DistanceKernels.countWithin(points, 5, 1000, 128, 128, 128, radiusSq, Integer.MAX_VALUE));
+    }
+
+    @Test
+    @DisplayName("Representatives keep every point's weight")
+    void representativesConserveWeight() {
+        PointArrays points = randomPoints(5000, 255);
+        int[] labels = new int[points.size];
+        int clusters = GridDbscan.cluster(points, 10.0f, 3, labels);
+
+        HybridClusterer.Representatives kept =
+            HybridClusterer.extractRepresentatives(points, labels, clusters, 10.0f, 0.0f, false);
+        HybridClusterer.Representatives merged =
+            HybridClusterer.extractRepresentatives(points, labels, clusters, 40.0f, 40.0f, true);
+
+        assertEquals(points.size, totalWeight(kept.weights()), 1e-3);
+        assertEquals(points.size, totalWeight(merged.weights()), 1e-3);
+        assertTrue(merged.points().size < kept.points().size);
+        assertEquals(0, merged.noise());
+    }
+
+    private static double totalWeight(float[] weights) {
+        double sum = 0;
+        for (float w : weights) sum += w;
+        return sum;
+    }
+
+    private static PointArrays randomPoints(int n, float range) {
+        Random rand = new Random(SEED + n);
+        PointArrays points = new PointArrays(n);
+        for (int i = 0; i < n; i++) {
+            points.c1[i] = rand.nextFloat() * range;
+            points.c2[i] = rand.nextFloat() * range;
+            points.c3[i] = rand.nextFloat() * range;
+        }
+        return points;
+    }
+}
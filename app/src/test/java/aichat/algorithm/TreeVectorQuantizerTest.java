@@ -0,0 +1,72 @@
+package aichat.algorithm;
+
+import aichat.model.ColorPoint;
+import org.junit.jupiter.api.DisplayName;
+import org.junit.jupiter.api.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Random;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+@DisplayName("TreeVectorQuantizer Tests")
+class TreeVectorQuantizerTest {
+
+    private final TreeVectorQuantizer quantizer = new TreeVectorQuantizer();
+
+    @Test
+    @DisplayName("Java fallback returns k colors")
+    void javaReturnsK() {
+        List<ColorPoint> points = randomPoints(5000, 42L);
+
+        List<ColorPoint> palette = quantizer.clusterJava(points, 700);
+
+        assertEquals(700, palette.size());
+    }
+
+    @Test
+    @DisplayName("Java fallback separates distinct clusters")
+    void javaSeparatesClusters() {
+        Random random = new Random(7);
+        List<ColorPoint> points = new ArrayList<>();
+        double[][] centers = {{30, 30, 30}, {220, 40, 40}, {40, 200, 90}, {200, 200, 220}};
+        for (int i = 0; i < 2000; i++) {
+            double[] c = centers[i % centers.length];
+            points.add(new ColorPoint(
+                c[0] + random.nextGaussian() * 3,
+                c[1] + random.nextGaussian() * 3,
+                c[2] + random.nextGaussian() * 3));
+        }
+
+        List<ColorPoint> palette = quantizer.clusterJava(points, 4);
+
+        assertEquals(4, palette.size());
+        for (double[] c : centers) {
+            ColorPoint expected = new ColorPoint(c[0], c[1], c[2]);
+            double nearest = palette.stream().mapToDouble(p -> p.distanceTo(expected)).min().orElseThrow();
+            assertTrue(nearest < 2.0, "no palette entry near " + expected);
+        }
+    }
+
+    @Test
+    @DisplayName("Stops at the number of distinct colors")
+    void stopsAtDistinctColors() {
+        List<ColorPoint> points = new ArrayList<>();
+        for (int i = 0; i < 600; i++) {
+            points.add(new ColorPoint((i % 3) * 100, 50, 50));
+        }
+
+        assertEquals(3, quantizer.clusterJava(points, 10).size());
+        assertEquals(3, quantizer.cluster(points, 10).size());
+    }
+
+    private List<ColorPoint> randomPoints(int n, long seed) {
+        Random random = new Random(seed);
+        List<ColorPoint> points = new ArrayList<>(n);
+        for (int i = 0; i < n; i++) {
+            points.add(new ColorPoint(random.nextDouble() * 255, random.nextDouble() * 255, random.nextDouble() * 255));
+        }
+        return points;
+    }
+}
@@ -0,0 +1,147 @@
+package aichat.color;
+
+import aichat.model.ColorPoint;
+import org.junit.jupiter.api.*;
+
+import java.util.Random;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Parity of the Vector API batch paths with the scalar double-precision
+ * conversions and CIEDE2000.
+ */
+@DisplayName("Vector color math Tests")
+class VectorColorMathTest {
+
+    private static final double LAB_TOLERANCE = 1e-3;
+    private static final double RGB_TOLERANCE = 1e-2;
+    private static final double DELTA_E_TOLERANCE = 1e-3;
+
+    // Odd length so every run ends in a masked tail
+    private static final int COUNT = 4099;
+
+    @BeforeAll
+    static void requireVectorApi() {
+        assumeTrue(ModuleLayer.boot().findModule("jdk.incubator.vector").isPresent());
+    }
+
+    @Test
+    @DisplayName("RGB to LAB matches the scalar path")
+    void rgbToLabParity() {
+        Random rand = new Random(42);
+        float[] c1 = new float[COUNT], c2 = new float[COUNT], c3 = new float[COUNT];
+        for (int i = 0; i < COUNT; i++) {
+            c1[i] = rand.nextInt(256);
+            c2[i] = rand.nextInt(256);
+            c3[i] = rand.nextInt(256);
+        }
+        // Exercise both sides of the sRGB and Lab breakpoints
+        c1[0] = 0; c2[0] = 0; c3[0] = 0;
+        c1[1] = 10; c2[1] = 11; c3[1] = 1;
+        c1[2] = 255; c2[2] = 255; c3[2] = 255;
+        float[] r = c1.clone(), g = c2.clone(), b = c3.clone();
+
+        VectorColorMath.rgbToLab(c1, c2, c3, COUNT);
+
+        for (int i = 0; i < COUNT; i++) {
+            ColorPoint expected = ColorSpaceConverter.rgbToLab(new ColorPoint(r[i], g[i], b[i]));
+            assertEquals(expected.c1(), c1[i], LAB_TOLERANCE, "L* at " + i);
+            assertEquals(expected.c2(), c2[i], LAB_TOLERANCE, "a* at " + i);
+            assertEquals(expected.c3(), c3[i], LAB_TOLERANCE, "b* at " + i);
+        }
+    }
+
+    @Test
+    @DisplayName("LAB to RGB matches the scalar path, clamping included")
+    void labToRgbParity() {
+        Random rand = new Random(7);
+        float[] c1 = new float[COUNT], c2 = new float[COUNT], c3 = new float[COUNT];
+        for (int i = 0; i < COUNT; i++) {
+            c1[i] = rand.nextFloat() * 100;
+            c2[i] = rand.nextFloat() * 200 - 100;
+            c3[i] = rand.nextFloat() * 200 - 100;
+        }
+        float[] l = c1.clone(), a = c2.clone(), b = c3.clone();
+
+        VectorColorMath.labToRgb(c1, c2, c3, COUNT);
+
+        for (int i = 0; i < COUNT; i++) {
+            ColorPoint expected = ColorSpaceConverter.labToRgb(new ColorPoint(l[i], a[i], b[i]));
+            assertEquals(expected.c1(), c1[i], RGB_TOLERANCE, "R at " + i);
+            assertEquals(expected.c2(), c2[i], RGB_TOLERANCE, "G at " + i);
+            assertEquals(expected.c3(), c3[i], RGB_TOLERANCE, "B at " + i);
+        }
+    }
+
+    @Test
+    @DisplayName("Batch CIEDE2000 matches the scalar formula")
+    void deltaE2000Parity() {
+        Random rand = new Random(11);
+        float[] lab1 = new float[COUNT * 3];
+        float[] lab2 = new float[COUNT * 3];
+        for (int i = 0; i < lab1.length; i += 3) {
+            lab1[i] = rand.nextFloat() * 100;
+            lab1[i + 1] = rand.nextFloat() * 200 - 100;
+            lab1[i + 2] = rand.nextFloat() * 200 - 100;
+            // Mostly near pairs, where the hue terms matter most
+            float spread = i % 2 == 0 ? 5 : 100;
+            lab2[i] = lab1[i] + (rand.nextFloat() - 0.5f) * spread;
+            lab2[i + 1] = lab1[i + 1] + (rand.nextFloat() - 0.5f) * spread;
+            lab2[i + 2] = lab1[i + 2] + (rand.nextFloat() - 0.5f) * spread;
+        }
+        // Identical, achromatic and opposite-hue pairs
+        lab2[0] = lab1[0]; lab2[1] = lab1[1]; lab2[2] = lab1[2];
+        lab1[3] = 50; lab1[4] = 0; lab1[5] = 0;
+        lab2[3] = 60; lab2[4] = 0; lab2[5] = 0;
+        lab1[6] = 50; lab1[7] = 20; lab1[8] = 1;
+        lab2[6] = 50; lab2[7] = -20; lab2[8] = -1;
+
+        float[] deltaE = ColorSpaceConverter.deltaE2000Batch(lab1, lab2);
+
+        assertEquals(COUNT, deltaE.length);
+        for (int i = 0; i < COUNT; i++) {
+            double expected = ColorSpaceConverter.deltaE2000(
+                new ColorPoint(lab1[i * 3], lab1[i * 3 + 1], lab1[i * 3 + 2]),
+                new ColorPoint(lab2[i * 3], lab2[i * 3 + 1], lab2[i * 3 + 2]));
+            assertEquals(expected, deltaE[i], DELTA_E_TOLERANCE * Math.max(1, expected), "pair " + i);
+        }
+        assertEquals(0, deltaE[0], DELTA_E_TOLERANCE);
+    }
+
+    @Test
+    @DisplayName("Sharma et al. reference pairs")
+    void deltaE2000Reference() {
+        float[] lab1 = {
+            50.0000f, 2.6772f, -79.7751f,
+            50.0000f, -1.3802f, -84.2814f,
+            50.0000f, 2.5000f, 0.0000f,
+            60.2574f, -34.0099f, 36.2677f,
+            22.7233f, 20.0904f, -46.6940f
+        };
+        float[] lab2 = {
+            50.0000f, 0.0000f, -82.7485f,
+            50.0000f, 0.0000f, -82.7485f,
+            50.0000f, 0.0000f, -2.5000f,
+            60.4626f, -34.1751f, 39.4387f,
+            23.0331f, 14.9730f, -42.5619f
+        };
+        double[] expected = { 2.0425, 1.0000, 4.3065, 1.2644, 2.0373 };
+
+        float[] deltaE = ColorSpaceConverter.deltaE2000Batch(lab1, lab2);
+
+        for (int i = 0; i < expected.length; i++) {
+            assertEquals(expected[i], deltaE[i], 0.01, "pair " + i);
+        }
+    }
+
+    @Test
+    @DisplayName("Batch CIEDE2000 rejects mismatched arrays")
+    void deltaE2000BatchValidation() {
+        assertThrows(IllegalArgumentException.class,
+            () -> ColorSpaceConverter.deltaE2000Batch(new float[6], new float[3]));
+        assertThrows(IllegalArgumentException.class,
+            () -> ColorSpaceConverter.deltaE2000Batch(new float[4], new float[4]));
+    }
+}
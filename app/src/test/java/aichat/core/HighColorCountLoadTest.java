@@ -3,11 +3,15 @@ package aichat.core;
 import aichat.core.ImageHarmonyEngine.ColorModel;
 import aichat.model.ColorPalette;
 import aichat.native_.NativeAccelerator;
+import aichat.native_.NativeMemoryStats;
 import org.junit.jupiter.api.*;
 import org.junit.jupiter.api.condition.DisabledIf;
 
 import java.awt.image.BufferedImage;
 import java.io.IOException;
+import java.lang.management.ManagementFactory;
+import java.lang.management.MemoryPoolMXBean;
+import java.lang.management.MemoryType;
 import java.nio.file.Files;
 import java.nio.file.Path;
 import java.nio.file.StandardOpenOption;
@@ -56,6 +60,8 @@ class HighColorCountLoadTest {
         boolean nativeEnabled,
         boolean simdEnabled,
         boolean openclEnabled,
+        long javaHeapPeakMb,
+        NativeMemoryStats nativeMemory,
         String timestamp
     ) {}
 
@@ -71,6 +77,9 @@ class HighColorCountLoadTest {
         System.out.println("Force Java mode: " + NativeAccelerator.isForceJava());
         System.out.println("=============================\n");
         
+        // Native buffers are invisible to the heap figures; track them per test
+        accel.setNativeMemoryTracking(true);
+        
         // Prepare output directory
         Files.createDirectories(OUTPUT_DIR);
     }
@@ -85,13 +94,16 @@ class HighColorCountLoadTest {
         // Export CSV
         StringBuilder csv = new StringBuilder();
         csv.append("test_id,width_px,height_px,megapixels,palette_size,color_model,");
-        csv.append("analyze_ms,resynthesize_ms,mp_per_second,native_enabled,simd_enabled,opencl_enabled,timestamp\n");
+        csv.append("analyze_ms,resynthesize_ms,mp_per_second,native_enabled,simd_enabled,opencl_enabled,");
+        csv.append("java_heap_peak_mb,native_peak_mb,timestamp\n");
         
         for (PerformanceResult r : results) {
-            csv.append(String.format("%s,%d,%d,%d,%d,%s,%d,%d,%.2f,%b,%b,%b,%s%n",
+            csv.append(String.format("%s,%d,%d,%d,%d,%s,%d,%d,%.2f,%b,%b,%b,%d,%s,%s%n",
                 r.testId, r.widthPx, r.heightPx, r.megapixels, r.paletteSize, r.colorModel,
                 r.analyzeMs, r.resynthesizeMs, r.mpPerSecond,
-                r.nativeEnabled, r.simdEnabled, r.openclEnabled, r.timestamp));
+                r.nativeEnabled, r.simdEnabled, r.openclEnabled, r.javaHeapPeakMb,
+                r.nativeMemory == null ? "" : String.format("%.1f", r.nativeMemory.peakBytes() / MB),
+                r.timestamp));
         }
         
         Files.writeString(CSV_FILE, csv.toString(), 
@@ -126,6 +138,10 @@ class HighColorCountLoadTest {
             json.append("        \"resynthesize_ms\": ").append(r.resynthesizeMs).append(",\n");
             json.append("        \"mp_per_second\": ").append(String.format("%.2f", r.mpPerSecond)).append("\n");
             json.append("      },\n");
+            json.append("      \"memory\": {\n");
+            json.append("        \"java_heap_peak_mb\": ").append(r.javaHeapPeakMb).append(",\n");
+            json.append("        \"native\": ").append(nativeMemoryJson(r.nativeMemory)).append("\n");
+            json.append("      },\n");
             json.append("      \"timestamp\": \"").append(r.timestamp).append("\"\n");
             json.append("    }").append(i < results.size() - 1 ? "," : "").append("\n");
         }
@@ -321,6 +337,36 @@ class HighColorCountLoadTest {
         }
     }
 
+    private static final double MB = 1024.0 * 1024.0;
+    
+    /** Peak native bytes in MB, overall, per subsystem and per operation call; null without tracking. */
+    private static String nativeMemoryJson(NativeMemoryStats stats) {
+        if (stats == null || !stats.enabled()) {
+            return "null";
+        }
+        StringBuilder json = new StringBuilder();
+        json.append(String.format("{ \"peak_mb\": %.2f, \"subsystem_peak_mb\": {", stats.peakBytes() / MB));
+        String sep = " ";
+        for (NativeMemoryStats.Subsystem s : stats.subsystems()) {
+            json.append(sep).append(String.format("\"%s\": %.2f", s.name(), s.peakBytes() / MB));
+            sep = ", ";
+        }
+        json.append(" }, \"call_peak_mb\": {");
+        sep = " ";
+        for (NativeMemoryStats.CallPeak c : stats.calls()) {
+            if (c.peakBytes() == 0) continue;
+            json.append(sep).append(String.format("\"%s\": %.2f", c.op(), c.peakBytes() / MB));
+            sep = ", ";
+        }
+        return json.append(" } }").toString();
+    }
+    
+    private static List<MemoryPoolMXBean> heapPools() {
+        return ManagementFactory.getMemoryPoolMXBeans().stream()
+            .filter(pool -> pool.getType() == MemoryType.HEAP)
+            .toList();
+    }
+    
     private void runLoadTest(int width, int height, int k, ColorModel model,
                             long maxAnalyzeMs, long maxResynthMs) {
         int megapixels = (width * height) / 1_000_000;
@@ -336,6 +382,10 @@ class HighColorCountLoadTest {
             engine.analyze(warmup, Math.min(k, 64));
         }
         
+        NativeAccelerator accel = NativeAccelerator.getInstance();
+        heapPools().forEach(MemoryPoolMXBean::resetPeakUsage);
+        accel.setNativeMemoryTracking(true);
+        
         long startAnalyze = System.nanoTime();
         ColorPalette srcPalette = engine.analyze(source, k);
         ColorPalette tgtPalette = engine.analyze(target, k);
@@ -354,15 +404,23 @@ class HighColorCountLoadTest {
         
         double mpPerSec = resynthMs > 0 ? megapixels / (resynthMs / 1000.0) : 0;
         
+        // Sum of per-pool peaks: an upper bound on the heap actually in use at once
+        long heapPeakMb = heapPools().stream().mapToLong(pool -> pool.getPeakUsage().getUsed()).sum() / 1024 / 1024;
+        NativeMemoryStats nativeMemory = accel.getNativeMemoryStats();
+        
         System.out.printf("  Analyze: %dms (limit: %dms)%n", analyzeMs, maxAnalyzeMs);
         System.out.printf("  Resynth: %dms (limit: %dms) [%.1f MP/s]%n", 
             resynthMs, maxResynthMs, mpPerSec);
+        if (nativeMemory != null) {
+            System.out.printf("  Memory: Java heap peak %dMB, native peak %.1fMB%n",
+                heapPeakMb, nativeMemory.peakBytes() / MB);
+        }
         
-        NativeAccelerator accel = NativeAccelerator.getInstance();
         results.add(new PerformanceResult(
             testId, width, height, megapixels, k, model.name(),
             analyzeMs, resynthMs, mpPerSec,
             accel.isAvailable(), accel.hasSIMD(), accel.hasOpenCL(),
+            heapPeakMb, nativeMemory,
             LocalDateTime.now().format(DateTimeFormatter.ISO_LOCAL_DATE_TIME)
         ));
         
@@ -9,6 +9,7 @@ import org.junit.jupiter.api.Nested;
 import org.junit.jupiter.api.Test;
 
 import java.awt.Color;
+import java.awt.Rectangle;
 import java.awt.image.BufferedImage;
 
 import static org.junit.jupiter.api.Assertions.*;
@@ -173,6 +174,51 @@ class ImageHarmonyEngineTest {
             double avgDiff = calculateAveragePixelDifference(image, result);
             assertTrue(avgDiff < 10, "Same palette resynthesis should preserve image, diff=" + avgDiff);
         }
+
+        @Test
+        @DisplayName("Viewport at full scale matches the same region of the full result")
+        void viewportMatchesFullResult() {
+            ImageHarmonyEngine engine = new ImageHarmonyEngine(ColorModel.RGB);
+            
+            BufferedImage source = createRandomImage(TEST_IMAGE_SIZE, TEST_IMAGE_SIZE, 1);
+            BufferedImage target = createRandomImage(TEST_IMAGE_SIZE, TEST_IMAGE_SIZE, 2);
+            ColorPalette sourcePalette = engine.analyze(source, 8);
+            ColorPalette targetPalette = engine.analyze(target, 8);
+            
+            for (boolean posterize : new boolean[] { false, true }) {
+                BufferedImage full = posterize
+                    ? engine.posterize(target, sourcePalette, targetPalette)
+                    : engine.resynthesize(target, sourcePalette, targetPalette);
+                BufferedImage viewport = engine.resynthesizeViewport(target, sourcePalette, targetPalette,
+                    new Rectangle(17, 23, 40, 30), 1.0, posterize);
+                
+                assertEquals(40, viewport.getWidth());
+                assertEquals(30, viewport.getHeight());
+                for (int y = 0; y < 30; y++) {
+                    for (int x = 0; x < 40; x++) {
+                        assertEquals(full.getRGB(17 + x, 23 + y), viewport.getRGB(x, y),
+                            "pixel (" + x + "," + y + ")");
+                    }
+                }
+            }
+        }
+
+        @Test
+        @DisplayName("Viewport is clipped to the image and scaled down")
+        void viewportClippedAndScaled() {
+            ImageHarmonyEngine engine = new ImageHarmonyEngine(ColorModel.RGB);
+            
+            BufferedImage image = createTestImage(Color.RED, Color.BLUE);
+            ColorPalette palette = engine.analyze(image, 2);
+            
+            BufferedImage viewport = engine.resynthesizeViewport(image, palette, palette,
+                new Rectangle(60, -20, 80, 80), 0.5, false);
+            
+            assertEquals(20, viewport.getWidth());
+            assertEquals(30, viewport.getHeight());
+            assertThrows(IllegalArgumentException.class, () -> engine.resynthesizeViewport(
+                image, palette, palette, new Rectangle(200, 200, 10, 10), 1.0, false));
+        }
     }
 
     @Nested
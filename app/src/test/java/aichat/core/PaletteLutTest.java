@@ -0,0 +1,140 @@
+package aichat.core;
+
+import aichat.model.ColorPalette;
+import aichat.model.ColorPoint;
+import org.junit.jupiter.api.*;
+
+import java.awt.image.BufferedImage;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Random;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * Unit tests for the Java palette LUT behind the resynthesis and
+ * posterization fallbacks.
+ */
+@DisplayName("Palette LUT Tests")
+class PaletteLutTest {
+
+    private static final long SEED = 42L;
+
+    private final ImageHarmonyEngine engine = new ImageHarmonyEngine();
+
+    @Test
+    @DisplayName("Resynthesis matches a per-pixel search over LUT cell centres")
+    void resynthesisMatchesReference() {
+        BufferedImage image = randomImage(64, 48, BufferedImage.TYPE_INT_RGB);
+        ColorPalette target = randomPalette(16, SEED);
+        ColorPalette source = randomPalette(16, SEED + 1);
+
+        BufferedImage result = engine.resynthesizeJava(image, source, target);
+
+        for (int y = 0; y < image.getHeight(); y++) {
+            for (int x = 0; x < image.getWidth(); x++) {
+                int rgb = image.getRGB(x, y);
+                ColorPoint t = target.getColor(referenceNearest(rgb, target));
+                ColorPoint s = source.getColor(referenceNearest(rgb, target));
+                int expected = (channel(s.c1() + (((rgb >> 16) & 0xFF) - t.c1())) << 16)
+                    | (channel(s.c2() + (((rgb >> 8) & 0xFF) - t.c2())) << 8)
+                    | channel(s.c3() + ((rgb & 0xFF) - t.c3()));
+                assertPixelClose(expected, result.getRGB(x, y), 1, x, y);
+            }
+        }
+    }
+
+    @Test
+    @DisplayName("Posterization only emits source palette colors")
+    void posterizationUsesSourceColors() {
+        BufferedImage image = randomImage(40, 40, BufferedImage.TYPE_INT_RGB);
+        ColorPalette target = randomPalette(12, SEED);
+        ColorPalette source = randomPalette(12, SEED + 2);
+
+        BufferedImage result = engine.posterizeJava(image, source, target);
+
+        for (int y = 0; y < image.getHeight(); y++) {
+            for (int x = 0; x < image.getWidth(); x++) {
+                int expected = source.getColor(referenceNearest(image.getRGB(x, y), target)).toRGB();
+                assertPixelClose(expected, result.getRGB(x, y), 1, x, y);
+            }
+        }
+    }
+
+    @Test
+    @DisplayName("Result does not depend on the input image's pixel layout")
+    void imageTypeIndependent() {
+        BufferedImage intRgb = randomImage(37, 29, BufferedImage.TYPE_INT_RGB);
+        BufferedImage bgr = new BufferedImage(37, 29, BufferedImage.TYPE_3BYTE_BGR);
+        bgr.getGraphics().drawImage(intRgb, 0, 0, null);
+        BufferedImage sub = randomImage(60, 60, BufferedImage.TYPE_INT_ARGB).getSubimage(3, 5, 37, 29);
+        sub.getGraphics().drawImage(intRgb, 0, 0, null);
+        ColorPalette palette = randomPalette(8, SEED);
+
+        BufferedImage expected = engine.resynthesizeJava(intRgb, palette, palette);
+        assertImagesEqual(expected, engine.resynthesizeJava(bgr, palette, palette));
+        assertImagesEqual(expected, engine.resynthesizeJava(sub, palette, palette));
+    }
+
+    // Cell centre of the 7-bit cube, weighted by the centre's red channel
+    private static int referenceNearest(int rgb, ColorPalette palette) {
+        float scale = 255.0f / 127;
+        float r = (((rgb >> 16) & 0xFF) >> 1) * scale;
+        float g = (((rgb >> 8) & 0xFF) >> 1) * scale;
+        float b = ((rgb & 0xFF) >> 1) * scale;
+        float wr = r < 128 ? 2 : 3;
+        float wb = r < 128 ? 3 : 2;
+        int nearest = 0;
+        float best = Float.MAX_VALUE;
+        for (int i = 0; i < palette.size(); i++) {
+            ColorPoint c = palette.getColor(i);
+            float dr = r - (float) c.c1(), dg = g - (float) c.c2(), db = b - (float) c.c3();
+            float d = wr * (dr * dr) + (4 * (dg * dg) + wb * (db * db));
+            if (d < best) {
+                best = d;
+                nearest = i;
+            }
+        }
+        return nearest;
+    }
+
+    private static int channel(double value) {
+        return Math.max(0, Math.min(255, (int) Math.round(value)));
+    }
+
+    private static void assertPixelClose(int expected, int actual, int tolerance, int x, int y) {
+        for (int shift = 0; shift <= 16; shift += 8) {
+            int diff = Math.abs(((expected >> shift) & 0xFF) - ((actual >> shift) & 0xFF));
+            assertTrue(diff <= tolerance,
+                String.format("pixel (%d,%d): expected %06X, got %06X", x, y, expected & 0xFFFFFF, actual & 0xFFFFFF));
+        }
+    }
+
+    private static void assertImagesEqual(BufferedImage expected, BufferedImage actual) {
+        for (int y = 0; y < expected.getHeight(); y++) {
+            for (int x = 0; x < expected.getWidth(); x++) {
+                assertEquals(expected.getRGB(x, y), actual.getRGB(x, y), "pixel (" + x + "," + y + ")");
+            }
+        }
+    }
+
+    private static BufferedImage randomImage(int width, int height, int type) {
+        BufferedImage image = new BufferedImage(width, height, type);
+        Random rand = new Random(SEED);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                image.setRGB(x, y, 0xFF000000 | rand.nextInt(0x1000000));
+            }
+        }
+        return image;
+    }
+
+    private static ColorPalette randomPalette(int size, long seed) {
+        Random rand = new Random(seed);
+        List<ColorPoint> colors = new ArrayList<>();
+        for (int i = 0; i < size; i++) {
+            colors.add(new ColorPoint(rand.nextInt(256), rand.nextInt(256), rand.nextInt(256)));
+        }
+        return new ColorPalette(colors);
+    }
+}
@@ -0,0 +1,142 @@
+package aichat.core;
+
+import aichat.model.ColorPoint;
+import aichat.model.ColorStatistics;
+import aichat.native_.NativeLibrary;
+import org.junit.jupiter.api.*;
+
+import java.awt.image.BufferedImage;
+import java.lang.foreign.Arena;
+import java.util.Random;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Unit tests for the Reinhard statistical transfer: the Java backend, the
+ * lab_statistics and reinhard_transfer native functions, and the two
+ * against each other.
+ */
+@DisplayName("Statistical Transfer Tests")
+class StatisticalTransferTest {
+
+    private static final long SEED = 42L;
+    private static final int WIDTH = 96;
+    private static final int HEIGHT = 64;
+
+    private final ImageHarmonyEngine engine = new ImageHarmonyEngine();
+
+    @Test
+    @DisplayName("Transfer to an image's own statistics leaves it unchanged")
+    void selfTransferIsIdentity() {
+        int[] pixels = randomPixels(WIDTH * HEIGHT, SEED);
+        ColorStatistics stats = StatisticalTransfer.statistics(pixels, WIDTH, HEIGHT, 0);
+
+        int[] out = new int[pixels.length];
+        StatisticalTransfer.apply(pixels, out, out.length, stats, stats);
+
+        for (int i = 0; i < pixels.length; i++) {
+            assertPixelClose(pixels[i], out[i], 1, i);
+        }
+    }
+
+    @Test
+    @DisplayName("Transferred image takes on the source statistics")
+    void resultMatchesSourceStatistics() {
+        BufferedImage target = image(randomPixels(WIDTH * HEIGHT, SEED));
+        ColorStatistics targetStats = engine.statistics(target);
+        ColorStatistics sourceStats = new ColorStatistics(
+            new ColorPoint(targetStats.mean().c1() + 3, targetStats.mean().c2() - 4, targetStats.mean().c3() + 5),
+            new ColorPoint(targetStats.stdDev().c1() * 0.8, targetStats.stdDev().c2() * 0.7, targetStats.stdDev().c3() * 0.9));
+
+        ColorStatistics result = engine.statistics(engine.transfer(target, sourceStats, targetStats));
+
+        assertEquals(sourceStats.mean().c1(), result.mean().c1(), 1.0);
+        assertEquals(sourceStats.mean().c2(), result.mean().c2(), 1.0);
+        assertEquals(sourceStats.mean().c3(), result.mean().c3(), 1.0);
+        assertEquals(sourceStats.stdDev().c1(), result.stdDev().c1(), 1.0);
+        assertEquals(sourceStats.stdDev().c2(), result.stdDev().c2(), 1.0);
+        assertEquals(sourceStats.stdDev().c3(), result.stdDev().c3(), 1.0);
+    }
+
+    @Test
+    @DisplayName("A flat channel is shifted, not scaled")
+    void flatImageShifted() {
+        int[] pixels = new int[WIDTH * HEIGHT];
+        java.util.Arrays.fill(pixels, 0x808080);
+        ColorStatistics targetStats = StatisticalTransfer.statistics(pixels, WIDTH, HEIGHT, 0);
+        assertEquals(0.0, targetStats.stdDev().c1(), 1e-3);
+
+        ColorStatistics sourceStats = new ColorStatistics(
+            new ColorPoint(targetStats.mean().c1() + 10, targetStats.mean().c2(), targetStats.mean().c3()),
+            new ColorPoint(20, 20, 20));
+        int[] out = new int[pixels.length];
+        StatisticalTransfer.apply(pixels, out, out.length, sourceStats, targetStats);
+
+        for (int p : out) {
+            assertEquals(out[0], p);
+        }
+        assertTrue((out[0] & 0xFF) > 0x80, "brighter gray expected");
+    }
+
+    @Test
+    @DisplayName("Native statistics match the Java reduction")
+    void nativeStatisticsMatchJava() {
+        assumeTrue(NativeLibrary.isAvailable());
+
+        int width = 1000;
+        int height = 700;
+        int[] pixels = randomPixels(width * height, SEED);
+        try (Arena arena = Arena.ofConfined()) {
+            for (int maxSamples : new int[] { 0, 10_000 }) {
+                float[] nativeStats = NativeLibrary.getInstance().labStatistics(arena, pixels, width, height, maxSamples);
+                float[] javaStats = StatisticalTransfer.statistics(pixels, width, height, maxSamples).toArray();
+                assertArrayEquals(javaStats, nativeStats, 0.05f, "maxSamples " + maxSamples);
+            }
+        }
+    }
+
+    @Test
+    @DisplayName("Native transfer matches the Java LUT within one level")
+    void nativeTransferMatchesJava() {
+        assumeTrue(NativeLibrary.isAvailable());
+
+        int[] pixels = randomPixels(WIDTH * HEIGHT, SEED);
+        ColorStatistics targetStats = StatisticalTransfer.statistics(pixels, WIDTH, HEIGHT, 0);
+        ColorStatistics sourceStats = new ColorStatistics(
+            new ColorPoint(62, 12, -8), new ColorPoint(18, 9, 14));
+
+        int[] java = new int[pixels.length];
+        StatisticalTransfer.apply(pixels, java, java.length, sourceStats, targetStats);
+        try (Arena arena = Arena.ofConfined()) {
+            int[] result = new int[pixels.length];
+            NativeLibrary.getInstance().reinhardTransfer(arena, pixels, WIDTH, HEIGHT,
+                sourceStats.toArray(), targetStats.toArray(), result);
+            for (int i = 0; i < result.length; i++) {
+                assertPixelClose(java[i], result[i], 1, i);
+            }
+        }
+    }
+
+    private static void assertPixelClose(int expected, int actual, int tolerance, int index) {
+        for (int shift = 0; shift <= 16; shift += 8) {
+            int diff = Math.abs(((expected >> shift) & 0xFF) - ((actual >> shift) & 0xFF));
+            assertTrue(diff <= tolerance, "pixel " + index + " differs by " + diff);
+        }
+    }
+
+    private static BufferedImage image(int[] pixels) {
+        BufferedImage image = new BufferedImage(WIDTH, HEIGHT, BufferedImage.TYPE_INT_RGB);
+        image.setRGB(0, 0, WIDTH, HEIGHT, pixels, 0, WIDTH);
+        return image;
+    }
+
+    private static int[] randomPixels(int n, long seed) {
+        Random rand = new Random(seed);
+        int[] pixels = new int[n];
+        for (int i = 0; i < n; i++) {
+            pixels[i] = rand.nextInt() & 0xFFFFFF;
+        }
+        return pixels;
+    }
+}
@@ -0,0 +1,139 @@
+package aichat.diagnostics;
+
+import aichat.core.ImageHarmonyEngine;
+import aichat.core.ImageHarmonyEngine.ColorModel;
+import aichat.model.ColorPalette;
+import jdk.jfr.Recording;
+import jdk.jfr.consumer.RecordedEvent;
+import jdk.jfr.consumer.RecordingFile;
+import org.junit.jupiter.api.BeforeAll;
+import org.junit.jupiter.api.DisplayName;
+import org.junit.jupiter.api.Test;
+import org.junit.jupiter.api.io.TempDir;
+
+import java.awt.image.BufferedImage;
+import java.io.IOException;
+import java.nio.file.Path;
+import java.util.List;
+import java.util.Random;
+import java.util.Set;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * Checks that a palette transfer leaves the engine's JFR events in a
+ * recording, on whichever backend is active.
+ */
+@DisplayName("JFR engine event Tests")
+class EngineEventsTest {
+
+    private static final int WIDTH = 160;
+    private static final int HEIGHT = 120;
+    private static final Set<String> BACKENDS = Set.of("native", "native-tiled", "gpu", "java");
+
+    private static List<RecordedEvent> events;
+
+    @BeforeAll
+    static void record(@TempDir Path dir) throws IOException {
+        ImageHarmonyEngine engine = new ImageHarmonyEngine(ColorModel.CIELAB);
+        BufferedImage source = randomImage(1);
+        BufferedImage target = randomImage(2);
+
+        Path file = dir.resolve("engine.jfr");
+        try (Recording recording = new Recording()) {
+            for (String name : List.of("aichat.Sampling", "aichat.ColorConversion", "aichat.Clustering",
+                                       "aichat.PaletteMapping", "aichat.Resynthesis", "aichat.NativeCall")) {
+                recording.enable(name).withoutThreshold();
+            }
+            recording.start();
+
+            ColorPalette sourcePalette = engine.analyze(source, 6);
+            ColorPalette targetPalette = engine.analyze(target, 6);
+            engine.resynthesize(target, sourcePalette, targetPalette);
+
+            recording.stop();
+            recording.dump(file);
+        }
+        events = RecordingFile.readAllEvents(file);
+    }
+
+    @Test
+    @DisplayName("Sampling records image size and sample count")
+    void samplingEvent() {
+        List<RecordedEvent> sampling = ofType("aichat.Sampling");
+        assertEquals(2, sampling.size());
+        for (RecordedEvent e : sampling) {
+            assertEquals(WIDTH, e.getInt("width"));
+            assertEquals(HEIGHT, e.getInt("height"));
+            assertTrue(e.getInt("samples") > 0);
+            assertTrue(e.getInt("samples") <= e.getInt("requested"));
+            assertTrue(BACKENDS.contains(e.getString("backend")));
+        }
+    }
+
+    @Test
+    @DisplayName("CIELAB engine records conversions both ways")
+    void colorConversionEvents() {
+        List<RecordedEvent> conversions = ofType("aichat.ColorConversion");
+        assertTrue(conversions.stream().anyMatch(e -> "rgb-to-lab".equals(e.getString("direction"))));
+        assertTrue(conversions.stream().anyMatch(e -> "lab-to-rgb".equals(e.getString("direction"))));
+        for (RecordedEvent e : conversions) {
+            assertTrue(e.getInt("points") > 0);
+        }
+    }
+
+    @Test
+    @DisplayName("Clustering records k, point count and iterations")
+    void clusteringEvent() {
+        List<RecordedEvent> clustering = ofType("aichat.Clustering");
+        assertTrue(clustering.size() >= 2, clustering.toString());
+        for (RecordedEvent e : clustering) {
+            assertEquals(6, e.getInt("k"));
+            assertTrue(e.getLong("points") >= 6);
+            assertTrue(e.getInt("iterations") >= 1, e.toString());
+            assertTrue(e.getInt("iterations") <= e.getInt("maxIterations"), e.toString());
+        }
+    }
+
+    @Test
+    @DisplayName("Resynthesis records mode, size and chosen backend")
+    void resynthesisEvent() {
+        List<RecordedEvent> resynthesis = ofType("aichat.Resynthesis");
+        assertEquals(1, resynthesis.size());
+        RecordedEvent e = resynthesis.get(0);
+        assertEquals("resynthesize", e.getString("mode"));
+        assertEquals(WIDTH, e.getInt("width"));
+        assertEquals(HEIGHT, e.getInt("height"));
+        assertEquals(6, e.getInt("paletteSize"));
+        assertTrue(BACKENDS.contains(e.getString("backend")));
+
+        assertEquals(1, ofType("aichat.PaletteMapping").size());
+    }
+
+    @Test
+    @DisplayName("Native calls record marshalled bytes")
+    void nativeCallEvents() {
+        for (RecordedEvent e : ofType("aichat.NativeCall")) {
+            assertFalse(e.getString("function").isEmpty());
+            assertTrue(e.getLong("inputBytes") >= 0);
+            if (e.getBoolean("success")) {
+                assertTrue(e.getLong("outputBytes") > 0, e.toString());
+            }
+        }
+    }
+
+    private static List<RecordedEvent> ofType(String name) {
+        return events.stream().filter(e -> e.getEventType().getName().equals(name)).toList();
+    }
+
+    private static BufferedImage randomImage(long seed) {
+        BufferedImage image = new BufferedImage(WIDTH, HEIGHT, BufferedImage.TYPE_INT_RGB);
+        Random rand = new Random(seed);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                image.setRGB(x, y, rand.nextInt(0xFFFFFF));
+            }
+        }
+        return image;
+    }
+}
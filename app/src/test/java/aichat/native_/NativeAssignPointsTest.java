@@ -313,4 +313,49 @@ class NativeAssignPointsTest {
             }
         }
     }
+    
+    @Nested
+    @DisplayName("Segment Overloads")
+    class SegmentTests {
+        
+        @Test
+        @DisplayName("Segment call matches the array call")
+        void segmentMatchesArray() {
+            assumeTrue(available, "Native assign_points_batch not available");
+            
+            Random random = new Random(7);
+            int n = 2000, k = 16;
+            float[] points = new float[n * 3];
+            float[] centroids = new float[k * 3];
+            for (int i = 0; i < points.length; i++) points[i] = random.nextFloat() * 255;
+            for (int i = 0; i < centroids.length; i++) centroids[i] = random.nextFloat() * 255;
+            
+            try (Arena arena = Arena.ofConfined()) {
+                int[] expected = nativeLib.assignPointsBatch(arena, points, centroids);
+                
+                MemorySegment pointsNative = arena.allocate(ValueLayout.JAVA_FLOAT, points.length);
+                MemorySegment centroidsNative = arena.allocate(ValueLayout.JAVA_FLOAT, centroids.length);
+                MemorySegment assignmentsNative = arena.allocate(ValueLayout.JAVA_INT, n);
+                pointsNative.copyFrom(MemorySegment.ofArray(points));
+                centroidsNative.copyFrom(MemorySegment.ofArray(centroids));
+                assignmentsNative.fill((byte) -1);
+                
+                int changed = nativeLib.assignPointsBatch(pointsNative, n, centroidsNative, k, assignmentsNative);
+                
+                assertEquals(n, changed, "Every point starts unassigned");
+                assertArrayEquals(expected, assignmentsNative.toArray(ValueLayout.JAVA_INT));
+            }
+        }
+        
+        @Test
+        @DisplayName("No-op downcall returns its argument")
+        void noopReturnsArgument() {
+            assumeTrue(available, "Native library not available");
+            
+            try (Arena arena = Arena.ofConfined()) {
+                MemorySegment data = arena.allocate(ValueLayout.JAVA_FLOAT, 3);
+                assertEquals(42, nativeLib.noop(data, 42));
+            }
+        }
+    }
 }
@@ -180,6 +180,56 @@ class NativeHybridClusterTest {
         }
     }
     
+    @Test
+    @DisplayName("Global DBSCAN finds dense regions spread over the whole sample")
+    void globalDbscanFindsInterleavedRegions() {
+        assumeTrue(available);
+        
+        try (Arena arena = Arena.ofConfined()) {
+            // Two tight regions interleaved through the whole sample
+            int n = 3000;
+            float[] points = new float[n * 3];
+            Random rand = new Random(7);
+            for (int i = 0; i < n; i++) {
+                float center = (i % 3 == 0) ? 200 : 40;
+                points[i * 3] = center + rand.nextFloat() * 6 - 3;
+                points[i * 3 + 1] = center + rand.nextFloat() * 6 - 3;
+                points[i * 3 + 2] = center + rand.nextFloat() * 6 - 3;
+            }
+            
+            float[] centroids = nativeLib.hybridCluster(arena, points, 2, 100,
+                8.0f, DBSCAN_MIN_PTS, KMEANS_MAX_ITER, KMEANS_THRESHOLD, 42L);
+            
+            float low = Math.min(centroids[0], centroids[3]);
+            float high = Math.max(centroids[0], centroids[3]);
+            assertEquals(40, low, 2);
+            assertEquals(200, high, 2);
+        }
+    }
+    
+    @Test
+    @DisplayName("Representative cap keeps noisy input within color range")
+    void boundedRepresentativesOnNoise() {
+        assumeTrue(available);
+        
+        try (Arena arena = Arena.ofConfined()) {
+            // Uniform noise yields almost no clusters, so the cap has to merge noise
+            float[] points = randomPoints(20000, 9);
+            int k = 8;
+            
+            float[] r1 = nativeLib.hybridCluster(arena, points, k, 500,
+                4.0f, DBSCAN_MIN_PTS, KMEANS_MAX_ITER, KMEANS_THRESHOLD, 64, 42L);
+            float[] r2 = nativeLib.hybridCluster(arena, points, k, 500,
+                4.0f, DBSCAN_MIN_PTS, KMEANS_MAX_ITER, KMEANS_THRESHOLD, 64, 42L);
+            
+            assertEquals(k * 3, r1.length);
+            assertArrayEquals(r1, r2, 0.0f);
+            for (float v : r1) {
+                assertTrue(v >= 0 && v <= 255);
+            }
+        }
+    }
+    
     @Test
     @DisplayName("Handles k > representatives gracefully")
     void handlesKGreaterThanRepresentatives() {
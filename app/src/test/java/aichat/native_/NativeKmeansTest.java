@@ -172,6 +172,44 @@ class NativeKmeansTest {
         }
     }
     
+    @Test
+    @DisplayName("Weighted k=1 returns the weighted mean")
+    void weightedK1ReturnsWeightedMean() {
+        assumeTrue(available);
+        
+        try (Arena arena = Arena.ofConfined()) {
+            float[] points = {0, 0, 0, 100, 100, 100};
+            float[] weights = {3, 1};
+            
+            float[] centroids = nativeLib.kmeansClusterWeighted(arena, points, weights, 1, 50, 0.01f, 42L);
+            
+            assertArrayEquals(new float[]{25, 25, 25}, centroids, 0.01f);
+        }
+    }
+    
+    @Test
+    @DisplayName("Weighted centroids are deterministic and within range")
+    void weightedDeterministic() {
+        assumeTrue(available);
+        
+        try (Arena arena = Arena.ofConfined()) {
+            float[] points = randomPoints(2000, 5);
+            float[] weights = new float[2000];
+            Random rand = new Random(5);
+            for (int i = 0; i < weights.length; i++) {
+                weights[i] = 1 + rand.nextInt(50);
+            }
+            
+            float[] r1 = nativeLib.kmeansClusterWeighted(arena, points, weights, 8, 50, 0.5f, 42L);
+            float[] r2 = nativeLib.kmeansClusterWeighted(arena, points, weights, 8, 50, 0.5f, 42L);
+            
+            assertArrayEquals(r1, r2, 0.0f);
+            for (float v : r1) {
+                assertTrue(v >= 0 && v <= 255);
+            }
+        }
+    }
+    
     private float[] randomPoints(int n, long seed) {
         float[] points = new float[n * 3];
         Random rand = new Random(seed);
@@ -0,0 +1,206 @@
+package aichat.native_;
+
+import org.junit.jupiter.api.*;
+
+import java.lang.foreign.*;
+import java.util.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Unit tests for the native metrics snapshot, the palette LUT cache and the
+ * Prometheus rendering.
+ */
+@DisplayName("Native metrics Tests")
+class NativeMetricsTest {
+
+    private static final int SIZE = 64;
+
+    private static NativeLibrary nativeLib;
+    private static boolean available;
+
+    @BeforeAll
+    static void setup() {
+        available = NativeLibrary.isAvailable();
+        if (available) {
+            nativeLib = NativeLibrary.getInstance();
+        }
+    }
+
+    @AfterEach
+    void restoreDefaults() {
+        if (available) {
+            nativeLib.setLutCacheEnabled(true);
+            nativeLib.setMemoryTracking(false);
+        }
+    }
+
+    @Test
+    @DisplayName("Snapshot lists every op with a full histogram")
+    void snapshotShape() {
+        assumeTrue(available);
+
+        NativeMetrics metrics = nativeLib.metricsSnapshot();
+        assertNotNull(metrics);
+        assertNotNull(metrics.op("kmeans"));
+        assertNotNull(metrics.op("resynthesize"));
+        assertNull(metrics.op("no-such-op"));
+        for (NativeMetrics.OpMetrics op : metrics.ops()) {
+            assertEquals(24, op.latencyBuckets().length, op.name());
+            assertEquals(op.calls(), Arrays.stream(op.latencyBuckets()).sum(), op.name());
+        }
+    }
+
+    @Test
+    @DisplayName("Resynthesis counts the call, its pixels and its time")
+    void resynthesisIsCounted() {
+        assumeTrue(available);
+
+        NativeMetrics before = nativeLib.metricsSnapshot();
+        resynthesize(PALETTE);
+        NativeMetrics after = nativeLib.metricsSnapshot();
+
+        NativeMetrics.OpMetrics b = before.op("resynthesize");
+        NativeMetrics.OpMetrics a = after.op("resynthesize");
+        assertEquals(b.calls() + 1, a.calls());
+        assertEquals(b.items() + SIZE * SIZE, a.items());
+        assertTrue(a.callNanos() > b.callNanos());
+        assertTrue(after.bytesAllocated() >= before.bytesAllocated());
+    }
+
+    @Test
+    @DisplayName("Repeated palette reuses the LUT and maps identically")
+    void lutCacheHit() {
+        assumeTrue(available);
+
+        nativeLib.clearLutCache();
+        NativeMetrics before = nativeLib.metricsSnapshot();
+        int[] first = resynthesize(PALETTE);
+        int[] second = resynthesize(PALETTE);
+        NativeMetrics after = nativeLib.metricsSnapshot();
+
+        assertArrayEquals(first, second);
+        assertEquals(before.lutBuilds() + 1, after.lutBuilds());
+        assertEquals(before.lutCacheHits() + 1, after.lutCacheHits());
+
+        nativeLib.setLutCacheEnabled(false);
+        assertArrayEquals(first, resynthesize(PALETTE));
+        NativeMetrics uncached = nativeLib.metricsSnapshot();
+        assertEquals(after.lutBuilds() + 1, uncached.lutBuilds());
+        assertEquals(after.lutCacheHits(), uncached.lutCacheHits());
+    }
+
+    @Test
+    @DisplayName("A changed palette builds a new LUT")
+    void lutCacheMissOnNewPalette() {
+        assumeTrue(available);
+
+        nativeLib.clearLutCache();
+        resynthesize(PALETTE);
+        NativeMetrics before = nativeLib.metricsSnapshot();
+        float[] other = PALETTE.clone();
+        other[0] = 16;
+        resynthesize(other);
+        NativeMetrics after = nativeLib.metricsSnapshot();
+
+        assertEquals(before.lutBuilds() + 1, after.lutBuilds());
+        assertEquals(before.lutCacheHits(), after.lutCacheHits());
+    }
+
+    @Test
+    @DisplayName("Prometheus output has cumulative buckets ending at +Inf")
+    void prometheusFormat() {
+        long[] buckets = new long[24];
+        buckets[0] = 2;
+        buckets[10] = 3;
+        buckets[23] = 1;
+        NativeMetrics metrics = new NativeMetrics(
+            List.of(new NativeMetrics.OpMetrics("kmeans", 6, 1_500_000_000L, 4096, buckets)),
+            7, 5, 1024, 9, 0);
+
+        String text = metrics.toPrometheus();
+        assertTrue(text.contains("# TYPE aichat_native_calls_total counter\n"), text);
+        assertTrue(text.contains("aichat_native_calls_total{op=\"kmeans\"} 6\n"), text);
+        assertTrue(text.contains("aichat_native_items_total{op=\"kmeans\"} 4096\n"), text);
+        assertTrue(text.contains("# TYPE aichat_native_call_duration_seconds histogram\n"), text);
+        assertTrue(text.contains("aichat_native_call_duration_seconds_bucket{op=\"kmeans\",le=\"0.000001\"} 2\n"), text);
+        assertTrue(text.contains("aichat_native_call_duration_seconds_bucket{op=\"kmeans\",le=\"0.000512\"} 2\n"), text);
+        assertTrue(text.contains("aichat_native_call_duration_seconds_bucket{op=\"kmeans\",le=\"0.001024\"} 5\n"), text);
+        assertTrue(text.contains("aichat_native_call_duration_seconds_bucket{op=\"kmeans\",le=\"4.194304\"} 5\n"), text);
+        assertTrue(text.contains("aichat_native_call_duration_seconds_bucket{op=\"kmeans\",le=\"+Inf\"} 6\n"), text);
+        assertTrue(text.contains("aichat_native_call_duration_seconds_sum{op=\"kmeans\"} 1.500000000\n"), text);
+        assertTrue(text.contains("aichat_native_call_duration_seconds_count{op=\"kmeans\"} 6\n"), text);
+        assertTrue(text.contains("aichat_native_lut_builds_total 7\n"), text);
+        assertTrue(text.contains("aichat_native_lut_cache_hits_total 5\n"), text);
+        assertTrue(text.contains("aichat_native_allocated_bytes_total 1024\n"), text);
+        assertTrue(text.contains("aichat_native_omp_regions_total 9\n"), text);
+        assertTrue(text.contains("aichat_native_gpu_fallbacks_total 0\n"), text);
+
+        assertEquals(Double.POSITIVE_INFINITY, metrics.op("kmeans").bucketUpperBoundSeconds(23));
+        assertEquals(1e-6, metrics.op("kmeans").bucketUpperBoundSeconds(0));
+    }
+
+    @Test
+    @DisplayName("Tracker attributes the LUT to its subsystem and call")
+    void memoryTracking() {
+        assumeTrue(available);
+
+        nativeLib.setLutCacheEnabled(false);
+        assertTrue(nativeLib.setMemoryTracking(true));
+        NativeMemoryStats start = nativeLib.memoryStats();
+        assertTrue(start.enabled());
+        assertEquals(0, start.call("resynthesize").peakBytes());
+
+        resynthesize(PALETTE);
+        NativeMemoryStats stats = nativeLib.memoryStats();
+
+        NativeMemoryStats.Subsystem lut = stats.subsystem("lut");
+        assertTrue(lut.peakBytes() > 0);
+        assertEquals(start.subsystem("lut").currentBytes(), lut.currentBytes(), "LUT freed after the call");
+        assertTrue(stats.peakBytes() >= lut.peakBytes());
+        assertTrue(stats.call("resynthesize").peakBytes() >= lut.peakBytes());
+        assertEquals(stats.call("resynthesize").peakBytes(), stats.call("resynthesize").lastPeakBytes());
+    }
+
+    @Test
+    @DisplayName("Nothing is tracked while the tracker is off")
+    void memoryTrackingOff() {
+        assumeTrue(available);
+
+        nativeLib.setLutCacheEnabled(false);
+        nativeLib.setMemoryTracking(true);
+        nativeLib.setMemoryTracking(false);
+        NativeMemoryStats before = nativeLib.memoryStats();
+        resynthesize(PALETTE);
+        NativeMemoryStats after = nativeLib.memoryStats();
+
+        assertFalse(after.enabled());
+        assertEquals(before.peakBytes(), after.peakBytes());
+        assertEquals(before.call("resynthesize"), after.call("resynthesize"));
+    }
+
+    @Test
+    @DisplayName("Accelerator exposes the snapshot for scraping")
+    void acceleratorMetrics() {
+        NativeAccelerator accel = NativeAccelerator.getInstance();
+        assumeTrue(accel.isAvailable());
+
+        NativeMetrics metrics = accel.getMetrics();
+        assertNotNull(metrics);
+        assertTrue(metrics.toPrometheus().contains("aichat_native_calls_total{op=\"resynthesize\"}"));
+    }
+
+    private static final float[] PALETTE = { 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255 };
+
+    private static int[] resynthesize(float[] palette) {
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = new int[SIZE * SIZE];
+            Random rand = new Random(42);
+            for (int i = 0; i < pixels.length; i++) {
+                pixels[i] = rand.nextInt(0xFFFFFF);
+            }
+            return nativeLib.resynthesizeImage(arena, pixels, SIZE, SIZE, palette, palette);
+        }
+    }
+}
@@ -151,4 +151,45 @@ class NativePosterizeTest {
             }
         }
     }
+    
+    @Test
+    @DisplayName("Palettes above 4096 colors still pick the nearest color")
+    void largePaletteNearest() {
+        assumeTrue(available);
+        
+        try (Arena arena = Arena.ofConfined()) {
+            Random rand = new Random(5);
+            int k = 5000;
+            float[] palette = new float[k * 3];
+            for (int i = 0; i < palette.length; i++) {
+                palette[i] = rand.nextInt(256);
+            }
+            int[] pixels = new int[2000];
+            for (int i = 0; i < pixels.length; i++) {
+                pixels[i] = rand.nextInt(0x1000000);
+            }
+            
+            int[] result = nativeLib.posterizeImage(arena, pixels, pixels.length, 1, palette, palette);
+            
+            for (int i = 0; i < pixels.length; i++) {
+                float best = Float.MAX_VALUE;
+                for (int c = 0; c < k; c++) {
+                    best = Math.min(best, weightedDistance(pixels[i], palette[c * 3], palette[c * 3 + 1], palette[c * 3 + 2]));
+                }
+                int out = result[i];
+                float got = weightedDistance(pixels[i], (out >> 16) & 0xFF, (out >> 8) & 0xFF, out & 0xFF);
+                assertEquals(best, got, 0.0f, "pixel " + i);
+            }
+        }
+    }
+    
+    // Perceptual weights keyed on the pixel's red channel, as in the native search
+    private static float weightedDistance(int pixel, float r, float g, float b) {
+        float pr = (pixel >> 16) & 0xFF;
+        float pg = (pixel >> 8) & 0xFF;
+        float pb = pixel & 0xFF;
+        float wr = pr < 128 ? 2 : 3;
+        float wb = pr < 128 ? 3 : 2;
+        return wr * (pr - r) * (pr - r) + 4 * (pg - g) * (pg - g) + wb * (pb - b) * (pb - b);
+    }
 }
@@ -0,0 +1,212 @@
+package aichat.native_;
+
+import aichat.core.BoxResampler;
+import org.junit.jupiter.api.*;
+import org.junit.jupiter.params.ParameterizedTest;
+import org.junit.jupiter.params.provider.CsvSource;
+
+import java.lang.foreign.*;
+import java.util.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Unit tests for the downscale_box and downscale_lanczos3 native functions
+ * and their Java box-filter fallback.
+ */
+@DisplayName("Native resampling Tests")
+class NativeResampleTest {
+
+    private static NativeLibrary nativeLib;
+    private static boolean available;
+
+    @BeforeAll
+    static void setup() {
+        available = NativeLibrary.isAvailable();
+        if (available) {
+            nativeLib = NativeLibrary.getInstance();
+        }
+    }
+
+    @ParameterizedTest(name = "{0}x{1} -> {2}x{3}")
+    @CsvSource({
+        "64, 48, 32, 24",
+        "100, 75, 33, 17",
+        "37, 29, 37, 29",
+        "1000, 1, 7, 1",
+        "5, 9, 1, 1"
+    })
+    @DisplayName("Matches a per-pixel box mean with opaque alpha")
+    void matchesReference(int width, int height, int dstWidth, int dstHeight) {
+        assumeTrue(available);
+
+        int[] pixels = randomPixels(width * height);
+        try (Arena arena = Arena.ofConfined()) {
+            int[] result = nativeLib.downscaleBox(arena, pixels, width, height, dstWidth, dstHeight);
+            int[] expected = reference(pixels, width, height, dstWidth, dstHeight);
+            assertArrayEquals(expected, result);
+        }
+    }
+
+    @ParameterizedTest(name = "{0}x{1} -> {2}x{3}")
+    @CsvSource({
+        "64, 48, 32, 24",
+        "100, 75, 33, 17",
+        "1923, 1081, 640, 360"
+    })
+    @DisplayName("Java box fallback matches native exactly")
+    void javaBoxMatchesNative(int width, int height, int dstWidth, int dstHeight) {
+        assumeTrue(available);
+
+        int[] pixels = randomPixels(width * height);
+        int[] java = new int[dstWidth * dstHeight];
+        BoxResampler.downscale(pixels, width, height, java, dstWidth, dstHeight);
+        try (Arena arena = Arena.ofConfined()) {
+            assertArrayEquals(nativeLib.downscaleBox(arena, pixels, width, height, dstWidth, dstHeight), java);
+        }
+    }
+
+    @ParameterizedTest(name = "{0}x{1} -> {2}x{3}")
+    @CsvSource({
+        "64, 48, 32, 24",
+        "100, 75, 33, 17",
+        "37, 29, 37, 29",
+        "301, 203, 40, 30"
+    })
+    @DisplayName("Lanczos-3 matches a separable double-precision reference")
+    void lanczosMatchesReference(int width, int height, int dstWidth, int dstHeight) {
+        assumeTrue(available);
+
+        int[] pixels = randomPixels(width * height);
+        try (Arena arena = Arena.ofConfined()) {
+            int[] result = nativeLib.downscaleLanczos3(arena, pixels, width, height, dstWidth, dstHeight);
+            int[] expected = lanczosReference(pixels, width, height, dstWidth, dstHeight);
+            for (int i = 0; i < result.length; i++) {
+                assertEquals(0xFF, result[i] >>> 24, "alpha at " + i);
+                for (int shift = 0; shift <= 16; shift += 8) {
+                    int diff = Math.abs(((result[i] >> shift) & 0xFF) - ((expected[i] >> shift) & 0xFF));
+                    assertTrue(diff <= 1, "pixel " + i + " differs by " + diff);
+                }
+            }
+        }
+    }
+
+    @Test
+    @DisplayName("Uniform image stays uniform")
+    void uniformImage() {
+        assumeTrue(available);
+
+        int[] pixels = new int[80 * 60];
+        Arrays.fill(pixels, 0x00336699);
+        try (Arena arena = Arena.ofConfined()) {
+            for (int p : nativeLib.downscaleBox(arena, pixels, 80, 60, 13, 11)) {
+                assertEquals(0xFF336699, p);
+            }
+            for (int p : nativeLib.downscaleLanczos3(arena, pixels, 80, 60, 13, 11)) {
+                assertEquals(0xFF336699, p);
+            }
+        }
+    }
+
+    @Test
+    @DisplayName("Upscaling and empty targets are rejected")
+    void invalidSizesRejected() {
+        assumeTrue(available);
+
+        int[] pixels = randomPixels(16);
+        try (Arena arena = Arena.ofConfined()) {
+            assertThrows(IllegalArgumentException.class,
+                () -> nativeLib.downscaleBox(arena, pixels, 4, 4, 5, 4));
+            assertThrows(IllegalArgumentException.class,
+                () -> nativeLib.downscaleBox(arena, pixels, 4, 4, 0, 2));
+            assertThrows(IllegalArgumentException.class,
+                () -> nativeLib.downscaleLanczos3(arena, pixels, 4, 4, 4, 5));
+        }
+    }
+
+    private static int[] reference(int[] pixels, int width, int height, int dstWidth, int dstHeight) {
+        int[] out = new int[dstWidth * dstHeight];
+        for (int dy = 0; dy < dstHeight; dy++) {
+            int y0 = (int) ((long) dy * height / dstHeight);
+            int y1 = (int) ((long) (dy + 1) * height / dstHeight);
+            for (int dx = 0; dx < dstWidth; dx++) {
+                int x0 = (int) ((long) dx * width / dstWidth);
+                int x1 = (int) ((long) (dx + 1) * width / dstWidth);
+                long[] sum = new long[3];
+                for (int y = y0; y < y1; y++) {
+                    for (int x = x0; x < x1; x++) {
+                        int p = pixels[y * width + x];
+                        sum[0] += (p >> 16) & 0xFF;
+                        sum[1] += (p >> 8) & 0xFF;
+                        sum[2] += p & 0xFF;
+                    }
+                }
+                long count = (long) (x1 - x0) * (y1 - y0);
+                int rgb = 0;
+                for (int c = 0; c < 3; c++) {
+                    rgb = (rgb << 8) | (int) Math.round((double) sum[c] / count);
+                }
+                out[dy * dstWidth + dx] = 0xFF000000 | rgb;
+            }
+        }
+        return out;
+    }
+
+    private static int[] lanczosReference(int[] pixels, int width, int height, int dstWidth, int dstHeight) {
+        double[][] wx = new double[dstWidth][];
+        int[] fx = new int[dstWidth];
+        double[][] wy = new double[dstHeight][];
+        int[] fy = new int[dstHeight];
+        lanczosWeights(dstWidth, width, fx, wx);
+        lanczosWeights(dstHeight, height, fy, wy);
+
+        int[] out = new int[dstWidth * dstHeight];
+        for (int dy = 0; dy < dstHeight; dy++) {
+            for (int dx = 0; dx < dstWidth; dx++) {
+                int rgb = 0;
+                for (int shift = 16; shift >= 0; shift -= 8) {
+                    double v = 0;
+                    for (int ty = 0; ty < wy[dy].length; ty++) {
+                        for (int tx = 0; tx < wx[dx].length; tx++) {
+                            int p = pixels[(fy[dy] + ty) * width + fx[dx] + tx];
+                            v += wy[dy][ty] * wx[dx][tx] * ((p >> shift) & 0xFF);
+                        }
+                    }
+                    rgb = (rgb << 8) | (int) (Math.max(0, Math.min(255, v)) + 0.5);
+                }
+                out[dy * dstWidth + dx] = 0xFF000000 | rgb;
+            }
+        }
+        return out;
+    }
+
+    private static void lanczosWeights(int n, int size, int[] first, double[][] weights) {
+        double scale = (double) size / n;
+        for (int i = 0; i < n; i++) {
+            double center = (i + 0.5) * scale;
+            int lo = Math.max(0, (int) Math.floor(center - 3 * scale));
+            int hi = Math.min(size, (int) Math.ceil(center + 3 * scale));
+            double[] w = new double[hi - lo];
+            double total = 0;
+            for (int j = lo; j < hi; j++) {
+                double x = (j + 0.5 - center) / scale;
+                double px = Math.PI * x;
+                w[j - lo] = x == 0 ? 1 : Math.abs(x) >= 3 ? 0 : 3 * Math.sin(px) * Math.sin(px / 3) / (px * px);
+                total += w[j - lo];
+            }
+            for (int j = 0; j < w.length; j++) w[j] /= total;
+            first[i] = lo;
+            weights[i] = w;
+        }
+    }
+
+    private static int[] randomPixels(int n) {
+        Random rand = new Random(42);
+        int[] pixels = new int[n];
+        for (int i = 0; i < n; i++) {
+            pixels[i] = rand.nextInt();
+        }
+        return pixels;
+    }
+}
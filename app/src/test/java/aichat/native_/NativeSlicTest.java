@@ -0,0 +1,116 @@
+package aichat.native_;
+
+import org.junit.jupiter.api.*;
+
+import java.lang.foreign.*;
+import java.util.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Unit tests for slic_superpixels native function.
+ */
+@DisplayName("Native slic_superpixels Tests")
+class NativeSlicTest {
+
+    private static NativeLibrary nativeLib;
+    private static boolean available;
+
+    @BeforeAll
+    static void setup() {
+        available = NativeLibrary.isAvailable();
+        if (available) {
+            nativeLib = NativeLibrary.getInstance();
+        }
+    }
+
+    @Test
+    @DisplayName("Areas cover every pixel and count stays within the cap")
+    void areasCoverImage() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int width = 640, height = 480;
+            int[] pixels = randomPixels(width * height, 42);
+
+            NativeLibrary.Superpixels result = nativeLib.slicSuperpixels(arena, pixels, width, height, 1000, 10f, 10);
+
+            assertTrue(result.count() > 0 && result.count() <= 1000);
+            double total = 0;
+            for (float area : result.areas()) {
+                total += area;
+            }
+            assertEquals(width * height, total, 0.0);
+        }
+    }
+
+    @Test
+    @DisplayName("Flat regions give their exact colors")
+    void flatRegionsExact() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int width = 400, height = 300;
+            int[] pixels = new int[width * height];
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) {
+                    pixels[y * width + x] = x < width / 2 ? 0xFFC81E32 : 0xFF1450B4;
+                }
+            }
+
+            NativeLibrary.Superpixels result = nativeLib.slicSuperpixels(arena, pixels, width, height, 200, 10f, 10);
+
+            float[] means = result.means();
+            for (int i = 0; i < result.count(); i++) {
+                boolean red = Math.abs(means[i * 3] - 0xC8) < 0.01f
+                    && Math.abs(means[i * 3 + 1] - 0x1E) < 0.01f
+                    && Math.abs(means[i * 3 + 2] - 0x32) < 0.01f;
+                boolean blue = Math.abs(means[i * 3] - 0x14) < 0.01f
+                    && Math.abs(means[i * 3 + 1] - 0x50) < 0.01f
+                    && Math.abs(means[i * 3 + 2] - 0xB4) < 0.01f;
+                assertTrue(red || blue, "superpixel " + i + " mixes both regions");
+            }
+        }
+    }
+
+    @Test
+    @DisplayName("Image smaller than the cap yields one superpixel per pixel")
+    void tinyImage() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = randomPixels(6, 1);
+
+            NativeLibrary.Superpixels result = nativeLib.slicSuperpixels(arena, pixels, 3, 2, 100, 10f, 10);
+
+            assertEquals(6, result.count());
+        }
+    }
+
+    @Test
+    @DisplayName("Same input = same superpixels")
+    void deterministic() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = randomPixels(500 * 400, 7);
+
+            NativeLibrary.Superpixels r1 = nativeLib.slicSuperpixels(arena, pixels, 500, 400, 2000, 10f, 10);
+            NativeLibrary.Superpixels r2 = nativeLib.slicSuperpixels(arena, pixels, 500, 400, 2000, 10f, 10);
+
+            assertEquals(r1.count(), r2.count());
+            assertArrayEquals(r1.means(), r2.means(), 0.0f);
+            assertArrayEquals(r1.areas(), r2.areas(), 0.0f);
+        }
+    }
+
+    private int[] randomPixels(int n, long seed) {
+        int[] pixels = new int[n];
+        Random rand = new Random(seed);
+        for (int i = 0; i < n; i++) {
+            pixels[i] = 0xFF000000 | rand.nextInt(0x1000000);
+        }
+        return pixels;
+    }
+}
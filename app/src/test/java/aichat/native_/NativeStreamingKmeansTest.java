@@ -0,0 +1,147 @@
+package aichat.native_;
+
+import org.junit.jupiter.api.*;
+import org.junit.jupiter.params.ParameterizedTest;
+import org.junit.jupiter.params.provider.ValueSource;
+
+import java.lang.foreign.*;
+import java.util.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Unit tests for kmeans_cluster_image native function.
+ */
+@DisplayName("Native kmeans_cluster_image Tests")
+class NativeStreamingKmeansTest {
+
+    private static NativeLibrary nativeLib;
+    private static boolean available;
+
+    @BeforeAll
+    static void setup() {
+        available = NativeLibrary.isAvailable();
+        if (available) {
+            nativeLib = NativeLibrary.getInstance();
+        }
+    }
+
+    @ParameterizedTest(name = "k={0}")
+    @ValueSource(ints = {2, 4, 8, 16})
+    void returnsKCentroids(int k) {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = randomPixels(200 * 150, 42);
+
+            float[] result = nativeLib.kmeansClusterImage(arena, pixels, k, 30, 0.5f, 42L);
+
+            assertEquals(k * 3, result.length);
+        }
+    }
+
+    @Test
+    @DisplayName("Two flat regions give their exact colors")
+    void flatRegionsExact() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            // Spans several tiles so the per-thread reduction is exercised
+            int[] pixels = new int[300 * 300];
+            for (int i = 0; i < pixels.length; i++) {
+                pixels[i] = i < pixels.length / 2 ? 0xFFC81E32 : 0xFF1450B4;
+            }
+
+            float[] centroids = nativeLib.kmeansClusterImage(arena, pixels, 2, 30, 0.5f, 42L);
+
+            List<float[]> sorted = new ArrayList<>();
+            sorted.add(new float[]{centroids[0], centroids[1], centroids[2]});
+            sorted.add(new float[]{centroids[3], centroids[4], centroids[5]});
+            sorted.sort(Comparator.comparingDouble(c -> c[0]));
+
+            assertArrayEquals(new float[]{0x14, 0x50, 0xB4}, sorted.get(0), 0.001f);
+            assertArrayEquals(new float[]{0xC8, 0x1E, 0x32}, sorted.get(1), 0.001f);
+        }
+    }
+
+    @Test
+    @DisplayName("k=1 returns exact image mean")
+    void k1ReturnsMean() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = randomPixels(100_000, 7);
+
+            double r = 0, g = 0, b = 0;
+            for (int p : pixels) {
+                r += (p >> 16) & 0xFF;
+                g += (p >> 8) & 0xFF;
+                b += p & 0xFF;
+            }
+
+            float[] centroids = nativeLib.kmeansClusterImage(arena, pixels, 1, 30, 0.5f, 42L);
+
+            assertEquals(r / pixels.length, centroids[0], 0.01);
+            assertEquals(g / pixels.length, centroids[1], 0.01);
+            assertEquals(b / pixels.length, centroids[2], 0.01);
+        }
+    }
+
+    @Test
+    @DisplayName("Same seed = same centroids")
+    void sameSeedSameResult() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = randomPixels(100_000, 42);
+
+            float[] r1 = nativeLib.kmeansClusterImage(arena, pixels, 8, 30, 0.5f, 123L);
+            float[] r2 = nativeLib.kmeansClusterImage(arena, pixels, 8, 30, 0.5f, 123L);
+
+            assertArrayEquals(r1, r2, 0.0f);
+        }
+    }
+
+    @Test
+    @DisplayName("Native segment input matches array input")
+    void segmentMatchesArray() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = randomPixels(50_000, 3);
+            MemorySegment segment = arena.allocate(ValueLayout.JAVA_INT, pixels.length);
+            segment.copyFrom(MemorySegment.ofArray(pixels));
+
+            float[] fromArray = nativeLib.kmeansClusterImage(arena, pixels, 6, 30, 0.5f, 42L);
+            float[] fromSegment = nativeLib.kmeansClusterImage(arena, segment, pixels.length, 6, 30, 0.5f, 42L);
+
+            assertArrayEquals(fromArray, fromSegment, 0.0f);
+        }
+    }
+
+    @Test
+    @DisplayName("Centroids within color range")
+    void centroidsWithinRange() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = randomPixels(50_000, 11);
+
+            float[] centroids = nativeLib.kmeansClusterImage(arena, pixels, 12, 30, 0.5f, 42L);
+
+            for (float v : centroids) {
+                assertTrue(v >= 0 && v <= 255);
+            }
+        }
+    }
+
+    private int[] randomPixels(int n, long seed) {
+        int[] pixels = new int[n];
+        Random rand = new Random(seed);
+        for (int i = 0; i < n; i++) {
+            pixels[i] = 0xFF000000 | rand.nextInt(0x1000000);
+        }
+        return pixels;
+    }
+}
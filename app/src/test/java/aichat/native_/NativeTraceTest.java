@@ -0,0 +1,158 @@
+package aichat.native_;
+
+import aichat.model.ColorPalette;
+import aichat.model.ColorPoint;
+import org.junit.jupiter.api.*;
+import org.junit.jupiter.api.io.TempDir;
+
+import java.io.IOException;
+import java.lang.foreign.*;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Unit tests for the native span ring buffers and the Chrome trace export.
+ */
+@DisplayName("Native trace Tests")
+class NativeTraceTest {
+
+    private static NativeLibrary nativeLib;
+    private static boolean available;
+
+    @BeforeAll
+    static void setup() {
+        available = NativeLibrary.isAvailable();
+        if (available) {
+            nativeLib = NativeLibrary.getInstance();
+        }
+    }
+
+    @AfterEach
+    void disableTracing() {
+        if (available) {
+            NativeAccelerator.getInstance().setTracing(false);
+            NativeAccelerator.getInstance().clearTrace();
+        }
+    }
+
+    @Test
+    @DisplayName("Nothing is recorded while tracing is off")
+    void disabledRecordsNothing() {
+        assumeTrue(available);
+
+        nativeLib.setTraceEnabled(false);
+        nativeLib.clearTrace();
+        resynthesize();
+
+        assertTrue(nativeLib.collectTrace().isEmpty());
+    }
+
+    @Test
+    @DisplayName("Resynthesis records LUT build and mapping spans")
+    void resynthesisRecordsPhases() {
+        assumeTrue(available);
+
+        nativeLib.clearTrace();
+        assertTrue(nativeLib.setTraceEnabled(true));
+        resynthesize();
+        nativeLib.setTraceEnabled(false);
+
+        List<NativeLibrary.TraceSpan> spans = nativeLib.collectTrace();
+        Set<String> names = new HashSet<>();
+        for (NativeLibrary.TraceSpan span : spans) {
+            names.add(span.name());
+            assertTrue(span.durationNanos() >= 0);
+            assertTrue(span.threadId() >= 1);
+        }
+        assertTrue(names.contains("resynthesize.lut_build"), names.toString());
+        assertTrue(names.contains("resynthesize.map"), names.toString());
+
+        nativeLib.clearTrace();
+        assertTrue(nativeLib.collectTrace().isEmpty());
+    }
+
+    @Test
+    @DisplayName("Rings of exited threads are reused")
+    void exitedThreadRingsReused() throws InterruptedException {
+        assumeTrue(available);
+
+        nativeLib.clearTrace();
+        int dropped = nativeLib.traceDroppedThreads();
+        assertTrue(nativeLib.setTraceEnabled(true));
+        // More short-lived threads than there are rings, one at a time
+        for (int i = 0; i < 300; i++) {
+            Thread thread = new Thread(NativeTraceTest::resynthesize);
+            thread.start();
+            thread.join();
+        }
+        nativeLib.setTraceEnabled(false);
+
+        assertEquals(dropped, nativeLib.traceDroppedThreads());
+        long threads = nativeLib.collectTrace().stream()
+            .filter(span -> span.name().equals("resynthesize.map"))
+            .mapToInt(NativeLibrary.TraceSpan::threadId)
+            .distinct()
+            .count();
+        assertTrue(threads >= 300, threads + " threads recorded");
+    }
+
+    @Test
+    @DisplayName("Native spans use the System.nanoTime clock")
+    void nativeClockMatchesJava() {
+        assumeTrue(available);
+
+        long before = System.nanoTime();
+        long nativeNow = nativeLib.traceNowNanos();
+        long after = System.nanoTime();
+
+        // Same clock on Linux; elsewhere the exporter measures the offset
+        assumeTrue(System.getProperty("os.name").toLowerCase().contains("linux"));
+        assertTrue(nativeNow >= before && nativeNow <= after,
+            "native " + nativeNow + " outside [" + before + ", " + after + "]");
+    }
+
+    @Test
+    @DisplayName("Chrome trace merges Java and native spans")
+    void chromeTraceMergesJavaAndNative(@TempDir Path dir) throws IOException {
+        assumeTrue(available);
+
+        NativeAccelerator accel = NativeAccelerator.getInstance();
+        assumeTrue(accel.isAvailable());
+        accel.clearTrace();
+        accel.setTracing(true);
+
+        int[] pixels = new int[64 * 64];
+        Random rand = new Random(42);
+        for (int i = 0; i < pixels.length; i++) {
+            pixels[i] = rand.nextInt(0xFFFFFF);
+        }
+        ColorPalette palette = new ColorPalette(List.of(
+            new ColorPoint(0, 0, 0), new ColorPoint(255, 255, 255), new ColorPoint(255, 0, 0)));
+        assertNotNull(accel.resynthesizeImage(pixels, 64, 64, palette, palette));
+        accel.setTracing(false);
+
+        Path file = dir.resolve("trace.json");
+        accel.writeChromeTrace(file);
+        String json = Files.readString(file);
+
+        assertTrue(json.startsWith("{\"displayTimeUnit\""));
+        assertTrue(json.contains("\"name\":\"resynthesizeImage\",\"cat\":\"java\""), json);
+        assertTrue(json.contains("\"name\":\"resynthesize.map\",\"cat\":\"native\""), json);
+    }
+
+    private static void resynthesize() {
+        try (Arena arena = Arena.ofConfined()) {
+            int[] pixels = new int[32 * 32];
+            Random rand = new Random(42);
+            for (int i = 0; i < pixels.length; i++) {
+                pixels[i] = rand.nextInt(0xFFFFFF);
+            }
+            float[] palette = { 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255 };
+            nativeLib.resynthesizeImage(arena, pixels, 32, 32, palette, palette);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+package aichat.native_;
+
+import org.junit.jupiter.api.*;
+import org.junit.jupiter.params.ParameterizedTest;
+import org.junit.jupiter.params.provider.ValueSource;
+
+import java.lang.foreign.*;
+import java.util.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+/**
+ * Unit tests for tsvq_build_palette native function.
+ */
+@DisplayName("Native tsvq_build_palette Tests")
+class NativeTsvqTest {
+
+    private static NativeLibrary nativeLib;
+    private static boolean available;
+
+    @BeforeAll
+    static void setup() {
+        available = NativeLibrary.isAvailable();
+        if (available) {
+            nativeLib = NativeLibrary.getInstance();
+        }
+    }
+
+    @ParameterizedTest(name = "k={0}")
+    @ValueSource(ints = {2, 64, 1024, 8192})
+    void returnsKColors(int k) {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            float[] points = randomPoints(50_000, 42);
+
+            float[] palette = nativeLib.tsvqBuildPalette(arena, points, null, k);
+
+            assertEquals(k * 3, palette.length);
+            for (float v : palette) {
+                assertTrue(v >= 0 && v <= 255);
+            }
+        }
+    }
+
+    @Test
+    @DisplayName("Fewer distinct colors than k gives one entry per color")
+    void stopsAtDistinctColors() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            float[] points = new float[3000 * 3];
+            for (int i = 0; i < 3000; i++) {
+                int c = i % 3;
+                points[i * 3] = c * 100;
+                points[i * 3 + 1] = 50;
+                points[i * 3 + 2] = 200 - c * 50;
+            }
+
+            float[] palette = nativeLib.tsvqBuildPalette(arena, points, null, 16);
+
+            assertEquals(9, palette.length);
+        }
+    }
+
+    @Test
+    @DisplayName("Weights pull a single color to the weighted mean")
+    void weightedMean() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            float[] points = {0, 0, 0, 100, 100, 100};
+            float[] weights = {3, 1};
+
+            float[] palette = nativeLib.tsvqBuildPalette(arena, points, weights, 1);
+
+            assertArrayEquals(new float[]{25, 25, 25}, palette, 0.01f);
+        }
+    }
+
+    @Test
+    @DisplayName("Same input = same palette")
+    void deterministic() {
+        assumeTrue(available);
+
+        try (Arena arena = Arena.ofConfined()) {
+            float[] points = randomPoints(100_000, 7);
+
+            float[] r1 = nativeLib.tsvqBuildPalette(arena, points, null, 2048);
+            float[] r2 = nativeLib.tsvqBuildPalette(arena, points, null, 2048);
+
+            assertArrayEquals(r1, r2, 0.0f);
+        }
+    }
+
+    private float[] randomPoints(int n, long seed) {
+        float[] points = new float[n * 3];
+        Random rand = new Random(seed);
+        for (int i = 0; i < points.length; i++) {
+            points[i] = rand.nextFloat() * 255;
+        }
+        return points;
+    }
+}
@@ -0,0 +1,677 @@
+// Standalone microbenchmarks for the native kernels, without FFM marshalling.
+// Built and run by `make bench` (or bench-scalar / bench-simd / bench-openmp);
+// prints one JSON document with per-case latency percentiles and throughput.
+// With --counters (Linux) each case also reports hardware counters per run.
+
+#include "../include/common.h"
+#include "../include/distance.h"
+#include "../include/kmeans.h"
+#include "../include/hybrid.h"
+#include "../include/color.h"
+#include "../include/image.h"
+#include "../include/resample.h"
+#include "../include/transfer.h"
+#include "../include/slic.h"
+#include "../include/tsvq.h"
+#include "../include/random.h"
+#include "../include/metrics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(VARIANT_SCALAR)
+#define BENCH_VARIANT "scalar"
+#elif defined(VARIANT_SIMD)
+#define BENCH_VARIANT "simd"
+#elif defined(VARIANT_OPENMP)
+#define BENCH_VARIANT "openmp"
+#else
+#define BENCH_VARIANT "default"
+#endif
+
+#define BENCH_SEED 42
+#define BENCH_CLUSTERS 32
+
+enum {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_COUNT
+};
+
+static const char* const COUNTER_NAMES[COUNTER_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+// One perf_event fd per counter, -1 where it could not be opened
+typedef struct {
+    int fd[COUNTER_COUNT];
+    int open;
+} Counters;
+
+// Raw read with PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+typedef struct {
+    uint64_t value;
+    uint64_t enabled;
+    uint64_t running;
+} CounterReading;
+
+typedef struct {
+    int reps;
+    int warmup;
+    int quick;
+    const char* filter;
+    FILE* out;
+    int cases;
+    Counters* counters;  // NULL without --counters or when none could be opened
+} Bench;
+
+typedef struct {
+    int n, k;
+    int width, height;
+    ColorPoint3f* points;
+    ColorPoint3f* centroids;
+    ColorPoint3f* output;
+    int* assignments;
+    float* areas;
+    float eps;
+    uint32_t* image;
+    uint32_t* out_image;
+    ColorPoint3f* palette;
+    ColorPoint3f* source_palette;
+    float stats[LAB_STATS_SIZE];
+    float source_stats[LAB_STATS_SIZE];
+#ifdef HAVE_TURBOJPEG
+    unsigned char* jpeg;
+    unsigned long jpeg_size;
+#endif
+} BenchArgs;
+
+typedef void (*BenchFn)(BenchArgs* args);
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+#ifdef __linux__
+static int open_counter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // User space only, which perf_event_paranoid <= 2 allows; inherited by
+    // threads created later, so the OpenMP pool is counted too
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+// Opens the counters for this process. Must run before the first OpenMP
+// region so the pool threads inherit them. Returns NULL, after saying why on
+// stderr, when no counter is available (containers often forbid them).
+static Counters* counters_open(void) {
+#ifdef __linux__
+    static Counters counters;
+    const struct { uint32_t type; uint64_t config; } events[COUNTER_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    int first_errno = 0;
+    counters.open = 0;
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        counters.fd[c] = open_counter(events[c].type, events[c].config);
+        if (counters.fd[c] >= 0) {
+            counters.open++;
+        } else if (!first_errno) {
+            first_errno = errno;
+        }
+    }
+    if (counters.open > 0) {
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            if (counters.fd[c] < 0) fprintf(stderr, "bench: counter %s unavailable\n", COUNTER_NAMES[c]);
+        }
+        return &counters;
+    }
+
+    fprintf(stderr, "bench: no hardware counters (%s; see /proc/sys/kernel/perf_event_paranoid), "
+                    "timing only\n", strerror(first_errno));
+    return NULL;
+#else
+    fprintf(stderr, "bench: hardware counters need Linux perf_event, timing only\n");
+    return NULL;
+#endif
+}
+
+static void counters_read(const Counters* counters, CounterReading* readings) {
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        readings[c].value = readings[c].enabled = readings[c].running = 0;
+#ifdef __linux__
+        if (counters->fd[c] >= 0 && read(counters->fd[c], &readings[c], sizeof(CounterReading))
+                != (ssize_t)sizeof(CounterReading)) {
+            readings[c].running = 0;
+        }
+#endif
+    }
+}
+
+// Count between two readings, scaled up for the share of time the kernel
+// had the counter scheduled; NAN when it never was
+static double counter_delta(const CounterReading* before, const CounterReading* after) {
+    uint64_t running = after->running - before->running;
+    if (running == 0) return NAN;
+    double enabled = (double)(after->enabled - before->enabled);
+    return (double)(after->value - before->value) * (enabled / (double)running);
+}
+
+static void json_number(FILE* out, const char* key, double value, int decimals) {
+    if (isnan(value)) {
+        fprintf(out, ", \"%s\": null", key);
+    } else {
+        fprintf(out, ", \"%s\": %.*f", key, decimals, value);
+    }
+}
+
+// Per-run counter values; miss counts are also given per item (pixel or
+// point) so cases of different sizes compare
+static void write_counters(FILE* out, const double* per_run, double items) {
+    double ipc = per_run[COUNTER_INSTRUCTIONS] / per_run[COUNTER_CYCLES];
+
+    fprintf(out, ", \"counters\": {\"cycles\": ");
+    if (isnan(per_run[COUNTER_CYCLES])) {
+        fprintf(out, "null");
+    } else {
+        fprintf(out, "%.0f", per_run[COUNTER_CYCLES]);
+    }
+    for (int c = COUNTER_INSTRUCTIONS; c < COUNTER_COUNT; c++) {
+        json_number(out, COUNTER_NAMES[c], per_run[c], 0);
+    }
+    json_number(out, "ipc", ipc, 3);
+    json_number(out, "l1d_misses_per_item", per_run[COUNTER_L1D_MISSES] / items, 4);
+    json_number(out, "llc_misses_per_item", per_run[COUNTER_LLC_MISSES] / items, 4);
+    json_number(out, "branch_misses_per_item", per_run[COUNTER_BRANCH_MISSES] / items, 4);
+    fprintf(out, "}");
+}
+
+// Linear interpolation between closest ranks of sorted samples
+static double percentile(const double* sorted, int count, double p) {
+    if (count == 1) return sorted[0];
+    double rank = p * (count - 1);
+    int lo = (int)rank;
+    int hi = lo + 1 < count ? lo + 1 : lo;
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+}
+
+// Times fn over bench->reps runs after bench->warmup untimed runs and writes
+// one JSON result object. `items` is the work per run behind the throughput.
+static void run_case(Bench* bench, const char* name, const char* params,
+                     double items, const char* unit, BenchFn fn, BenchArgs* args) {
+    if (bench->filter && !strstr(name, bench->filter)) return;
+
+    for (int i = 0; i < bench->warmup; i++) {
+        fn(args);
+    }
+
+    double* samples = (double*)malloc(bench->reps * sizeof(double));
+    if (!samples) return;
+
+    CounterReading before[COUNTER_COUNT], after[COUNTER_COUNT];
+    if (bench->counters) counters_read(bench->counters, before);
+
+    double total = 0;
+    for (int i = 0; i < bench->reps; i++) {
+        double start = now_ms();
+        fn(args);
+        samples[i] = now_ms() - start;
+        total += samples[i];
+    }
+
+    double per_run[COUNTER_COUNT];
+    if (bench->counters) {
+        counters_read(bench->counters, after);
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            per_run[c] = counter_delta(&before[c], &after[c]) / bench->reps;
+        }
+    }
+    qsort(samples, bench->reps, sizeof(double), compare_doubles);
+
+    double median = percentile(samples, bench->reps, 0.5);
+    fprintf(bench->out,
+        "%s    {\"name\": \"%s\", \"params\": {%s}, "
+        "\"median_ms\": %.4f, \"p10_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, "
+        "\"min_ms\": %.4f, \"max_ms\": %.4f, \"mean_ms\": %.4f, "
+        "\"throughput\": %.1f, \"unit\": \"%s\"",
+        bench->cases > 0 ? ",\n" : "", name, params,
+        median, percentile(samples, bench->reps, 0.1), percentile(samples, bench->reps, 0.9),
+        percentile(samples, bench->reps, 0.99), samples[0], samples[bench->reps - 1],
+        total / bench->reps, median > 0 ? items / (median / 1e3) : 0.0, unit);
+    if (bench->counters) {
+        write_counters(bench->out, per_run, items);
+    }
+    fprintf(bench->out, "}");
+    fflush(bench->out);
+    bench->cases++;
+
+    if (bench->counters) {
+        fprintf(stderr, "  %-28s %-36s median %10.3f ms  ipc %5.2f  llc/item %8.4f\n", name, params, median,
+                per_run[COUNTER_INSTRUCTIONS] / per_run[COUNTER_CYCLES], per_run[COUNTER_LLC_MISSES] / items);
+    } else {
+        fprintf(stderr, "  %-28s %-36s median %10.3f ms\n", name, params, median);
+    }
+    free(samples);
+}
+
+// Colors drawn around BENCH_CLUSTERS centers with 10% uniform noise, close
+// to what sampled photographs hand the clustering code
+static void fill_points(ColorPoint3f* points, int n, uint64_t seed) {
+    XorShift64 rng;
+    xorshift64_init(&rng, seed);
+
+    ColorPoint3f centers[BENCH_CLUSTERS];
+    for (int c = 0; c < BENCH_CLUSTERS; c++) {
+        centers[c].c1 = (float)(xorshift64_double(&rng) * 255.0);
+        centers[c].c2 = (float)(xorshift64_double(&rng) * 255.0);
+        centers[c].c3 = (float)(xorshift64_double(&rng) * 255.0);
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (xorshift64_int(&rng, 10) == 0) {
+            points[i].c1 = (float)(xorshift64_double(&rng) * 255.0);
+            points[i].c2 = (float)(xorshift64_double(&rng) * 255.0);
+            points[i].c3 = (float)(xorshift64_double(&rng) * 255.0);
+            continue;
+        }
+        const ColorPoint3f* c = &centers[xorshift64_int(&rng, BENCH_CLUSTERS)];
+        points[i].c1 = fminf(255.0f, fmaxf(0.0f, c->c1 + (float)(xorshift64_double(&rng) * 24.0 - 12.0)));
+        points[i].c2 = fminf(255.0f, fmaxf(0.0f, c->c2 + (float)(xorshift64_double(&rng) * 24.0 - 12.0)));
+        points[i].c3 = fminf(255.0f, fmaxf(0.0f, c->c3 + (float)(xorshift64_double(&rng) * 24.0 - 12.0)));
+    }
+}
+
+// Smooth gradients with a few flat blocks and light noise
+static void fill_image(uint32_t* image, int width, int height, uint64_t seed) {
+    XorShift64 rng;
+    xorshift64_init(&rng, seed);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int r = x * 255 / width;
+            int g = y * 255 / height;
+            int b = ((x / 128 + y / 128) & 1) ? 200 : (x + y) * 255 / (width + height);
+            r += xorshift64_int(&rng, 9) - 4;
+            r = r < 0 ? 0 : (r > 255 ? 255 : r);
+            image[(size_t)y * width + x] = 0xFF000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+        }
+    }
+}
+
+static void fill_palette(ColorPoint3f* palette, int k, uint64_t seed) {
+    XorShift64 rng;
+    xorshift64_init(&rng, seed);
+    for (int i = 0; i < k; i++) {
+        palette[i].c1 = (float)(xorshift64_double(&rng) * 255.0);
+        palette[i].c2 = (float)(xorshift64_double(&rng) * 255.0);
+        palette[i].c3 = (float)(xorshift64_double(&rng) * 255.0);
+    }
+}
+
+static void bench_assign(BenchArgs* a) {
+    assign_points_batch(a->points, a->n, a->centroids, a->k, a->assignments);
+}
+
+static void bench_kmeans(BenchArgs* a) {
+    kmeans_cluster(a->points, a->n, a->k, 20, 0.5f, a->centroids, a->assignments, BENCH_SEED);
+}
+
+static void bench_hybrid(BenchArgs* a) {
+    hybrid_cluster(a->points, a->n, a->k, 1000, a->eps, 3, 100, 0.5f, a->centroids, BENCH_SEED);
+}
+
+static void bench_tsvq(BenchArgs* a) {
+    tsvq_build_palette(a->points, NULL, a->n, a->k, a->centroids);
+}
+
+static void bench_rgb_to_lab(BenchArgs* a) {
+    rgb_to_lab_batch(a->points, a->output, a->n);
+}
+
+static void bench_lab_to_rgb(BenchArgs* a) {
+    lab_to_rgb_batch(a->output, a->points, a->n);
+}
+
+static void bench_extract(BenchArgs* a) {
+    extract_pixels(a->image, a->width * a->height, a->output);
+}
+
+static void bench_sample(BenchArgs* a) {
+    sample_pixels_from_image(a->image, a->width * a->height, a->output, a->n, BENCH_SEED);
+}
+
+static void bench_lut_build(BenchArgs* a) {
+    metrics_free(build_palette_lut(a->palette, a->k, PALETTE_LUT_BITS));
+}
+
+static void bench_resynthesize(BenchArgs* a) {
+    resynthesize_image(a->image, a->width, a->height, a->palette, a->source_palette, a->k, a->out_image);
+}
+
+static void bench_posterize(BenchArgs* a) {
+    posterize_image(a->image, a->width, a->height, a->palette, a->source_palette, a->k, a->out_image);
+}
+
+static void bench_downscale_box(BenchArgs* a) {
+    downscale_box(a->image, a->width, a->height, a->out_image, a->width / 4, a->height / 4);
+}
+
+static void bench_downscale_lanczos3(BenchArgs* a) {
+    downscale_lanczos3(a->image, a->width, a->height, a->out_image, a->width / 4, a->height / 4);
+}
+
+static void bench_lab_statistics(BenchArgs* a) {
+    lab_statistics(a->image, a->width, a->height, 1 << 18, a->stats);
+}
+
+static void bench_reinhard_transfer(BenchArgs* a) {
+    reinhard_transfer(a->image, a->width, a->height, a->source_stats, a->stats, a->out_image);
+}
+
+static void bench_kmeans_image(BenchArgs* a) {
+    kmeans_cluster_image(a->image, a->width * a->height, a->k, 20, 0.5f, a->centroids, BENCH_SEED);
+}
+
+static void bench_slic(BenchArgs* a) {
+    slic_superpixels(a->image, a->width, a->height, a->k, 10.0f, 10, a->output, a->areas);
+}
+
+#ifdef HAVE_TURBOJPEG
+static void bench_jpeg_encode(BenchArgs* a) {
+    unsigned char* jpeg = NULL;
+    unsigned long size = 0;
+    if (turbojpeg_encode(a->image, a->width, a->height, 90, &jpeg, &size) == 0) {
+        tjFree(jpeg);
+    }
+}
+
+static void bench_jpeg_decode(BenchArgs* a) {
+    int width, height;
+    uint32_t* pixels = NULL;
+    if (turbojpeg_decode_buffer(a->jpeg, a->jpeg_size, &width, &height, &pixels) == 0) {
+        turbojpeg_free(pixels);
+    }
+}
+#endif
+
+static void run_point_benchmarks(Bench* bench) {
+    static const int sizes[] = { 10000, 100000, 1000000 };
+    static const int ks[] = { 8, 64, 256 };
+    int num_sizes = bench->quick ? 1 : 3;
+    int num_ks = bench->quick ? 1 : 3;
+    int max_n = sizes[num_sizes - 1];
+
+    BenchArgs a = {0};
+    a.points = (ColorPoint3f*)malloc((size_t)max_n * sizeof(ColorPoint3f));
+    a.output = (ColorPoint3f*)malloc((size_t)max_n * sizeof(ColorPoint3f));
+    a.assignments = (int*)malloc((size_t)max_n * sizeof(int));
+    a.centroids = (ColorPoint3f*)malloc(4096 * sizeof(ColorPoint3f));
+    if (!a.points || !a.output || !a.assignments || !a.centroids) {
+        fprintf(stderr, "bench: out of memory\n");
+        exit(1);
+    }
+
+    char params[128];
+    for (int s = 0; s < num_sizes; s++) {
+        a.n = sizes[s];
+        fill_points(a.points, a.n, BENCH_SEED);
+
+        for (int j = 0; j < num_ks; j++) {
+            a.k = ks[j];
+            fill_palette(a.centroids, a.k, BENCH_SEED + 1);
+            snprintf(params, sizeof(params), "\"n\": %d, \"k\": %d", a.n, a.k);
+            run_case(bench, "assign_points_batch", params, a.n, "points/s", bench_assign, &a);
+        }
+
+        // Full clustering runs are only timed up to 100k points
+        if (a.n > 100000) continue;
+
+        for (int j = 0; j < num_ks && ks[j] <= 64; j++) {
+            a.k = ks[j];
+            snprintf(params, sizeof(params), "\"n\": %d, \"k\": %d", a.n, a.k);
+            run_case(bench, "kmeans_cluster", params, a.n, "points/s", bench_kmeans, &a);
+
+            a.eps = hybrid_calculate_dbscan_eps(a.points, a.n, 1000, 3, BENCH_SEED);
+            run_case(bench, "hybrid_cluster", params, a.n, "points/s", bench_hybrid, &a);
+        }
+
+        for (int j = 0; j < num_ks; j++) {
+            a.k = ks[j] * 16;
+            snprintf(params, sizeof(params), "\"n\": %d, \"k\": %d", a.n, a.k);
+            run_case(bench, "tsvq_build_palette", params, a.n, "points/s", bench_tsvq, &a);
+        }
+    }
+
+    for (int s = bench->quick ? 0 : 1; s < num_sizes; s++) {
+        a.n = sizes[s];
+        fill_points(a.points, a.n, BENCH_SEED);
+        snprintf(params, sizeof(params), "\"n\": %d", a.n);
+        run_case(bench, "rgb_to_lab_batch", params, a.n, "colors/s", bench_rgb_to_lab, &a);
+        rgb_to_lab_batch(a.points, a.output, a.n);
+        run_case(bench, "lab_to_rgb_batch", params, a.n, "colors/s", bench_lab_to_rgb, &a);
+    }
+
+    free(a.points);
+    free(a.output);
+    free(a.assignments);
+    free(a.centroids);
+}
+
+static void run_image_benchmarks(Bench* bench) {
+    static const int widths[] = { 1024, 2048 };
+    static const int heights[] = { 1024, 2048 };
+    static const int palette_sizes[] = { 16, 256, 4096, 16384 };
+    int num_images = bench->quick ? 1 : 2;
+    int num_palettes = bench->quick ? 2 : 4;
+    size_t max_pixels = (size_t)widths[num_images - 1] * heights[num_images - 1];
+
+    BenchArgs a = {0};
+    a.image = (uint32_t*)malloc(max_pixels * sizeof(uint32_t));
+    a.out_image = (uint32_t*)malloc(max_pixels * sizeof(uint32_t));
+    a.output = (ColorPoint3f*)malloc(max_pixels * sizeof(ColorPoint3f));
+    a.areas = (float*)malloc(4096 * sizeof(float));
+    a.centroids = (ColorPoint3f*)malloc(4096 * sizeof(ColorPoint3f));
+    a.palette = (ColorPoint3f*)malloc(16384 * sizeof(ColorPoint3f));
+    a.source_palette = (ColorPoint3f*)malloc(16384 * sizeof(ColorPoint3f));
+    if (!a.image || !a.out_image || !a.output || !a.areas || !a.centroids || !a.palette || !a.source_palette) {
+        fprintf(stderr, "bench: out of memory\n");
+        exit(1);
+    }
+    fill_palette(a.palette, 16384, BENCH_SEED + 2);
+    fill_palette(a.source_palette, 16384, BENCH_SEED + 3);
+
+    char params[128];
+    for (int p = 0; p < num_palettes && palette_sizes[p] <= 4096; p++) {
+        a.k = palette_sizes[p];
+        snprintf(params, sizeof(params), "\"palette\": %d", a.k);
+        run_case(bench, "build_palette_lut", params, PALETTE_LUT_SIZE, "cells/s", bench_lut_build, &a);
+    }
+
+    for (int s = 0; s < num_images; s++) {
+        a.width = widths[s];
+        a.height = heights[s];
+        double pixels = (double)a.width * a.height;
+        fill_image(a.image, a.width, a.height, BENCH_SEED);
+
+        snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d", a.width, a.height);
+        run_case(bench, "extract_pixels", params, pixels, "pixels/s", bench_extract, &a);
+
+        a.n = 10000;
+        snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"samples\": %d", a.width, a.height, a.n);
+        run_case(bench, "sample_pixels_from_image", params, pixels, "pixels/s", bench_sample, &a);
+
+        for (int p = 0; p < num_palettes; p++) {
+            a.k = palette_sizes[p];
+            snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"palette\": %d", a.width, a.height, a.k);
+            run_case(bench, "resynthesize_image", params, pixels, "pixels/s", bench_resynthesize, &a);
+            run_case(bench, "posterize_image", params, pixels, "pixels/s", bench_posterize, &a);
+        }
+
+        snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"scale\": 4", a.width, a.height);
+        run_case(bench, "downscale_box", params, pixels, "pixels/s", bench_downscale_box, &a);
+        run_case(bench, "downscale_lanczos3", params, pixels, "pixels/s", bench_downscale_lanczos3, &a);
+
+        // Toward a warmer, higher-contrast look than the test image
+        lab_statistics(a.image, a.width, a.height, 1 << 18, a.stats);
+        for (int c = 0; c < LAB_STATS_SIZE; c++) {
+            a.source_stats[c] = a.stats[c] * (c < 3 ? 1.0f : 1.2f);
+        }
+        a.source_stats[2] += 10.0f;
+        snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"samples\": %d", a.width, a.height, 1 << 18);
+        run_case(bench, "lab_statistics", params, pixels, "pixels/s", bench_lab_statistics, &a);
+        snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"lut\": %d", a.width, a.height, TRANSFER_LUT_SIZE);
+        run_case(bench, "reinhard_transfer", params, pixels, "pixels/s", bench_reinhard_transfer, &a);
+
+        static const int image_ks[] = { 8, 64 };
+        for (int j = 0; j < (bench->quick ? 1 : 2); j++) {
+            a.k = image_ks[j];
+            snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"k\": %d", a.width, a.height, a.k);
+            run_case(bench, "kmeans_cluster_image", params, pixels, "pixels/s", bench_kmeans_image, &a);
+        }
+
+        a.k = 4096;
+        snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"superpixels\": %d", a.width, a.height, a.k);
+        run_case(bench, "slic_superpixels", params, pixels, "pixels/s", bench_slic, &a);
+
+#ifdef HAVE_TURBOJPEG
+        snprintf(params, sizeof(params), "\"width\": %d, \"height\": %d, \"quality\": 90", a.width, a.height);
+        run_case(bench, "turbojpeg_encode", params, pixels, "pixels/s", bench_jpeg_encode, &a);
+
+        a.jpeg = NULL;
+        a.jpeg_size = 0;
+        if (turbojpeg_encode(a.image, a.width, a.height, 90, &a.jpeg, &a.jpeg_size) == 0) {
+            run_case(bench, "turbojpeg_decode_buffer", params, pixels, "pixels/s", bench_jpeg_decode, &a);
+            tjFree(a.jpeg);
+        }
+#endif
+    }
+
+    free(a.image);
+    free(a.out_image);
+    free(a.output);
+    free(a.areas);
+    free(a.centroids);
+    free(a.palette);
+    free(a.source_palette);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+        "usage: %s [--reps N] [--warmup N] [--quick] [--filter NAME] [--output FILE] [--counters]\n", program);
+}
+
+int main(int argc, char** argv) {
+    Bench bench = { 7, 2, 0, NULL, stdout, 0, NULL };
+    const char* output = NULL;
+    int counters = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--reps") && i + 1 < argc) {
+            bench.reps = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--warmup") && i + 1 < argc) {
+            bench.warmup = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--quick")) {
+            bench.quick = 1;
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            bench.filter = argv[++i];
+        } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (!strcmp(argv[i], "--counters")) {
+            counters = 1;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (bench.reps < 1) bench.reps = 1;
+    if (bench.warmup < 0) bench.warmup = 0;
+
+    // Every resynthesis rep times a LUT build, not a cache hit
+    aichat_lut_cache_enable(0);
+
+    // Before omp_get_max_threads() or any kernel starts the OpenMP pool
+    if (counters) {
+        bench.counters = counters_open();
+    }
+
+    if (output) {
+        bench.out = fopen(output, "w");
+        if (!bench.out) {
+            fprintf(stderr, "bench: cannot write %s\n", output);
+            return 1;
+        }
+    }
+
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+
+    fprintf(stderr, "AICHAT native bench: variant %s, %d thread(s), %d reps\n",
+            BENCH_VARIANT, threads, bench.reps);
+
+    fprintf(bench.out,
+        "{\n  \"library_version\": \"%s\",\n  \"variant\": \"%s\",\n  \"simd\": %d,\n"
+        "  \"turbojpeg\": %d,\n  \"threads\": %d,\n  \"reps\": %d,\n  \"warmup\": %d,\n  \"counters\": %d,\n"
+        "  \"results\": [\n",
+        aichat_native_version(), BENCH_VARIANT, aichat_has_simd(),
+#ifdef HAVE_TURBOJPEG
+        1,
+#else
+        0,
+#endif
+        threads, bench.reps, bench.warmup, bench.counters ? bench.counters->open : 0);
+
+    run_point_benchmarks(&bench);
+    run_image_benchmarks(&bench);
+
+    fprintf(bench.out, "\n  ]\n}\n");
+
+    if (output) {
+        fclose(bench.out);
+    }
+    return 0;
+}
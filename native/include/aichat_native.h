@@ -7,5 +7,7 @@
 #include "kmeans.h"
 #include "color.h"
 #include "image.h"
+#include "resample.h"
+#include "transfer.h"
 
 #endif // AICHAT_NATIVE_H
@@ -19,6 +19,12 @@ AICHAT_EXPORT void lab_to_rgb_batch(
     int n
 );
 
+// Single-color conversions behind the batch functions, for callers that
+// convert inside their own parallel loops. lab_to_rgb_single clamps to
+// [0, 255].
+void rgb_to_lab_single(const ColorPoint3f* rgb, ColorPoint3f* lab);
+void lab_to_rgb_single(const ColorPoint3f* lab, ColorPoint3f* rgb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,6 +53,14 @@ AICHAT_EXPORT const char* aichat_native_version(void);
 AICHAT_EXPORT int aichat_has_simd(void);
 AICHAT_EXPORT int aichat_has_opencl(void);
 
+// Does nothing and returns n; a baseline for measuring downcall overhead
+AICHAT_EXPORT int aichat_noop(const void* data, int n);
+
+// Sets the OpenMP thread count used by later calls from the calling thread
+// (n <= 0 leaves it unchanged) and returns the count now in effect; always 1
+// without OpenMP.
+AICHAT_EXPORT int aichat_set_num_threads(int n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,12 @@
 extern "C" {
 #endif
 
+// Upper bound on the representatives handed to the final k-means
+#define HYBRID_DEFAULT_MAX_REPRESENTATIVES 2048
+
+// Global grid DBSCAN over all points, then weighted k-means on the cluster
+// representatives (per-cell cluster centroids plus noise points, weighted by
+// the number of points they stand for).
 AICHAT_EXPORT int hybrid_cluster(
     const ColorPoint3f* points,
     int n,
@@ -21,6 +27,23 @@ AICHAT_EXPORT int hybrid_cluster(
     uint64_t seed
 );
 
+// As hybrid_cluster, with at most max_representatives representatives
+// (0 = default). Noise is grid-merged as needed to stay under the cap, so
+// the final k-means cost is bounded however noisy the input is.
+AICHAT_EXPORT int hybrid_cluster_bounded(
+    const ColorPoint3f* points,
+    int n,
+    int k,
+    int block_size,
+    float dbscan_eps,
+    int dbscan_min_pts,
+    int kmeans_max_iter,
+    float kmeans_threshold,
+    int max_representatives,
+    ColorPoint3f* centroids,
+    uint64_t seed
+);
+
 AICHAT_EXPORT float hybrid_calculate_dbscan_eps(
     const ColorPoint3f* points,
     int n,
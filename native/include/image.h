@@ -21,6 +21,27 @@ AICHAT_EXPORT int sample_pixels(
     uint64_t seed
 );
 
+// RGB lookup table shared by resynthesize_image and posterize_image:
+// PALETTE_LUT_BITS per channel, one uint16_t palette index per cell
+#define PALETTE_LUT_BITS 7
+#define PALETTE_LUT_DIM (1 << PALETTE_LUT_BITS)
+#define PALETTE_LUT_SIZE (PALETTE_LUT_DIM * PALETTE_LUT_DIM * PALETTE_LUT_DIM)
+#define PALETTE_LUT_SHIFT (8 - PALETTE_LUT_BITS)
+#define PALETTE_LUT_MIN_BITS 4
+#define PALETTE_LUT_MAX_BITS 8
+
+// Nearest palette index for every cell of a LUT with `bits` per channel
+// (palettes up to 65536 colors). Returns NULL on allocation failure; the
+// caller releases the table with metrics_free.
+uint16_t* build_palette_lut(const ColorPoint3f* palette, int palette_size, int bits);
+
+// resynthesize_image and posterize_image keep the last LUT they built (up to
+// PALETTE_LUT_BITS) and reuse it while the target palette is unchanged, so
+// tiled and repeated calls build it once. On by default; disabling it also
+// drops the cached table.
+AICHAT_EXPORT void aichat_lut_cache_enable(int enabled);
+AICHAT_EXPORT void aichat_lut_cache_clear(void);
+
 AICHAT_EXPORT void resynthesize_image(
     const uint32_t* image_pixels,
     int width,
@@ -31,6 +52,20 @@ AICHAT_EXPORT void resynthesize_image(
     uint32_t* output_pixels
 );
 
+// resynthesize_image with a LUT of lut_bits per channel, clamped to
+// [PALETTE_LUT_MIN_BITS, PALETTE_LUT_MAX_BITS]. 8 bits maps every input
+// color exactly; fewer bits build faster but snap colors to coarser cells.
+AICHAT_EXPORT void resynthesize_image_lut_bits(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    const ColorPoint3f* target_palette,
+    const ColorPoint3f* source_palette,
+    int palette_size,
+    int lut_bits,
+    uint32_t* output_pixels
+);
+
 AICHAT_EXPORT void posterize_image(
     const uint32_t* image_pixels,
     int width,
@@ -67,6 +102,14 @@ AICHAT_EXPORT int turbojpeg_decode_and_sample(
     int* out_height
 );
 
+AICHAT_EXPORT int turbojpeg_decode_buffer(
+    const unsigned char* jpeg_data,
+    unsigned long jpeg_size,
+    int* out_width,
+    int* out_height,
+    uint32_t** out_pixels
+);
+
 AICHAT_EXPORT int decode_jpeg_file_turbojpeg(
     const char* path,
     int* out_width,
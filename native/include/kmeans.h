@@ -42,6 +42,33 @@ AICHAT_EXPORT int kmeans_cluster(
     uint64_t seed
 );
 
+// K-means where each point counts with the given (positive) weight, e.g.
+// representatives standing in for many samples.
+AICHAT_EXPORT int kmeans_cluster_weighted(
+    const ColorPoint3f* points,
+    const float* weights,
+    int n,
+    int k,
+    int max_iterations,
+    float convergence_threshold,
+    ColorPoint3f* centroids,
+    int* assignments,
+    uint64_t seed
+);
+
+// Exact Lloyd iterations over every pixel of an ARGB buffer. Pixels are
+// streamed in cache-sized tiles; no assignment array is kept and centroid
+// sums are accumulated in integers. Returns the number of iterations run.
+AICHAT_EXPORT int kmeans_cluster_image(
+    const uint32_t* image_pixels,
+    int n,
+    int k,
+    int max_iterations,
+    float convergence_threshold,
+    ColorPoint3f* centroids,
+    uint64_t seed
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,123 @@
+#ifndef AICHAT_METRICS_H
+#define AICHAT_METRICS_H
+
+#include "common.h"
+#include "trace.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Always-on counters. Each exported call costs two clock reads and a few
+// relaxed atomic adds on the calling thread; nothing is counted per pixel.
+// Calls nested inside another counted call (hybrid's final k-means, say)
+// are not counted again.
+typedef enum {
+    METRICS_OP_KMEANS = 0,
+    METRICS_OP_HYBRID,
+    METRICS_OP_SLIC,
+    METRICS_OP_TSVQ,
+    METRICS_OP_SAMPLE,
+    METRICS_OP_COLOR_CONVERT,
+    METRICS_OP_RESYNTHESIZE,
+    METRICS_OP_POSTERIZE,
+    METRICS_OP_JPEG_DECODE,
+    METRICS_OP_JPEG_ENCODE,
+    METRICS_OP_GPU_RESYNTHESIZE,
+    METRICS_OP_RESAMPLE,
+    METRICS_OP_TRANSFER,
+    METRICS_OP_COUNT
+} MetricsOp;
+
+// Latency bucket i counts calls shorter than 2^i microseconds; the last
+// bucket also takes everything longer
+#define METRICS_LATENCY_BUCKETS 24
+
+typedef struct {
+    uint32_t op_count;         // METRICS_OP_COUNT, filled in by the snapshot
+    uint32_t latency_buckets;  // METRICS_LATENCY_BUCKETS, likewise
+    uint64_t calls[METRICS_OP_COUNT];
+    uint64_t call_ns[METRICS_OP_COUNT];
+    uint64_t items[METRICS_OP_COUNT];  // pixels or points processed
+    uint64_t latency[METRICS_OP_COUNT][METRICS_LATENCY_BUCKETS];
+    uint64_t lut_builds;
+    uint64_t lut_cache_hits;
+    uint64_t bytes_allocated;  // working buffers, cumulative
+    uint64_t omp_regions;      // parallel regions entered, serialized ones included
+    uint64_t gpu_fallbacks;    // GPU calls that failed and left the work to the CPU path
+} AichatMetrics;
+
+extern AichatMetrics aichat_metrics;
+
+static inline void metrics_add(uint64_t* counter, uint64_t value) {
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+// Start of a counted call, or 0 when already inside one on this thread
+uint64_t metrics_call_begin(void);
+void metrics_call_end(MetricsOp op, uint64_t start_ns, uint64_t items);
+
+#define METRICS_OMP_REGION() metrics_add(&aichat_metrics.omp_regions, 1)
+
+// Owners of working buffers, for the allocation tracker
+typedef enum {
+    MEM_KMEANS = 0,
+    MEM_HYBRID,   // block DBSCAN grid and representatives
+    MEM_LUT,
+    MEM_SLIC,
+    MEM_TSVQ,
+    MEM_JPEG,     // decode/encode scratch and decoded images
+    MEM_RESAMPLE, // per-thread row buffers and filter weights
+    MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+// Working-buffer allocation: counted in bytes_allocated and, while the
+// tracker is on, in the current/peak bytes of `subsystem` and of the
+// calling thread's counted call. Memory from these must be released with
+// metrics_free, never free.
+void* metrics_malloc(MemSubsystem subsystem, size_t size);
+void* metrics_calloc(MemSubsystem subsystem, size_t count, size_t size);
+void metrics_free(void* ptr);
+
+// Copies the counters into `out` (at most `size` bytes of it) and returns
+// sizeof(AichatMetrics), so a NULL/0 call sizes the buffer. The copy is not
+// atomic as a whole: counters bumped meanwhile may be off by those calls.
+AICHAT_EXPORT int aichat_metrics_snapshot(AichatMetrics* out, int size);
+AICHAT_EXPORT void aichat_metrics_reset(void);
+
+// Stable lowercase name of an op ("kmeans", "resynthesize", ...), NULL past the end
+AICHAT_EXPORT const char* aichat_metrics_op_name(int op);
+
+// Opt-in allocation tracker. Buffers allocated while it is off are never
+// counted, not even when freed later, so current bytes cover only what was
+// allocated since it was turned on. Per-call peaks cover allocations on the
+// calling thread, not those of OpenMP workers.
+typedef struct {
+    uint32_t subsystem_count;  // MEM_SUBSYSTEM_COUNT
+    uint32_t op_count;         // METRICS_OP_COUNT
+    uint32_t enabled;
+    uint32_t reserved;
+    int64_t current[MEM_SUBSYSTEM_COUNT];
+    int64_t peak[MEM_SUBSYSTEM_COUNT];
+    int64_t total_current;
+    int64_t total_peak;
+    int64_t call_peak[METRICS_OP_COUNT];       // most bytes one call held at once
+    int64_t call_last_peak[METRICS_OP_COUNT];  // same, for the latest call
+} AichatMemStats;
+
+// Turns tracking on or off. Turning it on (again) restarts the peaks from
+// the current bytes and clears the per-call peaks.
+AICHAT_EXPORT void aichat_memtrack_enable(int enabled);
+
+// As aichat_metrics_snapshot, for AichatMemStats
+AICHAT_EXPORT int aichat_memtrack_snapshot(AichatMemStats* out, int size);
+
+// Lowercase name of a subsystem ("kmeans", "lut", ...), NULL past the end
+AICHAT_EXPORT const char* aichat_memtrack_subsystem_name(int subsystem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AICHAT_METRICS_H
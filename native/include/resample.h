@@ -0,0 +1,41 @@
+#ifndef AICHAT_RESAMPLE_H
+#define AICHAT_RESAMPLE_H
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Box-filter (area-average) downscale of a packed RGB image to dst_width x
+// dst_height, each no larger than the source: every output pixel is the
+// rounded mean of the source pixels its box covers, written opaque (alpha
+// 0xFF) so the result can be displayed as ARGB directly. Returns 1 on
+// success, 0 on invalid sizes or when scratch memory cannot be allocated.
+AICHAT_EXPORT int downscale_box(
+    const uint32_t* src_pixels,
+    int width,
+    int height,
+    uint32_t* dst_pixels,
+    int dst_width,
+    int dst_height
+);
+
+// Lanczos-3 downscale with the same contract as downscale_box: separable,
+// the kernel widened by the scale factor so it also low-passes, taps
+// clipped at the image edges and renormalized. Sharper than the box filter
+// for previews, at several times its cost.
+AICHAT_EXPORT int downscale_lanczos3(
+    const uint32_t* src_pixels,
+    int width,
+    int height,
+    uint32_t* dst_pixels,
+    int dst_width,
+    int dst_height
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AICHAT_RESAMPLE_H
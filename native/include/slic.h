@@ -0,0 +1,30 @@
+#ifndef AICHAT_SLIC_H
+#define AICHAT_SLIC_H
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SLIC superpixels over an ARGB image: grid-seeded centers refined by
+// localized k-means in CIELAB + xy, each pixel only compared against the
+// centers of its 3x3 neighbouring grid cells. Writes the mean RGB color and
+// pixel count of every non-empty superpixel (at most max_superpixels) and
+// returns how many were written, or 0 on invalid input.
+AICHAT_EXPORT int slic_superpixels(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    int max_superpixels,
+    float compactness,
+    int max_iterations,
+    ColorPoint3f* means,
+    float* areas
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AICHAT_SLIC_H
@@ -0,0 +1,67 @@
+#ifndef AICHAT_TRACE_H
+#define AICHAT_TRACE_H
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lightweight phase spans: each thread records completed spans into its own
+// ring buffer, overwriting the oldest once TRACE_RING_CAPACITY is reached.
+// Recording is off by default; while off, trace_begin/trace_end cost one
+// relaxed load.
+//
+// At most TRACE_MAX_THREADS threads hold a ring at once. A ring is handed
+// on when its thread exits; a thread that finds none free records nothing
+// for its lifetime and is counted by aichat_trace_dropped_threads.
+#define TRACE_RING_CAPACITY 4096
+#define TRACE_MAX_THREADS 256
+
+// One completed span. Names are string literals owned by the library;
+// timestamps come from the monotonic clock (the one System.nanoTime uses).
+typedef struct {
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    const char* name;
+    int32_t thread_id;
+    int32_t reserved;
+} TraceEvent;
+
+extern int aichat_trace_active;
+
+uint64_t trace_now_ns(void);
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+// Start of a span, or 0 when tracing is off
+static inline uint64_t trace_begin(void) {
+    return __atomic_load_n(&aichat_trace_active, __ATOMIC_RELAXED) ? trace_now_ns() : 0;
+}
+
+static inline void trace_end(const char* name, uint64_t start_ns) {
+    if (start_ns) {
+        trace_record(name, start_ns, trace_now_ns());
+    }
+}
+
+AICHAT_EXPORT void aichat_trace_enable(int enabled);
+AICHAT_EXPORT int aichat_trace_is_enabled(void);
+AICHAT_EXPORT uint64_t aichat_trace_now_ns(void);
+
+// Copies up to `capacity` buffered spans (oldest first per thread) to `out`
+// and returns how many are buffered in total, so a NULL/0 call sizes the
+// output. Intended to be called while no traced native call is running.
+AICHAT_EXPORT int aichat_trace_collect(TraceEvent* out, int capacity);
+
+// Drops all buffered spans; same caveat as aichat_trace_collect
+AICHAT_EXPORT void aichat_trace_clear(void);
+
+// Threads that wanted to record spans while all TRACE_MAX_THREADS rings
+// were held by live threads
+AICHAT_EXPORT int aichat_trace_dropped_threads(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AICHAT_TRACE_H
@@ -0,0 +1,50 @@
+#ifndef AICHAT_TRANSFER_H
+#define AICHAT_TRANSFER_H
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Grid points per channel of the RGB cube the transfer is evaluated on
+#define TRANSFER_LUT_SIZE 33
+
+// Floats in a statistics block: mean L*, a*, b*, then their standard deviations
+#define LAB_STATS_SIZE 6
+
+// Per-channel mean and standard deviation in CIELAB of a packed RGB image,
+// from a regular grid of about max_samples pixels (every pixel when
+// max_samples <= 0), accumulated in double in one parallel reduction. Writes
+// LAB_STATS_SIZE floats to stats and returns the number of pixels sampled,
+// 0 on invalid input.
+AICHAT_EXPORT int lab_statistics(
+    const uint32_t* pixels,
+    int width,
+    int height,
+    int max_samples,
+    float* stats
+);
+
+// Reinhard statistical color transfer: each Lab channel x of the image
+// becomes (x - target_mean) * source_std / target_std + source_mean, so the
+// image takes on the source's statistics. The mapping is evaluated once on a
+// TRANSFER_LUT_SIZE^3 grid over RGB and applied per pixel by trilinear
+// interpolation, so its cost does not depend on Lab conversions per pixel.
+// A channel with a near-zero target deviation is only shifted. Output is
+// packed RGB like resynthesize_image. Returns 1 on success, 0 on invalid
+// input or when the LUT cannot be allocated.
+AICHAT_EXPORT int reinhard_transfer(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    const float* source_stats,
+    const float* target_stats,
+    uint32_t* output_pixels
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AICHAT_TRANSFER_H
@@ -0,0 +1,39 @@
+#ifndef AICHAT_TSVQ_H
+#define AICHAT_TSVQ_H
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tree-structured vector quantization: the leaf with the largest distortion
+// is split by 2-means until k leaves exist, then a few Lloyd passes refine
+// the leaves using the tree as the nearest-color index. Weights may be NULL.
+// Returns the number of palette entries written (fewer than k only when the
+// input has fewer distinct colors).
+AICHAT_EXPORT int tsvq_build_palette(
+    const ColorPoint3f* points,
+    const float* weights,
+    int n,
+    int k,
+    ColorPoint3f* palette
+);
+
+// Binary 2-means tree over a palette with per-node bounding boxes, used as
+// an exact nearest-color index for large palettes.
+typedef struct TsvqTree TsvqTree;
+
+TsvqTree* tsvq_tree_build(const ColorPoint3f* palette, int k);
+
+// Index of the palette entry minimising wr*dr^2 + wg*dg^2 + wb*db^2; ties go
+// to the lowest index, as in a linear scan.
+int tsvq_tree_nearest(const TsvqTree* tree, const ColorPoint3f* point, float wr, float wg, float wb);
+
+void tsvq_tree_free(TsvqTree* tree);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AICHAT_TSVQ_H
@@ -1,4 +1,5 @@
 #include "../include/color.h"
+#include "../include/metrics.h"
 #include <math.h>
 
 static inline float srgb_to_linear(float c) {
@@ -19,7 +20,7 @@ static inline float lab_f_inv(float t) {
     return (t > LAB_DELTA) ? t * t * t : (116.0f * t - 16.0f) / LAB_KAPPA;
 }
 
-static void rgb_to_lab_single(const ColorPoint3f* rgb, ColorPoint3f* lab) {
+void rgb_to_lab_single(const ColorPoint3f* rgb, ColorPoint3f* lab) {
     float r = srgb_to_linear(rgb->c1);
     float g = srgb_to_linear(rgb->c2);
     float b = srgb_to_linear(rgb->c3);
@@ -37,7 +38,7 @@ static void rgb_to_lab_single(const ColorPoint3f* rgb, ColorPoint3f* lab) {
     lab->c3 = 200.0f * (fy - fz);
 }
 
-static void lab_to_rgb_single(const ColorPoint3f* lab, ColorPoint3f* rgb) {
+void lab_to_rgb_single(const ColorPoint3f* lab, ColorPoint3f* rgb) {
     float fy = (lab->c1 + 16.0f) / 116.0f;
     float fx = lab->c2 / 500.0f + fy;
     float fz = fy - lab->c3 / 200.0f;
@@ -64,10 +65,13 @@ AICHAT_EXPORT void rgb_to_lab_batch(
     ColorPoint3f* lab,
     int n
 ) {
+    uint64_t call = metrics_call_begin();
+    METRICS_OMP_REGION();
     #pragma omp parallel for if(n > 1000)
     for (int i = 0; i < n; i++) {
         rgb_to_lab_single(&rgb[i], &lab[i]);
     }
+    metrics_call_end(METRICS_OP_COLOR_CONVERT, call, (uint64_t)n);
 }
 
 AICHAT_EXPORT void lab_to_rgb_batch(
@@ -75,8 +79,11 @@ AICHAT_EXPORT void lab_to_rgb_batch(
     ColorPoint3f* rgb,
     int n
 ) {
+    uint64_t call = metrics_call_begin();
+    METRICS_OMP_REGION();
     #pragma omp parallel for if(n > 1000)
     for (int i = 0; i < n; i++) {
         lab_to_rgb_single(&lab[i], &rgb[i]);
     }
+    metrics_call_end(METRICS_OP_COLOR_CONVERT, call, (uint64_t)n);
 }
@@ -4,6 +4,10 @@
 #include "../include/opencl_accel.h"
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 AICHAT_EXPORT const char* aichat_native_version(void) {
 #if defined(HAVE_OPENCL) && defined(HAVE_TURBOJPEG)
     return "2.1.0-opencl-turbojpeg";
@@ -36,6 +40,23 @@ AICHAT_EXPORT int aichat_has_turbojpeg(void) {
 #endif
 }
 
+AICHAT_EXPORT int aichat_noop(const void* data, int n) {
+    (void)data;
+    return n;
+}
+
+AICHAT_EXPORT int aichat_set_num_threads(int n) {
+#ifdef _OPENMP
+    if (n > 0) {
+        omp_set_num_threads(n);
+    }
+    return omp_get_max_threads();
+#else
+    (void)n;
+    return 1;
+#endif
+}
+
 #ifndef HAVE_TURBOJPEG
 AICHAT_EXPORT int decode_jpeg_file_turbojpeg(const char* path, int* w, int* h, unsigned char** pixels) {
     (void)path; (void)w; (void)h; (void)pixels;
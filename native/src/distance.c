@@ -1,4 +1,5 @@
 #include "../include/distance.h"
+#include "../include/metrics.h"
 #include <math.h>
 #include <float.h>
 #include <stdlib.h>
@@ -46,6 +47,7 @@ AICHAT_EXPORT int assign_points_batch(
 ) {
     int changed = 0;
     
+    METRICS_OMP_REGION();
     #pragma omp parallel for reduction(+:changed) if(n > 5000)
     for (int i = 0; i < n; i++) {
         int nearest = find_nearest_centroid(&points[i], centroids, k);
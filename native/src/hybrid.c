@@ -2,6 +2,8 @@
 #include "../include/kmeans.h"
 #include "../include/distance.h"
 #include "../include/random.h"
+#include "../include/trace.h"
+#include "../include/metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -11,11 +13,6 @@
 #include <omp.h>
 #endif
 
-typedef struct {
-    ColorPoint3f* representatives;
-    int count;
-} BlockResult;
-
 static inline float point_distance_sq(const ColorPoint3f* a, const ColorPoint3f* b) {
     float d1 = a->c1 - b->c1;
     float d2 = a->c2 - b->c2;
@@ -23,137 +20,451 @@ static inline float point_distance_sq(const ColorPoint3f* a, const ColorPoint3f*
     return d1*d1 + d2*d2 + d3*d3;
 }
 
-static inline int count_neighbors(const ColorPoint3f* points, int n, int idx, float eps_sq) {
-    const ColorPoint3f* p = &points[idx];
+// ==================== Global grid DBSCAN ====================
+//
+// Points are bucketed into a grid with cell side eps/sqrt(3), so any two
+// points sharing a cell are neighbours and all neighbours of a point lie
+// within +-2 cells. Core detection runs per cell in parallel, and clusters
+// are formed by a lock-free union-find over core cells.
+
+#define GRID_REACH 2
+#define DENSE_GRID_MIN (1 << 20)
+
+typedef struct {
+    int64_t key;
+    int index;
+} GridEntry;
+
+typedef struct {
+    int num_cells;
+    int64_t* cell_keys;
+    int* cell_start;       // num_cells + 1 offsets into the sorted points
+    int* neighbor_start;   // num_cells + 1 offsets into neighbors
+    int* neighbors;        // neighbouring cell indices, including the cell itself
+    ColorPoint3f* sorted;  // points in cell order
+    int* sorted_index;     // original index of each sorted point
+} DbscanGrid;
+
+static int compare_grid_entries(const void* a, const void* b) {
+    const GridEntry* ea = (const GridEntry*)a;
+    const GridEntry* eb = (const GridEntry*)b;
+    if (ea->key != eb->key) return ea->key < eb->key ? -1 : 1;
+    return ea->index - eb->index;
+}
+
+static int find_cell(const int64_t* keys, int num_cells, int64_t key) {
+    int lo = 0, hi = num_cells - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) >> 1;
+        if (keys[mid] == key) return mid;
+        if (keys[mid] < key) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+static void grid_free(DbscanGrid* grid) {
+    metrics_free(grid->cell_keys);
+    metrics_free(grid->cell_start);
+    metrics_free(grid->neighbor_start);
+    metrics_free(grid->neighbors);
+    metrics_free(grid->sorted);
+    metrics_free(grid->sorted_index);
+}
+
+// Occupied cells around cell c, in fixed offset order so later scans are
+// deterministic; written to out unless it is NULL. Returns their number.
+static int cell_neighbors(const DbscanGrid* grid, const int64_t* dims, const int* dense,
+                          int c, int* out) {
+    int64_t key = grid->cell_keys[c];
+    int64_t z = key % dims[2];
+    int64_t y = (key / dims[2]) % dims[1];
+    int64_t x = key / (dims[1] * dims[2]);
     int count = 0;
-    for (int j = 0; j < n; j++) {
-        float d1 = p->c1 - points[j].c1;
-        float d2 = p->c2 - points[j].c2;
-        float d3 = p->c3 - points[j].c3;
-        if (d1*d1 + d2*d2 + d3*d3 <= eps_sq) count++;
+    
+    for (int dx = -GRID_REACH; dx <= GRID_REACH; dx++) {
+        int64_t nx = x + dx;
+        if (nx < 0 || nx >= dims[0]) continue;
+        for (int dy = -GRID_REACH; dy <= GRID_REACH; dy++) {
+            int64_t ny = y + dy;
+            if (ny < 0 || ny >= dims[1]) continue;
+            for (int dz = -GRID_REACH; dz <= GRID_REACH; dz++) {
+                int64_t nz = z + dz;
+                if (nz < 0 || nz >= dims[2]) continue;
+                int64_t nkey = (nx * dims[1] + ny) * dims[2] + nz;
+                int cell = dense ? dense[nkey] : find_cell(grid->cell_keys, grid->num_cells, nkey);
+                if (cell >= 0) {
+                    if (out) out[count] = cell;
+                    count++;
+                }
+            }
+        }
     }
     return count;
 }
 
-static BlockResult block_dbscan(
+static int grid_build(DbscanGrid* grid, const ColorPoint3f* points, int n, float cell_size) {
+    memset(grid, 0, sizeof(*grid));
+    
+    float lo[3] = { points[0].c1, points[0].c2, points[0].c3 };
+    float hi[3] = { lo[0], lo[1], lo[2] };
+    for (int i = 1; i < n; i++) {
+        const float v[3] = { points[i].c1, points[i].c2, points[i].c3 };
+        for (int d = 0; d < 3; d++) {
+            if (v[d] < lo[d]) lo[d] = v[d];
+            if (v[d] > hi[d]) hi[d] = v[d];
+        }
+    }
+    
+    float inv_cell = 1.0f / cell_size;
+    int64_t dims[3];
+    for (int d = 0; d < 3; d++) {
+        dims[d] = (int64_t)((hi[d] - lo[d]) * inv_cell) + 1;
+    }
+    
+    GridEntry* entries = (GridEntry*)metrics_malloc(MEM_HYBRID, (size_t)n * sizeof(GridEntry));
+    grid->sorted = (ColorPoint3f*)metrics_malloc(MEM_HYBRID, (size_t)n * sizeof(ColorPoint3f));
+    grid->sorted_index = (int*)metrics_malloc(MEM_HYBRID, (size_t)n * sizeof(int));
+    grid->cell_keys = (int64_t*)metrics_malloc(MEM_HYBRID, (size_t)n * sizeof(int64_t));
+    grid->cell_start = (int*)metrics_malloc(MEM_HYBRID, ((size_t)n + 1) * sizeof(int));
+    grid->neighbor_start = (int*)metrics_malloc(MEM_HYBRID, ((size_t)n + 1) * sizeof(int));
+    if (!entries || !grid->sorted || !grid->sorted_index || !grid->cell_keys ||
+        !grid->cell_start || !grid->neighbor_start) {
+        metrics_free(entries);
+        grid_free(grid);
+        return -1;
+    }
+    
+    METRICS_OMP_REGION();
+    #pragma omp parallel for if(n > 10000)
+    for (int i = 0; i < n; i++) {
+        int64_t x = (int64_t)((points[i].c1 - lo[0]) * inv_cell);
+        int64_t y = (int64_t)((points[i].c2 - lo[1]) * inv_cell);
+        int64_t z = (int64_t)((points[i].c3 - lo[2]) * inv_cell);
+        if (x >= dims[0]) x = dims[0] - 1;
+        if (y >= dims[1]) y = dims[1] - 1;
+        if (z >= dims[2]) z = dims[2] - 1;
+        entries[i].key = (x * dims[1] + y) * dims[2] + z;
+        entries[i].index = i;
+    }
+    
+    qsort(entries, n, sizeof(GridEntry), compare_grid_entries);
+    
+    int num_cells = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || entries[i].key != entries[i - 1].key) {
+            grid->cell_keys[num_cells] = entries[i].key;
+            grid->cell_start[num_cells] = i;
+            num_cells++;
+        }
+        grid->sorted[i] = points[entries[i].index];
+        grid->sorted_index[i] = entries[i].index;
+    }
+    grid->cell_start[num_cells] = n;
+    grid->num_cells = num_cells;
+    metrics_free(entries);
+    
+    // Small grids get a dense key -> cell table; otherwise binary search
+    int64_t total_cells = dims[0] * dims[1] * dims[2];
+    int64_t dense_limit = (int64_t)n * 8 > DENSE_GRID_MIN ? (int64_t)n * 8 : DENSE_GRID_MIN;
+    int* dense = NULL;
+    if (total_cells <= dense_limit) {
+        dense = (int*)metrics_malloc(MEM_HYBRID, (size_t)total_cells * sizeof(int));
+        if (dense) {
+            memset(dense, 0xFF, (size_t)total_cells * sizeof(int));
+            for (int c = 0; c < num_cells; c++) dense[grid->cell_keys[c]] = c;
+        }
+    }
+    
+    // Two passes over the neighbourhoods, counting then filling, so the
+    // lists are written in place without a per-cell worst-case scratch
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(dynamic, 64) if(num_cells > 1000)
+    for (int c = 0; c < num_cells; c++) {
+        grid->neighbor_start[c + 1] = cell_neighbors(grid, dims, dense, c, NULL);
+    }
+    
+    grid->neighbor_start[0] = 0;
+    for (int c = 0; c < num_cells; c++) {
+        grid->neighbor_start[c + 1] += grid->neighbor_start[c];
+    }
+    
+    grid->neighbors = (int*)metrics_malloc(MEM_HYBRID, ((size_t)grid->neighbor_start[num_cells] + 1) * sizeof(int));
+    if (!grid->neighbors) {
+        metrics_free(dense);
+        grid_free(grid);
+        return -1;
+    }
+    
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(dynamic, 64) if(num_cells > 1000)
+    for (int c = 0; c < num_cells; c++) {
+        cell_neighbors(grid, dims, dense, c, &grid->neighbors[grid->neighbor_start[c]]);
+    }
+    
+    metrics_free(dense);
+    return 0;
+}
+
+// Lock-free union-find. Roots always link to the smaller index, so parents
+// only ever decrease and every component ends up rooted at its lowest cell,
+// whatever order the threads merge in.
+static int uf_find(int* parent, int x) {
+    for (;;) {
+        int p = __atomic_load_n(&parent[x], __ATOMIC_RELAXED);
+        if (p == x) return x;
+        int gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+        if (gp != p) {
+            __atomic_compare_exchange_n(&parent[x], &p, gp, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        x = gp;
+    }
+}
+
+static void uf_union(int* parent, int a, int b) {
+    for (;;) {
+        a = uf_find(parent, a);
+        b = uf_find(parent, b);
+        if (a == b) return;
+        if (a > b) {
+            int tmp = a;
+            a = b;
+            b = tmp;
+        }
+        int expected = b;
+        if (__atomic_compare_exchange_n(&parent[b], &expected, a, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+// Labels every point with a cluster id (0..clusters-1, ordered by grid cell)
+// or DBSCAN_NOISE. Returns the number of clusters, or -1 on allocation failure.
+static int global_dbscan(
     const ColorPoint3f* points,
     int n,
     float eps,
-    int min_pts
+    int min_pts,
+    int* labels
 ) {
-    BlockResult result = {NULL, 0};
-    
-    if (n == 0) return result;
-    
+    if (eps <= 0.0f) eps = 1e-3f;
     float eps_sq = eps * eps;
     
-    int* labels = (int*)malloc(n * sizeof(int));
-    int* queue = (int*)malloc(n * sizeof(int));
-    
-    for (int i = 0; i < n; i++) labels[i] = -2;
+    DbscanGrid grid;
+    if (grid_build(&grid, points, n, eps / sqrtf(3.0f)) != 0) {
+        return -1;
+    }
     
-    int cluster_id = 0;
+    int num_cells = grid.num_cells;
+    const ColorPoint3f* sorted = grid.sorted;
+    
+    unsigned char* core = (unsigned char*)metrics_calloc(MEM_HYBRID, n, 1);
+    unsigned char* cell_core = (unsigned char*)metrics_calloc(MEM_HYBRID, num_cells, 1);
+    int* parent = (int*)metrics_malloc(MEM_HYBRID, (size_t)num_cells * sizeof(int));
+    int* cell_cluster = (int*)metrics_malloc(MEM_HYBRID, (size_t)num_cells * sizeof(int));
+    if (!core || !cell_core || !parent || !cell_cluster) {
+        metrics_free(core);
+        metrics_free(cell_core);
+        metrics_free(parent);
+        metrics_free(cell_cluster);
+        grid_free(&grid);
+        return -1;
+    }
     
-    for (int i = 0; i < n; i++) {
-        if (labels[i] != -2) continue;
-        
-        int neighbor_count = count_neighbors(points, n, i, eps_sq);
+    // Core points: a cell holding min_pts points is core as a whole,
+    // otherwise count neighbours until min_pts is reached
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(dynamic, 16) if(num_cells > 64)
+    for (int c = 0; c < num_cells; c++) {
+        int start = grid.cell_start[c];
+        int end = grid.cell_start[c + 1];
         
-        if (neighbor_count < min_pts) {
-            labels[i] = -1;
+        if (end - start >= min_pts) {
+            memset(&core[start], 1, end - start);
+            cell_core[c] = 1;
             continue;
         }
         
-        labels[i] = cluster_id;
-        int queue_start = 0, queue_end = 0;
-        
-        const ColorPoint3f* pi = &points[i];
-        for (int j = 0; j < n; j++) {
-            if (j != i && labels[j] == -2) {
-                float d1 = pi->c1 - points[j].c1;
-                float d2 = pi->c2 - points[j].c2;
-                float d3 = pi->c3 - points[j].c3;
-                if (d1*d1 + d2*d2 + d3*d3 <= eps_sq) {
-                    queue[queue_end++] = j;
-                    labels[j] = -3;
+        for (int i = start; i < end; i++) {
+            int count = 0;
+            for (int e = grid.neighbor_start[c]; e < grid.neighbor_start[c + 1] && count < min_pts; e++) {
+                int nc = grid.neighbors[e];
+                for (int j = grid.cell_start[nc]; j < grid.cell_start[nc + 1]; j++) {
+                    if (point_distance_sq(&sorted[i], &sorted[j]) <= eps_sq && ++count >= min_pts) break;
                 }
             }
+            if (count >= min_pts) {
+                core[i] = 1;
+                cell_core[c] = 1;
+            }
         }
+    }
+    
+    for (int c = 0; c < num_cells; c++) parent[c] = c;
+    
+    // Core points within a cell are always mutually reachable, so clusters
+    // are merged at cell granularity: two core cells join when any pair of
+    // their core points lies within eps
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(dynamic, 16) if(num_cells > 64)
+    for (int c = 0; c < num_cells; c++) {
+        if (!cell_core[c]) continue;
         
-        while (queue_start < queue_end) {
-            int q = queue[queue_start++];
+        for (int e = grid.neighbor_start[c]; e < grid.neighbor_start[c + 1]; e++) {
+            int nc = grid.neighbors[e];
+            if (nc <= c || !cell_core[nc]) continue;
+            if (uf_find(parent, c) == uf_find(parent, nc)) continue;
             
-            if (labels[q] == -1) {
-                labels[q] = cluster_id;
-                continue;
+            int linked = 0;
+            for (int i = grid.cell_start[c]; i < grid.cell_start[c + 1] && !linked; i++) {
+                if (!core[i]) continue;
+                for (int j = grid.cell_start[nc]; j < grid.cell_start[nc + 1]; j++) {
+                    if (core[j] && point_distance_sq(&sorted[i], &sorted[j]) <= eps_sq) {
+                        linked = 1;
+                        break;
+                    }
+                }
             }
             
-            labels[q] = cluster_id;
+            if (linked) uf_union(parent, c, nc);
+        }
+    }
+    
+    // Roots are the lowest cell of each component; number them in cell order
+    int num_clusters = 0;
+    for (int c = 0; c < num_cells; c++) {
+        if (!cell_core[c]) {
+            cell_cluster[c] = DBSCAN_NOISE;
+        } else if (parent[c] == c) {
+            cell_cluster[c] = num_clusters++;
+        } else {
+            cell_cluster[c] = cell_cluster[uf_find(parent, c)];
+        }
+    }
+    
+    // Border points join the cluster of the first core neighbour found
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(dynamic, 16) if(num_cells > 64)
+    for (int c = 0; c < num_cells; c++) {
+        for (int i = grid.cell_start[c]; i < grid.cell_start[c + 1]; i++) {
+            int label = DBSCAN_NOISE;
             
-            if (count_neighbors(points, n, q, eps_sq) >= min_pts) {
-                const ColorPoint3f* pq = &points[q];
-                for (int j = 0; j < n; j++) {
-                    if (labels[j] == -2) {
-                        float d1 = pq->c1 - points[j].c1;
-                        float d2 = pq->c2 - points[j].c2;
-                        float d3 = pq->c3 - points[j].c3;
-                        if (d1*d1 + d2*d2 + d3*d3 <= eps_sq) {
-                            queue[queue_end++] = j;
-                            labels[j] = -3;
+            if (core[i]) {
+                label = cell_cluster[c];
+            } else {
+                for (int e = grid.neighbor_start[c]; e < grid.neighbor_start[c + 1] && label == DBSCAN_NOISE; e++) {
+                    int nc = grid.neighbors[e];
+                    if (!cell_core[nc]) continue;
+                    for (int j = grid.cell_start[nc]; j < grid.cell_start[nc + 1]; j++) {
+                        if (core[j] && point_distance_sq(&sorted[i], &sorted[j]) <= eps_sq) {
+                            label = cell_cluster[nc];
+                            break;
                         }
                     }
                 }
             }
+            
+            labels[grid.sorted_index[i]] = label;
         }
-        
-        cluster_id++;
     }
     
-    free(queue);
+    metrics_free(core);
+    metrics_free(cell_core);
+    metrics_free(parent);
+    metrics_free(cell_cluster);
+    grid_free(&grid);
     
-    int noise_count = 0;
-    for (int i = 0; i < n; i++) {
-        if (labels[i] == -1) noise_count++;
-    }
+    return num_clusters;
+}
+
+// Representative grid cells stop growing here: cells this wide already
+// cover the whole RGB / CIELAB range with a handful of cells
+#define REPRESENTATIVE_CELL_LIMIT 512.0f
+// Cell growth per compaction step (about 3x fewer cells each time)
+#define REPRESENTATIVE_CELL_GROWTH 1.5f
+
+typedef struct {
+    int label;
+    int index;
+    int64_t cell;
+} RepresentativeEntry;
+
+static int compare_representative_entries(const void* a, const void* b) {
+    const RepresentativeEntry* ea = (const RepresentativeEntry*)a;
+    const RepresentativeEntry* eb = (const RepresentativeEntry*)b;
+    if (ea->label != eb->label) return ea->label < eb->label ? -1 : 1;
+    if (ea->cell != eb->cell) return ea->cell < eb->cell ? -1 : 1;
+    return ea->index - eb->index;
+}
+
+static inline int64_t representative_cell(const ColorPoint3f* p, float inv_cell) {
+    int64_t x = (int64_t)floorf(p->c1 * inv_cell);
+    int64_t y = (int64_t)floorf(p->c2 * inv_cell);
+    int64_t z = (int64_t)floorf(p->c3 * inv_cell);
+    return ((x & 0x1FFFFF) << 42) | ((y & 0x1FFFFF) << 21) | (z & 0x1FFFFF);
+}
+
+// Builds weighted representatives: each cluster contributes one centroid per
+// cluster_cell-sized cell it occupies (a single centroid per cluster would
+// collapse clusters that chain across a wide colour range). Noise points are
+// kept individually when noise_cell is 0, otherwise merged per noise_cell
+// cell. With merge_labels set, cluster ids are ignored and all points are
+// merged per cluster_cell cell. Each weight is the number of points merged.
+// Output is ordered by cluster, then cell, with noise last.
+static int extract_representatives(
+    const ColorPoint3f* points,
+    int n,
+    const int* labels,
+    float cluster_cell,
+    float noise_cell,
+    int merge_labels,
+    RepresentativeEntry* entries,
+    ColorPoint3f* output,
+    float* weights,
+    int* noise_representatives
+) {
+    float inv_cluster = 1.0f / cluster_cell;
+    float inv_noise = noise_cell > 0.0f ? 1.0f / noise_cell : 0.0f;
     
-    int max_representatives = cluster_id + noise_count;
-    if (max_representatives == 0) {
-        free(labels);
-        return result;
+    for (int i = 0; i < n; i++) {
+        entries[i].index = i;
+        if (merge_labels) {
+            entries[i].label = 0;
+            entries[i].cell = representative_cell(&points[i], inv_cluster);
+        } else if (labels[i] != DBSCAN_NOISE) {
+            entries[i].label = labels[i];
+            entries[i].cell = representative_cell(&points[i], inv_cluster);
+        } else {
+            entries[i].label = INT32_MAX;
+            entries[i].cell = noise_cell > 0.0f ? representative_cell(&points[i], inv_noise) : i;
+        }
     }
     
-    result.representatives = (ColorPoint3f*)malloc((size_t)max_representatives * sizeof(ColorPoint3f));
-    result.count = 0;
+    qsort(entries, n, sizeof(RepresentativeEntry), compare_representative_entries);
     
-    for (int c = 0; c < cluster_id; c++) {
+    int count = 0;
+    *noise_representatives = 0;
+    for (int a = 0; a < n; ) {
         double sum_c1 = 0, sum_c2 = 0, sum_c3 = 0;
-        int count = 0;
-        
-        for (int i = 0; i < n; i++) {
-            if (labels[i] == c) {
-                sum_c1 += points[i].c1;
-                sum_c2 += points[i].c2;
-                sum_c3 += points[i].c3;
-                count++;
-            }
+        int b = a;
+        if (entries[a].label == INT32_MAX) (*noise_representatives)++;
+        while (b < n && entries[b].label == entries[a].label && entries[b].cell == entries[a].cell) {
+            const ColorPoint3f* p = &points[entries[b].index];
+            sum_c1 += p->c1;
+            sum_c2 += p->c2;
+            sum_c3 += p->c3;
+            b++;
         }
         
-        if (count > 0) {
-            result.representatives[result.count].c1 = (float)(sum_c1 / count);
-            result.representatives[result.count].c2 = (float)(sum_c2 / count);
-            result.representatives[result.count].c3 = (float)(sum_c3 / count);
-            result.count++;
-        }
-    }
-    
-    for (int i = 0; i < n; i++) {
-        if (labels[i] == -1) {
-            result.representatives[result.count++] = points[i];
-        }
+        output[count].c1 = (float)(sum_c1 / (b - a));
+        output[count].c2 = (float)(sum_c2 / (b - a));
+        output[count].c3 = (float)(sum_c3 / (b - a));
+        weights[count] = (float)(b - a);
+        count++;
+        a = b;
     }
     
-    free(labels);
-    return result;
+    return count;
 }
 
 AICHAT_EXPORT int hybrid_cluster(
@@ -168,62 +479,114 @@ AICHAT_EXPORT int hybrid_cluster(
     ColorPoint3f* centroids,
     uint64_t seed
 ) {
-    if (n == 0 || k <= 0) return 0;
+    return hybrid_cluster_bounded(points, n, k, block_size, dbscan_eps, dbscan_min_pts,
+                                  kmeans_max_iter, kmeans_threshold,
+                                  HYBRID_DEFAULT_MAX_REPRESENTATIVES, centroids, seed);
+}
+
+AICHAT_EXPORT int hybrid_cluster_bounded(
+    const ColorPoint3f* points,
+    int n,
+    int k,
+    int block_size,
+    float dbscan_eps,
+    int dbscan_min_pts,
+    int kmeans_max_iter,
+    float kmeans_threshold,
+    int max_representatives,
+    ColorPoint3f* centroids,
+    uint64_t seed
+) {
+    if (n <= 0 || k <= 0) return 0;
     if (k > n) k = n;
     
+    uint64_t call = metrics_call_begin();
+    
     int actual_max_iter = kmeans_max_iter;
     if (k > 100) actual_max_iter = 20;
     else if (k > 32) actual_max_iter = 30;
     
+    // Small samples go straight to k-means; block_size only sets that cut-off
+    // now that DBSCAN runs over the whole sample
     if (n <= block_size * 2) {
-        int* assignments = (int*)malloc(n * sizeof(int));
+        int* assignments = (int*)metrics_malloc(MEM_HYBRID, n * sizeof(int));
         int iterations = kmeans_cluster(points, n, k, actual_max_iter, 
                                          kmeans_threshold, centroids, assignments, seed);
-        free(assignments);
+        metrics_free(assignments);
+        metrics_call_end(METRICS_OP_HYBRID, call, (uint64_t)n);
         return iterations;
     }
     
-    int num_blocks = (n + block_size - 1) / block_size;
-    
-    ColorPoint3f* all_representatives = (ColorPoint3f*)malloc(n * sizeof(ColorPoint3f));
-    int total_representatives = 0;
+    uint64_t span = trace_begin();
+    
+    int cap = max_representatives > 0 ? max_representatives : HYBRID_DEFAULT_MAX_REPRESENTATIVES;
+    if (cap < k) cap = k;
+    
+    float base_cell = dbscan_eps > 0.0f ? dbscan_eps : 1e-3f;
+    
+    int* labels = (int*)metrics_malloc(MEM_HYBRID, n * sizeof(int));
+    RepresentativeEntry* entries = (RepresentativeEntry*)metrics_malloc(MEM_HYBRID, (size_t)n * sizeof(RepresentativeEntry));
+    ColorPoint3f* representatives = (ColorPoint3f*)metrics_malloc(MEM_HYBRID, (n > k ? n : k) * sizeof(ColorPoint3f));
+    float* weights = (float*)metrics_malloc(MEM_HYBRID, (n > k ? n : k) * sizeof(float));
+    int* assignments = (int*)metrics_malloc(MEM_HYBRID, (n > k ? n : k) * sizeof(int));
+    if (!labels || !entries || !representatives || !weights || !assignments) {
+        metrics_free(labels);
+        metrics_free(entries);
+        metrics_free(representatives);
+        metrics_free(weights);
+        metrics_free(assignments);
+        trace_end("hybrid_cluster", span);
+        metrics_call_end(METRICS_OP_HYBRID, call, (uint64_t)n);
+        return 0;
+    }
     
-    #ifdef _OPENMP
-    BlockResult* block_results = (BlockResult*)malloc(num_blocks * sizeof(BlockResult));
+    int total_representatives;
+    uint64_t phase = trace_begin();
+    int num_clusters = global_dbscan(points, n, dbscan_eps, dbscan_min_pts, labels);
+    trace_end("hybrid.dbscan", phase);
     
-    #pragma omp parallel for if(num_blocks > 4)
-    for (int b = 0; b < num_blocks; b++) {
-        int start = b * block_size;
-        int end = start + block_size;
-        if (end > n) end = n;
-        int block_n = end - start;
-        
-        block_results[b] = block_dbscan(&points[start], block_n, dbscan_eps, dbscan_min_pts);
+    if (num_clusters < 0) {
+        // Out of memory for the grid: treat everything as noise and let the
+        // compaction below bound the set
+        for (int i = 0; i < n; i++) labels[i] = DBSCAN_NOISE;
     }
     
-    for (int b = 0; b < num_blocks; b++) {
-        for (int i = 0; i < block_results[b].count; i++) {
-            all_representatives[total_representatives++] = block_results[b].representatives[i];
+    // Keep noise points as they are while the set fits the cap; otherwise
+    // grid-merge noise with growing cells, and as a last resort merge
+    // clusters sharing a cell too
+    float noise_cell = 0.0f;
+    float cluster_cell = base_cell;
+    int merge_labels = 0;
+    int noise_representatives = 0;
+    
+    phase = trace_begin();
+    total_representatives = extract_representatives(points, n, labels, cluster_cell, noise_cell,
+                                                    merge_labels, entries, representatives, weights,
+                                                    &noise_representatives);
+    
+    while (total_representatives > cap) {
+        if (!merge_labels && noise_representatives > 1 && noise_cell < REPRESENTATIVE_CELL_LIMIT) {
+            noise_cell = noise_cell > 0.0f ? noise_cell * REPRESENTATIVE_CELL_GROWTH : base_cell;
+        } else if (!merge_labels) {
+            // Start merging at the coarsest cell reached so far rather than
+            // going back to base_cell and regrowing through finer grids
+            merge_labels = 1;
+            if (noise_cell > cluster_cell) cluster_cell = noise_cell;
+        } else if (cluster_cell < REPRESENTATIVE_CELL_LIMIT) {
+            cluster_cell *= REPRESENTATIVE_CELL_GROWTH;
+        } else {
+            break;
         }
-        free(block_results[b].representatives);
-    }
-    free(block_results);
-    
-    #else
-    for (int b = 0; b < num_blocks; b++) {
-        int start = b * block_size;
-        int end = start + block_size;
-        if (end > n) end = n;
-        int block_n = end - start;
         
-        BlockResult br = block_dbscan(&points[start], block_n, dbscan_eps, dbscan_min_pts);
-        
-        for (int i = 0; i < br.count; i++) {
-            all_representatives[total_representatives++] = br.representatives[i];
-        }
-        free(br.representatives);
+        total_representatives = extract_representatives(points, n, labels, cluster_cell, noise_cell,
+                                                        merge_labels, entries, representatives, weights,
+                                                        &noise_representatives);
     }
-    #endif
+    
+    trace_end("hybrid.representatives", phase);
+    
+    metrics_free(entries);
+    metrics_free(labels);
     
     if (total_representatives < k) {
         XorShift64 rng;
@@ -231,18 +594,22 @@ AICHAT_EXPORT int hybrid_cluster(
         
         while (total_representatives < k) {
             int idx = xorshift64_int(&rng, n);
-            all_representatives[total_representatives++] = points[idx];
+            representatives[total_representatives] = points[idx];
+            weights[total_representatives] = 1.0f;
+            total_representatives++;
         }
     }
     
-    int* assignments = (int*)malloc(total_representatives * sizeof(int));
-    int iterations = kmeans_cluster(all_representatives, total_representatives, k,
-                                     actual_max_iter, kmeans_threshold, 
-                                     centroids, assignments, seed);
+    int iterations = kmeans_cluster_weighted(representatives, weights, total_representatives, k,
+                                             actual_max_iter, kmeans_threshold,
+                                             centroids, assignments, seed);
     
-    free(assignments);
-    free(all_representatives);
+    metrics_free(assignments);
+    metrics_free(representatives);
+    metrics_free(weights);
     
+    trace_end("hybrid_cluster", span);
+    metrics_call_end(METRICS_OP_HYBRID, call, (uint64_t)n);
     return iterations;
 }
 
@@ -281,13 +648,13 @@ AICHAT_EXPORT float hybrid_calculate_dbscan_eps(
         if (k >= block_n) k = block_n - 1;
         
         int sample_size = block_n < 20 ? block_n : 20;
-        float* k_distances = (float*)malloc(sample_size * sizeof(float));
+        float* k_distances = (float*)metrics_malloc(MEM_HYBRID, sample_size * sizeof(float));
         
         for (int i = 0; i < sample_size; i++) {
             int idx = start + xorshift64_int(&rng, block_n);
             const ColorPoint3f* p = &points[idx];
             
-            float* distances = (float*)malloc(block_n * sizeof(float));
+            float* distances = (float*)metrics_malloc(MEM_HYBRID, block_n * sizeof(float));
             for (int j = 0; j < block_n; j++) {
                 distances[j] = sqrtf(point_distance_sq(p, &points[start + j]));
             }
@@ -305,7 +672,7 @@ AICHAT_EXPORT float hybrid_calculate_dbscan_eps(
             }
             
             k_distances[i] = distances[k];
-            free(distances);
+            metrics_free(distances);
         }
         
         for (int i = 0; i < sample_size - 1; i++) {
@@ -320,7 +687,7 @@ AICHAT_EXPORT float hybrid_calculate_dbscan_eps(
         
         int median_idx = sample_size / 2;
         total_eps += k_distances[median_idx];
-        free(k_distances);
+        metrics_free(k_distances);
     }
     
     float avg_eps = total_eps / sample_blocks;
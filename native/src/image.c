@@ -1,6 +1,9 @@
 #include "../include/image.h"
 #include "../include/distance.h"
 #include "../include/random.h"
+#include "../include/tsvq.h"
+#include "../include/trace.h"
+#include "../include/metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -44,6 +47,7 @@ AICHAT_EXPORT void extract_pixels(
     int n,
     ColorPoint3f* output
 ) {
+    METRICS_OMP_REGION();
     #pragma omp parallel for if(n > 10000)
     for (int i = 0; i < n; i++) {
         uint32_t pixel = image_pixels[i];
@@ -60,8 +64,10 @@ AICHAT_EXPORT int sample_pixels(
     int sample_size,
     uint64_t seed
 ) {
+    uint64_t call = metrics_call_begin();
     if (input_size <= sample_size) {
         memcpy(output, input, input_size * sizeof(ColorPoint3f));
+        metrics_call_end(METRICS_OP_SAMPLE, call, (uint64_t)input_size);
         return input_size;
     }
     
@@ -77,6 +83,7 @@ AICHAT_EXPORT int sample_pixels(
         }
     }
     
+    metrics_call_end(METRICS_OP_SAMPLE, call, (uint64_t)input_size);
     return sample_size;
 }
 
@@ -87,11 +94,14 @@ AICHAT_EXPORT int sample_pixels_from_image(
     int sample_size,
     uint64_t seed
 ) {
+    uint64_t call = metrics_call_begin();
     if (total_pixels <= sample_size) {
         extract_pixels(image_pixels, total_pixels, output);
+        metrics_call_end(METRICS_OP_SAMPLE, call, (uint64_t)total_pixels);
         return total_pixels;
     }
     
+    uint64_t span = trace_begin();
     XorShift64 rng;
     xorshift64_init(&rng, seed);
     
@@ -111,10 +121,22 @@ AICHAT_EXPORT int sample_pixels_from_image(
             output[j].c3 = (float)(pixel & 0xFF);
         }
     }
+    trace_end("sample_pixels_from_image", span);
     
+    metrics_call_end(METRICS_OP_SAMPLE, call, (uint64_t)total_pixels);
     return sample_size;
 }
 
+// Palettes above this size skip the LUT and search a TSVQ index per pixel
+#define LARGE_PALETTE_THRESHOLD 4096
+
+// Weights follow the pixel's red channel, as in find_nearest_perceptual_avx2
+static inline int find_nearest_indexed(const TsvqTree* tree, const ColorPoint3f* point) {
+    float wr = point->c1 < 128.0f ? 2.0f : 3.0f;
+    float wb = point->c1 < 128.0f ? 3.0f : 2.0f;
+    return tsvq_tree_nearest(tree, point, wr, 4.0f, wb);
+}
+
 #ifdef __AVX2__
 #include <immintrin.h>
 
@@ -187,6 +209,115 @@ static int find_nearest_perceptual_avx2(const ColorPoint3f* point, const ColorPo
 }
 #endif
 
+uint16_t* build_palette_lut(const ColorPoint3f* palette, int palette_size, int bits) {
+    const int dim = 1 << bits;
+    const float scale = 255.0f / (float)(dim - 1);
+    
+    uint16_t* lut = (uint16_t*)metrics_malloc(MEM_LUT, (size_t)dim * dim * dim * sizeof(uint16_t));
+    if (!lut) return NULL;
+    metrics_add(&aichat_metrics.lut_builds, 1);
+    
+    METRICS_OMP_REGION();
+    #pragma omp parallel for collapse(3) schedule(static)
+    for (int ri = 0; ri < dim; ri++) {
+        for (int gi = 0; gi < dim; gi++) {
+            for (int bi = 0; bi < dim; bi++) {
+                ColorPoint3f p = { 
+                    ri * scale, 
+                    gi * scale, 
+                    bi * scale 
+                };
+#ifdef __AVX2__
+                lut[(ri << (bits * 2)) | (gi << bits) | bi] = 
+                    (uint16_t)find_nearest_perceptual_avx2(&p, palette, palette_size);
+#else
+                lut[(ri << (bits * 2)) | (gi << bits) | bi] = 
+                    (uint16_t)find_nearest_perceptual(&p, palette, palette_size);
+#endif
+            }
+        }
+    }
+    
+    return lut;
+}
+
+// Single-entry cache of the last LUT built for resynthesis or posterization
+typedef struct {
+    int bits;
+    int palette_size;
+    ColorPoint3f* palette;
+    uint16_t* lut;
+} PaletteLut;
+
+// Only held entries are outside the cache, so whoever swaps one out owns it
+static PaletteLut* g_lut_cache = NULL;
+static int g_lut_cache_enabled = 1;
+
+static void palette_lut_free(PaletteLut* entry) {
+    if (!entry) return;
+    free(entry->palette);
+    metrics_free(entry->lut);
+    free(entry);
+}
+
+static int palette_lut_cacheable(int bits) {
+    return bits <= PALETTE_LUT_BITS && __atomic_load_n(&g_lut_cache_enabled, __ATOMIC_RELAXED);
+}
+
+static void palette_lut_store(PaletteLut* entry) {
+    if (!entry) return;
+    palette_lut_free(__atomic_exchange_n(&g_lut_cache, entry, __ATOMIC_ACQ_REL));
+}
+
+// The cached LUT when it was built for this palette, otherwise a new one;
+// NULL on allocation failure. Hand it back with palette_lut_release.
+static PaletteLut* palette_lut_acquire(const ColorPoint3f* palette, int palette_size, int bits) {
+    size_t palette_bytes = (size_t)palette_size * sizeof(ColorPoint3f);
+    
+    if (palette_lut_cacheable(bits)) {
+        PaletteLut* cached = __atomic_exchange_n(&g_lut_cache, NULL, __ATOMIC_ACQ_REL);
+        if (cached && cached->bits == bits && cached->palette_size == palette_size &&
+            memcmp(cached->palette, palette, palette_bytes) == 0) {
+            metrics_add(&aichat_metrics.lut_cache_hits, 1);
+            return cached;
+        }
+        // Someone else's palette: leave it for them
+        palette_lut_store(cached);
+    }
+    
+    PaletteLut* entry = (PaletteLut*)malloc(sizeof(PaletteLut));
+    if (!entry) return NULL;
+    entry->bits = bits;
+    entry->palette_size = palette_size;
+    entry->palette = (ColorPoint3f*)malloc(palette_bytes);
+    entry->lut = build_palette_lut(palette, palette_size, bits);
+    if (!entry->palette || !entry->lut) {
+        palette_lut_free(entry);
+        return NULL;
+    }
+    memcpy(entry->palette, palette, palette_bytes);
+    return entry;
+}
+
+static void palette_lut_release(PaletteLut* entry) {
+    if (palette_lut_cacheable(entry->bits)) {
+        palette_lut_store(entry);
+    } else {
+        palette_lut_free(entry);
+    }
+}
+
+AICHAT_EXPORT void aichat_lut_cache_enable(int enabled) {
+    __atomic_store_n(&g_lut_cache_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+    if (!enabled) {
+        aichat_lut_cache_clear();
+    }
+}
+
+AICHAT_EXPORT void aichat_lut_cache_clear(void) {
+    palette_lut_free(__atomic_exchange_n(&g_lut_cache, NULL, __ATOMIC_ACQ_REL));
+}
+
 AICHAT_EXPORT void resynthesize_image(
     const uint32_t* image_pixels,
     int width,
@@ -196,15 +327,29 @@ AICHAT_EXPORT void resynthesize_image(
     int palette_size,
     uint32_t* output_pixels
 ) {
-    int n = width * height;
-    
-    const int LUT_BITS = 7;
-    const int LUT_DIM = 1 << LUT_BITS;
-    const int LUT_SIZE = LUT_DIM * LUT_DIM * LUT_DIM;
-    const float LUT_SCALE = 255.0f / (float)(LUT_DIM - 1);
-    const int SHIFT = 8 - LUT_BITS;
+    resynthesize_image_lut_bits(image_pixels, width, height, target_palette, source_palette,
+                                palette_size, PALETTE_LUT_BITS, output_pixels);
+}
+
+static void resynthesize_pixels(
+    const uint32_t* image_pixels,
+    int n,
+    const ColorPoint3f* target_palette,
+    const ColorPoint3f* source_palette,
+    int palette_size,
+    int lut_bits,
+    uint32_t* output_pixels
+) {
+    const int lut_shift = 8 - lut_bits;
     
-    if (palette_size > 4096) {
+    if (palette_size > LARGE_PALETTE_THRESHOLD) {
+        uint64_t span = trace_begin();
+        TsvqTree* tree = tsvq_tree_build(target_palette, palette_size);
+        trace_end("resynthesize.tsvq_build", span);
+        if (!tree) return;
+        
+        span = trace_begin();
+        METRICS_OMP_REGION();
         #pragma omp parallel for schedule(static, 32768)
         for (int i = 0; i < n; i++) {
             uint32_t pixel = image_pixels[i];
@@ -214,11 +359,7 @@ AICHAT_EXPORT void resynthesize_image(
                 .c3 = (float)(pixel & 0xFF)
             };
             
-#ifdef __AVX2__
-            int closest = find_nearest_perceptual_avx2(&point, target_palette, palette_size);
-#else
-            int closest = find_nearest_perceptual(&point, target_palette, palette_size);
-#endif
+            int closest = find_nearest_indexed(tree, &point);
             const ColorPoint3f* target_center = &target_palette[closest];
             const ColorPoint3f* source_center = &source_palette[closest];
             
@@ -232,33 +373,21 @@ AICHAT_EXPORT void resynthesize_image(
             
             output_pixels[i] = (uint32_t)((r << 16) | (g << 8) | b);
         }
+        trace_end("resynthesize.tsvq_map", span);
+        
+        tsvq_tree_free(tree);
         return;
     }
     
-    uint16_t* lut = (uint16_t*)malloc(LUT_SIZE * sizeof(uint16_t));
-    if (!lut) return;
-    
-    #pragma omp parallel for collapse(3) schedule(static)
-    for (int ri = 0; ri < LUT_DIM; ri++) {
-        for (int gi = 0; gi < LUT_DIM; gi++) {
-            for (int bi = 0; bi < LUT_DIM; bi++) {
-                ColorPoint3f p = { 
-                    ri * LUT_SCALE, 
-                    gi * LUT_SCALE, 
-                    bi * LUT_SCALE 
-                };
-#ifdef __AVX2__
-                lut[(ri << (LUT_BITS * 2)) | (gi << LUT_BITS) | bi] = 
-                    (uint16_t)find_nearest_perceptual_avx2(&p, target_palette, palette_size);
-#else
-                lut[(ri << (LUT_BITS * 2)) | (gi << LUT_BITS) | bi] = 
-                    (uint16_t)find_nearest_perceptual(&p, target_palette, palette_size);
-#endif
-            }
-        }
-    }
+    uint64_t span = trace_begin();
+    PaletteLut* entry = palette_lut_acquire(target_palette, palette_size, lut_bits);
+    trace_end("resynthesize.lut_build", span);
+    if (!entry) return;
+    const uint16_t* lut = entry->lut;
     
     // Apply palette mapping using LUT
+    span = trace_begin();
+    METRICS_OMP_REGION();
     #pragma omp parallel for schedule(static, 32768)
     for (int i = 0; i < n; i++) {
         uint32_t pixel = image_pixels[i];
@@ -266,7 +395,7 @@ AICHAT_EXPORT void resynthesize_image(
         int pg = (pixel >> 8) & 0xFF;
         int pb = pixel & 0xFF;
         
-        int idx = lut[((pr >> SHIFT) << (LUT_BITS * 2)) | ((pg >> SHIFT) << LUT_BITS) | (pb >> SHIFT)];
+        int idx = lut[((pr >> lut_shift) << (lut_bits * 2)) | ((pg >> lut_shift) << lut_bits) | (pb >> lut_shift)];
         
         const ColorPoint3f* target_center = &target_palette[idx];
         const ColorPoint3f* source_center = &source_palette[idx];
@@ -281,30 +410,46 @@ AICHAT_EXPORT void resynthesize_image(
         
         output_pixels[i] = (uint32_t)((r << 16) | (g << 8) | b);
     }
+    trace_end("resynthesize.map", span);
     
-    free(lut);
+    palette_lut_release(entry);
 }
 
-// Posterize: replace each pixel with exact palette color (no offset preservation)
-AICHAT_EXPORT void posterize_image(
+AICHAT_EXPORT void resynthesize_image_lut_bits(
     const uint32_t* image_pixels,
     int width,
     int height,
     const ColorPoint3f* target_palette,
     const ColorPoint3f* source_palette,
     int palette_size,
+    int lut_bits,
     uint32_t* output_pixels
 ) {
     int n = width * height;
+    if (lut_bits < PALETTE_LUT_MIN_BITS) lut_bits = PALETTE_LUT_MIN_BITS;
+    if (lut_bits > PALETTE_LUT_MAX_BITS) lut_bits = PALETTE_LUT_MAX_BITS;
     
-    const int LUT_BITS = 7;
-    const int LUT_DIM = 1 << LUT_BITS;
-    const int LUT_SIZE = LUT_DIM * LUT_DIM * LUT_DIM;
-    const float LUT_SCALE = 255.0f / (float)(LUT_DIM - 1);
-    const int SHIFT = 8 - LUT_BITS;
-    
-    // For very large palettes, skip LUT
-    if (palette_size > 4096) {
+    uint64_t call = metrics_call_begin();
+    resynthesize_pixels(image_pixels, n, target_palette, source_palette, palette_size, lut_bits, output_pixels);
+    metrics_call_end(METRICS_OP_RESYNTHESIZE, call, (uint64_t)n);
+}
+
+static void posterize_pixels(
+    const uint32_t* image_pixels,
+    int n,
+    const ColorPoint3f* target_palette,
+    const ColorPoint3f* source_palette,
+    int palette_size,
+    uint32_t* output_pixels
+) {
+    if (palette_size > LARGE_PALETTE_THRESHOLD) {
+        uint64_t span = trace_begin();
+        TsvqTree* tree = tsvq_tree_build(target_palette, palette_size);
+        trace_end("posterize.tsvq_build", span);
+        if (!tree) return;
+        
+        span = trace_begin();
+        METRICS_OMP_REGION();
         #pragma omp parallel for schedule(static, 32768)
         for (int i = 0; i < n; i++) {
             uint32_t pixel = image_pixels[i];
@@ -314,11 +459,7 @@ AICHAT_EXPORT void posterize_image(
                 .c3 = (float)(pixel & 0xFF)
             };
             
-#ifdef __AVX2__
-            int closest = find_nearest_perceptual_avx2(&point, target_palette, palette_size);
-#else
-            int closest = find_nearest_perceptual(&point, target_palette, palette_size);
-#endif
+            int closest = find_nearest_indexed(tree, &point);
             const ColorPoint3f* source_center = &source_palette[closest];
             
             int r = (int)(source_center->c1 + 0.5f);
@@ -327,34 +468,21 @@ AICHAT_EXPORT void posterize_image(
             
             output_pixels[i] = (uint32_t)((r << 16) | (g << 8) | b);
         }
+        trace_end("posterize.tsvq_map", span);
+        
+        tsvq_tree_free(tree);
         return;
     }
     
-    // Build LUT for palette lookup
-    uint16_t* lut = (uint16_t*)malloc(LUT_SIZE * sizeof(uint16_t));
-    if (!lut) return;
-    
-    #pragma omp parallel for collapse(3) schedule(static)
-    for (int ri = 0; ri < LUT_DIM; ri++) {
-        for (int gi = 0; gi < LUT_DIM; gi++) {
-            for (int bi = 0; bi < LUT_DIM; bi++) {
-                ColorPoint3f p = { 
-                    ri * LUT_SCALE, 
-                    gi * LUT_SCALE, 
-                    bi * LUT_SCALE 
-                };
-#ifdef __AVX2__
-                lut[(ri << (LUT_BITS * 2)) | (gi << LUT_BITS) | bi] = 
-                    (uint16_t)find_nearest_perceptual_avx2(&p, target_palette, palette_size);
-#else
-                lut[(ri << (LUT_BITS * 2)) | (gi << LUT_BITS) | bi] = 
-                    (uint16_t)find_nearest_perceptual(&p, target_palette, palette_size);
-#endif
-            }
-        }
-    }
+    uint64_t span = trace_begin();
+    PaletteLut* entry = palette_lut_acquire(target_palette, palette_size, PALETTE_LUT_BITS);
+    trace_end("posterize.lut_build", span);
+    if (!entry) return;
+    const uint16_t* lut = entry->lut;
     
     // Apply direct color replacement using LUT
+    span = trace_begin();
+    METRICS_OMP_REGION();
     #pragma omp parallel for schedule(static, 32768)
     for (int i = 0; i < n; i++) {
         uint32_t pixel = image_pixels[i];
@@ -362,7 +490,7 @@ AICHAT_EXPORT void posterize_image(
         int pg = (pixel >> 8) & 0xFF;
         int pb = pixel & 0xFF;
         
-        int idx = lut[((pr >> SHIFT) << (LUT_BITS * 2)) | ((pg >> SHIFT) << LUT_BITS) | (pb >> SHIFT)];
+        int idx = lut[((pr >> PALETTE_LUT_SHIFT) << (PALETTE_LUT_BITS * 2)) | ((pg >> PALETTE_LUT_SHIFT) << PALETTE_LUT_BITS) | (pb >> PALETTE_LUT_SHIFT)];
         
         const ColorPoint3f* source_center = &source_palette[idx];
         
@@ -372,6 +500,24 @@ AICHAT_EXPORT void posterize_image(
         
         output_pixels[i] = (uint32_t)((r << 16) | (g << 8) | b);
     }
+    trace_end("posterize.map", span);
+    
+    palette_lut_release(entry);
+}
+
+// Posterize: replace each pixel with exact palette color (no offset preservation)
+AICHAT_EXPORT void posterize_image(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    const ColorPoint3f* target_palette,
+    const ColorPoint3f* source_palette,
+    int palette_size,
+    uint32_t* output_pixels
+) {
+    int n = width * height;
     
-    free(lut);
+    uint64_t call = metrics_call_begin();
+    posterize_pixels(image_pixels, n, target_palette, source_palette, palette_size, output_pixels);
+    metrics_call_end(METRICS_OP_POSTERIZE, call, (uint64_t)n);
 }
@@ -1,6 +1,9 @@
 #include "../include/kmeans.h"
 #include "../include/distance.h"
 #include "../include/random.h"
+#include "../include/image.h"
+#include "../include/trace.h"
+#include "../include/metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -10,6 +13,16 @@
 #include <omp.h>
 #endif
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Streaming k-means: pixels per tile (64KB of ARGB, fits comfortably in L2)
+#define STREAM_TILE_PIXELS 16384
+// Sample used to seed the full-resolution iterations
+#define STREAM_SEED_SAMPLES 16384
+#define STREAM_SEED_ITERATIONS 20
+
 AICHAT_EXPORT void kmeans_init_plusplus(
     const ColorPoint3f* points,
     int n,
@@ -30,7 +43,7 @@ AICHAT_EXPORT void kmeans_init_plusplus(
         return;
     }
     
-    float* distances = (float*)malloc(n * sizeof(float));
+    float* distances = (float*)metrics_malloc(MEM_KMEANS, n * sizeof(float));
     
     int first = xorshift64_int(&rng, n);
     centroids[0] = points[first];
@@ -63,7 +76,7 @@ AICHAT_EXPORT void kmeans_init_plusplus(
         centroids[c] = points[selected];
     }
     
-    free(distances);
+    metrics_free(distances);
 }
 
 AICHAT_EXPORT float kmeans_update_centroids(
@@ -77,13 +90,14 @@ AICHAT_EXPORT float kmeans_update_centroids(
     XorShift64 rng;
     xorshift64_init(&rng, seed);
     
-    float* sums = (float*)calloc(k * 3, sizeof(float));
-    int* counts = (int*)calloc(k, sizeof(int));
+    float* sums = (float*)metrics_calloc(MEM_KMEANS, k * 3, sizeof(float));
+    int* counts = (int*)metrics_calloc(MEM_KMEANS, k, sizeof(int));
     
+    METRICS_OMP_REGION();
     #pragma omp parallel if(n > 10000)
     {
-        float* local_sums = (float*)calloc(k * 3, sizeof(float));
-        int* local_counts = (int*)calloc(k, sizeof(int));
+        float* local_sums = (float*)metrics_calloc(MEM_KMEANS, k * 3, sizeof(float));
+        int* local_counts = (int*)metrics_calloc(MEM_KMEANS, k, sizeof(int));
         
         #pragma omp for nowait
         for (int i = 0; i < n; i++) {
@@ -106,8 +120,8 @@ AICHAT_EXPORT float kmeans_update_centroids(
             }
         }
         
-        free(local_sums);
-        free(local_counts);
+        metrics_free(local_sums);
+        metrics_free(local_counts);
     }
     
     float max_movement = 0.0f;
@@ -133,8 +147,8 @@ AICHAT_EXPORT float kmeans_update_centroids(
         centroids[c] = new_centroid;
     }
     
-    free(sums);
-    free(counts);
+    metrics_free(sums);
+    metrics_free(counts);
     
     return sqrtf(max_movement);
 }
@@ -152,10 +166,14 @@ AICHAT_EXPORT int kmeans_cluster(
     if (n == 0 || k <= 0) return 0;
     if (k > n) k = n;
     
+    uint64_t call = metrics_call_begin();
+    uint64_t span = trace_begin();
     kmeans_init_plusplus(points, n, k, centroids, seed);
+    trace_end("kmeans.init", span);
     
     memset(assignments, 0, n * sizeof(int));
     
+    span = trace_begin();
     int iteration;
     for (iteration = 0; iteration < max_iterations; iteration++) {
         int changed = assign_points_batch(points, n, centroids, k, assignments);
@@ -167,6 +185,438 @@ AICHAT_EXPORT int kmeans_cluster(
             break;
         }
     }
+    trace_end("kmeans.iterate", span);
+    
+    metrics_call_end(METRICS_OP_KMEANS, call, (uint64_t)n);
+    return iteration;
+}
+
+// Weighted k-means++: D^2 sampling scaled by point weight. Large k uses
+// systematic sampling over the cumulative weight, mirroring the strided
+// initialisation of the unweighted version.
+// Returns 0 when the distance buffer cannot be allocated
+static int kmeans_init_plusplus_weighted(
+    const ColorPoint3f* points,
+    const float* weights,
+    int n,
+    int k,
+    ColorPoint3f* centroids,
+    uint64_t seed
+) {
+    XorShift64 rng;
+    xorshift64_init(&rng, seed);
+    
+    double total_weight = 0.0;
+    for (int i = 0; i < n; i++) total_weight += weights[i];
+    
+    if (k > 64) {
+        double step = total_weight / k;
+        double target = xorshift64_double(&rng) * step;
+        double cumulative = 0.0;
+        int i = 0;
+        for (int c = 0; c < k; c++) {
+            while (i < n - 1 && cumulative + weights[i] < target) {
+                cumulative += weights[i];
+                i++;
+            }
+            centroids[c] = points[i];
+            target += step;
+        }
+        return 1;
+    }
+    
+    float* distances = (float*)metrics_malloc(MEM_KMEANS, (size_t)n * sizeof(float));
+    if (!distances) return 0;
+    
+    double threshold = xorshift64_double(&rng) * total_weight;
+    double cumulative = 0.0;
+    int first = n - 1;
+    for (int i = 0; i < n; i++) {
+        cumulative += weights[i];
+        if (cumulative >= threshold) {
+            first = i;
+            break;
+        }
+    }
+    centroids[0] = points[first];
+    
+    for (int i = 0; i < n; i++) {
+        distances[i] = distance_squared(&points[i], &centroids[0]);
+    }
+    
+    for (int c = 1; c < k; c++) {
+        double total_dist = 0.0;
+        for (int i = 0; i < n; i++) {
+            total_dist += (double)distances[i] * weights[i];
+        }
+        
+        threshold = xorshift64_double(&rng) * total_dist;
+        cumulative = 0.0;
+        int selected = n - 1;
+        for (int i = 0; i < n; i++) {
+            cumulative += (double)distances[i] * weights[i];
+            if (cumulative >= threshold) {
+                selected = i;
+                break;
+            }
+        }
+        
+        centroids[c] = points[selected];
+        
+        for (int i = 0; i < n; i++) {
+            float d = distance_squared(&points[i], &centroids[c]);
+            if (d < distances[i]) distances[i] = d;
+        }
+    }
+    
+    metrics_free(distances);
+    return 1;
+}
+
+// Returns the largest centroid movement, or -1 when the accumulators
+// cannot be allocated
+static float kmeans_update_centroids_weighted(
+    const ColorPoint3f* points,
+    const float* weights,
+    int n,
+    const int* assignments,
+    int k,
+    ColorPoint3f* centroids,
+    uint64_t seed
+) {
+    XorShift64 rng;
+    xorshift64_init(&rng, seed);
+    
+    int num_threads = 1;
+#ifdef _OPENMP
+    if (n > 10000) num_threads = omp_get_max_threads();
+#endif
+    
+    // Per-thread sums reduced in thread order, so results do not depend on
+    // scheduling: 3 weighted channel sums followed by the total weight
+    double* accumulators = (double*)metrics_calloc(MEM_KMEANS, (size_t)num_threads * k * 4, sizeof(double));
+    if (!accumulators) return -1.0f;
+    
+    METRICS_OMP_REGION();
+    #pragma omp parallel num_threads(num_threads) if(num_threads > 1)
+    {
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        double* local = accumulators + (size_t)tid * k * 4;
+        
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; i++) {
+            int cluster = assignments[i];
+            if (cluster >= 0 && cluster < k) {
+                double w = weights[i];
+                local[cluster * 4 + 0] += points[i].c1 * w;
+                local[cluster * 4 + 1] += points[i].c2 * w;
+                local[cluster * 4 + 2] += points[i].c3 * w;
+                local[cluster * 4 + 3] += w;
+            }
+        }
+    }
+    
+    for (int t = 1; t < num_threads; t++) {
+        const double* src = accumulators + (size_t)t * k * 4;
+        for (int j = 0; j < k * 4; j++) {
+            accumulators[j] += src[j];
+        }
+    }
+    
+    float max_movement = 0.0f;
+    
+    for (int c = 0; c < k; c++) {
+        ColorPoint3f new_centroid;
+        double total = accumulators[c * 4 + 3];
+        
+        if (total > 0.0) {
+            new_centroid.c1 = (float)(accumulators[c * 4 + 0] / total);
+            new_centroid.c2 = (float)(accumulators[c * 4 + 1] / total);
+            new_centroid.c3 = (float)(accumulators[c * 4 + 2] / total);
+        } else {
+            int rand_idx = xorshift64_int(&rng, n);
+            new_centroid = points[rand_idx];
+        }
+        
+        float movement = distance_squared(&centroids[c], &new_centroid);
+        if (movement > max_movement) {
+            max_movement = movement;
+        }
+        
+        centroids[c] = new_centroid;
+    }
+    
+    metrics_free(accumulators);
+    
+    return sqrtf(max_movement);
+}
+
+AICHAT_EXPORT int kmeans_cluster_weighted(
+    const ColorPoint3f* points,
+    const float* weights,
+    int n,
+    int k,
+    int max_iterations,
+    float convergence_threshold,
+    ColorPoint3f* centroids,
+    int* assignments,
+    uint64_t seed
+) {
+    if (n <= 0 || k <= 0) return 0;
+    if (k > n) k = n;
+    
+    uint64_t call = metrics_call_begin();
+    uint64_t span = trace_begin();
+    int seeded = kmeans_init_plusplus_weighted(points, weights, n, k, centroids, seed);
+    trace_end("kmeans_weighted.init", span);
+    if (!seeded) {
+        metrics_call_end(METRICS_OP_KMEANS, call, (uint64_t)n);
+        return 0;
+    }
+    
+    memset(assignments, 0, n * sizeof(int));
+    
+    span = trace_begin();
+    int iteration;
+    for (iteration = 0; iteration < max_iterations; iteration++) {
+        int changed = assign_points_batch(points, n, centroids, k, assignments);
+        
+        float movement = kmeans_update_centroids_weighted(points, weights, n, assignments, k,
+                                                          centroids, seed + iteration);
+        if (movement < 0.0f) {
+            trace_end("kmeans_weighted.iterate", span);
+            metrics_call_end(METRICS_OP_KMEANS, call, (uint64_t)n);
+            return 0;
+        }
+        
+        if (movement < convergence_threshold || changed == 0) {
+            iteration++;
+            break;
+        }
+    }
+    trace_end("kmeans_weighted.iterate", span);
+    
+    metrics_call_end(METRICS_OP_KMEANS, call, (uint64_t)n);
+    return iteration;
+}
+
+static inline int nearest_rgb_centroid(int r, int g, int b,
+                                       const float* cr, const float* cg, const float* cb,
+                                       int k) {
+    float fr = (float)r, fg = (float)g, fb = (float)b;
+    int nearest = 0;
+    float min_dist = FLT_MAX;
+    
+    for (int c = 0; c < k; c++) {
+        float dr = fr - cr[c];
+        float dg = fg - cg[c];
+        float db = fb - cb[c];
+        float dist = dr * dr + dg * dg + db * db;
+        if (dist < min_dist) {
+            min_dist = dist;
+            nearest = c;
+        }
+    }
+    
+    return nearest;
+}
+
+// Assigns every pixel of [start, end) to its nearest centroid and adds it to
+// the integer accumulators. Nothing per pixel is stored.
+static void stream_assign_accumulate(
+    const uint32_t* RESTRICT pixels,
+    int start,
+    int end,
+    const float* cr,
+    const float* cg,
+    const float* cb,
+    int k,
+    int64_t* RESTRICT sums,
+    int64_t* RESTRICT counts
+) {
+    int i = start;
+    
+#ifdef __AVX2__
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    int nearest[8];
+    
+    for (; i + 7 < end; i += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i*)&pixels[i]);
+        __m256 vr = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+        __m256 vg = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+        __m256 vb = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+        
+        __m256 best_dist = _mm256_set1_ps(FLT_MAX);
+        __m256 best_idx = _mm256_castsi256_ps(_mm256_setzero_si256());
+        
+        for (int c = 0; c < k; c++) {
+            __m256 dr = _mm256_sub_ps(vr, _mm256_set1_ps(cr[c]));
+            __m256 dg = _mm256_sub_ps(vg, _mm256_set1_ps(cg[c]));
+            __m256 db = _mm256_sub_ps(vb, _mm256_set1_ps(cb[c]));
+            __m256 dist = _mm256_add_ps(
+                _mm256_mul_ps(dr, dr),
+                _mm256_add_ps(_mm256_mul_ps(dg, dg), _mm256_mul_ps(db, db))
+            );
+            
+            __m256 closer = _mm256_cmp_ps(dist, best_dist, _CMP_LT_OQ);
+            best_dist = _mm256_blendv_ps(best_dist, dist, closer);
+            best_idx = _mm256_blendv_ps(best_idx, _mm256_castsi256_ps(_mm256_set1_epi32(c)), closer);
+        }
+        
+        _mm256_storeu_si256((__m256i*)nearest, _mm256_castps_si256(best_idx));
+        
+        for (int j = 0; j < 8; j++) {
+            uint32_t pixel = pixels[i + j];
+            int c = nearest[j];
+            sums[c * 3 + 0] += (pixel >> 16) & 0xFF;
+            sums[c * 3 + 1] += (pixel >> 8) & 0xFF;
+            sums[c * 3 + 2] += pixel & 0xFF;
+            counts[c]++;
+        }
+    }
+#endif
+    
+    for (; i < end; i++) {
+        uint32_t pixel = pixels[i];
+        int r = (pixel >> 16) & 0xFF;
+        int g = (pixel >> 8) & 0xFF;
+        int b = pixel & 0xFF;
+        int c = nearest_rgb_centroid(r, g, b, cr, cg, cb, k);
+        sums[c * 3 + 0] += r;
+        sums[c * 3 + 1] += g;
+        sums[c * 3 + 2] += b;
+        counts[c]++;
+    }
+}
+
+AICHAT_EXPORT int kmeans_cluster_image(
+    const uint32_t* image_pixels,
+    int n,
+    int k,
+    int max_iterations,
+    float convergence_threshold,
+    ColorPoint3f* centroids,
+    uint64_t seed
+) {
+    if (n <= 0 || k <= 0) return 0;
+    if (k > n) k = n;
+    
+    uint64_t call = metrics_call_begin();
+    
+    // Seed from a k-means fit on a reservoir sample; the full-resolution
+    // passes below then only have to refine it
+    int sample_cap = n < STREAM_SEED_SAMPLES ? n : STREAM_SEED_SAMPLES;
+    ColorPoint3f* sample = (ColorPoint3f*)metrics_malloc(MEM_KMEANS, sample_cap * sizeof(ColorPoint3f));
+    int* sample_assignments = (int*)metrics_malloc(MEM_KMEANS, sample_cap * sizeof(int));
+    if (!sample || !sample_assignments) {
+        metrics_free(sample);
+        metrics_free(sample_assignments);
+        metrics_call_end(METRICS_OP_KMEANS, call, (uint64_t)n);
+        return 0;
+    }
+    
+    uint64_t span = trace_begin();
+    int m = sample_pixels_from_image(image_pixels, n, sample, sample_cap, seed);
+    kmeans_cluster(sample, m, k, STREAM_SEED_ITERATIONS, convergence_threshold,
+                   centroids, sample_assignments, seed);
+    trace_end("kmeans_image.seed", span);
+    
+    metrics_free(sample);
+    metrics_free(sample_assignments);
+    
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    
+    int num_tiles = (n + STREAM_TILE_PIXELS - 1) / STREAM_TILE_PIXELS;
+    
+    // Per-thread accumulators: 3 channel sums followed by the count, per centroid
+    int64_t* accumulators = (int64_t*)metrics_malloc(MEM_KMEANS, (size_t)num_threads * k * 4 * sizeof(int64_t));
+    float* coords = (float*)metrics_malloc(MEM_KMEANS, (size_t)k * 3 * sizeof(float));
+    if (!accumulators || !coords) {
+        metrics_free(accumulators);
+        metrics_free(coords);
+        metrics_call_end(METRICS_OP_KMEANS, call, (uint64_t)n);
+        return 0;
+    }
+    
+    float* cr = coords;
+    float* cg = coords + k;
+    float* cb = coords + 2 * k;
+    
+    span = trace_begin();
+    int iteration;
+    for (iteration = 0; iteration < max_iterations; iteration++) {
+        for (int c = 0; c < k; c++) {
+            cr[c] = centroids[c].c1;
+            cg[c] = centroids[c].c2;
+            cb[c] = centroids[c].c3;
+        }
+        
+        memset(accumulators, 0, (size_t)num_threads * k * 4 * sizeof(int64_t));
+        
+        METRICS_OMP_REGION();
+        #pragma omp parallel num_threads(num_threads) if(num_tiles > 1)
+        {
+            int tid = 0;
+#ifdef _OPENMP
+            tid = omp_get_thread_num();
+#endif
+            int64_t* sums = accumulators + (size_t)tid * k * 4;
+            int64_t* counts = sums + k * 3;
+            
+            #pragma omp for schedule(dynamic, 4)
+            for (int t = 0; t < num_tiles; t++) {
+                int start = t * STREAM_TILE_PIXELS;
+                int end = start + STREAM_TILE_PIXELS < n ? start + STREAM_TILE_PIXELS : n;
+                stream_assign_accumulate(image_pixels, start, end, cr, cg, cb, k, sums, counts);
+            }
+        }
+        
+        // Integer sums make the reduction exact and independent of thread order
+        for (int t = 1; t < num_threads; t++) {
+            const int64_t* src = accumulators + (size_t)t * k * 4;
+            for (int j = 0; j < k * 4; j++) {
+                accumulators[j] += src[j];
+            }
+        }
+        
+        const int64_t* sums = accumulators;
+        const int64_t* counts = accumulators + k * 3;
+        float max_movement = 0.0f;
+        
+        for (int c = 0; c < k; c++) {
+            // An empty cluster keeps its previous position
+            if (counts[c] == 0) continue;
+            
+            double inv_count = 1.0 / (double)counts[c];
+            ColorPoint3f updated = {
+                (float)(sums[c * 3 + 0] * inv_count),
+                (float)(sums[c * 3 + 1] * inv_count),
+                (float)(sums[c * 3 + 2] * inv_count)
+            };
+            
+            float movement = distance_squared(&centroids[c], &updated);
+            if (movement > max_movement) {
+                max_movement = movement;
+            }
+            centroids[c] = updated;
+        }
+        
+        if (sqrtf(max_movement) < convergence_threshold) {
+            iteration++;
+            break;
+        }
+    }
+    trace_end("kmeans_image.iterate", span);
+    
+    metrics_free(accumulators);
+    metrics_free(coords);
     
+    metrics_call_end(METRICS_OP_KMEANS, call, (uint64_t)n);
     return iteration;
 }
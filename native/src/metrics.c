@@ -0,0 +1,210 @@
+#include "../include/metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+AichatMetrics aichat_metrics;
+
+static AichatMemStats g_mem;
+static int g_mem_enabled = 0;
+
+static __thread int tls_call_depth = 0;
+
+// Bytes the current outermost call holds on this thread, and its high point
+static __thread int64_t tls_call_bytes = 0;
+static __thread int64_t tls_call_peak = 0;
+// Id of the current outermost call on this thread, 0 outside calls
+static __thread uint32_t tls_call_id = 0;
+static uint32_t g_next_call_id = 0;
+
+static const char* const OP_NAMES[METRICS_OP_COUNT] = {
+    "kmeans",
+    "hybrid",
+    "slic",
+    "tsvq",
+    "sample",
+    "color_convert",
+    "resynthesize",
+    "posterize",
+    "jpeg_decode",
+    "jpeg_encode",
+    "gpu_resynthesize",
+    "resample",
+    "transfer"
+};
+
+// Counters after the header, as one run of uint64_t words
+#define METRICS_FIRST_WORD offsetof(AichatMetrics, calls)
+#define METRICS_WORDS ((sizeof(AichatMetrics) - METRICS_FIRST_WORD) / sizeof(uint64_t))
+
+static const char* const SUBSYSTEM_NAMES[MEM_SUBSYSTEM_COUNT] = {
+    "kmeans",
+    "hybrid",
+    "lut",
+    "slic",
+    "tsvq",
+    "jpeg",
+    "resample"
+};
+
+uint64_t metrics_call_begin(void) {
+    if (tls_call_depth++ != 0) return 0;
+    tls_call_bytes = 0;
+    tls_call_peak = 0;
+    do {
+        tls_call_id = __atomic_add_fetch(&g_next_call_id, 1, __ATOMIC_RELAXED);
+    } while (tls_call_id == 0);
+    return trace_now_ns();
+}
+
+static void atomic_max(int64_t* target, int64_t value) {
+    int64_t seen = __atomic_load_n(target, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(target, &seen, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static int latency_bucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int bucket = us == 0 ? 0 : 64 - __builtin_clzll(us);
+    return bucket < METRICS_LATENCY_BUCKETS ? bucket : METRICS_LATENCY_BUCKETS - 1;
+}
+
+void metrics_call_end(MetricsOp op, uint64_t start_ns, uint64_t items) {
+    if (--tls_call_depth == 0) tls_call_id = 0;
+    if (!start_ns) return;
+
+    uint64_t elapsed = trace_now_ns() - start_ns;
+    metrics_add(&aichat_metrics.calls[op], 1);
+    metrics_add(&aichat_metrics.call_ns[op], elapsed);
+    metrics_add(&aichat_metrics.items[op], items);
+    metrics_add(&aichat_metrics.latency[op][latency_bucket(elapsed)], 1);
+    
+    if (__atomic_load_n(&g_mem_enabled, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&g_mem.call_last_peak[op], tls_call_peak, __ATOMIC_RELAXED);
+        atomic_max(&g_mem.call_peak[op], tls_call_peak);
+    }
+}
+
+// Ahead of every tracked block; 16 bytes keeps malloc's alignment.
+// call is the id of the call that allocated the block, so blocks that
+// outlive it (the cached palette LUT) are not charged to whichever later
+// call happens to free them
+typedef struct {
+    uint64_t size;
+    uint16_t subsystem;
+    uint16_t tracked;
+    uint32_t call;
+} MemHeader;
+
+static void mem_account(MemHeader* header, int64_t delta) {
+    int64_t current = __atomic_add_fetch(&g_mem.current[header->subsystem], delta, __ATOMIC_RELAXED);
+    int64_t total = __atomic_add_fetch(&g_mem.total_current, delta, __ATOMIC_RELAXED);
+    if (delta > 0) {
+        atomic_max(&g_mem.peak[header->subsystem], current);
+        atomic_max(&g_mem.total_peak, total);
+    }
+    if (tls_call_depth > 0 && header->call == tls_call_id) {
+        tls_call_bytes += delta;
+        if (tls_call_bytes > tls_call_peak) tls_call_peak = tls_call_bytes;
+    }
+}
+
+static void* mem_track(MemHeader* header, MemSubsystem subsystem, size_t size) {
+    if (!header) return NULL;
+    metrics_add(&aichat_metrics.bytes_allocated, size);
+    header->size = size;
+    header->subsystem = (uint16_t)subsystem;
+    header->tracked = (uint16_t)__atomic_load_n(&g_mem_enabled, __ATOMIC_RELAXED);
+    header->call = tls_call_id;
+    if (header->tracked) {
+        mem_account(header, (int64_t)size);
+    }
+    return header + 1;
+}
+
+void* metrics_malloc(MemSubsystem subsystem, size_t size) {
+    if (size > SIZE_MAX - sizeof(MemHeader)) return NULL;
+    return mem_track((MemHeader*)malloc(sizeof(MemHeader) + size), subsystem, size);
+}
+
+void* metrics_calloc(MemSubsystem subsystem, size_t count, size_t size) {
+    if (size != 0 && count > (SIZE_MAX - sizeof(MemHeader)) / size) return NULL;
+    return mem_track((MemHeader*)calloc(1, sizeof(MemHeader) + count * size), subsystem, count * size);
+}
+
+void metrics_free(void* ptr) {
+    if (!ptr) return;
+    MemHeader* header = (MemHeader*)ptr - 1;
+    if (header->tracked) {
+        mem_account(header, -(int64_t)header->size);
+    }
+    free(header);
+}
+
+AICHAT_EXPORT int aichat_metrics_snapshot(AichatMetrics* out, int size) {
+    if (out && size > 0) {
+        AichatMetrics copy;
+        copy.op_count = METRICS_OP_COUNT;
+        copy.latency_buckets = METRICS_LATENCY_BUCKETS;
+
+        const uint64_t* src = (const uint64_t*)((const char*)&aichat_metrics + METRICS_FIRST_WORD);
+        uint64_t* dst = (uint64_t*)((char*)&copy + METRICS_FIRST_WORD);
+        for (size_t i = 0; i < METRICS_WORDS; i++) {
+            dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+        }
+
+        memcpy(out, &copy, (size_t)size < sizeof(copy) ? (size_t)size : sizeof(copy));
+    }
+    return (int)sizeof(AichatMetrics);
+}
+
+AICHAT_EXPORT void aichat_metrics_reset(void) {
+    uint64_t* words = (uint64_t*)((char*)&aichat_metrics + METRICS_FIRST_WORD);
+    for (size_t i = 0; i < METRICS_WORDS; i++) {
+        __atomic_store_n(&words[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+AICHAT_EXPORT const char* aichat_metrics_op_name(int op) {
+    return op >= 0 && op < METRICS_OP_COUNT ? OP_NAMES[op] : NULL;
+}
+
+AICHAT_EXPORT void aichat_memtrack_enable(int enabled) {
+    if (enabled) {
+        for (int s = 0; s < MEM_SUBSYSTEM_COUNT; s++) {
+            __atomic_store_n(&g_mem.peak[s], __atomic_load_n(&g_mem.current[s], __ATOMIC_RELAXED),
+                             __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&g_mem.total_peak, __atomic_load_n(&g_mem.total_current, __ATOMIC_RELAXED),
+                         __ATOMIC_RELAXED);
+        for (int op = 0; op < METRICS_OP_COUNT; op++) {
+            __atomic_store_n(&g_mem.call_peak[op], 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&g_mem.call_last_peak[op], 0, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_store_n(&g_mem_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+AICHAT_EXPORT int aichat_memtrack_snapshot(AichatMemStats* out, int size) {
+    if (out && size > 0) {
+        AichatMemStats copy;
+        copy.subsystem_count = MEM_SUBSYSTEM_COUNT;
+        copy.op_count = METRICS_OP_COUNT;
+        copy.enabled = (uint32_t)__atomic_load_n(&g_mem_enabled, __ATOMIC_RELAXED);
+        copy.reserved = 0;
+
+        const size_t first = offsetof(AichatMemStats, current);
+        const int64_t* src = (const int64_t*)((const char*)&g_mem + first);
+        int64_t* dst = (int64_t*)((char*)&copy + first);
+        for (size_t i = 0; i < (sizeof(AichatMemStats) - first) / sizeof(int64_t); i++) {
+            dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+        }
+
+        memcpy(out, &copy, (size_t)size < sizeof(copy) ? (size_t)size : sizeof(copy));
+    }
+    return (int)sizeof(AichatMemStats);
+}
+
+AICHAT_EXPORT const char* aichat_memtrack_subsystem_name(int subsystem) {
+    return subsystem >= 0 && subsystem < MEM_SUBSYSTEM_COUNT ? SUBSYSTEM_NAMES[subsystem] : NULL;
+}
@@ -1,5 +1,7 @@
 #define CL_TARGET_OPENCL_VERSION 120
 #include "../include/opencl_accel.h"
+#include "../include/trace.h"
+#include "../include/metrics.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -358,10 +360,22 @@ static int build_lut_gpu(const float* palette, int palette_size) {
         return -1;
     }
     
+    metrics_add(&aichat_metrics.lut_builds, 1);
     return 0;
 }
 
-AICHAT_EXPORT int opencl_resynthesize_image(
+static int resynthesize_streaming_gpu(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    const float* target_palette,
+    const float* source_palette,
+    int palette_size,
+    uint32_t* output_pixels,
+    int tile_height
+);
+
+static int resynthesize_image_gpu(
     const uint32_t* image_pixels,
     int width,
     int height,
@@ -380,15 +394,19 @@ AICHAT_EXPORT int opencl_resynthesize_image(
     size_t palette_bytes = palette_size * 3 * sizeof(float);
     
     if (image_bytes * 2 + palette_bytes * 2 + LUT_SIZE * 2 > g_cl.max_alloc_size) {
-        return opencl_resynthesize_streaming(image_pixels, width, height,
-                                              target_palette, source_palette, 
-                                              palette_size, output_pixels, 0);
+        return resynthesize_streaming_gpu(image_pixels, width, height,
+                                          target_palette, source_palette, 
+                                          palette_size, output_pixels, 0);
     }
     
+    // Enqueues are asynchronous: GPU time shows up in the blocking readback span
+    uint64_t span = trace_begin();
     if (build_lut_gpu(target_palette, palette_size) != 0) {
         return -1;
     }
+    trace_end("opencl.lut_build", span);
     
+    span = trace_begin();
     if (g_cl.source_palette_buffer) {
         err = clEnqueueWriteBuffer(g_cl.queue, g_cl.source_palette_buffer, CL_FALSE, 0,
                                     palette_bytes, source_palette, 0, NULL, NULL);
@@ -405,6 +423,7 @@ AICHAT_EXPORT int opencl_resynthesize_image(
         clReleaseMemObject(input_buffer);
         return -1;
     }
+    trace_end("opencl.upload", span);
     
     int lut_bits = LUT_BITS;
     int shift = SHIFT;
@@ -432,8 +451,10 @@ AICHAT_EXPORT int opencl_resynthesize_image(
         return -1;
     }
     
+    span = trace_begin();
     err = clEnqueueReadBuffer(g_cl.queue, output_buffer, CL_TRUE, 0,
                                image_bytes, output_pixels, 0, NULL, NULL);
+    trace_end("opencl.readback", span);
     
     clReleaseMemObject(input_buffer);
     clReleaseMemObject(output_buffer);
@@ -441,7 +462,7 @@ AICHAT_EXPORT int opencl_resynthesize_image(
     return (err == CL_SUCCESS) ? 0 : -1;
 }
 
-AICHAT_EXPORT int opencl_resynthesize_streaming(
+static int resynthesize_streaming_gpu(
     const uint32_t* image_pixels,
     int width,
     int height,
@@ -468,6 +489,7 @@ AICHAT_EXPORT int opencl_resynthesize_streaming(
     cl_int err;
     size_t palette_bytes = palette_size * 3 * sizeof(float);
     
+    uint64_t span = trace_begin();
     if (build_lut_gpu(target_palette, palette_size) != 0) {
         return -1;
     }
@@ -475,6 +497,7 @@ AICHAT_EXPORT int opencl_resynthesize_streaming(
     err = clEnqueueWriteBuffer(g_cl.queue, g_cl.source_palette_buffer, CL_TRUE, 0,
                                 palette_bytes, source_palette, 0, NULL, NULL);
     if (err != CL_SUCCESS) return -1;
+    trace_end("opencl_streaming.lut_build", span);
     
     size_t max_tile_pixels = (size_t)width * tile_height;
     size_t tile_bytes = max_tile_pixels * sizeof(uint32_t);
@@ -500,6 +523,7 @@ AICHAT_EXPORT int opencl_resynthesize_streaming(
     
     cl_event write_event = NULL, kernel_event = NULL, read_event = NULL;
     
+    span = trace_begin();
     for (int tile = 0; tile < num_tiles; tile++) {
         int y_start = tile * tile_height;
         int current_tile_height = (y_start + tile_height > height) ? (height - y_start) : tile_height;
@@ -543,6 +567,7 @@ AICHAT_EXPORT int opencl_resynthesize_streaming(
         
         buffer_idx = 1 - buffer_idx;
     }
+    trace_end("opencl_streaming.tiles", span);
     
     for (int i = 0; i < 2; i++) {
         clReleaseMemObject(input_buffers[i]);
@@ -558,6 +583,46 @@ cleanup:
     return -1;
 }
 
+// Failures are counted as GPU fallbacks: the caller redoes the work on the CPU
+static int count_gpu_call(uint64_t call, int result, int width, int height) {
+    if (result != 0) {
+        metrics_add(&aichat_metrics.gpu_fallbacks, 1);
+    }
+    metrics_call_end(METRICS_OP_GPU_RESYNTHESIZE, call, (uint64_t)width * (uint64_t)height);
+    return result;
+}
+
+AICHAT_EXPORT int opencl_resynthesize_image(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    const float* target_palette,
+    const float* source_palette,
+    int palette_size,
+    uint32_t* output_pixels
+) {
+    uint64_t call = metrics_call_begin();
+    int result = resynthesize_image_gpu(image_pixels, width, height, target_palette, source_palette,
+                                        palette_size, output_pixels);
+    return count_gpu_call(call, result, width, height);
+}
+
+AICHAT_EXPORT int opencl_resynthesize_streaming(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    const float* target_palette,
+    const float* source_palette,
+    int palette_size,
+    uint32_t* output_pixels,
+    int tile_height
+) {
+    uint64_t call = metrics_call_begin();
+    int result = resynthesize_streaming_gpu(image_pixels, width, height, target_palette, source_palette,
+                                            palette_size, output_pixels, tile_height);
+    return count_gpu_call(call, result, width, height);
+}
+
 AICHAT_EXPORT int opencl_build_lut(
     const float* palette,
     int palette_size,
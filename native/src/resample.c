@@ -0,0 +1,335 @@
+#include "../include/resample.h"
+#include "../include/trace.h"
+#include "../include/metrics.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define LANCZOS_LOBES 3
+
+// Column sums are uint32_t per channel, so a box may span at most this many rows
+#define BOX_MAX_ROWS (UINT32_MAX / 255u)
+
+static int valid_sizes(const uint32_t* src_pixels, int width, int height,
+                       const uint32_t* dst_pixels, int dst_width, int dst_height) {
+    return src_pixels && dst_pixels && width > 0 && height > 0 &&
+           dst_width > 0 && dst_height > 0 && dst_width <= width && dst_height <= height;
+}
+
+static int max_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static int thread_id(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// Source span [*lo, *hi) covered by output index i of n over size pixels
+static inline void box_span(int i, int n, int size, int* lo, int* hi) {
+    *lo = (int)((int64_t)i * size / n);
+    *hi = (int)((int64_t)(i + 1) * size / n);
+}
+
+// Per-column channel sums of rows [y0, y1), four uint32_t per column in
+// memory byte order (B, G, R, A)
+static void sum_rows(const uint32_t* src_pixels, int width, int y0, int y1, uint32_t* columns) {
+    memset(columns, 0, (size_t)width * 4 * sizeof(uint32_t));
+    for (int y = y0; y < y1; y++) {
+        const uint32_t* row = src_pixels + (size_t)y * width;
+        int x = 0;
+#ifdef __AVX2__
+        for (; x + 4 <= width; x += 4) {
+            __m128i px = _mm_loadu_si128((const __m128i*)(row + x));
+            __m256i* lo = (__m256i*)(columns + (size_t)x * 4);
+            __m256i* hi = (__m256i*)(columns + (size_t)x * 4 + 8);
+            _mm256_storeu_si256(lo, _mm256_add_epi32(_mm256_loadu_si256(lo), _mm256_cvtepu8_epi32(px)));
+            _mm256_storeu_si256(hi, _mm256_add_epi32(_mm256_loadu_si256(hi),
+                _mm256_cvtepu8_epi32(_mm_srli_si128(px, 8))));
+        }
+#endif
+        for (; x < width; x++) {
+            uint32_t p = row[x];
+            uint32_t* c = columns + (size_t)x * 4;
+            c[0] += p & 0xFF;
+            c[1] += (p >> 8) & 0xFF;
+            c[2] += (p >> 16) & 0xFF;
+            c[3] += p >> 24;
+        }
+    }
+}
+
+AICHAT_EXPORT int downscale_box(
+    const uint32_t* src_pixels,
+    int width,
+    int height,
+    uint32_t* dst_pixels,
+    int dst_width,
+    int dst_height
+) {
+    if (!valid_sizes(src_pixels, width, height, dst_pixels, dst_width, dst_height) ||
+        (uint32_t)(height / dst_height + 1) > BOX_MAX_ROWS) {
+        return 0;
+    }
+
+    uint64_t call = metrics_call_begin();
+    uint64_t span = trace_begin();
+
+    int threads = max_threads();
+    size_t stride = (size_t)width * 4;
+    uint32_t* columns = (uint32_t*)metrics_malloc(MEM_RESAMPLE, (size_t)threads * stride * sizeof(uint32_t));
+    if (!columns) {
+        trace_end("downscale_box", span);
+        metrics_call_end(METRICS_OP_RESAMPLE, call, 0);
+        return 0;
+    }
+
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(dynamic, 8)
+    for (int dy = 0; dy < dst_height; dy++) {
+        int y0, y1;
+        box_span(dy, dst_height, height, &y0, &y1);
+        uint32_t* sums = columns + (size_t)thread_id() * stride;
+        sum_rows(src_pixels, width, y0, y1, sums);
+        uint32_t* out = dst_pixels + (size_t)dy * dst_width;
+
+        for (int dx = 0; dx < dst_width; dx++) {
+            int x0, x1;
+            box_span(dx, dst_width, width, &x0, &x1);
+
+            uint64_t s[4];
+#ifdef __AVX2__
+            __m256i acc = _mm256_setzero_si256();
+            for (int x = x0; x < x1; x++) {
+                __m128i c = _mm_loadu_si128((const __m128i*)(sums + (size_t)x * 4));
+                acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(c));
+            }
+            _mm256_storeu_si256((__m256i*)s, acc);
+#else
+            s[0] = s[1] = s[2] = 0;
+            for (int x = x0; x < x1; x++) {
+                const uint32_t* c = sums + (size_t)x * 4;
+                s[0] += c[0];
+                s[1] += c[1];
+                s[2] += c[2];
+            }
+#endif
+
+            uint64_t count = (uint64_t)(x1 - x0) * (uint64_t)(y1 - y0);
+            uint64_t half = count / 2;
+            out[dx] = 0xFF000000u
+                | (uint32_t)((s[2] + half) / count) << 16
+                | (uint32_t)((s[1] + half) / count) << 8
+                | (uint32_t)((s[0] + half) / count);
+        }
+    }
+
+    metrics_free(columns);
+    trace_end("downscale_box", span);
+    metrics_call_end(METRICS_OP_RESAMPLE, call, (uint64_t)width * height);
+    return 1;
+}
+
+static double lanczos3(double x) {
+    if (x == 0.0) return 1.0;
+    if (x <= -LANCZOS_LOBES || x >= LANCZOS_LOBES) return 0.0;
+    double px = M_PI * x;
+    return LANCZOS_LOBES * sin(px) * sin(px / LANCZOS_LOBES) / (px * px);
+}
+
+// Most taps any output index of a size -> n downscale can have
+static int lanczos_max_taps(int n, int size) {
+    double support = LANCZOS_LOBES * (double)size / n;
+    return (int)ceil(2.0 * support) + 2;
+}
+
+// Normalized weights of output indices 0..n-1 over size source pixels:
+// index i reads taps[i] pixels from first[i], weights at weights + i * max_taps
+static void lanczos_weights(int n, int size, int max_taps, int* first, int* taps, float* weights) {
+    double scale = (double)size / n;
+    double support = LANCZOS_LOBES * scale;
+    for (int i = 0; i < n; i++) {
+        double center = (i + 0.5) * scale;
+        int lo = (int)floor(center - support);
+        int hi = (int)ceil(center + support);
+        if (lo < 0) lo = 0;
+        if (hi > size) hi = size;
+        if (hi - lo > max_taps) hi = lo + max_taps;
+
+        float* w = weights + (size_t)i * max_taps;
+        double total = 0.0;
+        for (int j = lo; j < hi; j++) {
+            double v = lanczos3((j + 0.5 - center) / scale);
+            w[j - lo] = (float)v;
+            total += v;
+        }
+        for (int j = 0; j < hi - lo; j++) {
+            w[j] = (float)(w[j] / total);
+        }
+        first[i] = lo;
+        taps[i] = hi - lo;
+    }
+}
+
+// One source row filtered horizontally to dst_width pixels of four floats
+static void lanczos_row(const uint32_t* row, int dst_width, int max_taps,
+                        const int* first, const int* taps, const float* weights, float* out) {
+    for (int dx = 0; dx < dst_width; dx++) {
+        const uint32_t* px = row + first[dx];
+        const float* w = weights + (size_t)dx * max_taps;
+#ifdef __AVX2__
+        __m128 acc = _mm_setzero_ps();
+        for (int t = 0; t < taps[dx]; t++) {
+            __m128 v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)px[t])));
+            acc = _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(w[t])));
+        }
+        _mm_storeu_ps(out + (size_t)dx * 4, acc);
+#else
+        float b = 0.0f, g = 0.0f, r = 0.0f;
+        for (int t = 0; t < taps[dx]; t++) {
+            uint32_t p = px[t];
+            b += (float)(p & 0xFF) * w[t];
+            g += (float)((p >> 8) & 0xFF) * w[t];
+            r += (float)((p >> 16) & 0xFF) * w[t];
+        }
+        float* o = out + (size_t)dx * 4;
+        o[0] = b;
+        o[1] = g;
+        o[2] = r;
+        o[3] = 0.0f;
+#endif
+    }
+}
+
+static inline uint32_t clamp_channel(float v) {
+    v = v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+    return (uint32_t)(v + 0.5f);
+}
+
+AICHAT_EXPORT int downscale_lanczos3(
+    const uint32_t* src_pixels,
+    int width,
+    int height,
+    uint32_t* dst_pixels,
+    int dst_width,
+    int dst_height
+) {
+    if (!valid_sizes(src_pixels, width, height, dst_pixels, dst_width, dst_height)) {
+        return 0;
+    }
+
+    uint64_t call = metrics_call_begin();
+    uint64_t span = trace_begin();
+
+    int max_x_taps = lanczos_max_taps(dst_width, width);
+    int max_y_taps = lanczos_max_taps(dst_height, height);
+    int threads = max_threads();
+    size_t row_floats = (size_t)dst_width * 4;
+    // Each thread caches the last max_y_taps filtered rows, slot = row % max_y_taps
+    size_t cache_floats = (size_t)max_y_taps * row_floats;
+
+    int* x_first = (int*)metrics_malloc(MEM_RESAMPLE, (size_t)dst_width * 2 * sizeof(int));
+    int* y_first = (int*)metrics_malloc(MEM_RESAMPLE, (size_t)dst_height * 2 * sizeof(int));
+    float* x_weights = (float*)metrics_malloc(MEM_RESAMPLE, (size_t)dst_width * max_x_taps * sizeof(float));
+    float* y_weights = (float*)metrics_malloc(MEM_RESAMPLE, (size_t)dst_height * max_y_taps * sizeof(float));
+    float* cache = (float*)metrics_malloc(MEM_RESAMPLE, (size_t)threads * (cache_floats + row_floats) * sizeof(float));
+    int* tags = (int*)metrics_malloc(MEM_RESAMPLE, (size_t)threads * max_y_taps * sizeof(int));
+    if (!x_first || !y_first || !x_weights || !y_weights || !cache || !tags) {
+        metrics_free(x_first);
+        metrics_free(y_first);
+        metrics_free(x_weights);
+        metrics_free(y_weights);
+        metrics_free(cache);
+        metrics_free(tags);
+        trace_end("downscale_lanczos3", span);
+        metrics_call_end(METRICS_OP_RESAMPLE, call, 0);
+        return 0;
+    }
+    int* x_taps = x_first + dst_width;
+    int* y_taps = y_first + dst_height;
+    lanczos_weights(dst_width, width, max_x_taps, x_first, x_taps, x_weights);
+    lanczos_weights(dst_height, height, max_y_taps, y_first, y_taps, y_weights);
+    for (int i = 0; i < threads * max_y_taps; i++) tags[i] = -1;
+
+    METRICS_OMP_REGION();
+    // Contiguous row blocks per thread, so consecutive windows hit the row cache
+    #pragma omp parallel for schedule(static)
+    for (int dy = 0; dy < dst_height; dy++) {
+        int tid = thread_id();
+        float* rows = cache + (size_t)tid * (cache_floats + row_floats);
+        float* acc = rows + cache_floats;
+        int* row_tags = tags + (size_t)tid * max_y_taps;
+        const float* w = y_weights + (size_t)dy * max_y_taps;
+
+        memset(acc, 0, row_floats * sizeof(float));
+        for (int t = 0; t < y_taps[dy]; t++) {
+            int y = y_first[dy] + t;
+            int slot = y % max_y_taps;
+            float* row = rows + (size_t)slot * row_floats;
+            if (row_tags[slot] != y) {
+                lanczos_row(src_pixels + (size_t)y * width, dst_width, max_x_taps,
+                            x_first, x_taps, x_weights, row);
+                row_tags[slot] = y;
+            }
+
+            size_t i = 0;
+#ifdef __AVX2__
+            __m256 wt = _mm256_set1_ps(w[t]);
+            for (; i + 8 <= row_floats; i += 8) {
+                __m256 a = _mm256_loadu_ps(acc + i);
+                _mm256_storeu_ps(acc + i, _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(row + i), wt)));
+            }
+#endif
+            for (; i < row_floats; i++) {
+                acc[i] += row[i] * w[t];
+            }
+        }
+
+        uint32_t* out = dst_pixels + (size_t)dy * dst_width;
+        int dx = 0;
+#ifdef __AVX2__
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 max = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; dx < dst_width; dx++) {
+            __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(acc + (size_t)dx * 4), zero), max);
+            __m128i c = _mm_cvttps_epi32(_mm_add_ps(v, half));
+            c = _mm_packus_epi16(_mm_packus_epi32(c, c), c);
+            out[dx] = 0xFF000000u | ((uint32_t)_mm_cvtsi128_si32(c) & 0xFFFFFFu);
+        }
+#endif
+        for (; dx < dst_width; dx++) {
+            const float* v = acc + (size_t)dx * 4;
+            out[dx] = 0xFF000000u | clamp_channel(v[2]) << 16 | clamp_channel(v[1]) << 8 | clamp_channel(v[0]);
+        }
+    }
+
+    metrics_free(x_first);
+    metrics_free(y_first);
+    metrics_free(x_weights);
+    metrics_free(y_weights);
+    metrics_free(cache);
+    metrics_free(tags);
+    trace_end("downscale_lanczos3", span);
+    metrics_call_end(METRICS_OP_RESAMPLE, call, (uint64_t)width * height);
+    return 1;
+}
@@ -0,0 +1,269 @@
+#include "../include/slic.h"
+#include "../include/color.h"
+#include "../include/image.h"
+#include "../include/metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Per-center accumulator layout: L, a, b, x, y, R, G, B sums and pixel count
+#define SLIC_FIELDS 9
+#define SLIC_DEFAULT_COMPACTNESS 10.0f
+#define SLIC_DEFAULT_ITERATIONS 10
+// Stop once no center moves further than this in the combined Lab+xy metric
+#define SLIC_CONVERGENCE 0.5f
+
+typedef struct {
+    float l, a, b;
+    float x, y;
+} SlicCenter;
+
+// Smallest grid step whose cell count fits in max_superpixels
+static int slic_grid_step(int width, int height, int max_superpixels) {
+    int step = (int)ceil(sqrt((double)width * height / max_superpixels));
+    if (step < 1) step = 1;
+
+    while ((int64_t)((width + step - 1) / step) * ((height + step - 1) / step) > max_superpixels) {
+        step++;
+    }
+    return step;
+}
+
+// Assign every pixel of one grid row (a strip of `step` image rows) to the
+// nearest of the centers seeded in its 3x3 neighbouring cells and add it to
+// that center's sums. best_dist/best_index are scratch of `step` entries.
+static void slic_assign_strip(
+    const uint32_t* image_pixels,
+    const ColorPoint3f* lab,
+    int width,
+    int height,
+    int step,
+    int grid_w,
+    int grid_h,
+    int strip,
+    const SlicCenter* centers,
+    float spatial_weight,
+    float* best_dist,
+    int* best_index,
+    double* acc
+) {
+    int y_start = strip * step;
+    int y_end = y_start + step < height ? y_start + step : height;
+    int gy_start = strip > 0 ? strip - 1 : 0;
+    int gy_end = strip + 1 < grid_h ? strip + 1 : grid_h - 1;
+
+    for (int y = y_start; y < y_end; y++) {
+        for (int cx = 0; cx < grid_w; cx++) {
+            int gx_start = cx > 0 ? cx - 1 : 0;
+            int gx_end = cx + 1 < grid_w ? cx + 1 : grid_w - 1;
+
+            int candidates[9];
+            int num_candidates = 0;
+            for (int gy = gy_start; gy <= gy_end; gy++) {
+                for (int gx = gx_start; gx <= gx_end; gx++) {
+                    candidates[num_candidates++] = gy * grid_w + gx;
+                }
+            }
+
+            int x_start = cx * step;
+            int x_end = x_start + step < width ? x_start + step : width;
+            int len = x_end - x_start;
+            const ColorPoint3f* row = lab + (size_t)y * width + x_start;
+
+            // Candidate-major so the distance loop runs over contiguous pixels
+            for (int x = 0; x < len; x++) {
+                best_dist[x] = FLT_MAX;
+                best_index[x] = candidates[0];
+            }
+            for (int j = 0; j < num_candidates; j++) {
+                const SlicCenter* c = &centers[candidates[j]];
+                float dy = (float)y - c->y;
+                float dy_term = spatial_weight * dy * dy;
+                float cx_rel = c->x - (float)x_start;
+                int index = candidates[j];
+                for (int x = 0; x < len; x++) {
+                    float dl = row[x].c1 - c->l;
+                    float da = row[x].c2 - c->a;
+                    float db = row[x].c3 - c->b;
+                    float dx = (float)x - cx_rel;
+                    float dist = dl * dl + da * da + db * db + spatial_weight * dx * dx + dy_term;
+                    if (dist < best_dist[x]) {
+                        best_dist[x] = dist;
+                        best_index[x] = index;
+                    }
+                }
+            }
+
+            for (int x = x_start; x < x_end; x++) {
+                size_t i = (size_t)y * width + x;
+                const ColorPoint3f* p = &lab[i];
+                int best = best_index[x - x_start];
+
+                uint32_t pixel = image_pixels[i];
+                double* a = acc + (size_t)best * SLIC_FIELDS;
+                a[0] += p->c1;
+                a[1] += p->c2;
+                a[2] += p->c3;
+                a[3] += x;
+                a[4] += y;
+                a[5] += (pixel >> 16) & 0xFF;
+                a[6] += (pixel >> 8) & 0xFF;
+                a[7] += pixel & 0xFF;
+                a[8] += 1.0;
+            }
+        }
+    }
+}
+
+AICHAT_EXPORT int slic_superpixels(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    int max_superpixels,
+    float compactness,
+    int max_iterations,
+    ColorPoint3f* means,
+    float* areas
+) {
+    if (width <= 0 || height <= 0 || max_superpixels <= 0) return 0;
+    if ((int64_t)width * height > INT32_MAX) return 0;
+    if (compactness <= 0.0f) compactness = SLIC_DEFAULT_COMPACTNESS;
+    if (max_iterations <= 0) max_iterations = SLIC_DEFAULT_ITERATIONS;
+
+    int n = width * height;
+    uint64_t call = metrics_call_begin();
+    int step = slic_grid_step(width, height, max_superpixels);
+    int grid_w = (width + step - 1) / step;
+    int grid_h = (height + step - 1) / step;
+    int num_centers = grid_w * grid_h;
+    // Color distance is traded against distance in grid steps
+    float spatial_weight = (compactness / step) * (compactness / step);
+
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+
+    ColorPoint3f* lab = (ColorPoint3f*)metrics_malloc(MEM_SLIC, (size_t)n * sizeof(ColorPoint3f));
+    SlicCenter* centers = (SlicCenter*)metrics_malloc(MEM_SLIC, (size_t)num_centers * sizeof(SlicCenter));
+    double* accumulators = (double*)metrics_malloc(MEM_SLIC, (size_t)num_threads * num_centers * SLIC_FIELDS * sizeof(double));
+    float* scratch_dist = (float*)metrics_malloc(MEM_SLIC, (size_t)num_threads * step * sizeof(float));
+    int* scratch_index = (int*)metrics_malloc(MEM_SLIC, (size_t)num_threads * step * sizeof(int));
+    if (!lab || !centers || !accumulators || !scratch_dist || !scratch_index) {
+        metrics_free(lab);
+        metrics_free(centers);
+        metrics_free(accumulators);
+        metrics_free(scratch_dist);
+        metrics_free(scratch_index);
+        metrics_call_end(METRICS_OP_SLIC, call, (uint64_t)n);
+        return 0;
+    }
+
+    extract_pixels(image_pixels, n, lab);
+    rgb_to_lab_batch(lab, lab, n);
+
+    // Seed one center in the middle of every grid cell
+    for (int gy = 0; gy < grid_h; gy++) {
+        for (int gx = 0; gx < grid_w; gx++) {
+            int x = gx * step + step / 2;
+            int y = gy * step + step / 2;
+            if (x >= width) x = width - 1;
+            if (y >= height) y = height - 1;
+
+            const ColorPoint3f* p = &lab[(size_t)y * width + x];
+            SlicCenter* c = &centers[gy * grid_w + gx];
+            c->l = p->c1;
+            c->a = p->c2;
+            c->b = p->c3;
+            c->x = (float)x;
+            c->y = (float)y;
+        }
+    }
+
+    for (int iteration = 0; iteration < max_iterations; iteration++) {
+        memset(accumulators, 0, (size_t)num_threads * num_centers * SLIC_FIELDS * sizeof(double));
+
+        METRICS_OMP_REGION();
+        #pragma omp parallel num_threads(num_threads) if(n > 65536)
+        {
+            int tid = 0;
+#ifdef _OPENMP
+            tid = omp_get_thread_num();
+#endif
+            double* acc = accumulators + (size_t)tid * num_centers * SLIC_FIELDS;
+            float* best_dist = scratch_dist + (size_t)tid * step;
+            int* best_index = scratch_index + (size_t)tid * step;
+
+            // Static strips keep each thread's summation order fixed between runs
+            #pragma omp for schedule(static)
+            for (int strip = 0; strip < grid_h; strip++) {
+                slic_assign_strip(image_pixels, lab, width, height, step, grid_w, grid_h,
+                                  strip, centers, spatial_weight, best_dist, best_index, acc);
+            }
+        }
+
+        // Reduce in thread order so a given thread count is reproducible
+        for (int t = 1; t < num_threads; t++) {
+            const double* src = accumulators + (size_t)t * num_centers * SLIC_FIELDS;
+            for (size_t j = 0; j < (size_t)num_centers * SLIC_FIELDS; j++) {
+                accumulators[j] += src[j];
+            }
+        }
+
+        float max_movement = 0.0f;
+        for (int c = 0; c < num_centers; c++) {
+            const double* a = accumulators + (size_t)c * SLIC_FIELDS;
+            // An empty superpixel keeps its previous center
+            if (a[8] == 0.0) continue;
+
+            double inv_count = 1.0 / a[8];
+            SlicCenter updated = {
+                (float)(a[0] * inv_count), (float)(a[1] * inv_count), (float)(a[2] * inv_count),
+                (float)(a[3] * inv_count), (float)(a[4] * inv_count)
+            };
+
+            float dl = updated.l - centers[c].l;
+            float da = updated.a - centers[c].a;
+            float db = updated.b - centers[c].b;
+            float dx = updated.x - centers[c].x;
+            float dy = updated.y - centers[c].y;
+            float movement = dl * dl + da * da + db * db + spatial_weight * (dx * dx + dy * dy);
+            if (movement > max_movement) {
+                max_movement = movement;
+            }
+            centers[c] = updated;
+        }
+
+        if (sqrtf(max_movement) < SLIC_CONVERGENCE) {
+            break;
+        }
+    }
+
+    // The sums of the last assignment pass give each superpixel's mean color
+    int count = 0;
+    for (int c = 0; c < num_centers; c++) {
+        const double* a = accumulators + (size_t)c * SLIC_FIELDS;
+        if (a[8] == 0.0) continue;
+
+        double inv_count = 1.0 / a[8];
+        means[count].c1 = (float)(a[5] * inv_count);
+        means[count].c2 = (float)(a[6] * inv_count);
+        means[count].c3 = (float)(a[7] * inv_count);
+        areas[count] = (float)a[8];
+        count++;
+    }
+
+    metrics_free(lab);
+    metrics_free(centers);
+    metrics_free(accumulators);
+    metrics_free(scratch_dist);
+    metrics_free(scratch_index);
+
+    metrics_call_end(METRICS_OP_SLIC, call, (uint64_t)n);
+    return count;
+}
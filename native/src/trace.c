@@ -0,0 +1,188 @@
+#include "../include/trace.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <pthread.h>
+#endif
+
+typedef struct {
+    TraceEvent events[TRACE_RING_CAPACITY];
+    uint64_t count;  // spans ever recorded; the next slot is count % capacity
+    int32_t thread_id;
+    int32_t owned;   // 0 once the owning thread has exited
+} TraceRing;
+
+int aichat_trace_active = 0;
+
+// Rings are never freed: a thread's spans stay collectable after it exits,
+// and its ring is handed to the next new thread, which overwrites them
+static TraceRing* g_rings[TRACE_MAX_THREADS];
+static int g_ring_slots = 0;
+static int32_t g_next_thread_id = 0;
+static int g_dropped_threads = 0;
+
+static __thread TraceRing* tls_ring = NULL;
+static __thread int tls_ring_unavailable = 0;
+
+// Thread-exit hook that gives the exiting thread's ring back
+static void ring_release(void* ring) {
+    tls_ring = NULL;
+    tls_ring_unavailable = 1;
+    __atomic_store_n(&((TraceRing*)ring)->owned, 0, __ATOMIC_RELEASE);
+}
+
+#ifdef _WIN32
+static DWORD g_ring_key = FLS_OUT_OF_INDEXES;
+static INIT_ONCE g_ring_key_once = INIT_ONCE_STATIC_INIT;
+
+static void WINAPI ring_release_fls(void* ring) {
+    if (ring) ring_release(ring);
+}
+
+static BOOL CALLBACK ring_key_create(PINIT_ONCE once, void* param, void** context) {
+    (void)once; (void)param; (void)context;
+    g_ring_key = FlsAlloc(ring_release_fls);
+    return TRUE;
+}
+
+// Without the hook the ring simply stays owned, as if the thread lived on
+static void ring_watch_exit(TraceRing* ring) {
+    InitOnceExecuteOnce(&g_ring_key_once, ring_key_create, NULL, NULL);
+    if (g_ring_key != FLS_OUT_OF_INDEXES) FlsSetValue(g_ring_key, ring);
+}
+#else
+static pthread_key_t g_ring_key;
+static pthread_once_t g_ring_key_once = PTHREAD_ONCE_INIT;
+static int g_ring_key_ready = 0;
+
+static void ring_key_create(void) {
+    g_ring_key_ready = pthread_key_create(&g_ring_key, ring_release) == 0;
+}
+
+// Without the hook the ring simply stays owned, as if the thread lived on
+static void ring_watch_exit(TraceRing* ring) {
+    pthread_once(&g_ring_key_once, ring_key_create);
+    if (g_ring_key_ready) pthread_setspecific(g_ring_key, ring);
+}
+#endif
+
+uint64_t trace_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static int ring_count(void) {
+    int slots = __atomic_load_n(&g_ring_slots, __ATOMIC_ACQUIRE);
+    return slots < TRACE_MAX_THREADS ? slots : TRACE_MAX_THREADS;
+}
+
+static TraceRing* ring_for_thread(void) {
+    if (LIKELY(tls_ring != NULL)) return tls_ring;
+    if (tls_ring_unavailable) return NULL;
+
+    // Prefer a ring left behind by an exited thread
+    TraceRing* ring = NULL;
+    int rings = ring_count();
+    for (int r = 0; r < rings && !ring; r++) {
+        TraceRing* candidate = __atomic_load_n(&g_rings[r], __ATOMIC_ACQUIRE);
+        int32_t free_ring = 0;
+        if (candidate && __atomic_compare_exchange_n(&candidate->owned, &free_ring, 1, 0,
+                                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            ring = candidate;
+        }
+    }
+
+    if (!ring) {
+        int slot = __atomic_fetch_add(&g_ring_slots, 1, __ATOMIC_ACQ_REL);
+        ring = slot < TRACE_MAX_THREADS ? (TraceRing*)calloc(1, sizeof(TraceRing)) : NULL;
+        if (!ring) {
+            // Spans of this thread are lost for its lifetime
+            __atomic_add_fetch(&g_dropped_threads, 1, __ATOMIC_RELAXED);
+            tls_ring_unavailable = 1;
+            return NULL;
+        }
+        ring->owned = 1;
+        __atomic_store_n(&g_rings[slot], ring, __ATOMIC_RELEASE);
+    }
+
+    // A fresh id per thread, so recycled rings never mix two threads' ids
+    ring->thread_id = __atomic_add_fetch(&g_next_thread_id, 1, __ATOMIC_RELAXED);
+    ring_watch_exit(ring);
+    tls_ring = ring;
+    return ring;
+}
+
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    TraceRing* ring = ring_for_thread();
+    if (!ring) return;
+
+    uint64_t i = ring->count;
+    TraceEvent* e = &ring->events[i % TRACE_RING_CAPACITY];
+    e->start_ns = start_ns;
+    e->duration_ns = end_ns - start_ns;
+    e->name = name;
+    e->thread_id = ring->thread_id;
+    e->reserved = 0;
+    __atomic_store_n(&ring->count, i + 1, __ATOMIC_RELEASE);
+}
+
+AICHAT_EXPORT void aichat_trace_enable(int enabled) {
+    __atomic_store_n(&aichat_trace_active, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+AICHAT_EXPORT int aichat_trace_is_enabled(void) {
+    return __atomic_load_n(&aichat_trace_active, __ATOMIC_RELAXED);
+}
+
+AICHAT_EXPORT uint64_t aichat_trace_now_ns(void) {
+    return trace_now_ns();
+}
+
+AICHAT_EXPORT int aichat_trace_collect(TraceEvent* out, int capacity) {
+    int total = 0;
+    int rings = ring_count();
+
+    for (int r = 0; r < rings; r++) {
+        TraceRing* ring = __atomic_load_n(&g_rings[r], __ATOMIC_ACQUIRE);
+        if (!ring) continue;  // slot claimed, ring not published yet
+
+        uint64_t count = __atomic_load_n(&ring->count, __ATOMIC_ACQUIRE);
+        uint64_t first = count > TRACE_RING_CAPACITY ? count - TRACE_RING_CAPACITY : 0;
+        for (uint64_t i = first; i < count; i++) {
+            if (out && total < capacity) {
+                out[total] = ring->events[i % TRACE_RING_CAPACITY];
+            }
+            total++;
+        }
+    }
+
+    return total;
+}
+
+AICHAT_EXPORT int aichat_trace_dropped_threads(void) {
+    return __atomic_load_n(&g_dropped_threads, __ATOMIC_RELAXED);
+}
+
+AICHAT_EXPORT void aichat_trace_clear(void) {
+    int rings = ring_count();
+    for (int r = 0; r < rings; r++) {
+        TraceRing* ring = __atomic_load_n(&g_rings[r], __ATOMIC_ACQUIRE);
+        if (ring) {
+            __atomic_store_n(&ring->count, 0, __ATOMIC_RELEASE);
+        }
+    }
+}
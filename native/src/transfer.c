@@ -0,0 +1,208 @@
+#include "../include/transfer.h"
+#include "../include/color.h"
+#include "../include/trace.h"
+#include "../include/metrics.h"
+#include <stdint.h>
+#include <math.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define LUT_NODES (TRANSFER_LUT_SIZE * TRANSFER_LUT_SIZE * TRANSFER_LUT_SIZE)
+
+// Below this deviation a channel is treated as flat and only shifted
+#define MIN_STDDEV 1e-3f
+
+static void pixel_to_lab(uint32_t p, ColorPoint3f* lab) {
+    ColorPoint3f rgb = {
+        (float)((p >> 16) & 0xFF),
+        (float)((p >> 8) & 0xFF),
+        (float)(p & 0xFF)
+    };
+    rgb_to_lab_single(&rgb, lab);
+}
+
+AICHAT_EXPORT int lab_statistics(
+    const uint32_t* pixels,
+    int width,
+    int height,
+    int max_samples,
+    float* stats
+) {
+    if (!pixels || !stats || width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    uint64_t call = metrics_call_begin();
+    uint64_t span = trace_begin();
+
+    // A square grid, so samples never line up with a single column
+    int64_t total = (int64_t)width * height;
+    int stride = 1;
+    if (max_samples > 0 && total > max_samples) {
+        stride = (int)ceil(sqrt((double)total / max_samples));
+    }
+    int rows = (height + stride - 1) / stride;
+    int cols = (width + stride - 1) / stride;
+    int64_t samples = (int64_t)rows * cols;
+
+    double sum_l = 0, sum_a = 0, sum_b = 0;
+    double sq_l = 0, sq_a = 0, sq_b = 0;
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(static) reduction(+:sum_l,sum_a,sum_b,sq_l,sq_a,sq_b) if(samples > 4096)
+    for (int sy = 0; sy < rows; sy++) {
+        const uint32_t* row = pixels + (int64_t)sy * stride * width;
+        for (int sx = 0; sx < cols; sx++) {
+            ColorPoint3f lab;
+            pixel_to_lab(row[sx * stride], &lab);
+            sum_l += lab.c1;
+            sum_a += lab.c2;
+            sum_b += lab.c3;
+            sq_l += (double)lab.c1 * lab.c1;
+            sq_a += (double)lab.c2 * lab.c2;
+            sq_b += (double)lab.c3 * lab.c3;
+        }
+    }
+
+    double n = (double)samples;
+    double mean[3] = { sum_l / n, sum_a / n, sum_b / n };
+    double sq[3] = { sq_l / n, sq_a / n, sq_b / n };
+    for (int c = 0; c < 3; c++) {
+        stats[c] = (float)mean[c];
+        stats[3 + c] = (float)sqrt(fmax(0.0, sq[c] - mean[c] * mean[c]));
+    }
+
+    trace_end("lab_statistics", span);
+    metrics_call_end(METRICS_OP_TRANSFER, call, (uint64_t)samples);
+    return samples > INT32_MAX ? INT32_MAX : (int)samples;
+}
+
+// Transferred color of every grid node, as {b, g, r, 0} floats so one
+// 128-bit lane group holds a node and packs straight to 0x00RRGGBB
+static void build_transfer_lut(float* lut, const float* scale, const float* offset) {
+    const float step = 255.0f / (TRANSFER_LUT_SIZE - 1);
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < LUT_NODES; i++) {
+        int r = i / (TRANSFER_LUT_SIZE * TRANSFER_LUT_SIZE);
+        int g = (i / TRANSFER_LUT_SIZE) % TRANSFER_LUT_SIZE;
+        int b = i % TRANSFER_LUT_SIZE;
+        ColorPoint3f rgb = { r * step, g * step, b * step };
+        ColorPoint3f lab;
+        rgb_to_lab_single(&rgb, &lab);
+        lab.c1 = lab.c1 * scale[0] + offset[0];
+        lab.c2 = lab.c2 * scale[1] + offset[1];
+        lab.c3 = lab.c3 * scale[2] + offset[2];
+        lab_to_rgb_single(&lab, &rgb);
+        float* node = lut + (size_t)i * 4;
+        node[0] = rgb.c3;
+        node[1] = rgb.c2;
+        node[2] = rgb.c1;
+        node[3] = 0.0f;
+    }
+}
+
+AICHAT_EXPORT int reinhard_transfer(
+    const uint32_t* image_pixels,
+    int width,
+    int height,
+    const float* source_stats,
+    const float* target_stats,
+    uint32_t* output_pixels
+) {
+    if (!image_pixels || !output_pixels || !source_stats || !target_stats ||
+        width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    uint64_t call = metrics_call_begin();
+    uint64_t span = trace_begin();
+
+    float* lut = (float*)metrics_malloc(MEM_LUT, (size_t)LUT_NODES * 4 * sizeof(float));
+    if (!lut) {
+        trace_end("reinhard_transfer", span);
+        metrics_call_end(METRICS_OP_TRANSFER, call, 0);
+        return 0;
+    }
+
+    float scale[3], offset[3];
+    for (int c = 0; c < 3; c++) {
+        float deviation = target_stats[3 + c];
+        scale[c] = deviation > MIN_STDDEV ? source_stats[3 + c] / deviation : 1.0f;
+        offset[c] = source_stats[c] - target_stats[c] * scale[c];
+    }
+    uint64_t build_span = trace_begin();
+    build_transfer_lut(lut, scale, offset);
+    trace_end("reinhard_transfer.lut_build", build_span);
+
+    // Lower grid node and weight of every 8-bit channel value
+    int cell[256];
+    float weight[256];
+    for (int v = 0; v < 256; v++) {
+        float x = v * (float)(TRANSFER_LUT_SIZE - 1) / 255.0f;
+        int i = (int)x;
+        if (i > TRANSFER_LUT_SIZE - 2) i = TRANSFER_LUT_SIZE - 2;
+        cell[v] = i;
+        weight[v] = x - i;
+    }
+
+    const int db = 4;
+    const int dg = TRANSFER_LUT_SIZE * 4;
+    const int dr = TRANSFER_LUT_SIZE * TRANSFER_LUT_SIZE * 4;
+    int64_t total = (int64_t)width * height;
+
+    METRICS_OMP_REGION();
+    #pragma omp parallel for schedule(static, 32768)
+    for (int64_t i = 0; i < total; i++) {
+        uint32_t p = image_pixels[i];
+        int r = (p >> 16) & 0xFF;
+        int g = (p >> 8) & 0xFF;
+        int b = p & 0xFF;
+        const float* c000 = lut + ((cell[r] * TRANSFER_LUT_SIZE + cell[g]) * TRANSFER_LUT_SIZE + cell[b]) * 4;
+#ifdef __AVX2__
+        __m128 wb = _mm_set1_ps(weight[b]);
+        __m128 wg = _mm_set1_ps(weight[g]);
+        __m128 wr = _mm_set1_ps(weight[r]);
+        __m128 v000 = _mm_loadu_ps(c000);
+        __m128 v001 = _mm_loadu_ps(c000 + db);
+        __m128 v010 = _mm_loadu_ps(c000 + dg);
+        __m128 v011 = _mm_loadu_ps(c000 + dg + db);
+        __m128 v100 = _mm_loadu_ps(c000 + dr);
+        __m128 v101 = _mm_loadu_ps(c000 + dr + db);
+        __m128 v110 = _mm_loadu_ps(c000 + dr + dg);
+        __m128 v111 = _mm_loadu_ps(c000 + dr + dg + db);
+        __m128 v00 = _mm_add_ps(v000, _mm_mul_ps(_mm_sub_ps(v001, v000), wb));
+        __m128 v01 = _mm_add_ps(v010, _mm_mul_ps(_mm_sub_ps(v011, v010), wb));
+        __m128 v10 = _mm_add_ps(v100, _mm_mul_ps(_mm_sub_ps(v101, v100), wb));
+        __m128 v11 = _mm_add_ps(v110, _mm_mul_ps(_mm_sub_ps(v111, v110), wb));
+        __m128 v0 = _mm_add_ps(v00, _mm_mul_ps(_mm_sub_ps(v01, v00), wg));
+        __m128 v1 = _mm_add_ps(v10, _mm_mul_ps(_mm_sub_ps(v11, v10), wg));
+        __m128 v = _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), wr));
+        __m128i c = _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+        c = _mm_packus_epi32(c, c);
+        c = _mm_packus_epi16(c, c);
+        output_pixels[i] = (uint32_t)_mm_cvtsi128_si32(c) & 0xFFFFFFu;
+#else
+        float fb = weight[b], fg = weight[g], fr = weight[r];
+        uint32_t packed = 0;
+        for (int k = 2; k >= 0; k--) {
+            const float* n = c000 + k;
+            float v00 = n[0] + (n[db] - n[0]) * fb;
+            float v01 = n[dg] + (n[dg + db] - n[dg]) * fb;
+            float v10 = n[dr] + (n[dr + db] - n[dr]) * fb;
+            float v11 = n[dr + dg] + (n[dr + dg + db] - n[dr + dg]) * fb;
+            float v0 = v00 + (v01 - v00) * fg;
+            float v1 = v10 + (v11 - v10) * fg;
+            float v = v0 + (v1 - v0) * fr;
+            packed = (packed << 8) | (uint32_t)fminf(255.0f, fmaxf(0.0f, v) + 0.5f);
+        }
+        output_pixels[i] = packed;
+#endif
+    }
+
+    metrics_free(lut);
+    trace_end("reinhard_transfer", span);
+    metrics_call_end(METRICS_OP_TRANSFER, call, (uint64_t)total);
+    return 1;
+}
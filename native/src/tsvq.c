@@ -0,0 +1,496 @@
+#include "../include/tsvq.h"
+#include "../include/metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define TSVQ_SPLIT_ITERATIONS 8
+#define TSVQ_REFINE_ITERATIONS 2
+// Palette entries per index leaf, scanned linearly
+#define TSVQ_LEAF_SIZE 8
+// Bounds the index depth (and so the search stack) for degenerate splits
+#define TSVQ_MAX_DEPTH 48
+#define TSVQ_PARALLEL_MIN 65536
+
+typedef struct {
+    int left, right;   // children, -1 for a leaf
+    int start, end;    // entries of a leaf in tree order
+    float lo[3], hi[3];
+    // Split plane: entries with dot(normal, p) <= offset went left
+    float normal[3];
+    float offset;
+} TsvqNode;
+
+struct TsvqTree {
+    TsvqNode* nodes;
+    int num_nodes;
+    ColorPoint3f* points;  // palette entries in leaf order
+    int* order;            // palette index of each entry in `points`
+};
+
+typedef struct {
+    int start, end;
+    double distortion;
+} TsvqLeaf;
+
+static inline float point_weight(const float* weights, int i) {
+    return weights ? weights[i] : 1.0f;
+}
+
+// Weighted mean of idx[start, end); returns the weighted squared error
+// around it
+static double range_mean(
+    const ColorPoint3f* points,
+    const float* weights,
+    const int* idx,
+    int start,
+    int end,
+    float mean[3]
+) {
+    double w = 0, s0 = 0, s1 = 0, s2 = 0, q = 0;
+
+    METRICS_OMP_REGION();
+    #pragma omp parallel for reduction(+:w,s0,s1,s2,q) if(end - start > TSVQ_PARALLEL_MIN)
+    for (int i = start; i < end; i++) {
+        const ColorPoint3f* p = &points[idx[i]];
+        double pw = point_weight(weights, idx[i]);
+        w += pw;
+        s0 += pw * p->c1;
+        s1 += pw * p->c2;
+        s2 += pw * p->c3;
+        q += pw * ((double)p->c1 * p->c1 + (double)p->c2 * p->c2 + (double)p->c3 * p->c3);
+    }
+
+    if (w <= 0.0) {
+        mean[0] = points[idx[start]].c1;
+        mean[1] = points[idx[start]].c2;
+        mean[2] = points[idx[start]].c3;
+        return 0.0;
+    }
+
+    double m0 = s0 / w, m1 = s1 / w, m2 = s2 / w;
+    mean[0] = (float)m0;
+    mean[1] = (float)m1;
+    mean[2] = (float)m2;
+
+    double distortion = q - w * (m0 * m0 + m1 * m1 + m2 * m2);
+    return distortion > 0.0 ? distortion : 0.0;
+}
+
+static inline float dist_sq3(const ColorPoint3f* p, const float c[3]) {
+    float d0 = p->c1 - c[0];
+    float d1 = p->c2 - c[1];
+    float d2 = p->c3 - c[2];
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+static inline float plane_side(const ColorPoint3f* p, const float normal[3]) {
+    return normal[0] * p->c1 + normal[1] * p->c2 + normal[2] * p->c3;
+}
+
+// Partitions idx[start, end) so entries with dot(normal, p) <= offset come
+// first; returns the first index of the second half
+static int partition_plane(const ColorPoint3f* points, int* idx, int start, int end,
+                           const float normal[3], float offset) {
+    int i = start, j = end - 1;
+    while (i <= j) {
+        if (plane_side(&points[idx[i]], normal) <= offset) {
+            i++;
+        } else {
+            int t = idx[i]; idx[i] = idx[j]; idx[j] = t;
+            j--;
+        }
+    }
+    return i;
+}
+
+// Splits idx[start, end) in place with a 2-means seeded one standard
+// deviation either side of the mean along the widest axis. The split is the
+// bisecting plane of the two means, returned in normal/offset. Returns the
+// first index of the second half, or -1 when the range holds a single color.
+static int tsvq_split(const ColorPoint3f* points, const float* weights, int* idx, int start, int end,
+                      float normal[3], float* offset) {
+    int count = end - start;
+    if (count < 2) return -1;
+
+    double w = 0, s0 = 0, s1 = 0, s2 = 0, q0 = 0, q1 = 0, q2 = 0;
+
+    METRICS_OMP_REGION();
+    #pragma omp parallel for reduction(+:w,s0,s1,s2,q0,q1,q2) if(count > TSVQ_PARALLEL_MIN)
+    for (int i = start; i < end; i++) {
+        const ColorPoint3f* p = &points[idx[i]];
+        double pw = point_weight(weights, idx[i]);
+        w += pw;
+        s0 += pw * p->c1;
+        s1 += pw * p->c2;
+        s2 += pw * p->c3;
+        q0 += pw * p->c1 * p->c1;
+        q1 += pw * p->c2 * p->c2;
+        q2 += pw * p->c3 * p->c3;
+    }
+    if (w <= 0.0) return -1;
+
+    double mean[3] = { s0 / w, s1 / w, s2 / w };
+    double var[3] = { q0 / w - mean[0] * mean[0], q1 / w - mean[1] * mean[1], q2 / w - mean[2] * mean[2] };
+
+    int axis = 0;
+    if (var[1] > var[axis]) axis = 1;
+    if (var[2] > var[axis]) axis = 2;
+    if (var[axis] <= 1e-9) return -1;
+
+    float c0[3] = { (float)mean[0], (float)mean[1], (float)mean[2] };
+    float c1[3] = { c0[0], c0[1], c0[2] };
+    float sd = (float)sqrt(var[axis]);
+    c0[axis] -= sd;
+    c1[axis] += sd;
+
+    for (int iter = 0; iter < TSVQ_SPLIT_ITERATIONS; iter++) {
+        double w0 = 0, a0 = 0, b0 = 0, d0 = 0;
+        double w1 = 0, a1 = 0, b1 = 0, d1 = 0;
+
+        METRICS_OMP_REGION();
+        #pragma omp parallel for reduction(+:w0,a0,b0,d0,w1,a1,b1,d1) if(count > TSVQ_PARALLEL_MIN)
+        for (int i = start; i < end; i++) {
+            const ColorPoint3f* p = &points[idx[i]];
+            double pw = point_weight(weights, idx[i]);
+            if (dist_sq3(p, c0) <= dist_sq3(p, c1)) {
+                w0 += pw; a0 += pw * p->c1; b0 += pw * p->c2; d0 += pw * p->c3;
+            } else {
+                w1 += pw; a1 += pw * p->c1; b1 += pw * p->c2; d1 += pw * p->c3;
+            }
+        }
+        if (w0 <= 0.0 || w1 <= 0.0) break;
+
+        float n0[3] = { (float)(a0 / w0), (float)(b0 / w0), (float)(d0 / w0) };
+        float n1[3] = { (float)(a1 / w1), (float)(b1 / w1), (float)(d1 / w1) };
+        float movement = fmaxf(
+            (n0[0] - c0[0]) * (n0[0] - c0[0]) + (n0[1] - c0[1]) * (n0[1] - c0[1]) + (n0[2] - c0[2]) * (n0[2] - c0[2]),
+            (n1[0] - c1[0]) * (n1[0] - c1[0]) + (n1[1] - c1[1]) * (n1[1] - c1[1]) + (n1[2] - c1[2]) * (n1[2] - c1[2]));
+        memcpy(c0, n0, sizeof(c0));
+        memcpy(c1, n1, sizeof(c1));
+        if (movement < 1e-4f) break;
+    }
+
+    // Nearer to c0 <=> on c0's side of the bisecting plane
+    normal[0] = c1[0] - c0[0];
+    normal[1] = c1[1] - c0[1];
+    normal[2] = c1[2] - c0[2];
+    *offset = 0.5f * ((c1[0] * c1[0] + c1[1] * c1[1] + c1[2] * c1[2])
+                    - (c0[0] * c0[0] + c0[1] * c0[1] + c0[2] * c0[2]));
+
+    int mid = partition_plane(points, idx, start, end, normal, *offset);
+    if (mid > start && mid < end) return mid;
+
+    // 2-means collapsed onto one side: cut at the mean of the widest axis
+    normal[0] = normal[1] = normal[2] = 0.0f;
+    normal[axis] = 1.0f;
+    *offset = (float)mean[axis];
+
+    mid = partition_plane(points, idx, start, end, normal, *offset);
+    return (mid > start && mid < end) ? mid : -1;
+}
+
+// Max-heap of leaf indices by distortion; ties go to the older leaf
+static inline int leaf_before(const TsvqLeaf* leaves, int a, int b) {
+    if (leaves[a].distortion != leaves[b].distortion) {
+        return leaves[a].distortion > leaves[b].distortion;
+    }
+    return a < b;
+}
+
+static void heap_push(int* heap, int* size, const TsvqLeaf* leaves, int leaf) {
+    int i = (*size)++;
+    heap[i] = leaf;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!leaf_before(leaves, heap[i], heap[parent])) break;
+        int t = heap[i]; heap[i] = heap[parent]; heap[parent] = t;
+        i = parent;
+    }
+}
+
+static int heap_pop(int* heap, int* size, const TsvqLeaf* leaves) {
+    int top = heap[0];
+    heap[0] = heap[--(*size)];
+    int i = 0;
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, best = i;
+        if (l < *size && leaf_before(leaves, heap[l], heap[best])) best = l;
+        if (r < *size && leaf_before(leaves, heap[r], heap[best])) best = r;
+        if (best == i) break;
+        int t = heap[i]; heap[i] = heap[best]; heap[best] = t;
+        i = best;
+    }
+    return top;
+}
+
+static int tree_build_node(TsvqTree* tree, const ColorPoint3f* palette, int* idx, int start, int end, int depth) {
+    int node = tree->num_nodes++;
+    TsvqNode* nd = &tree->nodes[node];
+
+    nd->lo[0] = nd->lo[1] = nd->lo[2] = FLT_MAX;
+    nd->hi[0] = nd->hi[1] = nd->hi[2] = -FLT_MAX;
+    for (int i = start; i < end; i++) {
+        const ColorPoint3f* p = &palette[idx[i]];
+        nd->lo[0] = fminf(nd->lo[0], p->c1); nd->hi[0] = fmaxf(nd->hi[0], p->c1);
+        nd->lo[1] = fminf(nd->lo[1], p->c2); nd->hi[1] = fmaxf(nd->hi[1], p->c2);
+        nd->lo[2] = fminf(nd->lo[2], p->c3); nd->hi[2] = fmaxf(nd->hi[2], p->c3);
+    }
+
+    int mid = -1;
+    if (end - start > TSVQ_LEAF_SIZE && depth < TSVQ_MAX_DEPTH) {
+        mid = tsvq_split(palette, NULL, idx, start, end, nd->normal, &nd->offset);
+    }
+
+    nd->start = start;
+    nd->end = end;
+    if (mid < 0) {
+        nd->left = nd->right = -1;
+        return node;
+    }
+
+    // Children are appended after this node; index the array again afterwards
+    int left = tree_build_node(tree, palette, idx, start, mid, depth + 1);
+    int right = tree_build_node(tree, palette, idx, mid, end, depth + 1);
+    tree->nodes[node].left = left;
+    tree->nodes[node].right = right;
+    return node;
+}
+
+TsvqTree* tsvq_tree_build(const ColorPoint3f* palette, int k) {
+    if (k <= 0) return NULL;
+
+    TsvqTree* tree = (TsvqTree*)metrics_malloc(MEM_TSVQ, sizeof(TsvqTree));
+    if (!tree) return NULL;
+
+    // A binary tree with non-empty leaves has at most 2k - 1 nodes
+    tree->nodes = (TsvqNode*)metrics_malloc(MEM_TSVQ, (size_t)(2 * k) * sizeof(TsvqNode));
+    tree->points = (ColorPoint3f*)metrics_malloc(MEM_TSVQ, (size_t)k * sizeof(ColorPoint3f));
+    tree->order = (int*)metrics_malloc(MEM_TSVQ, (size_t)k * sizeof(int));
+    tree->num_nodes = 0;
+    if (!tree->nodes || !tree->points || !tree->order) {
+        tsvq_tree_free(tree);
+        return NULL;
+    }
+
+    for (int i = 0; i < k; i++) {
+        tree->order[i] = i;
+    }
+    tree_build_node(tree, palette, tree->order, 0, k, 0);
+
+    for (int i = 0; i < k; i++) {
+        tree->points[i] = palette[tree->order[i]];
+    }
+    return tree;
+}
+
+static inline float box_distance(const TsvqNode* nd, const ColorPoint3f* p, float wr, float wg, float wb) {
+    float dr = p->c1 < nd->lo[0] ? nd->lo[0] - p->c1 : (p->c1 > nd->hi[0] ? p->c1 - nd->hi[0] : 0.0f);
+    float dg = p->c2 < nd->lo[1] ? nd->lo[1] - p->c2 : (p->c2 > nd->hi[1] ? p->c2 - nd->hi[1] : 0.0f);
+    float db = p->c3 < nd->lo[2] ? nd->lo[2] - p->c3 : (p->c3 > nd->hi[2] ? p->c3 - nd->hi[2] : 0.0f);
+    return wr * dr * dr + wg * dg * dg + wb * db * db;
+}
+
+int tsvq_tree_nearest(const TsvqTree* tree, const ColorPoint3f* point, float wr, float wg, float wb) {
+    // Each level leaves at most one sibling on the stack, with its bound
+    int stack[TSVQ_MAX_DEPTH + 2];
+    float bounds[TSVQ_MAX_DEPTH + 2];
+    int top = 0;
+    stack[top] = 0;
+    bounds[top++] = 0.0f;
+
+    float min_weight = fminf(wr, fminf(wg, wb));
+    float best_dist = FLT_MAX;
+    int best = -1;
+
+    while (top > 0) {
+        top--;
+        // Equal bounds are still visited so ties resolve to the lowest index
+        if (bounds[top] > best_dist) continue;
+        const TsvqNode* nd = &tree->nodes[stack[top]];
+
+        if (nd->left < 0) {
+            for (int i = nd->start; i < nd->end; i++) {
+                const ColorPoint3f* c = &tree->points[i];
+                float dr = point->c1 - c->c1;
+                float dg = point->c2 - c->c2;
+                float db = point->c3 - c->c3;
+                float dist = wr * dr * dr + (wg * dg * dg + wb * db * db);
+                int index = tree->order[i];
+                if (dist < best_dist || (dist == best_dist && index < best)) {
+                    best_dist = dist;
+                    best = index;
+                }
+            }
+            continue;
+        }
+
+        // Everything in the far child lies beyond the split plane; the slack
+        // keeps the bound conservative under rounding
+        float side = plane_side(point, nd->normal) - nd->offset;
+        float norm_sq = nd->normal[0] * nd->normal[0] + nd->normal[1] * nd->normal[1]
+                      + nd->normal[2] * nd->normal[2];
+        float plane_bound = min_weight * (side * side / norm_sq) * 0.999f - 1e-3f;
+
+        int near_child = side <= 0.0f ? nd->left : nd->right;
+        int far_child = side <= 0.0f ? nd->right : nd->left;
+        float far_bound = fmaxf(plane_bound, box_distance(&tree->nodes[far_child], point, wr, wg, wb));
+        float near_bound = box_distance(&tree->nodes[near_child], point, wr, wg, wb);
+
+        // Push the far child first so the near one is searched first
+        if (far_bound <= best_dist) {
+            stack[top] = far_child;
+            bounds[top++] = far_bound;
+        }
+        stack[top] = near_child;
+        bounds[top++] = near_bound;
+    }
+
+    return best;
+}
+
+void tsvq_tree_free(TsvqTree* tree) {
+    if (!tree) return;
+    metrics_free(tree->nodes);
+    metrics_free(tree->points);
+    metrics_free(tree->order);
+    metrics_free(tree);
+}
+
+// Lloyd passes over all points with assignments looked up through the tree
+static void tsvq_refine(const ColorPoint3f* points, const float* weights, int n, ColorPoint3f* palette, int k) {
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+
+    double* accumulators = (double*)metrics_malloc(MEM_TSVQ, (size_t)num_threads * k * 4 * sizeof(double));
+    if (!accumulators) return;
+
+    for (int iter = 0; iter < TSVQ_REFINE_ITERATIONS; iter++) {
+        TsvqTree* tree = tsvq_tree_build(palette, k);
+        if (!tree) break;
+
+        memset(accumulators, 0, (size_t)num_threads * k * 4 * sizeof(double));
+
+        METRICS_OMP_REGION();
+        #pragma omp parallel num_threads(num_threads) if(n > 10000)
+        {
+            int tid = 0;
+#ifdef _OPENMP
+            tid = omp_get_thread_num();
+#endif
+            double* acc = accumulators + (size_t)tid * k * 4;
+
+            #pragma omp for schedule(static)
+            for (int i = 0; i < n; i++) {
+                int c = tsvq_tree_nearest(tree, &points[i], 1.0f, 1.0f, 1.0f);
+                double pw = point_weight(weights, i);
+                acc[c * 4 + 0] += pw * points[i].c1;
+                acc[c * 4 + 1] += pw * points[i].c2;
+                acc[c * 4 + 2] += pw * points[i].c3;
+                acc[c * 4 + 3] += pw;
+            }
+        }
+
+        tsvq_tree_free(tree);
+
+        for (int t = 1; t < num_threads; t++) {
+            const double* src = accumulators + (size_t)t * k * 4;
+            for (int j = 0; j < k * 4; j++) {
+                accumulators[j] += src[j];
+            }
+        }
+
+        for (int c = 0; c < k; c++) {
+            const double* a = accumulators + (size_t)c * 4;
+            // An entry that lost all its points keeps its position
+            if (a[3] <= 0.0) continue;
+            palette[c].c1 = (float)(a[0] / a[3]);
+            palette[c].c2 = (float)(a[1] / a[3]);
+            palette[c].c3 = (float)(a[2] / a[3]);
+        }
+    }
+
+    metrics_free(accumulators);
+}
+
+AICHAT_EXPORT int tsvq_build_palette(
+    const ColorPoint3f* points,
+    const float* weights,
+    int n,
+    int k,
+    ColorPoint3f* palette
+) {
+    if (n <= 0 || k <= 0) return 0;
+    if (k > n) k = n;
+
+    uint64_t call = metrics_call_begin();
+
+    int* idx = (int*)metrics_malloc(MEM_TSVQ, (size_t)n * sizeof(int));
+    TsvqLeaf* leaves = (TsvqLeaf*)metrics_malloc(MEM_TSVQ, (size_t)k * sizeof(TsvqLeaf));
+    int* heap = (int*)metrics_malloc(MEM_TSVQ, (size_t)k * sizeof(int));
+    if (!idx || !leaves || !heap) {
+        metrics_free(idx);
+        metrics_free(leaves);
+        metrics_free(heap);
+        metrics_call_end(METRICS_OP_TSVQ, call, (uint64_t)n);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        idx[i] = i;
+    }
+
+    float mean[3];
+    int heap_size = 0;
+    int num_leaves = 1;
+    leaves[0].start = 0;
+    leaves[0].end = n;
+    leaves[0].distortion = range_mean(points, weights, idx, 0, n, mean);
+    if (leaves[0].distortion > 0.0) {
+        heap_push(heap, &heap_size, leaves, 0);
+    }
+
+    // Greedily split the leaf with the largest distortion
+    while (num_leaves < k && heap_size > 0) {
+        int leaf = heap_pop(heap, &heap_size, leaves);
+        int start = leaves[leaf].start;
+        int end = leaves[leaf].end;
+
+        float normal[3], offset;
+        int mid = tsvq_split(points, weights, idx, start, end, normal, &offset);
+        if (mid < 0) continue;
+
+        int sibling = num_leaves++;
+        leaves[leaf].end = mid;
+        leaves[sibling].start = mid;
+        leaves[sibling].end = end;
+        leaves[leaf].distortion = range_mean(points, weights, idx, start, mid, mean);
+        leaves[sibling].distortion = range_mean(points, weights, idx, mid, end, mean);
+
+        if (leaves[leaf].distortion > 0.0) heap_push(heap, &heap_size, leaves, leaf);
+        if (leaves[sibling].distortion > 0.0) heap_push(heap, &heap_size, leaves, sibling);
+    }
+
+    for (int l = 0; l < num_leaves; l++) {
+        range_mean(points, weights, idx, leaves[l].start, leaves[l].end, mean);
+        palette[l].c1 = mean[0];
+        palette[l].c2 = mean[1];
+        palette[l].c3 = mean[2];
+    }
+
+    metrics_free(idx);
+    metrics_free(leaves);
+    metrics_free(heap);
+
+    tsvq_refine(points, weights, n, palette, num_leaves);
+
+    metrics_call_end(METRICS_OP_TSVQ, call, (uint64_t)n);
+    return num_leaves;
+}
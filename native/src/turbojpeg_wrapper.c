@@ -1,5 +1,7 @@
 #include "../include/image.h"
 #include "../include/random.h"
+#include "../include/trace.h"
+#include "../include/metrics.h"
 #include <turbojpeg.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -35,13 +37,13 @@ AICHAT_EXPORT int turbojpeg_decode(
     *height = h;
     
     size_t pixel_size = (size_t)w * h * 3;
-    *pixels = (unsigned char*)malloc(pixel_size);
+    *pixels = (unsigned char*)metrics_malloc(MEM_JPEG, pixel_size);
     if (*pixels == NULL) {
         return -1;
     }
     
     if (tjDecompress2(handle, jpeg_data, jpeg_size, *pixels, w, 0, h, TJPF_RGB, TJFLAG_FASTDCT) != 0) {
-        free(*pixels);
+        metrics_free(*pixels);
         *pixels = NULL;
         return -1;
     }
@@ -76,11 +78,11 @@ AICHAT_EXPORT int turbojpeg_decode_and_sample(
     
     // For small images, decode fully
     if (total_pixels <= sample_size) {
-        unsigned char* pixels = (unsigned char*)malloc((size_t)total_pixels * 3);
+        unsigned char* pixels = (unsigned char*)metrics_malloc(MEM_JPEG, (size_t)total_pixels * 3);
         if (!pixels) return -1;
         
         if (tjDecompress2(handle, jpeg_data, jpeg_size, pixels, w, 0, h, TJPF_RGB, TJFLAG_FASTDCT) != 0) {
-            free(pixels);
+            metrics_free(pixels);
             return -1;
         }
         
@@ -90,16 +92,16 @@ AICHAT_EXPORT int turbojpeg_decode_and_sample(
             output[i].c3 = (float)pixels[i * 3 + 2];
         }
         
-        free(pixels);
+        metrics_free(pixels);
         return total_pixels;
     }
     
     // For large images, decode and sample
-    unsigned char* pixels = (unsigned char*)malloc((size_t)total_pixels * 3);
+    unsigned char* pixels = (unsigned char*)metrics_malloc(MEM_JPEG, (size_t)total_pixels * 3);
     if (!pixels) return -1;
     
     if (tjDecompress2(handle, jpeg_data, jpeg_size, pixels, w, 0, h, TJPF_RGB, TJFLAG_FASTDCT) != 0) {
-        free(pixels);
+        metrics_free(pixels);
         return -1;
     }
     
@@ -121,7 +123,7 @@ AICHAT_EXPORT int turbojpeg_decode_and_sample(
         }
     }
     
-    free(pixels);
+    metrics_free(pixels);
     return sample_size;
 }
 
@@ -130,11 +132,10 @@ AICHAT_EXPORT int turbojpeg_available(void) {
 }
 
 AICHAT_EXPORT void turbojpeg_free(void* ptr) {
-    free(ptr);
+    metrics_free(ptr);
 }
 
-// Decode JPEG from memory buffer, returns ARGB pixels
-AICHAT_EXPORT int turbojpeg_decode_buffer(
+static int decode_buffer_argb(
     const unsigned char* jpeg_data,
     unsigned long jpeg_size,
     int* out_width,
@@ -155,26 +156,29 @@ AICHAT_EXPORT int turbojpeg_decode_buffer(
     *out_height = h;
     
     size_t num_pixels = (size_t)w * h;
-    *out_pixels = (uint32_t*)malloc(num_pixels * sizeof(uint32_t));
+    *out_pixels = (uint32_t*)metrics_malloc(MEM_JPEG, num_pixels * sizeof(uint32_t));
     if (!*out_pixels) {
         return -1;
     }
     
-    unsigned char* bgrx = (unsigned char*)malloc(num_pixels * 4);
+    unsigned char* bgrx = (unsigned char*)metrics_malloc(MEM_JPEG, num_pixels * 4);
     if (!bgrx) {
-        free(*out_pixels);
+        metrics_free(*out_pixels);
         *out_pixels = NULL;
         return -1;
     }
     
+    uint64_t span = trace_begin();
     if (tjDecompress2(handle, jpeg_data, jpeg_size, bgrx, w, 0, h, TJPF_BGRX, TJFLAG_FASTDCT) != 0) {
-        free(bgrx);
-        free(*out_pixels);
+        metrics_free(bgrx);
+        metrics_free(*out_pixels);
         *out_pixels = NULL;
         return -1;
     }
+    trace_end("jpeg_decode.decompress", span);
     
     // Convert BGRX to ARGB
+    span = trace_begin();
     uint32_t* pixels = *out_pixels;
     for (size_t i = 0; i < num_pixels; i++) {
         unsigned char b = bgrx[i * 4];
@@ -182,12 +186,28 @@ AICHAT_EXPORT int turbojpeg_decode_buffer(
         unsigned char r = bgrx[i * 4 + 2];
         pixels[i] = 0xFF000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
     }
+    trace_end("jpeg_decode.convert", span);
     
-    free(bgrx);
+    metrics_free(bgrx);
     return 0;
 }
 
-AICHAT_EXPORT int decode_jpeg_file_turbojpeg(
+// Decode JPEG from memory buffer, returns ARGB pixels
+AICHAT_EXPORT int turbojpeg_decode_buffer(
+    const unsigned char* jpeg_data,
+    unsigned long jpeg_size,
+    int* out_width,
+    int* out_height,
+    uint32_t** out_pixels
+) {
+    uint64_t call = metrics_call_begin();
+    int result = decode_buffer_argb(jpeg_data, jpeg_size, out_width, out_height, out_pixels);
+    metrics_call_end(METRICS_OP_JPEG_DECODE, call,
+                     result == 0 ? (uint64_t)*out_width * (uint64_t)*out_height : 0);
+    return result;
+}
+
+static int decode_file_argb(
     const char* path,
     int* out_width,
     int* out_height,
@@ -199,34 +219,36 @@ AICHAT_EXPORT int decode_jpeg_file_turbojpeg(
         return -1;
     }
     
+    uint64_t span = trace_begin();
     fseek(f, 0, SEEK_END);
     long size = ftell(f);
     fseek(f, 0, SEEK_SET);
     
-    unsigned char* jpeg_data = (unsigned char*)malloc(size);
+    unsigned char* jpeg_data = (unsigned char*)metrics_malloc(MEM_JPEG, size);
     if (!jpeg_data) {
         fclose(f);
         return -1;
     }
     
     if (fread(jpeg_data, 1, size, f) != (size_t)size) {
-        free(jpeg_data);
+        metrics_free(jpeg_data);
         fclose(f);
         return -1;
     }
     fclose(f);
+    trace_end("jpeg_decode.read_file", span);
     
     // Decode JPEG
     tjhandle handle = get_tj_handle();
     if (handle == NULL) {
-        free(jpeg_data);
+        metrics_free(jpeg_data);
         return -1;
     }
     
     int w, h, subsamp, colorspace;
     if (tjDecompressHeader3(handle, jpeg_data, size, &w, &h, &subsamp, &colorspace) != 0) {
         fprintf(stderr, "TurboJPEG: Failed to read header: %s\n", tjGetErrorStr2(handle));
-        free(jpeg_data);
+        metrics_free(jpeg_data);
         return -1;
     }
     
@@ -234,31 +256,34 @@ AICHAT_EXPORT int decode_jpeg_file_turbojpeg(
     *out_height = h;
     
     size_t num_pixels = (size_t)w * h;
-    *out_pixels = (uint32_t*)malloc(num_pixels * sizeof(uint32_t));
+    *out_pixels = (uint32_t*)metrics_malloc(MEM_JPEG, num_pixels * sizeof(uint32_t));
     if (!*out_pixels) {
-        free(jpeg_data);
+        metrics_free(jpeg_data);
         return -1;
     }
     
-    unsigned char* bgrx = (unsigned char*)malloc(num_pixels * 4);
+    unsigned char* bgrx = (unsigned char*)metrics_malloc(MEM_JPEG, num_pixels * 4);
     if (!bgrx) {
-        free(*out_pixels);
+        metrics_free(*out_pixels);
         *out_pixels = NULL;
-        free(jpeg_data);
+        metrics_free(jpeg_data);
         return -1;
     }
     
+    span = trace_begin();
     if (tjDecompress2(handle, jpeg_data, size, bgrx, w, 0, h, TJPF_BGRX, TJFLAG_FASTDCT) != 0) {
         fprintf(stderr, "TurboJPEG: Decompression failed: %s\n", tjGetErrorStr2(handle));
-        free(bgrx);
-        free(*out_pixels);
+        metrics_free(bgrx);
+        metrics_free(*out_pixels);
         *out_pixels = NULL;
-        free(jpeg_data);
+        metrics_free(jpeg_data);
         return -1;
     }
     
-    free(jpeg_data);
+    trace_end("jpeg_decode.decompress", span);
+    metrics_free(jpeg_data);
     
+    span = trace_begin();
     uint32_t* pixels = *out_pixels;
     for (size_t i = 0; i < num_pixels; i++) {
         unsigned char b = bgrx[i * 4];
@@ -266,11 +291,25 @@ AICHAT_EXPORT int decode_jpeg_file_turbojpeg(
         unsigned char r = bgrx[i * 4 + 2];
         pixels[i] = 0xFF000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
     }
+    trace_end("jpeg_decode.convert", span);
     
-    free(bgrx);
+    metrics_free(bgrx);
     return 0;
 }
 
+AICHAT_EXPORT int decode_jpeg_file_turbojpeg(
+    const char* path,
+    int* out_width,
+    int* out_height,
+    uint32_t** out_pixels
+) {
+    uint64_t call = metrics_call_begin();
+    int result = decode_file_argb(path, out_width, out_height, out_pixels);
+    metrics_call_end(METRICS_OP_JPEG_DECODE, call,
+                     result == 0 ? (uint64_t)*out_width * (uint64_t)*out_height : 0);
+    return result;
+}
+
 static __thread tjhandle tj_compress_handle = NULL;
 
 static tjhandle get_tj_compress_handle(void) {
@@ -280,7 +319,7 @@ static tjhandle get_tj_compress_handle(void) {
     return tj_compress_handle;
 }
 
-AICHAT_EXPORT int turbojpeg_encode(
+static int encode_rgb(
     const uint32_t* pixels,
     int width,
     int height,
@@ -294,12 +333,14 @@ AICHAT_EXPORT int turbojpeg_encode(
     }
     
     size_t num_pixels = (size_t)width * height;
-    unsigned char* rgb = (unsigned char*)malloc(num_pixels * 3);
+    unsigned char* rgb = (unsigned char*)metrics_malloc(MEM_JPEG, num_pixels * 3);
     if (!rgb) {
         return -1;
     }
     
     // Convert ARGB to RGB in parallel
+    uint64_t span = trace_begin();
+    METRICS_OMP_REGION();
     #pragma omp parallel for schedule(static, 65536) if(num_pixels > 100000)
     for (size_t i = 0; i < num_pixels; i++) {
         uint32_t pixel = pixels[i];
@@ -308,9 +349,12 @@ AICHAT_EXPORT int turbojpeg_encode(
         rgb[i * 3 + 2] = (unsigned char)(pixel & 0xFF);
     }
     
+    trace_end("jpeg_encode.convert", span);
+    
     *jpeg_data = NULL;
     *jpeg_size = 0;
     
+    span = trace_begin();
     int result = tjCompress2(
         handle,
         rgb,
@@ -325,7 +369,8 @@ AICHAT_EXPORT int turbojpeg_encode(
         TJFLAG_FASTDCT
     );
     
-    free(rgb);
+    trace_end("jpeg_encode.compress", span);
+    metrics_free(rgb);
     
     if (result != 0) {
         fprintf(stderr, "TurboJPEG encode failed: %s\n", tjGetErrorStr2(handle));
@@ -339,7 +384,21 @@ AICHAT_EXPORT int turbojpeg_encode(
     return 0;
 }
 
-AICHAT_EXPORT int turbojpeg_encode_to_file(
+AICHAT_EXPORT int turbojpeg_encode(
+    const uint32_t* pixels,
+    int width,
+    int height,
+    int quality,
+    unsigned char** jpeg_data,
+    unsigned long* jpeg_size
+) {
+    uint64_t call = metrics_call_begin();
+    int result = encode_rgb(pixels, width, height, quality, jpeg_data, jpeg_size);
+    metrics_call_end(METRICS_OP_JPEG_ENCODE, call, (uint64_t)width * (uint64_t)height);
+    return result;
+}
+
+static int encode_to_file(
     const uint32_t* pixels,
     int width,
     int height,
@@ -349,10 +408,11 @@ AICHAT_EXPORT int turbojpeg_encode_to_file(
     unsigned char* jpeg_data = NULL;
     unsigned long jpeg_size = 0;
     
-    if (turbojpeg_encode(pixels, width, height, quality, &jpeg_data, &jpeg_size) != 0) {
+    if (encode_rgb(pixels, width, height, quality, &jpeg_data, &jpeg_size) != 0) {
         return -1;
     }
     
+    uint64_t span = trace_begin();
     FILE* file = fopen(path, "wb");
     if (!file) {
         tjFree(jpeg_data);
@@ -361,11 +421,25 @@ AICHAT_EXPORT int turbojpeg_encode_to_file(
     
     size_t written = fwrite(jpeg_data, 1, jpeg_size, file);
     fclose(file);
+    trace_end("jpeg_encode.write_file", span);
     tjFree(jpeg_data);
     
     return (written == jpeg_size) ? 0 : -1;
 }
 
+AICHAT_EXPORT int turbojpeg_encode_to_file(
+    const uint32_t* pixels,
+    int width,
+    int height,
+    int quality,
+    const char* path
+) {
+    uint64_t call = metrics_call_begin();
+    int result = encode_to_file(pixels, width, height, quality, path);
+    metrics_call_end(METRICS_OP_JPEG_ENCODE, call, (uint64_t)width * (uint64_t)height);
+    return result;
+}
+
 AICHAT_EXPORT void turbojpeg_cleanup(void) {
     if (tj_handle != NULL) {
         tjDestroy(tj_handle);